@@ -172,6 +172,10 @@
 /* Define to 1 if you have the ANSI C header files. */
 #define STDC_HEADERS 1
 
+/* Define to the storage class of thread-local variables, or to nothing if
+   there is none */
+#define TLS __declspec(thread)
+
 /* Version number of package */
 #define VERSION "1"
 
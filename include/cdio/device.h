@@ -166,7 +166,11 @@ extern "C" {
                          listed before NRG, to make the code prefer
                          BIN/CUE over NRG when both exist. */
     DRIVER_NRG,     /**< Nero NRG format CD image. */
-    DRIVER_DEVICE   /**< Is really a set of the above; should come last */
+    DRIVER_DEVICE,  /**< Is really a set of the above; should come last */
+    DRIVER_MMC_EMU  /**< MMC drive emulated from a disc image. This is
+                         never scanned for, and comes after
+                         DRIVER_DEVICE so the values above stay as
+                         they were. */
   } driver_id_t;
 
   /**
@@ -366,6 +370,18 @@ extern "C" {
                                          bool b_any,
                                          /*out*/ driver_id_t *p_driver_id);
 
+  /**
+     Set how long cdio_get_devices_with_cap() and
+     cdio_get_devices_with_cap_ret() wait for drives to say what is in
+     them. All the drives are looked at together, so this is the most
+     the whole search waits. A drive that takes longer is taken to have
+     nothing in it.
+
+     @param i_timeout_ms milliseconds, or 0 (the default) to wait as
+     long as it takes.
+  */
+  void cdio_set_device_probe_timeout (unsigned int i_timeout_ms);
+
   /**
      Like cdio_get_devices(), but we may change the p_driver_id if we
      were given \p DRIVER_DEVICE or \p DRIVER_UNKNOWN. This is because often
@@ -712,6 +728,18 @@ extern "C" {
    */
   char **cdio_get_devices_linux(void);
 
+  /**
+     Return a list of the CD-ROM drives that the GNU/Linux sysfs
+     directory psz_sys_block (normally "/sys/block") lists, as names
+     in the device directory psz_dev (normally "/dev"). No drive is
+     opened, so this is quick however many there are.
+
+     @return NULL if psz_sys_block can't be read or this isn't
+     GNU/Linux. Free the list with cdio_free_device_list().
+   */
+  char **cdio_get_devices_sysfs_linux(const char *psz_sys_block,
+                                      const char *psz_dev);
+
   /**
      Set up CD-ROM for reading using the Sun Solaris driver. The
      device_name is the some sort of device name.
@@ -857,6 +885,23 @@ extern "C" {
 
   char **cdio_get_devices_nrg(void);
 
+  /**
+     Set up an emulated MMC drive holding the disc image psz_image,
+     which may be a cdrdao TOC file, a BIN/CUE cue sheet or a Nero NRG
+     image. MMC commands are answered from the image, and the drive
+     can be slowed down and made to fail with cdio_set_arg() keys
+     starting "emu-".
+
+     @return the CdIo object or NULL if psz_image can't be used.
+   */
+  CdIo_t * cdio_open_mmc_emu (const char *psz_image);
+
+  /**
+     Like cdio_open_mmc_emu(); the emulator has only one access mode.
+   */
+  CdIo_t * cdio_open_am_mmc_emu (const char *psz_image,
+                                 const char *psz_access_mode);
+
   /**
 
      Determine if bin_name is the bin file part of  a CDRWIN CD disk image.
@@ -941,6 +986,22 @@ extern "C" {
   /**
      Set the arg "key" with "value" in "p_cdio".
 
+     Besides the keys of each driver, such as "source" and
+     "access-mode", every driver takes "mmc-max-transfer": the most
+     bytes a single MMC read command may transfer, as a decimal
+     number. Longer reads are split into commands of that size. Some
+     drivers, like the GNU/Linux one, set it from what the host
+     adapter allows when the device is opened. "0" goes back to the
+     small fixed sizes used when the limit isn't known. The GNU/Linux
+     driver also reads data sectors in requests of up to that size.
+
+     The GNU/Linux driver takes "direct-io" too: "true" reads data
+     sectors with O_DIRECT, so they don't pass through the page
+     cache, and "false" goes back to buffered reads. Its
+     "mmc-transport" is "SG_IO" to send MMC commands with the SG_IO
+     ioctl rather than "CDROM_SEND_PACKET"; SCSI generic devices,
+     /dev/sg*, always use SG_IO.
+
      @param p_cdio the CD object to set
      @param key the key to set
      @param value the value to assocaiate with key
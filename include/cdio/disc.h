@@ -133,6 +133,50 @@ extern "C" {
   */
   bool cdio_is_discmode_dvd (discmode_t discmode);
 
+  /**
+    Return a string telling this disc from others, made from its table
+    of contents: two discs with the same one are taken to be the same.
+
+    @return NULL if there is no disc or its table of contents can't be
+    read. Otherwise the caller must free the string with cdio_free().
+  */
+  char *cdio_get_disc_fingerprint (const CdIo_t *p_cdio);
+
+  /**
+    Cache what is slow to read from discs in drives: their media
+    catalog numbers, ISRCs and CD-Text. A disc's ISRCs take a
+    subchannel read per track, which can add up to many seconds.
+
+    Once this is called, cdio_get_mcn(), cdio_get_track_isrc(),
+    cdio_get_cdtext() and cdio_get_cdtext_raw() on drives give what was
+    read before from the same disc, by any CdIo_t object in the
+    process, and read from the disc only what hasn't been. Each asks
+    the drive first whether its media changed, which is quick, and
+    only if it did, or the drive can't tell, reads the table of
+    contents to find the disc by its fingerprint. Disc images aren't
+    cached.
+
+    A media change the cache takes from the drive is still reported by
+    the next cdio_get_media_changed() on the same CdIo_t object, though
+    not on others. cdio_get_cdtext() gives a cdtext_t which lasts
+    until it is next called on the object, rather than until
+    cdio_destroy().
+
+    @param psz_dir if not NULL, a directory where what is read is also
+    kept, one file per disc, so it is there for other processes and
+    later runs too. It must exist.
+
+    @return DRIVER_OP_SUCCESS, or DRIVER_OP_ERROR if psz_dir isn't a
+    directory.
+  */
+  driver_return_code_t cdio_disc_cache_enable (const char *psz_dir);
+
+  /**
+    Stop caching and forget what is cached in memory. Nothing else may
+    be using libcdio meanwhile.
+  */
+  void cdio_disc_cache_disable (void);
+
   /**
       cdio_stat_size is deprecated. @see cdio_get_disc_last_lsn
   */
@@ -432,7 +432,6 @@ struct logical_vol_desc_s
     udf_long_ad_t fsd_loc;
     udf_Uint8_t   logvol_content_use[16];
   } lvd_use;
-  udf_Uint8_t     logvol_contents_use[16];
   udf_Uint32_t    maptable_len;
   udf_Uint32_t    i_partition_maps;
   udf_regid_t     imp_id;
@@ -473,6 +472,27 @@ struct generic_partition_map2
   udf_Uint8_t   partition_id[62];
 } GNUC_PACKED;
 
+/** Metadata Partition Map (UDF 2.50 2.2.10), a Type 2 Partition Map */
+struct metadata_partition_map
+{
+  udf_Uint8_t   partition_map_type;
+  udf_Uint8_t   partition_map_length;
+  udf_Uint8_t   reserved1[2];
+  udf_regid_t   partition_type_id;
+  udf_Uint16_t  vol_seq_num;
+  udf_Uint16_t  i_partition;
+  udf_Uint32_t  metadata_file_loc;
+  udf_Uint32_t  metadata_mirror_file_loc;
+  udf_Uint32_t  metadata_bitmap_file_loc;
+  udf_Uint32_t  alloc_unit_size;
+  udf_Uint16_t  align_unit_size;
+  udf_Uint8_t   flags;
+  udf_Uint8_t   reserved2[5];
+} GNUC_PACKED;
+
+/** Partition Type Identifier of a Metadata Partition Map */
+#define UDF_ID_METADATA                 "*UDF Metadata Partition"
+
 /** Unallocated Space Descriptor (ECMA 167r3 3/10.8) */
 struct unalloc_space_desc_s
 {
@@ -565,6 +565,12 @@ struct iso9660_stat_s { /* big endian!! */
   iso9660_xa_t       xa;              /**< XA attributes */
   enum { _STAT_FILE = 1, _STAT_DIR = 2 } type;
   bool               b_xa;
+  struct iso9660_arena_s *p_arena;    /**< Internal: block allocator this
+                                         entry and its Rock Ridge symlink
+                                         were carved from, or NULL if
+                                         individually allocated. Release
+                                         entries with iso9660_stat_free()
+                                         either way. */
   char               filename[EMPTY_ARRAY_SIZE];    /**< filename */
 };
 
@@ -692,6 +698,32 @@ typedef struct _iso9660_s iso9660_t;
   long int iso9660_iso_seek_read (const iso9660_t *p_iso, /*out*/ void *ptr,
                                   lsn_t start, long int i_size);
 
+  /*!
+    Read bytes from the data of a file, starting at a byte offset
+    within that file. Multi-extent files are read as one. Whole
+    blocks inside the range are read straight into p_buf; only a
+    partial first and last block go through a block-sized buffer.
+
+    @param p_iso the ISO-9660 file image to get data from
+
+    @param p_stat the file, as returned by iso9660_ifs_stat() or
+    iso9660_ifs_readdir()
+
+    @param p_buf place to put returned data. It should be able to
+    store at least i_len bytes
+
+    @param i_len number of bytes to read
+
+    @param i_offset byte offset within the file to start reading from
+
+    @return number of bytes read, which is less than i_len only at the
+    end of the file, 0 at or past the end of the file, or -1 on error.
+  */
+  ssize_t iso9660_ifs_file_pread (const iso9660_t *p_iso,
+                                  const iso9660_stat_t *p_stat,
+                                  /*out*/ void *p_buf, size_t i_len,
+                                  uint64_t i_offset);
+
   /*!
     Read the Primary Volume Descriptor for a CD.
     True is returned if read, and false if there was an error.
@@ -970,6 +1002,11 @@ iso9660_stat_t *iso9660_ifs_find_lsn_with_path(iso9660_t *p_iso,
 /*!
   Free the passed iso9660_stat_t structure.
 
+  Entries returned in a list by iso9660_fs_readdir() or
+  iso9660_ifs_readdir() share one block allocator; freeing such an
+  entry only drops its reference and the memory goes back in one
+  piece when the last entry of that directory read is freed.
+
   @param p_stat iso9660 stat buffer to free.
 
  */
@@ -1098,6 +1135,113 @@ CdioList_t * iso9660_fs_readdir (CdIo_t *p_cdio, const char psz_path[]);
 */
 CdioList_t * iso9660_ifs_readdir (iso9660_t *p_iso, const char psz_path[]);
 
+/*!
+  Order in which iso9660_ifs_walk() reports directory entries.
+*/
+typedef enum {
+  ISO9660_WALK_ORDERED,   /**< As a single-threaded depth-first walk
+                             would: the entries of a directory in
+                             on-disk order, then the walk of each of
+                             its subdirectories in turn. */
+  ISO9660_WALK_UNORDERED  /**< The entries of each directory as soon as
+                             that directory has been read. */
+} iso9660_walk_order_t;
+
+/*!
+  Called by iso9660_ifs_walk() for each entry of each directory.
+
+  @param psz_dir_path the path of the directory containing p_stat,
+  ending in "/".
+
+  @param p_stat the entry, including "." and "..". It is only valid
+  during the call and must not be freed.
+
+  @return 0 to continue or non-zero to stop the walk.
+*/
+typedef int (*iso9660_walk_visitor_t) (const char psz_dir_path[],
+                                       const iso9660_stat_t *p_stat,
+                                       void *p_user_data);
+
+/*!
+  Walk the directory tree of p_iso below psz_path, calling visitor for
+  every entry found.
+
+  Directories are read by i_threads worker threads which share out
+  the directories still to be read among themselves. Directory reads
+  don't move the file position of p_iso, so they run concurrently.
+  visitor itself is always called on the calling thread, one entry at
+  a time. With i_threads 0 or 1, or without thread support,
+  everything happens on the calling thread.
+
+  @param p_iso the ISO-9660 file image to get data from
+
+  @param psz_path the directory to start from.
+
+  @param visitor called for each entry.
+
+  @param p_user_data passed on to visitor.
+
+  @param i_threads number of worker threads to use.
+
+  @param order whether entries are reported in depth-first order or
+  as soon as they have been read.
+
+  @return 0 if the whole tree was visited, the value visitor returned
+  if it stopped the walk, or -1 if psz_path is not a directory or a
+  directory could not be read.
+*/
+int iso9660_ifs_walk (iso9660_t *p_iso, const char psz_path[],
+                      iso9660_walk_visitor_t visitor, void *p_user_data,
+                      unsigned int i_threads, iso9660_walk_order_t order);
+
+/*!
+  Options for iso9660_ifs_extract_tree(). A zeroed structure, like
+  passing NULL, selects the defaults.
+*/
+typedef struct iso9660_extract_opts_s {
+  uint32_t     i_max_read_blocks;   /**< Largest single read from the
+                                       image, in blocks. 0 means 512
+                                       (1 MiB). */
+  uint32_t     i_max_gap_blocks;    /**< Unused blocks between two files
+                                       that are read through rather
+                                       than skipped over. */
+  unsigned int i_threads;           /**< Threads used for reading
+                                       directories, see
+                                       iso9660_ifs_walk(). */
+  bool         b_no_rock_ridge;     /**< Don't create Rock Ridge symbolic
+                                       links or apply Rock Ridge
+                                       permissions. */
+} iso9660_extract_opts_t;
+
+/*!
+  Extract all files and directories below psz_src_dir of p_iso into
+  the local directory psz_dst_dir, which is created if needed.
+
+  The extents of all files are gathered first and then read from the
+  image in a single front-to-back pass, with neighbouring extents
+  merged into large reads. Where threads are available, the files are
+  written by a second thread while the next read is under way.
+
+  File names are taken as found, with ";1" version numbers removed
+  from plain ISO 9660 names. Rock Ridge symbolic links are created as
+  such and Rock Ridge permissions are applied, unless
+  p_opts->b_no_rock_ridge is set.
+
+  @param p_iso the ISO-9660 file image to get data from
+
+  @param psz_src_dir the directory of p_iso to extract.
+
+  @param psz_dst_dir the local directory to extract into.
+
+  @param p_opts options, or NULL for the defaults.
+
+  @return 0 on success or -1 on error. The error is logged and
+  whatever was extracted up to that point is left in place.
+*/
+int iso9660_ifs_extract_tree (iso9660_t *p_iso, const char psz_src_dir[],
+                              const char psz_dst_dir[],
+                              const iso9660_extract_opts_t *p_opts);
+
 /*!
   Return the PVD's application ID.
 
@@ -1211,6 +1355,35 @@ lsn_t iso9660_get_dir_extent(const iso9660_dir_t *p_idr);
   */
   bool_3way_t iso9660_have_rr(iso9660_t *p_iso, uint64_t u_file_limit);
 
+  /*!
+    Make directory reads of p_iso decode only the Rock Ridge names
+    (and what is needed to place entries, such as deep directory
+    links) instead of all Rock Ridge fields. The POSIX attributes,
+    symbolic link targets and time stamps of an entry are then
+    decoded the first time iso9660_ifs_get_rock_ridge() is called on
+    it. This makes listings that only need names and sizes cheaper.
+
+    @param p_iso the ISO-9660 file image
+    @param b_lazy true to defer decoding, false for the default of
+    decoding everything while reading a directory
+  */
+  void iso9660_ifs_set_rock_ridge_lazy(iso9660_t *p_iso, bool b_lazy);
+
+  /*!
+    Get the Rock Ridge fields of an entry, decoding them now if that
+    was deferred by iso9660_ifs_set_rock_ridge_lazy(). This re-reads
+    the one block holding the entry's directory record.
+
+    @param p_iso the ISO-9660 file image p_stat came from
+    @param p_stat an entry returned by iso9660_ifs_stat(),
+    iso9660_ifs_readdir() and the like; its rr field is updated.
+
+    @return the Rock Ridge fields of p_stat, or NULL if p_stat has no
+    Rock Ridge extensions or they could not be decoded.
+  */
+  const iso_rock_statbuf_t *
+  iso9660_ifs_get_rock_ridge(iso9660_t *p_iso, iso9660_stat_t *p_stat);
+
   /*!
     Get the system ID.  psz_system_id is set to NULL if there
     is some problem in getting this and false is returned.
@@ -764,7 +764,8 @@ driver_return_code_t mmc_audio_get_volume (CdIo_t *p_cdio,  /*out*/
 
   /**
       Read sectors using SCSI-MMC GPCMD_READ_CD.
-      Can read only up to 25 blocks.
+      The read is split into commands of no more than the
+      "mmc-max-transfer" bytes given by cdio_set_arg(), if set.
   */
   driver_return_code_t mmc_read_sectors ( const CdIo_t *p_cdio, void *p_buf,
                                           lsn_t i_lsn,  int read_sector_type,
@@ -0,0 +1,146 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+   \file mmc_async.h
+
+   \brief Running Multimedia Commands (MMC) without waiting for them.
+
+   mmc_run_cmd() returns only once a command is done, so keeping
+   several drives busy takes a thread for each. Here a command is
+   handed over with mmc_submit_cmd(), more can follow it before it is
+   done, and finished ones are collected with mmc_reap_cmds(). A single
+   thread can keep deep queues going on many drives by poll()ing the
+   descriptors mmc_get_completion_fd() gives.
+
+   Drivers which can't queue commands, or devices which can't (on
+   GNU/Linux, only SCSI generic devices, /dev/sg*, can), run each
+   command when it is submitted. It is then reaped like any other, so
+   callers needn't tell the two apart.
+
+   Once a driver's own queue is full (the GNU/Linux sg driver takes 16
+   commands per open device) further commands are also run when they
+   are submitted.
+
+   The commands of one CdIo_t object must be submitted and reaped from
+   one thread at a time, and all of them reaped before cdio_destroy().
+*/
+
+#ifndef CDIO_MMC_ASYNC_H_
+#define CDIO_MMC_ASYNC_H_
+
+#include <cdio/mmc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  typedef struct mmc_async_cmd_s mmc_async_cmd_t;
+
+  /**
+     An MMC command to be run by mmc_submit_cmd(). The caller owns it
+     and it, along with its buffer, must stay put until it comes back
+     from mmc_reap_cmds().
+  */
+  struct mmc_async_cmd_s {
+    /* Set by the caller. */
+    mmc_cdb_t            cdb;          /**< the command */
+    unsigned int         i_cdb;        /**< CDB length in bytes; 0 to have
+                                          it worked out from the opcode */
+    unsigned int         i_timeout_ms; /**< how long the command may take */
+    cdio_mmc_direction_t e_direction;  /**< which way the data goes */
+    unsigned int         i_buf;        /**< size of p_buf */
+    void                *p_buf;        /**< data sent or received */
+    void                *p_user_data;  /**< the caller's; left alone */
+
+    /* Set once the command is done. */
+    driver_return_code_t i_status;     /**< as mmc_run_cmd() would return */
+    cdio_mmc_request_sense_t sense;    /**< sense reply, if any */
+    unsigned int         i_sense;      /**< valid bytes in sense */
+
+    /* For libcdio's use. */
+    mmc_async_cmd_t     *p_next;
+  };
+
+  /**
+    Fill in p_cmd for a READ CD of i_blocks raw sectors starting at
+    i_lsn into p_buf, like a single command of mmc_read_sectors().
+    p_buf must hold CDIO_CD_FRAMESIZE_RAW * i_blocks bytes.
+    p_cmd->p_user_data is left as it was.
+  */
+  void mmc_prep_read_sectors(mmc_async_cmd_t *p_cmd, void *p_buf,
+                             lsn_t i_lsn, int sector_type,
+                             uint32_t i_blocks);
+
+  /**
+    Start running the command in p_cmd, without waiting for it to
+    finish.
+
+    @param p_cdio  CD structure set by cdio_open().
+    @param p_cmd   the command.
+
+    @return DRIVER_OP_SUCCESS if the command was queued; it must then
+    be reaped with mmc_reap_cmds(), which tells how it went. Otherwise
+    it was not queued.
+  */
+  driver_return_code_t mmc_submit_cmd(CdIo_t *p_cdio, mmc_async_cmd_t *p_cmd);
+
+  /**
+    Collect submitted commands that are done.
+
+    @param p_cdio        CD structure set by cdio_open().
+    @param ap_done       where the finished commands are put, in the
+                         order they finished.
+    @param i_max         room in ap_done.
+    @param i_timeout_ms  how long to wait for a command to finish when
+                         none has yet: 0 not to wait, and a negative
+                         number to wait as long as it takes.
+
+    @return the number of commands put in ap_done, which is 0 if none
+    finished in time or none were pending, or a negative
+    driver_return_code_t on error.
+  */
+  int mmc_reap_cmds(CdIo_t *p_cdio, mmc_async_cmd_t *ap_done[],
+                    unsigned int i_max, int i_timeout_ms);
+
+  /**
+    Return the number of commands submitted and not yet reaped.
+  */
+  unsigned int mmc_get_cmds_pending(const CdIo_t *p_cdio);
+
+  /**
+    Return a descriptor that poll() reports readable when
+    mmc_reap_cmds() has a queued command to give, or -1 if commands
+    for p_cdio aren't queued but run when submitted. Either way, reap
+    with no timeout before polling, as commands which were run when
+    submitted don't make the descriptor readable.
+  */
+  int mmc_get_completion_fd(const CdIo_t *p_cdio);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_MMC_ASYNC_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
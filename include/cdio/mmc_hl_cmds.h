@@ -96,6 +96,28 @@ extern "C" {
   driver_return_code_t mmc_mode_sense( CdIo_t *p_cdio, /*out*/ void *p_buf,
                                        unsigned int i_size, int page);
   
+  /**
+    Get how many times the drive retries a read before giving up, from
+    the Read/Write Error Recovery mode page.
+
+    @param p_cdio the CD object to be acted upon.
+    @return the read retry count, or a negative driver_return_code_t.
+  */
+  int mmc_get_read_retries( CdIo_t *p_cdio );
+
+  /**
+    Set how many times the drive retries a read before giving up, via
+    MODE SELECT of the Read/Write Error Recovery mode page. A damaged
+    disc is read much faster with few retries, as each unreadable
+    sector can otherwise take the drive seconds.
+
+    @param p_cdio the CD object to be acted upon.
+    @param i_retries the read retry count; 0 gives up at the first error.
+    @return DRIVER_OP_SUCCESS if we ran the commands ok.
+  */
+  driver_return_code_t mmc_set_read_retries( CdIo_t *p_cdio,
+                                             uint8_t i_retries );
+
   /**
     Set the drive speed in CD-ROM speed units.
 
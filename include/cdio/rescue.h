@@ -0,0 +1,181 @@
+/*
+    Copyright (C) 2026 agent <agent@local>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+   \file rescue.h
+
+   \brief Reading as much as can be read from a damaged disc.
+
+   Reading a damaged disc sector by sector stalls on every unreadable
+   sector, often for seconds while the drive retries it. The rescue
+   reader gets the readable parts first, in the way GNU ddrescue does:
+
+   -# Large reads are made across the area. After one fails, reading
+      goes on further ahead, twice as far each time another one fails,
+      so time isn't spent in a scratched stretch.
+   -# What was skipped is then read, still in large reads.
+   -# Each read that failed is halved until the sectors that can't be
+      read are found.
+   -# Those can be tried again a given number of times.
+
+   Each sector read is handed to a callback. What has been read, what
+   can't be and what hasn't been tried are kept in a map, which can be
+   saved and loaded to carry on later, perhaps in another drive.
+
+   The drive's own read retries can be cut down while this runs, via
+   the MMC Read/Write Error Recovery mode page.
+*/
+
+#ifndef CDIO_RESCUE_H_
+#define CDIO_RESCUE_H_
+
+#include <cdio/cdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  typedef struct cdio_rescue_s cdio_rescue_t;
+
+  /**
+     What is known about a sector. The values are what the map file
+     uses, as GNU ddrescue's does.
+  */
+  typedef enum {
+    CDIO_RESCUE_UNTRIED   = '?', /**< not read yet */
+    CDIO_RESCUE_UNTRIMMED = '*', /**< in a read that failed */
+    CDIO_RESCUE_BAD       = '-', /**< can't be read on its own */
+    CDIO_RESCUE_FINISHED  = '+'  /**< read and handed over */
+  } cdio_rescue_status_t;
+
+  /**
+     Where what was read goes: i_blocks sectors starting at i_lsn.
+     Anything but DRIVER_OP_SUCCESS stops cdio_rescue_run(), which
+     then returns it.
+  */
+  typedef driver_return_code_t
+  (*cdio_rescue_write_fn_t) (void *p_user_data, lsn_t i_lsn,
+                             const void *p_buf, uint32_t i_blocks);
+
+  /**
+    Get ready to rescue i_blocks sectors of i_blocksize bytes starting
+    at i_lsn. Sectors of CDIO_CD_FRAMESIZE_RAW bytes are read with
+    cdio_read_audio_sectors(), others with cdio_read_data_sectors().
+    Nothing has been tried yet.
+
+    @return NULL on error.
+  */
+  cdio_rescue_t *cdio_rescue_new(CdIo_t *p_cdio, lsn_t i_lsn,
+                                 uint32_t i_blocks, uint16_t i_blocksize);
+
+  /** Free what cdio_rescue_new() gave. */
+  void cdio_rescue_destroy(cdio_rescue_t *p_rescue);
+
+  /**
+    Set how many sectors the first reads get at a time. The default is
+    32; it can be no more than 65535.
+  */
+  driver_return_code_t cdio_rescue_set_read_blocks(cdio_rescue_t *p_rescue,
+                                                   uint32_t i_blocks);
+
+  /**
+    Set the most sectors skipped after a failed read. 0, the default,
+    is a 64th of the area, and never less than a read.
+  */
+  void cdio_rescue_set_max_skip(cdio_rescue_t *p_rescue, uint32_t i_blocks);
+
+  /**
+    Set how many times the sectors that can't be read are tried again,
+    one by one, once everything else is done. The default is 0.
+  */
+  void cdio_rescue_set_retry_passes(cdio_rescue_t *p_rescue,
+                                    unsigned int i_passes);
+
+  /**
+    Set the drive's read retry count while reading, as
+    mmc_set_read_retries() does, or -1 (the default) to leave it
+    alone. It is put back before the retry passes and when done.
+    Drivers without MMC commands ignore this.
+  */
+  void cdio_rescue_set_drive_retries(cdio_rescue_t *p_rescue, int i_retries);
+
+  /**
+    Read what isn't read yet, as the map has it, and hand it to
+    write_fn.
+
+    @param p_rescue    what cdio_rescue_new() gave.
+    @param write_fn    where the sectors go.
+    @param p_user_data passed to write_fn.
+    @param psz_map     if not NULL, the map is saved there after each
+                       pass and when done.
+
+    @return DRIVER_OP_SUCCESS once everything has been tried, even if
+    not everything could be read; see cdio_rescue_get_count(). Otherwise
+    what stopped it: write_fn's return, or the driver's when it can't
+    read at all.
+  */
+  driver_return_code_t cdio_rescue_run(cdio_rescue_t *p_rescue,
+                                       cdio_rescue_write_fn_t write_fn,
+                                       void *p_user_data,
+                                       const char *psz_map);
+
+  /**
+    Save the map to psz_map, replacing it at once rather than
+    rewriting it in place, so it is never left half written.
+  */
+  driver_return_code_t cdio_rescue_save_map(const cdio_rescue_t *p_rescue,
+                                            const char *psz_map);
+
+  /**
+    Load a map saved by cdio_rescue_save_map() to carry on from it.
+    Parts of the map outside the area are ignored, and parts of the
+    area it doesn't cover are left as they were.
+
+    @return DRIVER_OP_BAD_PARAMETER if psz_map isn't a map, and
+    DRIVER_OP_ERROR if it can't be read.
+  */
+  driver_return_code_t cdio_rescue_load_map(cdio_rescue_t *p_rescue,
+                                            const char *psz_map);
+
+  /** Return the number of sectors with the given status. */
+  uint32_t cdio_rescue_get_count(const cdio_rescue_t *p_rescue,
+                                 cdio_rescue_status_t status);
+
+  /**
+    Get the i_region-th run of sectors of the same status, counting
+    from 0 at the start of the area.
+
+    @return false if there are fewer runs than that.
+  */
+  bool cdio_rescue_get_region(const cdio_rescue_t *p_rescue,
+                              unsigned int i_region, /*out*/ lsn_t *pi_lsn,
+                              /*out*/ uint32_t *pi_blocks,
+                              /*out*/ cdio_rescue_status_t *p_status);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_RESCUE_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -330,6 +330,13 @@ typedef struct iso_rock_statbuf_s {
                                          number, the lower 16-bits is the
                                          minor device number */
   uint32_t        u_su_fields;        /**< System Use field attributes */
+  bool            b_deferred;         /**< The PX, SL and TF fields have
+                                         not been decoded yet; see
+                                         iso9660_ifs_get_rock_ridge(). */
+  lsn_t           i_dir_lsn;          /**< When b_deferred, the block
+                                         holding the directory record */
+  uint16_t        i_dir_offset;       /**< ... and the offset of the
+                                         record in that block */
 
 } iso_rock_statbuf_t;
 
@@ -385,6 +392,16 @@ int parse_rock_ridge_stat(iso9660_dir_t *de,
 */
 const char *iso9660_get_rock_attr_str(posix_mode_t st_mode);
 
+/*! Size of the buffer iso9660_get_rock_attr_str_r() needs. */
+#define ISO_ROCK_ATTR_STR_SIZE sizeof("drwxrwxrwx")
+
+/*!
+  Reentrant form of iso9660_get_rock_attr_str(): the string is put in
+  psz_buf, which must hold at least ISO_ROCK_ATTR_STR_SIZE bytes, and
+  psz_buf is returned.
+*/
+char *iso9660_get_rock_attr_str_r(posix_mode_t st_mode, char *psz_buf);
+
 /** These variables are not used, but are defined to facilatate debugging
     by letting us use enumerations values (which also correspond to 
     \#define's inside a debugged program.
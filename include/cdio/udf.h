@@ -35,6 +35,7 @@ typedef uint16_t partition_num_t;
 /** Opaque structures. */
 typedef struct udf_s udf_t; 
 typedef struct udf_file_s udf_file_t;
+typedef struct udf_extent_s udf_extent_t;
 
 typedef struct udf_dirent_s {
     char              *psz_name;
@@ -46,8 +47,17 @@ typedef struct udf_dirent_s {
     uint32_t           i_part_start;
     uint32_t           i_loc, i_loc_end;
     uint64_t           dir_left;
+    uint64_t           i_position; /* where udf_read_block() reads next */
     uint8_t           *sector;
     udf_fileid_desc_t *fid;
+    bool               b_fe;     /* true once fe has been read. It is
+                                    read when first needed. */
+    uint32_t           i_fe_lba; /* partition block of fe */
+    uint16_t           i_fe_part; /* and its partition reference number */
+    udf_extent_t      *p_extents; /* Where the file data is, decoded from
+                                     the allocation descriptors on first
+                                     read. Private to libudf. */
+    unsigned int       i_extents;
     
     /* This field has to come last because it is variable in length. */
     udf_file_entry_t   fe;
@@ -111,6 +121,20 @@ extern "C" {
   */
   udf_dirent_t *udf_get_root (udf_t *p_udf, bool b_any_partition, 
                               partition_num_t i_partition);
+
+  /*!
+    UDF 2.50 and later volumes, such as those of Blu-ray discs, keep
+    all file entries and directories in a metadata partition, which
+    is stored as the metadata file. Read all of it into memory, one
+    extent at a time, if it takes no more than i_max_bytes, so that
+    looking up and walking files doesn't read the disc any more.
+
+    Call this before the volume is read from several threads.
+    Return true if the metadata of p_udf is now held in memory;
+    false if it has no metadata partition, if that is too big or if
+    it can't be read. The memory is freed by udf_close().
+  */
+  bool udf_pin_metadata (udf_t *p_udf, uint64_t i_max_bytes);
   
   /**
    * Gets the Volume Identifier string, in 8bit unicode (latin-1)
@@ -138,13 +162,15 @@ extern "C" {
    * psz_logvolid, place to put the string
    * i_logvolid, size of the buffer psz_logvolid points to
    * returns the size of buffer needed for all data
-   * A call to udf_get_root() should have been issued before this call
    */
   int udf_get_logical_volume_id(udf_t *p_udf, /*out*/ char *psz_logvolid,  
                         unsigned int i_logvolid);
 
   /*!
-    Return a file pointer matching psz_name. 
+    Return a file pointer matching psz_name, a path relative to the
+    directory p_udf_root. Directories looked up are cached in the
+    udf_t, so looking up files in them again doesn't read the disc.
+    udf_readdir() on the result returns NULL.
   */
   udf_dirent_t *udf_fopen(udf_dirent_t *p_udf_root, const char *psz_name);
   
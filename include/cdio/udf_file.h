@@ -70,7 +70,8 @@ extern "C" {
      Attempts to read up to count bytes from UDF directory entry
      p_udf_dirent into the buffer starting at buf. buf should be a
      multiple of UDF_BLOCKSIZE bytes. Reading continues after the
-     point at which we last read or from the beginning the first time.
+     point at which we last read p_udf_dirent or from the beginning
+     the first time.
      
      If count is zero, read() returns zero and has no other results. If
      count is greater than SSIZE_MAX, the result is unspecified.
@@ -88,6 +89,29 @@ extern "C" {
   ssize_t udf_read_block(const udf_dirent_t *p_udf_dirent, 
 			 void * buf, size_t count);
 
+  /**
+    Read bytes from the data of a file, starting at a byte offset
+    within that file. Reads are split at the extents of the file;
+    within one, whole blocks are read straight into p_buf and only a
+    partial first and last block go through a block-sized buffer.
+    The file position udf_read_block() uses is left alone.
+
+    @param p_udf_dirent the file, as returned by udf_fopen() or
+    udf_readdir()
+
+    @param p_buf place to put returned data. It should be able to
+    store at least i_len bytes
+
+    @param i_len number of bytes to read
+
+    @param i_offset byte offset within the file to start reading from
+
+    @return number of bytes read, which is less than i_len only at the
+    end of the file, 0 at or past the end of the file, or -1 on error.
+  */
+  ssize_t udf_pread(const udf_dirent_t *p_udf_dirent, void *p_buf,
+                    size_t i_len, uint64_t i_offset);
+
   /**
     Advances p_udf_direct to the the next directory entry in the
     pointed to by p_udf_dir. It also returns this as the value.  NULL
@@ -98,6 +122,53 @@ extern "C" {
   */
   udf_dirent_t *udf_readdir(udf_dirent_t *p_udf_dirent);
   
+  /**
+    Order in which udf_walk() reports directory entries.
+  */
+  typedef enum {
+    UDF_WALK_ORDERED,   /**< As a single-threaded depth-first walk
+                           would: the entries of a directory in on-disk
+                           order, then the walk of each of its
+                           subdirectories in turn. */
+    UDF_WALK_UNORDERED  /**< The entries of each directory as soon as
+                           that directory has been read. */
+  } udf_walk_order_t;
+
+  /**
+    Called by udf_walk() for each entry of each directory.
+
+    psz_dir_path is the path of the directory containing the entry,
+    ending in "/". p_udf_dirent is a copy of the entry as udf_readdir()
+    returned it, the parent directory entry included. It can be passed
+    to the udf_get_...() and udf_is_dir() accessors, but not to
+    udf_readdir() or udf_opendir(); it is only valid during the call
+    and must not be freed.
+
+    Return 0 to continue or non-zero to stop the walk.
+  */
+  typedef int (*udf_walk_visitor_t)(const char psz_dir_path[],
+                                    const udf_dirent_t *p_udf_dirent,
+                                    void *p_user_data);
+
+  /**
+    Walk the directory tree below psz_path, looked up from p_udf_root
+    as by udf_fopen(), calling visitor for every entry found.
+
+    Directories are read by i_threads worker threads which share out
+    the directories still to be read among themselves. When the UDF
+    was opened from an image file, directory reads don't move the file
+    position and run concurrently; reads from a device always happen
+    on one thread. visitor itself is always called on the calling
+    thread, one entry at a time.
+
+    Return 0 if the whole tree was visited, the value visitor returned
+    if it stopped the walk, or -1 if psz_path is not a directory or
+    memory ran out.
+  */
+  int udf_walk(udf_dirent_t *p_udf_root, const char psz_path[],
+               udf_walk_visitor_t visitor, void *p_user_data,
+               unsigned int i_threads, udf_walk_order_t order);
+
   /**
     free free resources associated with p_udf_dirent.
   */
@@ -95,6 +95,29 @@ bool cdio_charset_from_utf8(cdio_utf8_t * src, char ** dst,
 bool cdio_charset_to_utf8(const char *src, size_t src_len, cdio_utf8_t **dst,
                           const char * src_charset);
 
+/** \brief Size of a buffer big enough for cdio_utf16be_to_utf8()
+ *  \param src_len Length of the source string in bytes
+ */
+#define CDIO_UTF16BE_TO_UTF8_SIZE(src_len) (3 * ((src_len) / 2) + 1)
+
+/** \brief Convert a UCS-2BE or UTF-16BE string to UTF-8
+ *  \param src Source string
+ *  \param src_len Length of the source string in bytes
+ *  \param dst Destination buffer of at least
+ *  CDIO_UTF16BE_TO_UTF8_SIZE(src_len) bytes
+ *  \returns the length of the destination string, not counting the
+ *  terminating 0.
+ *
+ *  Unlike cdio_charset_to_utf8(), this needs neither iconv nor any
+ *  memory allocation, which makes it suitable for decoding large
+ *  numbers of short strings such as Joliet or UDF file names.
+ *  Unpaired surrogates are replaced by U+FFFD and an odd trailing
+ *  byte is ignored.
+ */
+
+size_t cdio_utf16be_to_utf8(const uint8_t *src, size_t src_len,
+                            cdio_utf8_t *dst);
+
 #ifdef _WIN32
 /** \brief Convert an UTF8 string to UTF-16 (allocate returned string)
  *  \param str Source string
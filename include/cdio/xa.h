@@ -143,6 +143,17 @@ typedef struct iso9660_xa_s
 */
 const char *
 iso9660_get_xa_attr_str (uint16_t xa_attr);
+
+/*! Size of the buffer iso9660_get_xa_attr_str_r() needs. */
+#define ISO_XA_ATTR_STR_SIZE sizeof("d---1xrxrxr")
+
+/*!
+  Reentrant form of iso9660_get_xa_attr_str(): the string is put in
+  psz_buf, which must hold at least ISO_XA_ATTR_STR_SIZE bytes, and
+  psz_buf is returned.
+*/
+char *
+iso9660_get_xa_attr_str_r (uint16_t xa_attr, char *psz_buf);
   
 /*! 
   Allocates and initalizes a new iso9600_xa_t variable and returns
@@ -65,6 +65,10 @@
 #define CDIO_LSEEK lseek
 #endif
 
+/* Memory used for O_DIRECT reads is aligned to this. A page is enough
+   for any logical block size a CD or DVD device has. */
+#define CDIO_DIRECT_IO_ALIGN 4096
+
 /*!
   Eject media -- there's nothing to do here. We always return -2.
   Should we also free resources?
@@ -156,9 +160,7 @@ cdio_generic_init (void *user_data, int open_flags)
 driver_return_code_t
 cdio_generic_read_form1_sector (void * user_data, void *data, lsn_t lsn)
 {
-  if (0 > cdio_generic_lseek(user_data, CDIO_CD_FRAMESIZE*lsn, SEEK_SET))
-    return DRIVER_OP_ERROR;
-  return cdio_generic_read(user_data, data, CDIO_CD_FRAMESIZE);
+  return cdio_generic_read_blocks(user_data, data, lsn, CDIO_CD_FRAMESIZE, 1);
 }
 
 /*!
@@ -511,12 +513,92 @@ driver_return_code_t
 read_data_sectors_generic (void *p_user_data, void *p_buf, lsn_t i_lsn,
                            uint16_t i_blocksize, uint32_t i_blocks)
 {
-  int rc;
-  if (0 > cdio_generic_lseek(p_user_data, i_blocksize*i_lsn, SEEK_SET))
-    return DRIVER_OP_ERROR;
-  rc = cdio_generic_read(p_user_data, p_buf, i_blocksize*i_blocks);
-  if (rc > 0) return DRIVER_OP_SUCCESS;
-  return DRIVER_OP_ERROR;
+  return cdio_generic_read_blocks(p_user_data, p_buf, i_lsn, i_blocksize,
+                                  i_blocks);
+}
+
+/* Read exactly i_size bytes at i_offset, going on after short reads.
+   Returns false on an error or if the device ends first. */
+static bool
+read_fully_generic (generic_img_private_t *p_env, uint8_t *p_buf,
+                    size_t i_size, off_t i_offset)
+{
+  size_t i_done = 0;
+
+#ifndef HAVE_PREAD
+  if (0 > cdio_generic_lseek(p_env, i_offset, SEEK_SET)) {
+    cdio_warn ("lseek (%s): %s", p_env->source_name, strerror (errno));
+    return false;
+  }
+#endif
+
+  while (i_done < i_size) {
+#ifdef HAVE_PREAD
+    ssize_t i_read = pread(p_env->fd, p_buf + i_done, i_size - i_done,
+                           i_offset + i_done);
+#else
+    ssize_t i_read = read(p_env->fd, p_buf + i_done, i_size - i_done);
+#endif
+    if (i_read < 0) {
+      if (EINTR == errno) continue;
+      cdio_warn ("read (%s) at byte %lld: %s", p_env->source_name,
+                 (long long int) (i_offset + i_done), strerror (errno));
+      return false;
+    }
+    if (0 == i_read) {
+      cdio_debug ("read (%s): end of device at byte %lld",
+                  p_env->source_name, (long long int) (i_offset + i_done));
+      return false;
+    }
+    i_done += i_read;
+  }
+  return true;
+}
+
+driver_return_code_t
+cdio_generic_read_blocks (void *p_user_data, void *p_buf, lsn_t i_lsn,
+                          uint16_t i_blocksize, uint32_t i_blocks)
+{
+  generic_img_private_t *p_env = p_user_data;
+  uint32_t i_chunk = i_blocks;
+  uint8_t *p_bounce = NULL;
+  uint8_t *p_aligned = NULL;
+  driver_return_code_t rc = DRIVER_OP_SUCCESS;
+  uint32_t i;
+
+  if (!p_env || p_env->fd < 0) return DRIVER_OP_UNINIT;
+  if (i_lsn < 0 || 0 == i_blocksize) return DRIVER_OP_BAD_PARAMETER;
+  if (0 == i_blocks) return DRIVER_OP_SUCCESS;
+
+  /* Stay within what the device takes in one request; the kernel
+     would split anything larger anyway. */
+  if (p_env->cdio && p_env->cdio->i_max_transfer >= i_blocksize
+      && p_env->cdio->i_max_transfer / i_blocksize < i_chunk)
+    i_chunk = p_env->cdio->i_max_transfer / i_blocksize;
+
+  if (p_env->b_direct_io
+      && 0 != (uintptr_t) p_buf % CDIO_DIRECT_IO_ALIGN) {
+    p_bounce = malloc((size_t) i_chunk * i_blocksize + CDIO_DIRECT_IO_ALIGN);
+    if (!p_bounce) return DRIVER_OP_ERROR;
+    p_aligned = p_bounce + CDIO_DIRECT_IO_ALIGN
+      - (uintptr_t) p_bounce % CDIO_DIRECT_IO_ALIGN;
+  }
+
+  for (i = 0; i < i_blocks; i += i_chunk) {
+    const uint32_t i_now = (i_blocks - i < i_chunk) ? i_blocks - i : i_chunk;
+    const size_t i_size = (size_t) i_now * i_blocksize;
+    uint8_t *p_dest = (uint8_t *) p_buf + (size_t) i * i_blocksize;
+
+    if (!read_fully_generic(p_env, p_aligned ? p_aligned : p_dest, i_size,
+                            ((off_t) i_lsn + i) * i_blocksize)) {
+      rc = DRIVER_OP_ERROR;
+      break;
+    }
+    if (p_aligned) memcpy(p_dest, p_aligned, i_size);
+  }
+
+  free(p_bounce);
+  return rc;
 }
 
 
@@ -231,6 +231,41 @@ _stdio_read(void *user_data, void *buf, size_t count)
   return read_count;
 }
 
+#ifdef HAVE_PREAD
+/*!
+  Like pread(2) on the underlying file descriptor. The FILE position
+  and its buffer are left alone, so concurrent callers don't interfere
+  with each other or with _stdio_read().
+  */
+static ssize_t
+_stdio_pread(void *user_data, void *buf, size_t count, off_t offset)
+{
+  _UserData *const ud = user_data;
+  size_t done = 0;
+
+  while (done < count)
+    {
+      ssize_t ret = pread(fileno(ud->fd), (uint8_t *) buf + done,
+                          count - done, offset + done);
+      if (ret < 0)
+        {
+          if (EINTR == errno)
+            continue;
+          cdio_error ("pread (): %s", strerror (errno));
+          break;
+        }
+      if (0 == ret)
+        {
+          cdio_debug ("pread (): EOF encountered");
+          break;
+        }
+      done += ret;
+    }
+
+  return done;
+}
+#endif
+
 /*!
   Deallocate resources assocaited with obj. After this obj is unusable.
 */
@@ -244,7 +279,7 @@ CdioDataSource_t *
 cdio_stdio_new(const char pathname[])
 {
   CdioDataSource_t *new_obj = NULL;
-  cdio_stream_io_functions funcs = { NULL, NULL, NULL, NULL, NULL, NULL };
+  cdio_stream_io_functions funcs = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
   _UserData *ud = NULL;
   struct CDIO_STAT_STRUCT statbuf;
   char* pathdup;
@@ -277,6 +312,9 @@ cdio_stdio_new(const char pathname[])
   funcs.read   = _stdio_read;
   funcs.close  = _stdio_close;
   funcs.free   = _stdio_free;
+#ifdef HAVE_PREAD
+  funcs.pread  = _stdio_pread;
+#endif
 
   new_obj = cdio_stream_new(ud, &funcs);
 
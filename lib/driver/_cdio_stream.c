@@ -33,6 +33,9 @@
 #ifdef HAVE_STDARG_H
 #include <stdarg.h>
 #endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 #include "cdio_assert.h"
 
 /* #define STREAM_DEBUG  */
@@ -50,8 +53,19 @@ struct _CdioDataSource {
   cdio_stream_io_functions op;
   int is_open;
   off_t position;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t lock; /* serializes cdio_stream_pread() emulation */
+#endif
 };
 
+#ifdef HAVE_PTHREAD
+#define STREAM_LOCK(p_obj)   pthread_mutex_lock(&(p_obj)->lock)
+#define STREAM_UNLOCK(p_obj) pthread_mutex_unlock(&(p_obj)->lock)
+#else
+#define STREAM_LOCK(p_obj)
+#define STREAM_UNLOCK(p_obj)
+#endif
+
 void
 cdio_stream_close(CdioDataSource_t *p_obj)
 {
@@ -74,6 +88,9 @@ cdio_stream_destroy(CdioDataSource_t *p_obj)
 
   p_obj->op.free(p_obj->user_data);
   p_obj->user_data = NULL;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_destroy(&p_obj->lock);
+#endif
   free(p_obj);
 }
 
@@ -103,6 +120,9 @@ cdio_stream_new(void *user_data, const cdio_stream_io_functions *funcs)
 
   new_obj->user_data = user_data;
   memcpy(&(new_obj->op), funcs, sizeof(cdio_stream_io_functions));
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&new_obj->lock, NULL);
+#endif
 
   return new_obj;
 }
@@ -160,6 +180,53 @@ cdio_stream_read(CdioDataSource_t* p_obj, void *ptr, size_t size, size_t nmemb)
   return read_bytes;
 }
 
+/**
+  Like pread(2): read size * nmemb bytes starting at byte offset
+  i_offset without using or changing the stream position.
+
+  Several threads may call this on the same stream at the same
+  time. When the stream has no positionless read operation of its
+  own, the read is emulated with seek and read under a lock and the
+  previous position is restored afterwards.
+
+  @return the number of bytes read, which is short (or zero) on
+  end-of-file or error.
+*/
+ssize_t
+cdio_stream_pread(CdioDataSource_t* p_obj, void *ptr, size_t size,
+                  size_t nmemb, off_t i_offset)
+{
+  ssize_t read_bytes = 0;
+
+  if (!p_obj) return 0;
+  if (i_offset < 0) return 0;
+
+  STREAM_LOCK(p_obj);
+  if (!_cdio_stream_open_if_necessary(p_obj)) {
+    STREAM_UNLOCK(p_obj);
+    return 0;
+  }
+
+  if (p_obj->op.pread) {
+    STREAM_UNLOCK(p_obj);
+    return p_obj->op.pread(p_obj->user_data, ptr, size*nmemb, i_offset);
+  }
+
+  {
+    const off_t i_saved = p_obj->position;
+
+    if (0 == cdio_stream_seek(p_obj, i_offset, SEEK_SET)) {
+      read_bytes = (p_obj->op.read)(p_obj->user_data, ptr, size*nmemb);
+      p_obj->position += read_bytes;
+    }
+    if (i_saved >= 0)
+      cdio_stream_seek(p_obj, i_saved, SEEK_SET);
+  }
+  STREAM_UNLOCK(p_obj);
+
+  return read_bytes;
+}
+
 /**
   Like 3 fseek and in fact may be the same.
 
@@ -43,6 +43,9 @@ extern "C" {
   
   typedef void(*cdio_data_free_t)(void *user_data);
   
+  typedef ssize_t(*cdio_data_pread_t)(void *user_data, void *buf,
+                                      size_t count, off_t offset);
+  
   
   /* abstract data source */
   
@@ -53,6 +56,7 @@ extern "C" {
     cdio_data_read_t read;
     cdio_data_close_t close;
     cdio_data_free_t free;
+    cdio_data_pread_t pread; /* optional; may be NULL */
   } cdio_stream_io_functions;
   
   /**
@@ -90,6 +94,20 @@ extern "C" {
   ssize_t cdio_stream_read(CdioDataSource_t* p_obj, void *ptr, size_t i_size, 
                            size_t nmemb);
   
+  /**
+    Like pread(2): read i_size * nmemb bytes starting at byte offset
+    i_offset without using or changing the stream position.
+
+    Several threads may call this on the same stream at the same
+    time. When the stream has no positionless read operation of its
+    own, the read is emulated with seek and read under a lock.
+
+    @return the number of bytes read, which is short (or zero) on
+    end-of-file or error.
+  */
+  ssize_t cdio_stream_pread(CdioDataSource_t* p_obj, void *ptr, size_t i_size,
+                            size_t nmemb, off_t i_offset);
+
   /** 
     Like fseek(3)/fseeko(3) and in fact may be the same.
 
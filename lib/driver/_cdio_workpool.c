@@ -0,0 +1,345 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include "_cdio_workpool.h"
+
+/* A growable array of tasks used as a double-ended queue: the owner
+   pushes and pops at the tail, thieves take from the head. */
+typedef struct {
+  void  **pp_task;
+  size_t  i_head;
+  size_t  i_tail;
+  size_t  i_alloc;
+} workpool_queue_t;
+
+struct _CdioWorkPool;
+
+typedef struct {
+  struct _CdioWorkPool *p_pool;
+  unsigned int i_worker;
+#ifdef HAVE_PTHREAD
+  pthread_t thread;
+#endif
+} workpool_worker_t;
+
+struct _CdioWorkPool {
+  unsigned int         i_threads;
+  cdio_work_fn_t       work;
+  cdio_work_done_fn_t  done;
+  void                *p_user_data;
+  workpool_queue_t    *p_queue;    /* one per worker */
+  workpool_worker_t   *p_worker;
+  workpool_queue_t     finished;   /* tasks waiting for the done callback */
+  unsigned long        i_queued;   /* tasks in the worker queues */
+  unsigned long        i_pending;  /* tasks not yet through done callback */
+  bool                 b_stop;
+  bool                 b_lost;     /* a finished task couldn't be queued */
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t      lock;
+  pthread_cond_t       work_cond;  /* signalled when a task is queued */
+  pthread_cond_t       done_cond;  /* signalled when a task has finished */
+#endif
+};
+
+#ifdef HAVE_PTHREAD
+#define POOL_LOCK(p)   pthread_mutex_lock(&(p)->lock)
+#define POOL_UNLOCK(p) pthread_mutex_unlock(&(p)->lock)
+#else
+#define POOL_LOCK(p)
+#define POOL_UNLOCK(p)
+#endif
+
+static bool
+_queue_push(workpool_queue_t *p_queue, void *p_task)
+{
+  if (p_queue->i_tail == p_queue->i_alloc) {
+    if (p_queue->i_head > 0) {
+      /* Reuse the room left by stolen tasks. */
+      memmove(p_queue->pp_task, p_queue->pp_task + p_queue->i_head,
+              (p_queue->i_tail - p_queue->i_head) * sizeof(void *));
+      p_queue->i_tail -= p_queue->i_head;
+      p_queue->i_head  = 0;
+    } else {
+      size_t i_alloc = p_queue->i_alloc ? 2 * p_queue->i_alloc : 32;
+      void **pp_task = realloc(p_queue->pp_task, i_alloc * sizeof(void *));
+      if (!pp_task) {
+        cdio_warn("Couldn't realloc(%lu)",
+                  (unsigned long) (i_alloc * sizeof(void *)));
+        return false;
+      }
+      p_queue->pp_task = pp_task;
+      p_queue->i_alloc = i_alloc;
+    }
+  }
+  p_queue->pp_task[p_queue->i_tail++] = p_task;
+  return true;
+}
+
+/* Take the newest task. */
+static void *
+_queue_pop(workpool_queue_t *p_queue)
+{
+  if (p_queue->i_head == p_queue->i_tail) return NULL;
+  return p_queue->pp_task[--p_queue->i_tail];
+}
+
+/* Take the oldest task. */
+static void *
+_queue_steal(workpool_queue_t *p_queue)
+{
+  void *p_task;
+
+  if (p_queue->i_head == p_queue->i_tail) return NULL;
+  p_task = p_queue->pp_task[p_queue->i_head++];
+  if (p_queue->i_head == p_queue->i_tail)
+    p_queue->i_head = p_queue->i_tail = 0;
+  return p_task;
+}
+
+/* Find a task for worker i_worker: its own newest, else the oldest of
+   the next worker that has any. The pool lock must be held and
+   i_queued must be non-zero. */
+static void *
+_workpool_take(CdioWorkPool_t *p_pool, unsigned int i_worker)
+{
+  void *p_task = _queue_pop(&p_pool->p_queue[i_worker]);
+  unsigned int i;
+
+  for (i = 1; !p_task && i < p_pool->i_threads; i++)
+    p_task = _queue_steal(&p_pool->p_queue[(i_worker + i)
+                                           % p_pool->i_threads]);
+  if (p_task)
+    p_pool->i_queued--;
+  return p_task;
+}
+
+CdioWorkPool_t *
+cdio_workpool_new(unsigned int i_threads, cdio_work_fn_t work,
+                  cdio_work_done_fn_t done, void *p_user_data)
+{
+  CdioWorkPool_t *p_pool;
+
+  if (!work || !done) return NULL;
+  if (0 == i_threads) i_threads = 1;
+#ifndef HAVE_PTHREAD
+  i_threads = 1;
+#endif
+
+  p_pool = calloc(1, sizeof(CdioWorkPool_t));
+  if (!p_pool) {
+    cdio_warn("Couldn't calloc(1, %lu)",
+              (unsigned long) sizeof(CdioWorkPool_t));
+    return NULL;
+  }
+  p_pool->p_queue  = calloc(i_threads, sizeof(workpool_queue_t));
+  p_pool->p_worker = calloc(i_threads, sizeof(workpool_worker_t));
+  if (!p_pool->p_queue || !p_pool->p_worker) {
+    cdio_warn("Couldn't calloc(%u, %lu)", i_threads,
+              (unsigned long) sizeof(workpool_queue_t));
+    free(p_pool->p_queue);
+    free(p_pool->p_worker);
+    free(p_pool);
+    return NULL;
+  }
+
+  p_pool->i_threads   = i_threads;
+  p_pool->work        = work;
+  p_pool->done        = done;
+  p_pool->p_user_data = p_user_data;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&p_pool->lock, NULL);
+  pthread_cond_init(&p_pool->work_cond, NULL);
+  pthread_cond_init(&p_pool->done_cond, NULL);
+#endif
+  return p_pool;
+}
+
+bool
+cdio_workpool_push(CdioWorkPool_t *p_pool, unsigned int i_worker,
+                   void *p_task)
+{
+  bool b_ok;
+
+  if (!p_pool) return false;
+
+  POOL_LOCK(p_pool);
+  b_ok = _queue_push(&p_pool->p_queue[i_worker % p_pool->i_threads],
+                     p_task);
+  if (b_ok) {
+    p_pool->i_queued++;
+    p_pool->i_pending++;
+#ifdef HAVE_PTHREAD
+    pthread_cond_signal(&p_pool->work_cond);
+#endif
+  }
+  POOL_UNLOCK(p_pool);
+  return b_ok;
+}
+
+/* Run everything on the calling thread. */
+static int
+_workpool_run_inline(CdioWorkPool_t *p_pool)
+{
+  void *p_task;
+
+  while (p_pool->i_queued > 0) {
+    int i_rc;
+
+    p_task = _workpool_take(p_pool, 0);
+    p_pool->work(p_task, 0, p_pool->p_user_data);
+    p_pool->i_pending--;
+    i_rc = p_pool->done(p_task, p_pool->p_user_data);
+    if (i_rc) return i_rc;
+  }
+  return 0;
+}
+
+#ifdef HAVE_PTHREAD
+static void *
+_workpool_thread(void *p_arg)
+{
+  workpool_worker_t *p_worker = p_arg;
+  CdioWorkPool_t *p_pool = p_worker->p_pool;
+
+  POOL_LOCK(p_pool);
+  for (;;) {
+    void *p_task;
+
+    while (!p_pool->b_stop && 0 == p_pool->i_queued)
+      pthread_cond_wait(&p_pool->work_cond, &p_pool->lock);
+    if (p_pool->b_stop) break;
+
+    p_task = _workpool_take(p_pool, p_worker->i_worker);
+    POOL_UNLOCK(p_pool);
+
+    p_pool->work(p_task, p_worker->i_worker, p_pool->p_user_data);
+
+    POOL_LOCK(p_pool);
+    if (!_queue_push(&p_pool->finished, p_task))
+      p_pool->b_lost = true;
+    pthread_cond_signal(&p_pool->done_cond);
+  }
+  POOL_UNLOCK(p_pool);
+  return NULL;
+}
+#endif
+
+int
+cdio_workpool_run(CdioWorkPool_t *p_pool)
+{
+  int i_rc = 0;
+#ifdef HAVE_PTHREAD
+  unsigned int i, i_started = 0;
+#endif
+
+  if (!p_pool) return 0;
+
+#ifdef HAVE_PTHREAD
+  if (p_pool->i_threads > 1) {
+    p_pool->b_stop = false;
+    for (i = 0; i < p_pool->i_threads; i++) {
+      workpool_worker_t *p_worker = &p_pool->p_worker[i];
+      p_worker->p_pool   = p_pool;
+      p_worker->i_worker = i;
+      if (0 != pthread_create(&p_worker->thread, NULL, _workpool_thread,
+                              p_worker))
+        break;
+      i_started++;
+    }
+  }
+
+  if (0 == i_started)
+    return _workpool_run_inline(p_pool);
+
+  if (i_started < p_pool->i_threads)
+    cdio_info("only %u of %u worker threads could be started",
+              i_started, p_pool->i_threads);
+
+  POOL_LOCK(p_pool);
+  while (0 == i_rc) {
+    void *p_task;
+
+    while (0 == i_rc && (p_task = _queue_steal(&p_pool->finished))) {
+      POOL_UNLOCK(p_pool);
+      i_rc = p_pool->done(p_task, p_pool->p_user_data);
+      POOL_LOCK(p_pool);
+      p_pool->i_pending--;
+    }
+    if (i_rc || 0 == p_pool->i_pending) break;
+    if (p_pool->b_lost) {
+      i_rc = DRIVER_OP_ERROR;
+      break;
+    }
+    pthread_cond_wait(&p_pool->done_cond, &p_pool->lock);
+  }
+  p_pool->b_stop = true;
+  pthread_cond_broadcast(&p_pool->work_cond);
+  POOL_UNLOCK(p_pool);
+
+  for (i = 0; i < i_started; i++)
+    pthread_join(p_pool->p_worker[i].thread, NULL);
+  return i_rc;
+#else
+  return _workpool_run_inline(p_pool);
+#endif
+}
+
+void
+cdio_workpool_free(CdioWorkPool_t *p_pool)
+{
+  unsigned int i;
+
+  if (!p_pool) return;
+
+  for (i = 0; i < p_pool->i_threads; i++)
+    free(p_pool->p_queue[i].pp_task);
+  free(p_pool->finished.pp_task);
+  free(p_pool->p_queue);
+  free(p_pool->p_worker);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_destroy(&p_pool->lock);
+  pthread_cond_destroy(&p_pool->work_cond);
+  pthread_cond_destroy(&p_pool->done_cond);
+#endif
+  free(p_pool);
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,111 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* A small work-stealing thread pool, shared by the filesystem
+   libraries for things like parallel directory tree walks.
+
+   Every worker has its own queue. A worker takes the task it queued
+   most recently from its own queue and, when that is empty, steals
+   the oldest task from another worker's queue. Each finished task is
+   handed back to the thread that called cdio_workpool_run(), one at
+   a time, so that results can be consumed without further locking.
+
+   Without POSIX threads, or when a single thread is asked for, the
+   tasks are run on the calling thread instead.
+*/
+
+#ifndef CDIO_WORKPOOL_H_
+#define CDIO_WORKPOOL_H_
+
+#include <cdio/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+  typedef struct _CdioWorkPool CdioWorkPool_t;
+
+  /**
+     Run p_task. This is called on a worker thread; i_worker
+     identifies that worker and should be passed to
+     cdio_workpool_push() for any tasks p_task gives rise to.
+  */
+  typedef void (*cdio_work_fn_t)(void *p_task, unsigned int i_worker,
+                                 void *p_user_data);
+
+  /**
+     Consume the result of a finished p_task. This is called on the
+     thread running cdio_workpool_run(), one task at a time. Return
+     non-zero to stop: no further tasks are started and
+     cdio_workpool_run() returns that value.
+  */
+  typedef int (*cdio_work_done_fn_t)(void *p_task, void *p_user_data);
+
+  /**
+     Create a pool of i_threads workers. Nothing is started until
+     cdio_workpool_run() is called.
+
+     @return the new pool or NULL if out of memory. Free it with
+     cdio_workpool_free().
+  */
+  CdioWorkPool_t *cdio_workpool_new(unsigned int i_threads,
+                                    cdio_work_fn_t work,
+                                    cdio_work_done_fn_t done,
+                                    void *p_user_data);
+
+  /**
+     Queue p_task on the queue of worker i_worker. Before
+     cdio_workpool_run() is called, any i_worker may be used to seed
+     the pool.
+
+     @return false if out of memory, in which case p_task is not
+     queued.
+  */
+  bool cdio_workpool_push(CdioWorkPool_t *p_pool, unsigned int i_worker,
+                          void *p_task);
+
+  /**
+     Run queued tasks, and the tasks they queue in turn, until all
+     have been passed to the done callback or that callback asks to
+     stop. Tasks still queued when stopping are dropped; they remain
+     owned by the caller.
+
+     @return 0 when all tasks finished, the value returned by the
+     done callback if it asked to stop, or DRIVER_OP_ERROR if a
+     finished task could not be handed back for lack of memory.
+  */
+  int cdio_workpool_run(CdioWorkPool_t *p_pool);
+
+  /**
+     Free p_pool. It must not be running.
+  */
+  void cdio_workpool_free(CdioWorkPool_t *p_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_WORKPOOL_H_ */
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -943,6 +943,7 @@ cdio_open_am_aix (const char *psz_orig_source, const char *access_mode)
 
   cdio_funcs_t _funcs;
 
+  memset(&_funcs, 0, sizeof(_funcs));
   _funcs.eject_media        = eject_media_aix;
   _funcs.free               = cdio_generic_free;
   _funcs.get_arg            = get_arg_aix;
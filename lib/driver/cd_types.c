@@ -69,9 +69,9 @@ and
 cdio_fs_cap_t debug_cdio_fs_cap;
 cdio_fs_t     debug_cdio_fs;
 
-static char buffer[6][CDIO_CD_FRAMESIZE_RAW];  /* for CD-Data */
-
-/* Some interesting sector numbers stored in the above buffer. */
+/* cdio_guess_cd_type() reads the sectors it examines into a
+   char buffer[6][CDIO_CD_FRAMESIZE_RAW] of its own, which is passed to
+   the helpers below. Some interesting sector numbers stored there: */
 #define ISO_SUPERBLOCK_SECTOR  16  /* buffer[0] */
 #define UFS_SUPERBLOCK_SECTOR   4  /* buffer[2] */
 #define BOOT_SECTOR            17  /* buffer[3] */
@@ -129,12 +129,13 @@ static const signature_t sigs[] =
 
 
 /*
-   Read a particular block into the global array to be used for further
+   Read a particular block into buffer[bufnum] to be used for further
    analysis later.
 */
 static driver_return_code_t
-_cdio_read_block(const CdIo_t *p_cdio, int superblock, uint32_t offset,
-		 uint8_t bufnum, track_t i_track)
+_cdio_read_block(const CdIo_t *p_cdio, char buffer[][CDIO_CD_FRAMESIZE_RAW],
+		 int superblock, uint32_t offset, uint8_t bufnum,
+		 track_t i_track)
 {
   unsigned int track_sec_count = cdio_get_track_sec_count(p_cdio, i_track);
   memset(buffer[bufnum], 0, CDIO_CD_FRAMESIZE);
@@ -157,7 +158,7 @@ _cdio_read_block(const CdIo_t *p_cdio, int superblock, uint32_t offset,
    matches index "num".
  */
 static bool
-_cdio_is_it(int num)
+_cdio_is_it(char buffer[][CDIO_CD_FRAMESIZE_RAW], int num)
 {
   const signature_t *sigp=&sigs[num];
   int len=strlen(sigp->sig_str);
@@ -167,7 +168,7 @@ _cdio_is_it(int num)
 }
 
 static int
-_cdio_is_hfs(void)
+_cdio_is_hfs(char buffer[][CDIO_CD_FRAMESIZE_RAW])
 {
   return (0 == memcmp(&buffer[1][512],"PM",2)) ||
     (0 == memcmp(&buffer[1][512],"TS",2)) ||
@@ -175,27 +176,27 @@ _cdio_is_hfs(void)
 }
 
 static int
-_cdio_is_3do(void)
+_cdio_is_3do(char buffer[][CDIO_CD_FRAMESIZE_RAW])
 {
   return (0 == memcmp(&buffer[1][0],"\x01\x5a\x5a\x5a\x5a\x5a\x01", 7)) &&
     (0 == memcmp(&buffer[1][40], "CD-ROM", 6));
 }
 
 static int
-_cdio_is_joliet(void)
+_cdio_is_joliet(char buffer[][CDIO_CD_FRAMESIZE_RAW])
 {
   return 2 == buffer[3][0] && buffer[3][88] == 0x25 && buffer[3][89] == 0x2f;
 }
 
 static int
-_cdio_is_UDF(void)
+_cdio_is_UDF(char buffer[][CDIO_CD_FRAMESIZE_RAW])
 {
   return 2 == ((uint16_t)buffer[5][0] | ((uint16_t)buffer[5][1] << 8));
 }
 
 /* ISO 9660 volume space in M2F1_SECTOR_SIZE byte units */
 static int
-_cdio_get_iso9660_fs_sec_count(void)
+_cdio_get_iso9660_fs_sec_count(char buffer[][CDIO_CD_FRAMESIZE_RAW])
 {
   return ((buffer[0][80] & 0xff) |
 	 ((buffer[0][81] & 0xff) << 8) |
@@ -204,7 +205,7 @@ _cdio_get_iso9660_fs_sec_count(void)
 }
 
 static uint8_t
-_cdio_get_joliet_level( void )
+_cdio_get_joliet_level(char buffer[][CDIO_CD_FRAMESIZE_RAW])
 {
   switch (buffer[3][90]) {
   case 0x40: return 1;
@@ -223,6 +224,7 @@ cdio_fs_anal_t
 cdio_guess_cd_type(const CdIo_t *p_cdio, int start_session, track_t i_track,
 		   /*out*/ cdio_iso_analysis_t *iso_analysis)
 {
+  char buffer[6][CDIO_CD_FRAMESIZE_RAW] = { { 0, }, };  /* for CD-Data */
   int ret = CDIO_FS_UNKNOWN;
   bool sector0_read_ok;
 
@@ -230,26 +232,28 @@ cdio_guess_cd_type(const CdIo_t *p_cdio, int start_session, track_t i_track,
     return CDIO_FS_AUDIO;
 
   if ( DRIVER_OP_SUCCESS !=
-       _cdio_read_block(p_cdio, ISO_PVD_SECTOR, start_session, 0, i_track) )
+       _cdio_read_block(p_cdio, buffer, ISO_PVD_SECTOR, start_session, 0,
+			i_track) )
     return CDIO_FS_UNKNOWN;
 
-  if ( _cdio_is_it(INDEX_XISO) )
+  if ( _cdio_is_it(buffer, INDEX_XISO) )
     return CDIO_FS_ANAL_XISO;
 
-  if ( DRIVER_OP_SUCCESS != _cdio_read_block(p_cdio, ISO_SUPERBLOCK_SECTOR,
+  if ( DRIVER_OP_SUCCESS != _cdio_read_block(p_cdio, buffer,
+					     ISO_SUPERBLOCK_SECTOR,
 					     start_session, 0, i_track) )
     return ret;
 
-  if ( _cdio_is_it(INDEX_UDF) ) {
+  if ( _cdio_is_it(buffer, INDEX_UDF) ) {
     /* Detect UDF version
        Test if we have a valid version of UDF the xbox can read natively */
-    if (_cdio_read_block(p_cdio, 35, start_session, 5, i_track) < 0)
+    if (_cdio_read_block(p_cdio, buffer, 35, start_session, 5, i_track) < 0)
       return CDIO_FS_UNKNOWN;
 
      iso_analysis->UDFVerMinor=(unsigned int)buffer[5][240];
      iso_analysis->UDFVerMajor=(unsigned int)buffer[5][241];
      /*	Read disc label */
-     if (_cdio_read_block(p_cdio, 32, start_session, 5, i_track) < 0)
+     if (_cdio_read_block(p_cdio, buffer, 32, start_session, 5, i_track) < 0)
        return CDIO_FS_UDF;
 
      strncpy(iso_analysis->iso_label, buffer[5]+25, 33);
@@ -258,38 +262,41 @@ cdio_guess_cd_type(const CdIo_t *p_cdio, int start_session, track_t i_track,
    }
 
   /* We have something that smells of a filesystem. */
-  if (_cdio_is_it(INDEX_CD_I) && _cdio_is_it(INDEX_CD_RTOS)
-      && !_cdio_is_it(INDEX_BRIDGE) && !_cdio_is_it(INDEX_XA)) {
+  if (_cdio_is_it(buffer, INDEX_CD_I) && _cdio_is_it(buffer, INDEX_CD_RTOS)
+      && !_cdio_is_it(buffer, INDEX_BRIDGE)
+      && !_cdio_is_it(buffer, INDEX_XA)) {
     return (CDIO_FS_INTERACTIVE | CDIO_FS_ANAL_ISO9660_ANY);
   } else {
     /* read sector 0 ONLY, when NO greenbook CD-I !!!! */
 
     sector0_read_ok =
-      _cdio_read_block(p_cdio, 0, start_session, 1, i_track) == 0;
+      _cdio_read_block(p_cdio, buffer, 0, start_session, 1, i_track) == 0;
 
-    if (_cdio_is_it(INDEX_HS))
+    if (_cdio_is_it(buffer, INDEX_HS))
       ret |= CDIO_FS_HIGH_SIERRA;
-    else if (_cdio_is_it(INDEX_ISOFS)) {
-      if (_cdio_is_it(INDEX_CD_RTOS) && _cdio_is_it(INDEX_BRIDGE))
+    else if (_cdio_is_it(buffer, INDEX_ISOFS)) {
+      if (_cdio_is_it(buffer, INDEX_CD_RTOS)
+	  && _cdio_is_it(buffer, INDEX_BRIDGE))
 	ret = (CDIO_FS_ISO_9660_INTERACTIVE | CDIO_FS_ANAL_ISO9660_ANY);
-      else if (_cdio_is_hfs())
+      else if (_cdio_is_hfs(buffer))
 	ret = CDIO_FS_ISO_HFS;
       else
 	ret = (CDIO_FS_ISO_9660 | CDIO_FS_ANAL_ISO9660_ANY);
-      iso_analysis->isofs_size = _cdio_get_iso9660_fs_sec_count();
+      iso_analysis->isofs_size = _cdio_get_iso9660_fs_sec_count(buffer);
       strncpy(iso_analysis->iso_label, buffer[0]+40,33);
       iso_analysis->iso_label[32] = '\0';
 
-      if ( _cdio_read_block(p_cdio, UDF_ANCHOR_SECTOR, start_session, 5,
-			    i_track) < 0)
+      if ( _cdio_read_block(p_cdio, buffer, UDF_ANCHOR_SECTOR, start_session,
+			    5, i_track) < 0)
 	return ret;
 
       /* Maybe there is an UDF anchor in IOS session
 	 so its ISO/UDF session and we prefere UDF */
-      if ( _cdio_is_UDF() ) {
+      if ( _cdio_is_UDF(buffer) ) {
 	/* Detect UDF version.
 	   Test if we have a valid version of UDF the xbox can read natively */
-	if ( _cdio_read_block(p_cdio, 35, start_session, 5, i_track) < 0)
+	if ( _cdio_read_block(p_cdio, buffer, 35, start_session, 5,
+			      i_track) < 0)
 	  return ret;
 
 	iso_analysis->UDFVerMinor=(unsigned int)buffer[5][240];
@@ -297,7 +304,7 @@ cdio_guess_cd_type(const CdIo_t *p_cdio, int start_session, track_t i_track,
 #if 0
 	/*  We are using ISO/UDF cd's as iso,
 	    no need to get UDF disc label */
-	if (_cdio_read_block(p_cdio, 32, start_session, 5, i_track) < 0)
+	if (_cdio_read_block(p_cdio, buffer, 32, start_session, 5, i_track) < 0)
 	  return ret;
 	stnrcpy(iso_analysis->iso_label, buffer[5]+25, 33);
 	iso_analysis->iso_label[32] = '\0';
@@ -310,41 +317,44 @@ cdio_guess_cd_type(const CdIo_t *p_cdio, int start_session, track_t i_track,
 	ret |= CDIO_FS_ANAL_ROCKRIDGE;
 #endif
 
-      if (_cdio_read_block(p_cdio, BOOT_SECTOR, start_session, 3, i_track) < 0)
+      if (_cdio_read_block(p_cdio, buffer, BOOT_SECTOR, start_session, 3,
+			   i_track) < 0)
 	return ret;
 
-      if (_cdio_is_joliet()) {
-	iso_analysis->joliet_level = _cdio_get_joliet_level();
+      if (_cdio_is_joliet(buffer)) {
+	iso_analysis->joliet_level = _cdio_get_joliet_level(buffer);
 	ret |= (CDIO_FS_ANAL_JOLIET | CDIO_FS_ANAL_ISO9660_ANY);
       }
-      if (_cdio_is_it(INDEX_BOOTABLE))
+      if (_cdio_is_it(buffer, INDEX_BOOTABLE))
 	ret |= CDIO_FS_ANAL_BOOTABLE;
 
-      if ( _cdio_is_it(INDEX_XA) && _cdio_is_it(INDEX_ISOFS)
-	  && !(sector0_read_ok && _cdio_is_it(INDEX_PHOTO_CD)) ) {
+      if ( _cdio_is_it(buffer, INDEX_XA) && _cdio_is_it(buffer, INDEX_ISOFS)
+	  && !(sector0_read_ok && _cdio_is_it(buffer, INDEX_PHOTO_CD)) ) {
 
-        if ( _cdio_read_block(p_cdio, VCD_INFO_SECTOR, start_session, 4,
-			     i_track) < 0 )
+        if ( _cdio_read_block(p_cdio, buffer, VCD_INFO_SECTOR, start_session,
+			      4, i_track) < 0 )
 	  return ret;
 
-	if (_cdio_is_it(INDEX_BRIDGE) && _cdio_is_it(INDEX_CD_RTOS)) {
+	if (_cdio_is_it(buffer, INDEX_BRIDGE)
+	    && _cdio_is_it(buffer, INDEX_CD_RTOS)) {
 	  ret |= CDIO_FS_ANAL_ISO9660_ANY;
-	  if (_cdio_is_it(INDEX_VIDEO_CD))  ret |= CDIO_FS_ANAL_VIDEOCD;
-	  else if (_cdio_is_it(INDEX_SVCD)) ret |= CDIO_FS_ANAL_SVCD;
-	} else if (_cdio_is_it(INDEX_SVCD)) ret |= CDIO_FS_ANAL_CVD;
+	  if (_cdio_is_it(buffer, INDEX_VIDEO_CD))
+	    ret |= CDIO_FS_ANAL_VIDEOCD;
+	  else if (_cdio_is_it(buffer, INDEX_SVCD)) ret |= CDIO_FS_ANAL_SVCD;
+	} else if (_cdio_is_it(buffer, INDEX_SVCD)) ret |= CDIO_FS_ANAL_CVD;
 
       }
     }
-    else if (_cdio_is_hfs())          ret |= CDIO_FS_HFS;
-    else if (sector0_read_ok && _cdio_is_it(INDEX_EXT2))
+    else if (_cdio_is_hfs(buffer))    ret |= CDIO_FS_HFS;
+    else if (sector0_read_ok && _cdio_is_it(buffer, INDEX_EXT2))
       ret |= (CDIO_FS_EXT2 | CDIO_FS_ANAL_ISO9660_ANY);
-    else if (_cdio_is_3do())          ret |= CDIO_FS_3DO;
+    else if (_cdio_is_3do(buffer))    ret |= CDIO_FS_3DO;
     else {
-      if ( _cdio_read_block(p_cdio, UFS_SUPERBLOCK_SECTOR, start_session, 2,
-			    i_track) < 0 )
+      if ( _cdio_read_block(p_cdio, buffer, UFS_SUPERBLOCK_SECTOR,
+			    start_session, 2, i_track) < 0 )
 	return ret;
 
-      if (sector0_read_ok && _cdio_is_it(INDEX_UFS))
+      if (sector0_read_ok && _cdio_is_it(buffer, INDEX_UFS))
 	ret |= CDIO_FS_UFS;
       else
 	ret |= CDIO_FS_UNKNOWN;
@@ -352,11 +362,11 @@ cdio_guess_cd_type(const CdIo_t *p_cdio, int start_session, track_t i_track,
   }
 
   /* other checks */
-  if (_cdio_is_it(INDEX_XA))
+  if (_cdio_is_it(buffer, INDEX_XA))
     ret |= (CDIO_FS_ANAL_XA | CDIO_FS_ANAL_ISO9660_ANY);
-  if (_cdio_is_it(INDEX_PHOTO_CD))
+  if (_cdio_is_it(buffer, INDEX_PHOTO_CD))
     ret |= (CDIO_FS_ANAL_PHOTO_CD | CDIO_FS_ANAL_ISO9660_ANY);
-  if (_cdio_is_it(INDEX_CDTV))
+  if (_cdio_is_it(buffer, INDEX_CDTV))
     ret |= CDIO_FS_ANAL_CDTV;
   return ret;
 }
@@ -23,6 +23,10 @@
 # define __CDIO_CONFIG_H__ 1
 #endif
 
+#include <errno.h>
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
 #ifdef HAVE_SYS_TYPES_H
 #include <sys/types.h>
 #endif
@@ -47,6 +51,9 @@ cdio_get_arg (const CdIo *obj, const char key[])
 {
   if (obj == NULL) return NULL;
 
+  if (key && !strcmp(key, "mmc-max-transfer"))
+    return obj->i_max_transfer ? obj->sz_max_transfer : NULL;
+
   if (obj->op.get_arg) {
     return obj->op.get_arg (obj->env, key);
   } else {
@@ -77,6 +84,22 @@ driver_return_code_t
 cdio_set_arg (CdIo_t *p_cdio, const char key[], const char value[])
 {
   if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (key && !strcmp(key, "mmc-max-transfer")) {
+    /* Kept here rather than by the driver, as the MMC layer uses it. */
+    char *psz_end;
+    unsigned long int i_max;
+
+    if (!value || value[0] < '0' || value[0] > '9')
+      return DRIVER_OP_BAD_PARAMETER;
+    errno = 0;
+    i_max = strtoul(value, &psz_end, 10);
+    if (*psz_end || errno || i_max > 0xffffffffUL)
+      return DRIVER_OP_BAD_PARAMETER;
+    p_cdio->i_max_transfer = (uint32_t) i_max;
+    snprintf(p_cdio->sz_max_transfer, sizeof(p_cdio->sz_max_transfer),
+             "%lu", i_max);
+    return DRIVER_OP_SUCCESS;
+  }
   if (!p_cdio->op.set_arg) return DRIVER_OP_UNSUPPORTED;
   if (!key) return DRIVER_OP_ERROR;
 
@@ -36,6 +36,7 @@
 #include <cdio/cdio.h>
 #include <cdio/audio.h>
 #include <cdio/cdtext.h>
+#include <cdio/mmc_async.h>
 #include "mmc/mmc_private.h"
 
 #ifdef __cplusplus
@@ -446,6 +447,34 @@ extern "C" {
     */
     mmc_run_cmd_fn_t run_mmc_cmd;
 
+    /*!
+      Queue an MMC command without waiting for it; see mmc_submit_cmd().
+      p_cmd->i_cdb has been filled in.
+
+      Returns DRIVER_OP_UNSUPPORTED if the device can't queue
+      commands, in which case the command is run by run_mmc_cmd
+      instead.
+    */
+    driver_return_code_t (*submit_mmc_cmd) ( void *p_env,
+                                             mmc_async_cmd_t *p_cmd );
+
+    /*!
+      Collect up to i_max commands queued by submit_mmc_cmd that are
+      done, waiting as mmc_reap_cmds() does. Sets i_status and the
+      sense reply of each.
+
+      Returns the number of commands collected or a negative
+      driver_return_code_t.
+    */
+    int (*reap_mmc_cmds) ( void *p_env, mmc_async_cmd_t *ap_done[],
+                           unsigned int i_max, int i_timeout_ms );
+
+    /*!
+      Return the descriptor to poll() for commands queued by
+      submit_mmc_cmd, or -1.
+    */
+    int (*get_mmc_completion_fd) ( void *p_env );
+
     /*!
       Set the arg "key" with "value" in the source device.
     */
@@ -476,6 +505,10 @@ extern "C" {
 #define CDIO_HEADER_TYPE_ISO            0x0001
 
 #define CDIO_HEADER_FLAGS_DISABLE_RR_DD 0x0001
+#define CDIO_HEADER_FLAGS_LAZY_RR       0x0002
+
+  /* Length of the strings cdio_get_disc_fingerprint() gives. */
+#define CDIO_DISC_FINGERPRINT_LEN 26
 
   /*! Implementation of CdIo type */
   struct _CdIo {
@@ -484,6 +517,25 @@ extern "C" {
     cdio_funcs_t  op;        /**< driver-specific routines handling
                                   implementation. */
     void*         env;       /**< environment. Passed to routine above. */
+    uint32_t      i_max_transfer; /**< Most bytes an MMC read command may
+                                       transfer, or 0 if not known. */
+    char          sz_max_transfer[11]; /**< i_max_transfer as a string,
+                                            for cdio_get_arg(). */
+
+    /* Commands from mmc_submit_cmd() not yet reaped. Those the driver
+       ran when submitted wait in the async_done list; the driver has
+       i_async_queued more. */
+    mmc_async_cmd_t *p_async_done;
+    mmc_async_cmd_t *p_async_done_last;
+    unsigned int     i_async_queued;
+
+    /* The disc cache (disc_cache.c). */
+    bool        b_cache_media_changed; /**< the cache took a media change
+                                            cdio_get_media_changed() has
+                                            yet to report */
+    cdtext_t   *p_cache_cdtext;        /**< CD-Text built from the cache */
+    char        sz_cache_cdtext_disc[CDIO_DISC_FINGERPRINT_LEN + 1];
+                                       /**< the disc it is for */
   };
 
   /* This is used in drivers that must keep their own internal
@@ -529,6 +581,14 @@ extern "C" {
      on a particular host. */
   extern CdIo_driver_t CdIo_all_drivers[];
 
+  /* The disc cache. Each gives what the driver would, from the cache
+     when caching is on and p_cdio is a drive. */
+  char     *cdio_disc_cache_get_mcn    (const CdIo_t *p_cdio);
+  char     *cdio_disc_cache_get_isrc   (const CdIo_t *p_cdio, track_t i_track);
+  uint8_t  *cdio_disc_cache_get_cdtext_raw (CdIo_t *p_cdio);
+  cdtext_t *cdio_disc_cache_get_cdtext (CdIo_t *p_cdio);
+  int       cdio_disc_cache_get_media_changed (CdIo_t *p_cdio);
+
   /*!
     Add/allocate a drive to the end of drives.
     Use cdio_free_device_list() to free this device_list.
@@ -593,6 +653,9 @@ extern "C" {
   /*! True if Nero driver is available. */
   bool cdio_have_nrg     (void);
 
+  /*! True if the MMC emulator is available. It always is. */
+  bool cdio_have_mmc_emu (void);
+
   /*! True if BIN/CUE driver is available. */
   bool cdio_have_bincue  (void);
 
@@ -0,0 +1,123 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Calendar arithmetic for ISO 9660 and UDF timestamps. The day
+   conversions follow Howard Hinnant's days_from_civil and
+   civil_from_days, which use 400-year eras so that no loops or
+   tables are needed. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#include "cdio_time.h"
+
+/* Days from 1970-01-01 to i_year-i_month-i_day. i_month is 1-12. */
+int64_t
+_cdio_days_from_civil(int64_t i_year, unsigned int i_month,
+                      unsigned int i_day)
+{
+  int64_t i_era;
+  unsigned int i_yoe, i_doy, i_doe;
+
+  if (i_month <= 2) i_year--;
+  i_era = CDIO_FLOOR_DIV(i_year, 400);
+  i_yoe = (unsigned int) (i_year - i_era * 400);            /* [0, 399] */
+  i_doy = (153 * (i_month > 2 ? i_month - 3 : i_month + 9) + 2) / 5
+    + i_day - 1;                                             /* [0, 365] */
+  i_doe = i_yoe * 365 + i_yoe / 4 - i_yoe / 100 + i_doy;    /* [0, 146096] */
+  return i_era * 146097 + (int64_t) i_doe - 719468;
+}
+
+/* The inverse of _cdio_days_from_civil(). Also gives the day of the
+   year (0-365) and of the week (0-6, Sunday is 0). */
+void
+_cdio_civil_from_days(int64_t i_days, int64_t *p_year, int *p_month,
+                      int *p_mday, int *p_yday, int *p_wday)
+{
+  int64_t i_z = i_days + 719468;
+  int64_t i_era = CDIO_FLOOR_DIV(i_z, 146097);
+  unsigned int i_doe = (unsigned int) (i_z - i_era * 146097);
+  unsigned int i_yoe = (i_doe - i_doe / 1460 + i_doe / 36524
+                        - i_doe / 146096) / 365;
+  unsigned int i_doy = i_doe - (365 * i_yoe + i_yoe / 4 - i_yoe / 100);
+  unsigned int i_mp = (5 * i_doy + 2) / 153;
+  unsigned int i_month = i_mp < 10 ? i_mp + 3 : i_mp - 9;
+  int64_t i_year = (int64_t) i_yoe + i_era * 400 + (i_month <= 2);
+  bool b_leap = (0 == i_year % 4 && 0 != i_year % 100) || 0 == i_year % 400;
+
+  *p_year  = i_year;
+  *p_month = i_month;
+  *p_mday  = i_doy - (153 * i_mp + 2) / 5 + 1;
+  /* i_doy counts from March 1st. */
+  *p_yday  = i_mp < 10 ? i_doy + 59 + b_leap : i_doy - 306;
+  /* 1970-01-01 was a Thursday. */
+  *p_wday  = (int) (((i_days % 7) + 11) % 7);
+}
+
+/* Like timegm(): the seconds since the Epoch of the UTC time in p_tm.
+   Fields out of their normal ranges are allowed; tm_wday, tm_yday and
+   tm_isdst are ignored. */
+int64_t
+_cdio_timegm(const struct tm *p_tm)
+{
+  int64_t i_year = (int64_t) p_tm->tm_year + 1900
+    + CDIO_FLOOR_DIV(p_tm->tm_mon, 12);
+  int i_mon = p_tm->tm_mon - 12 * CDIO_FLOOR_DIV(p_tm->tm_mon, 12);
+  int64_t i_days = _cdio_days_from_civil(i_year, i_mon + 1, 1)
+    + p_tm->tm_mday - 1;
+
+  return i_days * CDIO_SECS_PER_DAY + (int64_t) p_tm->tm_hour * 3600
+    + (int64_t) p_tm->tm_min * 60 + p_tm->tm_sec;
+}
+
+/* Like gmtime_r(): break i_time, seconds since the Epoch, down into
+   p_tm as UTC. */
+struct tm *
+_cdio_gmtime(int64_t i_time, struct tm *p_tm)
+{
+  int64_t i_days = CDIO_FLOOR_DIV(i_time, CDIO_SECS_PER_DAY);
+  int i_secs = (int) (i_time - i_days * CDIO_SECS_PER_DAY);
+  int64_t i_year;
+  int i_month;
+
+  _cdio_civil_from_days(i_days, &i_year, &i_month, &p_tm->tm_mday,
+                        &p_tm->tm_yday, &p_tm->tm_wday);
+  p_tm->tm_year  = (int) (i_year - 1900);
+  p_tm->tm_mon   = i_month - 1;
+  p_tm->tm_hour  = i_secs / 3600;
+  p_tm->tm_min   = i_secs / 60 % 60;
+  p_tm->tm_sec   = i_secs % 60;
+  p_tm->tm_isdst = 0;
+#ifdef HAVE_TM_GMTOFF
+  p_tm->tm_gmtoff = 0;
+#endif
+#ifdef HAVE_STRUCT_TM_TM_ZONE
+  p_tm->tm_zone = (char *) "GMT";
+#endif
+  return p_tm;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
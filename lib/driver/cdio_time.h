@@ -0,0 +1,72 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Calendar arithmetic on the proleptic Gregorian calendar in UTC,
+   shared by the ISO 9660 and UDF timestamp code.
+
+   Nothing here calls into the C library's time functions, so these
+   are fast, thread-safe and don't depend on TZ. Leap seconds are not
+   taken into account, just as POSIX time_t doesn't.
+*/
+
+#ifndef CDIO_TIME_H_
+#define CDIO_TIME_H_
+
+#include <time.h>
+#include <cdio/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define CDIO_SECS_PER_DAY (24 * 60 * 60)
+
+/* Floor division, for when a may be negative. */
+#define CDIO_FLOOR_DIV(a, b) ((a) / (b) - ((a) % (b) < 0))
+
+  /* Days from 1970-01-01 to i_year-i_month-i_day. i_month is 1-12. */
+  int64_t _cdio_days_from_civil(int64_t i_year, unsigned int i_month,
+                                unsigned int i_day);
+
+  /* The inverse of _cdio_days_from_civil(). Also gives the day of the
+     year (0-365) and of the week (0-6, Sunday is 0). */
+  void _cdio_civil_from_days(int64_t i_days, int64_t *p_year,
+                             int *p_month, int *p_mday, int *p_yday,
+                             int *p_wday);
+
+  /* Like timegm(): the seconds since the Epoch of the UTC time in
+     p_tm. Fields out of their normal ranges are allowed; tm_wday,
+     tm_yday and tm_isdst are ignored. */
+  int64_t _cdio_timegm(const struct tm *p_tm);
+
+  /* Like gmtime_r(): break i_time, seconds since the Epoch, down into
+     p_tm as UTC. */
+  struct tm *_cdio_gmtime(int64_t i_time, struct tm *p_tm);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CDIO_TIME_H_ */
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -49,6 +49,12 @@
 #ifdef HAVE_SYS_STAT_H
 #include <sys/stat.h>
 #endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 /* The last valid entry of Cdio_driver.
    -1 or (CDIO_DRIVER_UNINIT) means uninitialzed.
@@ -58,6 +64,12 @@
 #define CDIO_DRIVER_UNINIT -1
 int CdIo_last_driver = CDIO_DRIVER_UNINIT;
 
+#ifdef HAVE_PTHREAD
+/* Serializes filling in CdIo_driver, which opens in several threads
+   may all try first. */
+static pthread_mutex_t driver_init_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 #ifdef HAVE_AIX_CDROM
 const driver_id_t cdio_os_driver = DRIVER_AIX;
 #elif  defined(HAVE_FREEBSD_CDROM)
@@ -238,6 +250,32 @@ CdIo_driver_t CdIo_all_drivers[] = {
    NULL,
    &cdio_get_devices_nrg,
    NULL
+  },
+
+  {DRIVER_DEVICE,
+   0,
+   "Device",
+   "Any of the hardware device drivers",
+   &cdio_have_false,
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+   NULL,
+   NULL
+  },
+
+  {DRIVER_MMC_EMU,
+   CDIO_SRC_IS_DISK_IMAGE_MASK,
+   "MMC emulator",
+   "MMC drive emulated from a disc image",
+   &cdio_have_mmc_emu,
+   &cdio_open_mmc_emu,
+   &cdio_open_am_mmc_emu,
+   NULL,
+   NULL,
+   NULL,
+   NULL
   }
 
 };
@@ -326,6 +364,36 @@ cdio_driver_describe(driver_id_t driver_id)
   return CdIo_all_drivers[driver_id].describe;
 }
 
+/* Fill in CdIo_driver unless that has been done already. Returns
+   false if it had. */
+static bool
+_cdio_init_drivers(void)
+{
+  CdIo_driver_t *all_dp;
+  CdIo_driver_t *dp = CdIo_driver;
+  const driver_id_t *p_driver_id;
+  bool b_init = false;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&driver_init_lock);
+#endif
+  if (CdIo_last_driver == CDIO_DRIVER_UNINIT) {
+    for (p_driver_id=cdio_drivers; *p_driver_id!=DRIVER_UNKNOWN;
+         p_driver_id++) {
+      all_dp = &CdIo_all_drivers[*p_driver_id];
+      if ((*CdIo_all_drivers[*p_driver_id].have_driver)()) {
+        *dp++ = *all_dp;
+        CdIo_last_driver++;
+      }
+    }
+    b_init = true;
+  }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&driver_init_lock);
+#endif
+  return b_init;
+}
+
 /*!
   Initialize CD Reading and control routines. Should be called first.
   May be implicitly called by other routines if not called first.
@@ -333,24 +401,10 @@ cdio_driver_describe(driver_id_t driver_id)
 bool
 cdio_init(void)
 {
-
-  CdIo_driver_t *all_dp;
-  CdIo_driver_t *dp = CdIo_driver;
-  const driver_id_t *p_driver_id;
-
-  if (CdIo_last_driver != CDIO_DRIVER_UNINIT) {
+  if (!_cdio_init_drivers()) {
     cdio_warn ("Init routine called more than once.");
     return false;
   }
-
-  for (p_driver_id=cdio_drivers; *p_driver_id!=DRIVER_UNKNOWN; p_driver_id++) {
-    all_dp = &CdIo_all_drivers[*p_driver_id];
-    if ((*CdIo_all_drivers[*p_driver_id].have_driver)()) {
-      *dp++ = *all_dp;
-      CdIo_last_driver++;
-    }
-  }
-
   return true;
 }
 
@@ -360,12 +414,12 @@ cdio_init(void)
 void
 cdio_destroy (CdIo_t *p_cdio)
 {
-  CdIo_last_driver = CDIO_DRIVER_UNINIT;
   if (p_cdio == NULL) return;
 
   if (p_cdio->op.free != NULL && p_cdio->env)
     p_cdio->op.free (p_cdio->env);
   p_cdio->env = NULL;
+  if (p_cdio->p_cache_cdtext) cdtext_destroy (p_cdio->p_cache_cdtext);
   free (p_cdio);
 }
 
@@ -579,6 +633,7 @@ cdio_get_devices_ret (/*in/out*/ driver_id_t *p_driver_id)
     *p_driver_id = cdio_get_driver_id(p_cdio);
     break;
   default:
+    if (!CdIo_all_drivers[*p_driver_id].get_devices) return NULL;
     return (*CdIo_all_drivers[*p_driver_id].get_devices)();
   }
 
@@ -592,6 +647,312 @@ cdio_get_devices_ret (/*in/out*/ driver_id_t *p_driver_id)
   }
 }
 
+/* How long cdio_get_devices_with_cap_ret() waits for drives to say
+   what is in them, in milliseconds, or 0 to wait as long as it takes. */
+static unsigned int i_probe_timeout_ms = 0;
+
+/*!
+  Set how long cdio_get_devices_with_cap() and
+  cdio_get_devices_with_cap_ret() wait for the drives they look at.
+*/
+void
+cdio_set_device_probe_timeout (unsigned int i_timeout_ms)
+{
+  i_probe_timeout_ms = i_timeout_ms;
+}
+
+/* What was last found in each drive, by the disc it had. Guessing what
+   is on a disc reads several sectors, which there is no need to do
+   again for the same disc. */
+typedef struct probe_cache_s probe_cache_t;
+struct probe_cache_s {
+  probe_cache_t  *p_next;
+  char           *psz_device;
+  char           *psz_fingerprint;
+  cdio_fs_anal_t  got_cap;
+};
+
+static probe_cache_t *p_probe_cache = NULL;
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t probe_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define PROBE_CACHE_LOCK()   pthread_mutex_lock(&probe_cache_lock)
+#define PROBE_CACHE_UNLOCK() pthread_mutex_unlock(&probe_cache_lock)
+#else
+#define PROBE_CACHE_LOCK()
+#define PROBE_CACHE_UNLOCK()
+#endif
+
+static bool
+probe_cache_get(const char *psz_device, const char *psz_fingerprint,
+                /*out*/ cdio_fs_anal_t *p_got_cap)
+{
+  probe_cache_t *p_entry;
+  bool b_found = false;
+
+  PROBE_CACHE_LOCK();
+  for (p_entry = p_probe_cache; p_entry; p_entry = p_entry->p_next)
+    if (0 == strcmp(p_entry->psz_device, psz_device)) {
+      if ((b_found = (0 == strcmp(p_entry->psz_fingerprint, psz_fingerprint))))
+        *p_got_cap = p_entry->got_cap;
+      break;
+    }
+  PROBE_CACHE_UNLOCK();
+  return b_found;
+}
+
+static void
+probe_cache_put(const char *psz_device, const char *psz_fingerprint,
+                cdio_fs_anal_t got_cap)
+{
+  probe_cache_t *p_entry;
+  char *psz_copy = strdup(psz_fingerprint);
+
+  if (!psz_copy) return;
+  PROBE_CACHE_LOCK();
+  for (p_entry = p_probe_cache; p_entry; p_entry = p_entry->p_next)
+    if (0 == strcmp(p_entry->psz_device, psz_device)) break;
+  if (!p_entry && (p_entry = calloc(1, sizeof(probe_cache_t)))) {
+    if ((p_entry->psz_device = strdup(psz_device))) {
+      p_entry->p_next = p_probe_cache;
+      p_probe_cache = p_entry;
+    } else {
+      free(p_entry);
+      p_entry = NULL;
+    }
+  }
+  if (p_entry) {
+    free(p_entry->psz_fingerprint);
+    p_entry->psz_fingerprint = psz_copy;
+    p_entry->got_cap = got_cap;
+    psz_copy = NULL;
+  }
+  PROBE_CACHE_UNLOCK();
+  free(psz_copy);
+}
+
+/* A drive being looked at. */
+typedef struct {
+  char           *psz_device;
+  driver_id_t     driver_id;
+  bool            b_disc;     /**< it has a disc with tracks */
+  cdio_fs_anal_t  got_cap;    /**< what is on it, if b_disc */
+  bool            b_done;
+} device_probe_t;
+
+/* The drives looked at by one call. Each thread holds a reference, so
+   one still stuck in a drive after the caller has given up on it frees
+   what it uses when it does return. */
+typedef struct {
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t  lock;
+  pthread_cond_t   done;
+#endif
+  unsigned int     i_refs;
+  unsigned int     i_probes;
+  device_probe_t  *p_probes;
+} device_probes_t;
+
+static void
+probes_release(device_probes_t *p_probes)
+{
+  unsigned int i, i_refs;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&p_probes->lock);
+#endif
+  i_refs = --p_probes->i_refs;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&p_probes->lock);
+#endif
+  if (i_refs) return;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_destroy(&p_probes->lock);
+  pthread_cond_destroy(&p_probes->done);
+#endif
+  for (i = 0; i < p_probes->i_probes; i++)
+    free(p_probes->p_probes[i].psz_device);
+  free(p_probes->p_probes);
+  free(p_probes);
+}
+
+/* Open the drive and see what is in it. */
+static void
+probe_device(device_probe_t *p_probe)
+{
+  CdIo_t *p_cdio = cdio_open(p_probe->psz_device, p_probe->driver_id);
+  bool b_disc = false;
+  cdio_fs_anal_t got_cap = 0;
+
+  if (NULL != p_cdio) {
+    track_t i_first_track = cdio_get_first_track_num(p_cdio);
+
+    if (CDIO_INVALID_TRACK != i_first_track) {
+      char *psz_fingerprint = cdio_get_disc_fingerprint(p_cdio);
+
+      b_disc = true;
+      if (!psz_fingerprint
+          || !probe_cache_get(p_probe->psz_device, psz_fingerprint,
+                              &got_cap)) {
+        cdio_iso_analysis_t cdio_iso_analysis;
+
+        got_cap = cdio_guess_cd_type(p_cdio, 0, i_first_track,
+                                     &cdio_iso_analysis);
+        if (psz_fingerprint)
+          probe_cache_put(p_probe->psz_device, psz_fingerprint, got_cap);
+      }
+      free(psz_fingerprint);
+    }
+    cdio_destroy(p_cdio);
+  }
+  p_probe->b_disc  = b_disc;
+  p_probe->got_cap = got_cap;
+}
+
+typedef struct {
+  device_probes_t *p_probes;
+  unsigned int     i_probe;
+} probe_job_t;
+
+#ifdef HAVE_PTHREAD
+static void *
+probe_thread(void *p_arg)
+{
+  probe_job_t *p_job = p_arg;
+  device_probes_t *p_probes = p_job->p_probes;
+  device_probe_t *p_probe = &p_probes->p_probes[p_job->i_probe];
+
+  free(p_job);
+  probe_device(p_probe);
+  pthread_mutex_lock(&p_probes->lock);
+  p_probe->b_done = true;
+  pthread_cond_signal(&p_probes->done);
+  pthread_mutex_unlock(&p_probes->lock);
+  probes_release(p_probes);
+  return NULL;
+}
+#endif
+
+/* Look at all the drives at once, so that a slow one, or one without
+   a disc spinning up, doesn't hold up the others. Drives not done by
+   the time i_probe_timeout_ms is up count as having nothing.
+
+   The returned array is a copy, since the threads of drives not done
+   still use theirs; each entry's psz_device is left NULL. */
+static device_probe_t *
+probe_devices(char *ppsz_drives[], unsigned int i_drives,
+              driver_id_t driver_id)
+{
+  device_probes_t *p_probes = calloc(1, sizeof(device_probes_t));
+  device_probe_t *p_result = calloc(i_drives, sizeof(device_probe_t));
+  unsigned int i;
+#ifdef HAVE_PTHREAD
+  struct timespec deadline;
+  bool b_deadline = false;
+  int i_wait = 0;
+#endif
+
+  if (!p_probes || !p_result
+      || !(p_probes->p_probes = calloc(i_drives, sizeof(device_probe_t)))) {
+    free(p_probes);
+    free(p_result);
+    return NULL;
+  }
+  p_probes->i_probes = i_drives;
+  p_probes->i_refs   = 1;
+  for (i = 0; i < i_drives; i++) {
+    p_probes->p_probes[i].psz_device = strdup(ppsz_drives[i]);
+    p_probes->p_probes[i].driver_id  = driver_id;
+  }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&p_probes->lock, NULL);
+  pthread_cond_init(&p_probes->done, NULL);
+#ifdef HAVE_GETTIMEOFDAY
+  if (i_probe_timeout_ms) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    deadline.tv_sec  = now.tv_sec + i_probe_timeout_ms / 1000;
+    deadline.tv_nsec = (now.tv_usec + (i_probe_timeout_ms % 1000) * 1000L)
+      * 1000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+    b_deadline = true;
+  }
+#endif
+#endif
+
+  for (i = 0; i < i_drives; i++) {
+    device_probe_t *p_probe = &p_probes->p_probes[i];
+#ifdef HAVE_PTHREAD
+    probe_job_t *p_job = malloc(sizeof(probe_job_t));
+    pthread_attr_t attr;
+    pthread_t thread;
+    bool b_started = false;
+
+    if (!p_probe->psz_device) {
+      p_probe->b_done = true;
+      continue;
+    }
+    if (p_job) {
+      p_job->p_probes = p_probes;
+      p_job->i_probe  = i;
+      pthread_mutex_lock(&p_probes->lock);
+      p_probes->i_refs++;
+      pthread_mutex_unlock(&p_probes->lock);
+      pthread_attr_init(&attr);
+      pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+      b_started = (0 == pthread_create(&thread, &attr, probe_thread, p_job));
+      pthread_attr_destroy(&attr);
+      if (!b_started) {
+        pthread_mutex_lock(&p_probes->lock);
+        p_probes->i_refs--;
+        pthread_mutex_unlock(&p_probes->lock);
+        free(p_job);
+      }
+    }
+    if (b_started) continue;
+    /* No thread for it: look here. */
+    probe_device(p_probe);
+    pthread_mutex_lock(&p_probes->lock);
+    p_probe->b_done = true;
+    pthread_mutex_unlock(&p_probes->lock);
+#else
+    if (p_probe->psz_device) probe_device(p_probe);
+    p_probe->b_done = true;
+#endif
+  }
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&p_probes->lock);
+  for (i = 0; i < i_drives && 0 == i_wait; ) {
+    if (p_probes->p_probes[i].b_done)
+      i++;
+    else if (b_deadline)
+      i_wait = pthread_cond_timedwait(&p_probes->done, &p_probes->lock,
+                                      &deadline);
+    else
+      i_wait = pthread_cond_wait(&p_probes->done, &p_probes->lock);
+  }
+#endif
+  for (i = 0; i < i_drives; i++) {
+    const device_probe_t *p_probe = &p_probes->p_probes[i];
+    if (p_probe->b_done) {
+      p_result[i].b_disc  = p_probe->b_disc;
+      p_result[i].got_cap = p_probe->got_cap;
+    } else
+      cdio_warn("%s didn't answer in %u ms", p_probe->psz_device,
+                i_probe_timeout_ms);
+  }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&p_probes->lock);
+#endif
+  probes_release(p_probes);
+  return p_result;
+}
+
 /*!
   Return an array of device names in search_devices that have at
   least the capabilities listed by cap.  If search_devices is NULL,
@@ -645,43 +1006,39 @@ cdio_get_devices_with_cap_ret (/*in*/ char* search_devices[],
     }
   } else {
     const cdio_fs_anal_t need_fs = CDIO_FSTYPE(need_cap);
-    char **d = ppsz_drives;
-
-    for( ;  *d != NULL; d++ ) {
-      CdIo_t *p_cdio = cdio_open(*d, *p_driver_id);
-
-      if (NULL != p_cdio) {
-        track_t i_first_track = cdio_get_first_track_num(p_cdio);
-        cdio_iso_analysis_t cdio_iso_analysis;
-
-        if (CDIO_INVALID_TRACK != i_first_track) {
-          const cdio_fs_anal_t got_cap =
-            cdio_guess_cd_type(p_cdio, 0, i_first_track, &cdio_iso_analysis);
-
-          /* Match on filesystem. Here either we don't know what the
-             filesystem is - automatic match, or we no that the file
-             system is in the set of those specified.
-             We refine the logic further after this initial test. */
-          if ( CDIO_FS_UNKNOWN == need_fs || 0 == need_fs
-               || (CDIO_FSTYPE(got_cap) == need_fs) ) {
-              /* Match on analysis type. If we haven't set any
-                 analysis type, then an automatic match. Otherwise
-                 a match is determined by whether we need all
-                 analysis types or any of them. */
-              const cdio_fs_anal_t need_anal = need_cap & ~CDIO_FS_MASK;
-              const cdio_fs_anal_t got_anal  = got_cap  & ~CDIO_FS_MASK;
-              const bool b_match = !need_anal
-                || (b_any
-                    ? (got_anal & need_anal) != 0
-                    : (got_anal & need_anal) == need_anal);
-              if (b_match)
-                cdio_add_device_list(&ppsz_drives_ret, *d, &i_drives);
-            }
-        }
-
-        cdio_destroy(p_cdio);
+    unsigned int i, i_candidates = 0;
+    device_probe_t *p_probes;
+
+    while (ppsz_drives[i_candidates]) i_candidates++;
+    p_probes = probe_devices(ppsz_drives, i_candidates, *p_driver_id);
+
+    for (i = 0; p_probes && i < i_candidates; i++) {
+      if (p_probes[i].b_disc) {
+        const cdio_fs_anal_t got_cap = p_probes[i].got_cap;
+
+        /* Match on filesystem. Here either we don't know what the
+           filesystem is - automatic match, or we no that the file
+           system is in the set of those specified.
+           We refine the logic further after this initial test. */
+        if ( CDIO_FS_UNKNOWN == need_fs || 0 == need_fs
+             || (CDIO_FSTYPE(got_cap) == need_fs) ) {
+            /* Match on analysis type. If we haven't set any
+               analysis type, then an automatic match. Otherwise
+               a match is determined by whether we need all
+               analysis types or any of them. */
+            const cdio_fs_anal_t need_anal = need_cap & ~CDIO_FS_MASK;
+            const cdio_fs_anal_t got_anal  = got_cap  & ~CDIO_FS_MASK;
+            const bool b_match = !need_anal
+              || (b_any
+                  ? (got_anal & need_anal) != 0
+                  : (got_anal & need_anal) == need_anal);
+            if (b_match)
+              cdio_add_device_list(&ppsz_drives_ret, ppsz_drives[i],
+                                   &i_drives);
+          }
       }
     }
+    free(p_probes);
   }
   cdio_add_device_list(&ppsz_drives_ret, NULL, &i_drives);
   if (b_free_ppsz_drives) {
@@ -818,7 +1175,7 @@ cdio_get_media_changed(CdIo_t *p_cdio)
 {
   if (!p_cdio) return DRIVER_OP_UNINIT;
   if (p_cdio->op.get_media_changed)
-    return p_cdio->op.get_media_changed(p_cdio->env);
+    return cdio_disc_cache_get_media_changed(p_cdio);
   return DRIVER_OP_UNSUPPORTED;
 }
 
@@ -945,7 +1302,7 @@ cdio_open_am (const char *psz_orig_source, driver_id_t driver_id,
 {
   char *psz_source;
 
-  if (CdIo_last_driver == -1) cdio_init();
+  _cdio_init_drivers();
 
   if (!psz_orig_source || !*psz_orig_source)
     psz_source = cdio_get_default_device(NULL);
@@ -978,6 +1335,7 @@ cdio_open_am (const char *psz_orig_source, driver_id_t driver_id,
   case DRIVER_NRG:
   case DRIVER_BINCUE:
   case DRIVER_CDRDAO:
+  case DRIVER_MMC_EMU:
     if ((*CdIo_all_drivers[driver_id].have_driver)()) {
       CdIo_t *ret =
         (*CdIo_all_drivers[driver_id].driver_open_am)(psz_source,
@@ -1024,7 +1382,7 @@ cdio_open_cd (const char *psz_source)
 CdIo_t *
 cdio_open_am_cd (const char *psz_source, const char *psz_access_mode)
 {
-  if (CdIo_last_driver == -1) cdio_init();
+  _cdio_init_drivers();
 
   /* Scan for a driver. */
   return scan_for_driver(cdio_device_drivers, psz_source, psz_access_mode);
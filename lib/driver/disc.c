@@ -66,7 +66,7 @@ cdio_get_cdtext (CdIo *obj)
   if (obj == NULL) return NULL;
   
   if (NULL != obj->op.get_cdtext) {
-    return obj->op.get_cdtext (obj->env);
+    return cdio_disc_cache_get_cdtext (obj);
   } else {
     return NULL;
   }
@@ -86,7 +86,7 @@ cdio_get_cdtext_raw (CdIo *obj)
   if (obj == NULL) return NULL;
 
   if (NULL != obj->op.get_cdtext_raw) {
-    return obj->op.get_cdtext_raw (obj->env);
+    return cdio_disc_cache_get_cdtext_raw (obj);
   } else {
     return NULL;
   }
@@ -129,7 +129,7 @@ char *
 cdio_get_mcn (const CdIo_t *p_cdio) 
 {
   if (p_cdio && p_cdio->op.get_mcn) {
-    return p_cdio->op.get_mcn (p_cdio->env);
+    return cdio_disc_cache_get_mcn (p_cdio);
   } else {
     return NULL;
   }
@@ -0,0 +1,661 @@
+/* Caching what is slow to read from discs in drives.
+
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Discs are known by a fingerprint of their table of contents. What
+   has been read from each is kept in a list of discs, and which disc
+   each drive last had in a list of drives, both shared by all CdIo_t
+   objects. Neither list is pruned: a process sees few discs. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include "cdio_private.h"
+
+#define MAX_FILE_SIZE   (1024 * 1024)
+static const char CACHE_FILE_HEADER[] = "# libcdio disc cache";
+
+typedef struct cache_disc_s cache_disc_t;
+struct cache_disc_s {
+  cache_disc_t *p_next;
+  char      sz_fingerprint[CDIO_DISC_FINGERPRINT_LEN + 1];
+  char     *psz_toc;         /**< what the fingerprint was made from */
+
+  /* What has been read, each with whether it has. */
+  bool      b_mcn;
+  char     *psz_mcn;
+  bool      ab_isrc[CDIO_CD_MAX_TRACKS + 1];
+  char     *apsz_isrc[CDIO_CD_MAX_TRACKS + 1];
+  bool      b_cdtext;
+  uint8_t  *p_cdtext;        /**< as cdio_get_cdtext_raw() gives it */
+  size_t    i_cdtext;
+};
+
+typedef struct cache_drive_s cache_drive_t;
+struct cache_drive_s {
+  cache_drive_t *p_next;
+  char          *psz_source;
+  cache_disc_t  *p_disc;     /**< the disc in it, or NULL if not known */
+};
+
+static bool           b_cache_enabled = false;
+static char          *psz_cache_dir   = NULL;
+static cache_disc_t  *p_cache_discs   = NULL;
+static cache_drive_t *p_cache_drives  = NULL;
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+#define CACHE_LOCK()   pthread_mutex_lock(&cache_lock)
+#define CACHE_UNLOCK() pthread_mutex_unlock(&cache_lock)
+#else
+#define CACHE_LOCK()
+#define CACHE_UNLOCK()
+#endif
+
+/* The table of contents as text: the first track, the number of
+   tracks, each track's start and format, and the lead-out. */
+static char *
+get_toc_text(const CdIo_t *p_cdio)
+{
+  const track_t i_first = cdio_get_first_track_num(p_cdio);
+  const track_t i_tracks = cdio_get_num_tracks(p_cdio);
+  const lsn_t i_leadout = cdio_get_track_lsn(p_cdio, CDIO_CDROM_LEADOUT_TRACK);
+  char *psz_toc, *p;
+  track_t i;
+
+  if (CDIO_INVALID_TRACK == i_first || CDIO_INVALID_TRACK == i_tracks
+      || 0 == i_tracks || i_first + i_tracks - 1 > CDIO_CD_MAX_TRACKS
+      || CDIO_INVALID_LSN == i_leadout)
+    return NULL;
+  psz_toc = malloc(16 + (i_tracks + 1) * 24);
+  if (!psz_toc) return NULL;
+
+  p = psz_toc + sprintf(psz_toc, "%u %u", i_first, i_tracks);
+  for (i = i_first; i < i_first + i_tracks; i++) {
+    const lsn_t i_lsn = cdio_get_track_lsn(p_cdio, i);
+    const track_format_t format = cdio_get_track_format(p_cdio, i);
+
+    if (CDIO_INVALID_LSN == i_lsn) {
+      free(psz_toc);
+      return NULL;
+    }
+    p += sprintf(p, " %ld:%d", (long) i_lsn, (int) format);
+  }
+  sprintf(p, " %ld", (long) i_leadout);
+  return psz_toc;
+}
+
+/* Track counts and lead-out, then a 64-bit FNV-1a hash of the table of
+   contents. */
+static void
+make_fingerprint(const char *psz_toc, char *psz_fingerprint)
+{
+  uint64_t i_hash = 0xcbf29ce484222325ULL;
+  unsigned int i_first = 0, i_tracks = 0;
+  long int i_leadout;
+  const char *p;
+
+  for (p = psz_toc; *p; p++) {
+    i_hash ^= (uint8_t) *p;
+    i_hash *= 0x100000001b3ULL;
+  }
+  sscanf(psz_toc, "%u %u", &i_first, &i_tracks);
+  p = strrchr(psz_toc, ' ');
+  i_leadout = p ? strtol(p + 1, NULL, 10) : 0;
+  snprintf(psz_fingerprint, CDIO_DISC_FINGERPRINT_LEN + 1,
+           "%02x%02x%06lx%08lx%08lx",
+           i_first & 0xff, i_tracks & 0xff,
+           (unsigned long) i_leadout & 0xffffff,
+           (unsigned long) (i_hash >> 32),
+           (unsigned long) (i_hash & 0xffffffff));
+}
+
+char *
+cdio_get_disc_fingerprint(const CdIo_t *p_cdio)
+{
+  char *psz_toc, *psz_fingerprint;
+
+  if (!p_cdio) return NULL;
+  psz_toc = get_toc_text(p_cdio);
+  if (!psz_toc) return NULL;
+  psz_fingerprint = malloc(CDIO_DISC_FINGERPRINT_LEN + 1);
+  if (psz_fingerprint) make_fingerprint(psz_toc, psz_fingerprint);
+  free(psz_toc);
+  return psz_fingerprint;
+}
+
+static void
+free_disc(cache_disc_t *p_disc)
+{
+  unsigned int i;
+
+  free(p_disc->psz_toc);
+  free(p_disc->psz_mcn);
+  for (i = 0; i <= CDIO_CD_MAX_TRACKS; i++)
+    free(p_disc->apsz_isrc[i]);
+  free(p_disc->p_cdtext);
+  free(p_disc);
+}
+
+/* MCNs and ISRCs are saved only if they stay on one line. */
+static bool
+is_printable(const char *psz)
+{
+  for ( ; *psz; psz++)
+    if ((unsigned char) *psz < 0x20 || 0x7f == *psz) return false;
+  return true;
+}
+
+static void
+write_value(FILE *fp, const char *psz_key, const char *psz_value)
+{
+  if (!psz_value)
+    fprintf(fp, "%s\n", psz_key);
+  else if (is_printable(psz_value))
+    fprintf(fp, "%s %s\n", psz_key, psz_value);
+}
+
+/* Write what is known of the disc to its file in the cache directory.
+   Called with the cache locked. */
+static void
+save_disc(const cache_disc_t *p_disc)
+{
+  char *psz_file, *psz_tmp;
+  unsigned int i;
+  FILE *fp;
+  bool b_ok;
+
+  if (!psz_cache_dir) return;
+  psz_file = malloc(strlen(psz_cache_dir) + CDIO_DISC_FINGERPRINT_LEN + 2);
+  psz_tmp = malloc(strlen(psz_cache_dir) + CDIO_DISC_FINGERPRINT_LEN + 16);
+  if (!psz_file || !psz_tmp) goto done;
+  sprintf(psz_file, "%s/%s", psz_cache_dir, p_disc->sz_fingerprint);
+#ifdef HAVE_UNISTD_H
+  sprintf(psz_tmp, "%s.%lu", psz_file, (unsigned long) getpid());
+#else
+  sprintf(psz_tmp, "%s.new", psz_file);
+#endif
+
+  fp = fopen(psz_tmp, "w");
+  if (!fp) {
+    cdio_info("can't write disc cache file %s", psz_tmp);
+    goto done;
+  }
+  fprintf(fp, "%s\ntoc %s\n", CACHE_FILE_HEADER, p_disc->psz_toc);
+  if (p_disc->b_mcn) write_value(fp, "mcn", p_disc->psz_mcn);
+  for (i = 0; i <= CDIO_CD_MAX_TRACKS; i++)
+    if (p_disc->ab_isrc[i]) {
+      char psz_key[10];
+
+      snprintf(psz_key, sizeof(psz_key), "isrc %u", i);
+      write_value(fp, psz_key, p_disc->apsz_isrc[i]);
+    }
+  if (p_disc->b_cdtext) {
+    size_t j;
+
+    fputs("cdtext", fp);
+    if (p_disc->p_cdtext) {
+      fputc(' ', fp);
+      for (j = 0; j < p_disc->i_cdtext; j++)
+        fprintf(fp, "%02x", p_disc->p_cdtext[j]);
+    }
+    fputc('\n', fp);
+  }
+  b_ok = !ferror(fp);
+  b_ok = (0 == fclose(fp)) && b_ok;
+  if (!b_ok || 0 != rename(psz_tmp, psz_file)) {
+    cdio_info("can't write disc cache file %s", psz_file);
+    remove(psz_tmp);
+  }
+
+ done:
+  free(psz_file);
+  free(psz_tmp);
+}
+
+/* A value on a line of a cache file: NULL for none and "" for an
+   empty one. */
+static char *
+read_value(const char *psz_rest)
+{
+  if (' ' != *psz_rest) return NULL;
+  return strdup(psz_rest + 1);
+}
+
+static uint8_t *
+read_hex(const char *psz_hex, size_t *pi_bytes)
+{
+  const size_t i_len = strlen(psz_hex);
+  uint8_t *p_bytes;
+  size_t i;
+
+  if (0 == i_len || i_len % 2) return NULL;
+  p_bytes = malloc(i_len / 2);
+  if (!p_bytes) return NULL;
+  for (i = 0; i < i_len / 2; i++) {
+    unsigned int i_byte;
+
+    if (1 != sscanf(psz_hex + 2 * i, "%2x", &i_byte)) {
+      free(p_bytes);
+      return NULL;
+    }
+    p_bytes[i] = i_byte;
+  }
+  *pi_bytes = i_len / 2;
+  return p_bytes;
+}
+
+/* Take what the disc's file in the cache directory has, if it is for
+   this disc. Called with the cache locked. */
+static void
+load_disc(cache_disc_t *p_disc)
+{
+  char *psz_file, *p_text = NULL, *psz_line, *psz_next;
+  size_t i_text = 0;
+  bool b_ours = false;
+  FILE *fp;
+
+  if (!psz_cache_dir) return;
+  psz_file = malloc(strlen(psz_cache_dir) + CDIO_DISC_FINGERPRINT_LEN + 2);
+  if (!psz_file) return;
+  sprintf(psz_file, "%s/%s", psz_cache_dir, p_disc->sz_fingerprint);
+  fp = fopen(psz_file, "r");
+  free(psz_file);
+  if (!fp) return;
+  while (!feof(fp) && !ferror(fp) && i_text < MAX_FILE_SIZE) {
+    char *p_more = realloc(p_text, i_text + 4096 + 1);
+
+    if (!p_more) break;
+    p_text = p_more;
+    i_text += fread(p_text + i_text, 1, 4096, fp);
+  }
+  fclose(fp);
+  if (!p_text) return;
+  p_text[i_text] = '\0';
+
+  /* Lines are "key" for none, or "key value". */
+  for (psz_line = p_text; psz_line && *psz_line; psz_line = psz_next) {
+    psz_next = strchr(psz_line, '\n');
+    if (psz_next) *psz_next++ = '\0';
+
+    if (psz_line == p_text) {
+      if (strcmp(psz_line, CACHE_FILE_HEADER)) break;
+    } else if (!strncmp(psz_line, "toc ", 4)) {
+      /* The fingerprint could be another disc's too. */
+      b_ours = !strcmp(psz_line + 4, p_disc->psz_toc);
+      if (!b_ours) break;
+    } else if (!b_ours) {
+      break;
+    } else if (!strncmp(psz_line, "mcn", 3)
+               && ('\0' == psz_line[3] || ' ' == psz_line[3])) {
+      if (!p_disc->b_mcn) {
+        p_disc->psz_mcn = read_value(psz_line + 3);
+        p_disc->b_mcn = true;
+      }
+    } else if (!strncmp(psz_line, "isrc ", 5)) {
+      char *psz_rest;
+      const unsigned long int i_track = strtoul(psz_line + 5, &psz_rest, 10);
+
+      if (psz_rest != psz_line + 5 && i_track <= CDIO_CD_MAX_TRACKS
+          && !p_disc->ab_isrc[i_track]) {
+        p_disc->apsz_isrc[i_track] = read_value(psz_rest);
+        p_disc->ab_isrc[i_track] = true;
+      }
+    } else if (!strncmp(psz_line, "cdtext", 6)
+               && ('\0' == psz_line[6] || ' ' == psz_line[6])) {
+      if (!p_disc->b_cdtext) {
+        p_disc->p_cdtext = ('\0' == psz_line[6]) ? NULL
+          : read_hex(psz_line + 7, &p_disc->i_cdtext);
+        /* CD-Text whose length doesn't match what it says it has is
+           taken as not there, so that it is read again. */
+        if (p_disc->p_cdtext
+            && (p_disc->i_cdtext < 4
+                || CDIO_MMC_GET_LEN16(p_disc->p_cdtext) + 2
+                   != p_disc->i_cdtext)) {
+          free(p_disc->p_cdtext);
+          p_disc->p_cdtext = NULL;
+          continue;
+        }
+        p_disc->b_cdtext = ('\0' == psz_line[6]) || NULL != p_disc->p_cdtext;
+      }
+    }
+  }
+  free(p_text);
+}
+
+static cache_drive_t *
+find_drive(const char *psz_source)
+{
+  cache_drive_t *p_drive;
+
+  for (p_drive = p_cache_drives; p_drive; p_drive = p_drive->p_next)
+    if (!strcmp(p_drive->psz_source, psz_source)) return p_drive;
+  return NULL;
+}
+
+/* Drives are cached; disc images needn't be. */
+static bool
+is_drive(const CdIo_t *p_cdio)
+{
+  return (p_cdio->driver_id >= DRIVER_AIX && p_cdio->driver_id <= DRIVER_WIN32)
+    || DRIVER_MMC_EMU == p_cdio->driver_id;
+}
+
+/* The cached disc in p_cdio's drive, or NULL if not caching. */
+static cache_disc_t *
+find_disc(CdIo_t *p_cdio)
+{
+  const char *psz_source;
+  cache_drive_t *p_drive;
+  cache_disc_t *p_disc;
+  char sz_fingerprint[CDIO_DISC_FINGERPRINT_LEN + 1];
+  char *psz_toc;
+  bool b_enabled, b_reread;
+  int i_changed;
+
+  CACHE_LOCK();
+  b_enabled = b_cache_enabled;
+  CACHE_UNLOCK();
+  if (!b_enabled || !is_drive(p_cdio)) return NULL;
+  psz_source = cdio_get_arg(p_cdio, "source");
+  if (!psz_source) return NULL;
+
+  i_changed = p_cdio->op.get_media_changed
+    ? p_cdio->op.get_media_changed(p_cdio->env) : DRIVER_OP_UNSUPPORTED;
+  if (i_changed > 0) p_cdio->b_cache_media_changed = true;
+
+  CACHE_LOCK();
+  p_drive = find_drive(psz_source);
+  if (p_drive && p_drive->p_disc && 0 == i_changed) {
+    p_disc = p_drive->p_disc;
+    CACHE_UNLOCK();
+    return p_disc;
+  }
+  /* The driver may still have the table of contents of the disc
+     before. */
+  b_reread = i_changed > 0 || (p_drive && !p_drive->p_disc);
+  CACHE_UNLOCK();
+
+  if (b_reread && p_cdio->op.read_toc) p_cdio->op.read_toc(p_cdio->env);
+  psz_toc = get_toc_text(p_cdio);
+  if (psz_toc) make_fingerprint(psz_toc, sz_fingerprint);
+
+  CACHE_LOCK();
+  p_disc = NULL;
+  if (psz_toc && b_cache_enabled) {
+    for (p_disc = p_cache_discs; p_disc; p_disc = p_disc->p_next)
+      if (!strcmp(p_disc->sz_fingerprint, sz_fingerprint)) break;
+    if (!p_disc && (p_disc = calloc(1, sizeof(*p_disc)))) {
+      strcpy(p_disc->sz_fingerprint, sz_fingerprint);
+      p_disc->psz_toc = psz_toc;
+      psz_toc = NULL;
+      load_disc(p_disc);
+      p_disc->p_next = p_cache_discs;
+      p_cache_discs = p_disc;
+    }
+    p_drive = find_drive(psz_source);
+    if (!p_drive && (p_drive = calloc(1, sizeof(*p_drive)))) {
+      p_drive->psz_source = strdup(psz_source);
+      if (p_drive->psz_source) {
+        p_drive->p_next = p_cache_drives;
+        p_cache_drives = p_drive;
+      } else {
+        free(p_drive);
+        p_drive = NULL;
+      }
+    }
+  }
+  if (p_drive) p_drive->p_disc = p_disc;
+  CACHE_UNLOCK();
+  free(psz_toc);
+  return p_disc;
+}
+
+char *
+cdio_disc_cache_get_mcn(const CdIo_t *p_cdio)
+{
+  cache_disc_t *p_disc = find_disc((CdIo_t *) p_cdio);
+  char *psz_mcn;
+
+  if (p_disc) {
+    CACHE_LOCK();
+    if (p_disc->b_mcn) {
+      psz_mcn = p_disc->psz_mcn ? strdup(p_disc->psz_mcn) : NULL;
+      CACHE_UNLOCK();
+      return psz_mcn;
+    }
+    CACHE_UNLOCK();
+  }
+
+  psz_mcn = p_cdio->op.get_mcn(p_cdio->env);
+  if (p_disc) {
+    CACHE_LOCK();
+    if (!p_disc->b_mcn) {
+      p_disc->psz_mcn = psz_mcn ? strdup(psz_mcn) : NULL;
+      p_disc->b_mcn = true;
+      save_disc(p_disc);
+    }
+    CACHE_UNLOCK();
+  }
+  return psz_mcn;
+}
+
+char *
+cdio_disc_cache_get_isrc(const CdIo_t *p_cdio, track_t i_track)
+{
+  cache_disc_t *p_disc = (i_track <= CDIO_CD_MAX_TRACKS)
+    ? find_disc((CdIo_t *) p_cdio) : NULL;
+  char *psz_isrc;
+
+  if (p_disc) {
+    CACHE_LOCK();
+    if (p_disc->ab_isrc[i_track]) {
+      psz_isrc = p_disc->apsz_isrc[i_track]
+        ? strdup(p_disc->apsz_isrc[i_track]) : NULL;
+      CACHE_UNLOCK();
+      return psz_isrc;
+    }
+    CACHE_UNLOCK();
+  }
+
+  psz_isrc = p_cdio->op.get_track_isrc(p_cdio->env, i_track);
+  if (p_disc) {
+    CACHE_LOCK();
+    if (!p_disc->ab_isrc[i_track]) {
+      p_disc->apsz_isrc[i_track] = psz_isrc ? strdup(psz_isrc) : NULL;
+      p_disc->ab_isrc[i_track] = true;
+      save_disc(p_disc);
+    }
+    CACHE_UNLOCK();
+  }
+  return psz_isrc;
+}
+
+/* CD-Text as cdio_get_cdtext_raw() gives it, from the cache when
+   p_disc has it. */
+static uint8_t *
+get_cdtext_raw(CdIo_t *p_cdio, cache_disc_t *p_disc)
+{
+  uint8_t *p_cdtext;
+  size_t i_cdtext;
+
+  if (p_disc) {
+    CACHE_LOCK();
+    if (p_disc->b_cdtext) {
+      p_cdtext = NULL;
+      if (p_disc->p_cdtext && (p_cdtext = malloc(p_disc->i_cdtext)))
+        memcpy(p_cdtext, p_disc->p_cdtext, p_disc->i_cdtext);
+      CACHE_UNLOCK();
+      return p_cdtext;
+    }
+    CACHE_UNLOCK();
+  }
+
+  p_cdtext = p_cdio->op.get_cdtext_raw(p_cdio->env);
+  if (p_disc) {
+    i_cdtext = p_cdtext ? CDIO_MMC_GET_LEN16(p_cdtext) + 2 : 0;
+    CACHE_LOCK();
+    if (!p_disc->b_cdtext) {
+      p_disc->p_cdtext = p_cdtext ? malloc(i_cdtext) : NULL;
+      if (p_disc->p_cdtext) {
+        memcpy(p_disc->p_cdtext, p_cdtext, i_cdtext);
+        p_disc->i_cdtext = i_cdtext;
+      }
+      p_disc->b_cdtext = !p_cdtext || p_disc->p_cdtext;
+      if (p_disc->b_cdtext) save_disc(p_disc);
+    }
+    CACHE_UNLOCK();
+  }
+  return p_cdtext;
+}
+
+uint8_t *
+cdio_disc_cache_get_cdtext_raw(CdIo_t *p_cdio)
+{
+  return get_cdtext_raw(p_cdio, find_disc(p_cdio));
+}
+
+cdtext_t *
+cdio_disc_cache_get_cdtext(CdIo_t *p_cdio)
+{
+  cache_disc_t *p_disc;
+  uint8_t *p_cdtext;
+
+  if (!p_cdio->op.get_cdtext_raw || !(p_disc = find_disc(p_cdio)))
+    return p_cdio->op.get_cdtext(p_cdio->env);
+  if (!strcmp(p_cdio->sz_cache_cdtext_disc, p_disc->sz_fingerprint))
+    return p_cdio->p_cache_cdtext;
+
+  /* As get_cdtext_generic() does. */
+  if (p_cdio->p_cache_cdtext) cdtext_destroy(p_cdio->p_cache_cdtext);
+  p_cdio->p_cache_cdtext = NULL;
+  p_cdtext = get_cdtext_raw(p_cdio, p_disc);
+  if (p_cdtext) {
+    const int i_len = CDIO_MMC_GET_LEN16(p_cdtext) - 2;
+
+    p_cdio->p_cache_cdtext = cdtext_init();
+    if (i_len <= 0
+        || 0 != cdtext_data_init(p_cdio->p_cache_cdtext, &p_cdtext[4], i_len)) {
+      cdtext_destroy(p_cdio->p_cache_cdtext);
+      p_cdio->p_cache_cdtext = NULL;
+    }
+    free(p_cdtext);
+  }
+  strcpy(p_cdio->sz_cache_cdtext_disc, p_disc->sz_fingerprint);
+  return p_cdio->p_cache_cdtext;
+}
+
+int
+cdio_disc_cache_get_media_changed(CdIo_t *p_cdio)
+{
+  int i_changed = p_cdio->op.get_media_changed(p_cdio->env);
+
+  if (i_changed > 0 && is_drive(p_cdio)) {
+    const char *psz_source = cdio_get_arg(p_cdio, "source");
+    cache_drive_t *p_drive;
+
+    CACHE_LOCK();
+    if (psz_source && (p_drive = find_drive(psz_source)))
+      p_drive->p_disc = NULL;
+    CACHE_UNLOCK();
+  }
+  if (p_cdio->b_cache_media_changed) {
+    p_cdio->b_cache_media_changed = false;
+    i_changed = 1;
+  }
+  return i_changed;
+}
+
+driver_return_code_t
+cdio_disc_cache_enable(const char *psz_dir)
+{
+  char *psz_new_dir = NULL;
+
+  if (psz_dir) {
+#ifdef HAVE_SYS_STAT_H
+    struct stat st;
+
+    if (0 != stat(psz_dir, &st) || !S_ISDIR(st.st_mode)) {
+      cdio_warn("disc cache %s isn't a directory", psz_dir);
+      return DRIVER_OP_ERROR;
+    }
+#endif
+    psz_new_dir = strdup(psz_dir);
+    if (!psz_new_dir) return DRIVER_OP_ERROR;
+  }
+
+  CACHE_LOCK();
+  free(psz_cache_dir);
+  psz_cache_dir = psz_new_dir;
+  b_cache_enabled = true;
+  CACHE_UNLOCK();
+  return DRIVER_OP_SUCCESS;
+}
+
+void
+cdio_disc_cache_disable(void)
+{
+  CACHE_LOCK();
+  while (p_cache_discs) {
+    cache_disc_t *p_next = p_cache_discs->p_next;
+
+    free_disc(p_cache_discs);
+    p_cache_discs = p_next;
+  }
+  while (p_cache_drives) {
+    cache_drive_t *p_next = p_cache_drives->p_next;
+
+    free(p_cache_drives->psz_source);
+    free(p_cache_drives);
+    p_cache_drives = p_next;
+  }
+  free(psz_cache_dir);
+  psz_cache_dir = NULL;
+  b_cache_enabled = false;
+  CACHE_UNLOCK();
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
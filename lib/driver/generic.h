@@ -87,6 +87,10 @@ extern "C" {
                                or empty text, or NULL. No other forms.
     */
     char *scsi_tuple;
+
+    /* True if fd was opened or later set with O_DIRECT, so that reads
+       on it must go to and from suitably aligned memory. */
+    bool b_direct_io;
   } generic_img_private_t;
 
   /*!
@@ -138,7 +142,7 @@ extern "C" {
 
   /*!
     Reads a single form1 sector from cd device into data starting
-    from lsn. Returns 0 if no error.
+    from lsn. Returns DRIVER_OP_SUCCESS if no error.
   */
   int cdio_generic_read_form1_sector (void * user_data, void *data,
                                       lsn_t lsn);
@@ -238,6 +242,25 @@ extern "C" {
                                                   void *p_buf, lsn_t i_lsn,
                                                   uint16_t i_blocksize,
                                                   uint32_t i_blocks);
+
+  /*!
+    Read i_blocks blocks of i_blocksize bytes starting at block i_lsn
+    of the device in p_env->fd into p_buf.
+
+    The blocks are read with as few pread()s as the transfer limit of
+    the device, cdio_get_arg(p_cdio, "mmc-max-transfer"), allows,
+    rather than a seek and read per block. Short reads are continued
+    where they left off. When the device was opened for direct I/O
+    and p_buf isn't aligned for it, the blocks are read through an
+    aligned buffer instead.
+
+    @return DRIVER_OP_SUCCESS if every block was read, DRIVER_OP_ERROR
+    otherwise.
+  */
+  driver_return_code_t cdio_generic_read_blocks (void *p_env, void *p_buf,
+                                                 lsn_t i_lsn,
+                                                 uint16_t i_blocksize,
+                                                 uint32_t i_blocks);
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -21,6 +21,10 @@
    control of the CD drive.
 */
 
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE /* for O_DIRECT */
+#endif
+
 #ifdef HAVE_CONFIG_H
 # include "config.h"
 # define __CDIO_CONFIG_H__ 1
@@ -75,6 +79,8 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <poll.h>
+#include <dirent.h>
 
 #ifndef PATH_MAX
 #define PATH_MAX 4096
@@ -89,12 +95,23 @@ typedef enum {
   _AM_MMC_RDWR_EXCL,
 } access_mode_t;
 
+/* How MMC commands get to the drive. */
+typedef enum {
+  _TRANSPORT_SEND_PACKET,       /* ioctl CDROM_SEND_PACKET */
+  _TRANSPORT_SG_IO,             /* ioctl SG_IO */
+} mmc_transport_t;
+
 typedef struct {
   /* Things common to all drivers like this.
      This must be first. */
   generic_img_private_t gen;
 
   access_mode_t access_mode;
+  mmc_transport_t transport;
+
+  /* True if fd is a SCSI generic device, /dev/sg*, which can have
+     several commands outstanding through write() and read(). */
+  bool b_sg_async;
 
   /* Some of the more OS specific things. */
   /* Entry info for each track, add 1 for leadout. */
@@ -409,6 +426,11 @@ get_arg_linux (void *env, const char key[])
     return _obj->gen.scsi_tuple;
   } else if (!strcmp (key, "mmc-supported?")) {
       return is_mmc_supported(env) ? "true" : "false";
+  } else if (!strcmp (key, "direct-io")) {
+    return _obj->gen.b_direct_io ? "true" : "false";
+  } else if (!strcmp (key, "mmc-transport")) {
+    return (_TRANSPORT_SG_IO == _obj->transport)
+      ? "SG_IO" : "CDROM_SEND_PACKET";
   }
   return NULL;
 }
@@ -931,7 +953,7 @@ is_cdrom_linux(const char *drive, char *mnttype)
 }
 
 /* MMC driver to read audio sectors.
-   Can read only up to 25 blocks.
+   Reads are split at the most the host can transfer at once.
 */
 static driver_return_code_t
 read_audio_sectors_linux (void *p_user_data, void *p_buf, lsn_t i_lsn,
@@ -943,7 +965,7 @@ read_audio_sectors_linux (void *p_user_data, void *p_buf, lsn_t i_lsn,
 }
 
 /* Packet driver to read mode2 sectors.
-   Can read only up to 25 blocks.
+   Can read only as many blocks as mmc_get_read_chunk() allows.
 */
 static driver_return_code_t
 _read_mode2_sectors_mmc (_img_private_t *p_env, void *p_buf, lba_t lba,
@@ -995,12 +1017,17 @@ static driver_return_code_t
 _read_mode2_sectors (_img_private_t *p_env, void *p_buf, lba_t lba,
                      uint32_t i_blocks, bool b_read_10)
 {
+  /* 25 blocks at a time if we don't know how much the host can take;
+     READ(10) has a 16-bit length, READ CD a 24-bit one. */
+  const uint32_t i_chunk =
+    mmc_get_read_chunk(p_env->gen.cdio, M2RAW_SECTOR_SIZE, 25,
+                       b_read_10 ? 0xFFFF : 0xFFFFFF);
   unsigned int l = 0;
   int retval = 0;
 
   while (i_blocks > 0)
     {
-      const unsigned i_blocks2 = (i_blocks > 25) ? 25 : i_blocks;
+      const unsigned i_blocks2 = (i_blocks > i_chunk) ? i_chunk : i_blocks;
       void *p_buf2 = ((char *)p_buf ) + (l * M2RAW_SECTOR_SIZE);
 
       retval |= _read_mode2_sectors_mmc (p_env, p_buf2, lba + l,
@@ -1028,7 +1055,7 @@ _read_mode1_sector_linux (void *p_user_data, void *p_data, lsn_t lsn,
 }
 
 /*!
-   Reads i_blocks of mode2 sectors from cd device into data starting
+   Reads i_blocks of mode1 sectors from cd device into data starting
    from lsn.
    Returns 0 if no error.
  */
@@ -1041,6 +1068,12 @@ _read_mode1_sectors_linux (void *p_user_data, void *p_data, lsn_t lsn,
   int retval;
   unsigned int blocksize = b_form2 ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE;
 
+  /* Form 1 sectors lie back to back on the device, so they can be read
+     in as few requests as the device allows. */
+  if (!b_form2)
+    return cdio_generic_read_blocks(p_env, p_data, lsn, CDIO_CD_FRAMESIZE,
+                                    i_blocks);
+
   for (i = 0; i < i_blocks; i++) {
     if ( (retval = _read_mode1_sector_linux (p_env,
                                             ((char *)p_data) + (blocksize*i),
@@ -1222,6 +1255,191 @@ read_toc_linux (void *p_user_data)
   return true;
 }
 
+/* The driver_return_code_t for a failed MMC ioctl, read or write. */
+static driver_return_code_t
+errno_to_status_linux(int i_errno)
+{
+  switch (i_errno) {
+  case EPERM:
+    return DRIVER_OP_NOT_PERMITTED;
+  case EINVAL:
+    return DRIVER_OP_BAD_PARAMETER;
+  case EFAULT:
+    return DRIVER_OP_BAD_POINTER;
+  case EIO:
+  default:
+    return DRIVER_OP_ERROR;
+  }
+}
+
+/* Set up *p_hdr to run an MMC command through the SCSI generic (sg)
+   version 3 interface. p_sense gets the sense reply. */
+static void
+fill_sg_io_hdr_linux(struct sg_io_hdr *p_hdr, unsigned int i_timeout_ms,
+                     unsigned int i_cdb, const mmc_cdb_t *p_cdb,
+                     cdio_mmc_direction_t e_direction,
+                     unsigned int i_buf, void *p_buf,
+                     cdio_mmc_request_sense_t *p_sense)
+{
+  memset(p_hdr, 0, sizeof(*p_hdr));
+  memset(p_sense, 0, sizeof(*p_sense));
+  p_hdr->interface_id = 'S';
+  p_hdr->cmd_len      = i_cdb;
+  p_hdr->cmdp         = (unsigned char *) p_cdb->field;
+  p_hdr->sbp          = (unsigned char *) p_sense;
+  p_hdr->mx_sb_len    = sizeof(*p_sense);
+  p_hdr->timeout      = i_timeout_ms ? i_timeout_ms : mmc_timeout_ms;
+
+  if (0 == i_buf || SCSI_MMC_DATA_NONE == e_direction) {
+    p_hdr->dxfer_direction = SG_DXFER_NONE;
+  } else {
+    p_hdr->dxfer_direction = (SCSI_MMC_DATA_READ == e_direction)
+      ? SG_DXFER_FROM_DEV : SG_DXFER_TO_DEV;
+    p_hdr->dxfer_len = i_buf;
+    p_hdr->dxferp    = p_buf;
+  }
+}
+
+/* How a command run through the sg interface went. */
+static driver_return_code_t
+sg_io_status_linux(const struct sg_io_hdr *p_hdr)
+{
+  if (SG_INFO_OK == (p_hdr->info & SG_INFO_OK_MASK))
+    return DRIVER_OP_SUCCESS;
+  cdio_info("SG_IO command %s (0x%0x) failed: status 0x%x, host status "
+            "0x%x, driver status 0x%x",
+            mmc_cmd2str(p_hdr->cmdp ? p_hdr->cmdp[0] : 0),
+            p_hdr->cmdp ? p_hdr->cmdp[0] : 0, p_hdr->status,
+            p_hdr->host_status, p_hdr->driver_status);
+  return DRIVER_OP_ERROR;
+}
+
+/*!
+  Run a SCSI MMC command with the SG_IO ioctl, which works on both
+  CD-ROM block devices and SCSI generic devices. Arguments are as for
+  run_mmc_cmd_linux().
+*/
+static driver_return_code_t
+run_mmc_cmd_sg_io_linux(_img_private_t *p_env, unsigned int i_timeout_ms,
+                        unsigned int i_cdb, const mmc_cdb_t *p_cdb,
+                        cdio_mmc_direction_t e_direction,
+                        unsigned int i_buf, /*in/out*/ void *p_buf)
+{
+  struct sg_io_hdr hdr;
+  cdio_mmc_request_sense_t sense;
+
+  p_env->gen.scsi_mmc_sense_valid = 0;
+  fill_sg_io_hdr_linux(&hdr, i_timeout_ms, i_cdb, p_cdb, e_direction,
+                       i_buf, p_buf, &sense);
+
+  if (-1 == ioctl(p_env->gen.fd, SG_IO, &hdr)) {
+    cdio_info("ioctl SG_IO for command %s (0x%0x) failed:\n\t%s",
+              mmc_cmd2str((uint8_t) p_cdb->field[0]), p_cdb->field[0],
+              strerror(errno));
+    return errno_to_status_linux(errno);
+  }
+
+  /* Record SCSI sense reply for API call mmc_last_cmd_sense(). */
+  if (hdr.sb_len_wr > 0) {
+    memcpy((void *) p_env->gen.scsi_mmc_sense, &sense, hdr.sb_len_wr);
+    p_env->gen.scsi_mmc_sense_valid = hdr.sb_len_wr;
+  }
+  return sg_io_status_linux(&hdr);
+}
+
+/*!
+  Queue an MMC command on a SCSI generic device without waiting for
+  it, by writing its sg_io_hdr to the device. The reply is read back
+  by reap_mmc_cmds_linux().
+
+  When the device is not a SCSI generic one, or its queue is full,
+  DRIVER_OP_UNSUPPORTED is returned so that the command is run
+  synchronously instead.
+*/
+static driver_return_code_t
+submit_mmc_cmd_linux(void *p_user_data, mmc_async_cmd_t *p_cmd)
+{
+  _img_private_t *p_env = p_user_data;
+  struct sg_io_hdr hdr;
+  ssize_t i_written;
+
+  if (!p_env->b_sg_async) return DRIVER_OP_UNSUPPORTED;
+
+  fill_sg_io_hdr_linux(&hdr, p_cmd->i_timeout_ms, p_cmd->i_cdb, &p_cmd->cdb,
+                       p_cmd->e_direction, p_cmd->i_buf, p_cmd->p_buf,
+                       &p_cmd->sense);
+  hdr.usr_ptr = p_cmd;
+
+  do {
+    i_written = write(p_env->gen.fd, &hdr, sizeof(hdr));
+  } while (i_written < 0 && EINTR == errno);
+
+  if (i_written < 0) {
+    /* EDOM: the sg driver has as many commands queued as it takes. */
+    if (EDOM == errno || EAGAIN == errno) return DRIVER_OP_UNSUPPORTED;
+    cdio_info("write of command %s (0x%0x) to %s failed:\n\t%s",
+              mmc_cmd2str((uint8_t) p_cmd->cdb.field[0]),
+              p_cmd->cdb.field[0], p_env->gen.source_name, strerror(errno));
+    return errno_to_status_linux(errno);
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Read back up to i_max replies to commands queued by
+  submit_mmc_cmd_linux(), waiting up to i_timeout_ms for the first.
+*/
+static int
+reap_mmc_cmds_linux(void *p_user_data, mmc_async_cmd_t *ap_done[],
+                    unsigned int i_max, int i_timeout_ms)
+{
+  _img_private_t *p_env = p_user_data;
+  unsigned int i_done = 0;
+
+  while (i_done < i_max) {
+    struct sg_io_hdr hdr;
+    mmc_async_cmd_t *p_cmd;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.interface_id = 'S';
+    if (read(p_env->gen.fd, &hdr, sizeof(hdr)) < 0) {
+      if (EINTR == errno) continue;
+      if (EAGAIN == errno && 0 == i_done && 0 != i_timeout_ms) {
+        struct pollfd pfd;
+        int i_ready;
+
+        pfd.fd = p_env->gen.fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        i_ready = poll(&pfd, 1, i_timeout_ms);
+        if (i_ready < 0 && EINTR == errno) continue;
+        if (i_ready <= 0) break;
+        /* Don't wait again if the reply isn't there after all. */
+        i_timeout_ms = 0;
+        continue;
+      }
+      if (EAGAIN == errno) break;
+      cdio_warn("read of replies from %s failed: %s",
+                p_env->gen.source_name, strerror(errno));
+      return i_done ? (int) i_done : errno_to_status_linux(errno);
+    }
+
+    p_cmd = hdr.usr_ptr;
+    p_cmd->i_status = sg_io_status_linux(&hdr);
+    p_cmd->i_sense  = hdr.sb_len_wr;
+    ap_done[i_done++] = p_cmd;
+  }
+  return (int) i_done;
+}
+
+static int
+get_mmc_completion_fd_linux(void *p_user_data)
+{
+  const _img_private_t *p_env = p_user_data;
+
+  return p_env->b_sg_async ? p_env->gen.fd : -1;
+}
+
 /*!
   Run a SCSI MMC command.
 
@@ -1248,6 +1466,10 @@ run_mmc_cmd_linux(void *p_user_data,
   struct cdrom_generic_command cgc;
   cdio_mmc_request_sense_t sense;
 
+  if (_TRANSPORT_SG_IO == p_env->transport)
+    return run_mmc_cmd_sg_io_linux(p_env, i_timeout_ms, i_cdb, p_cdb,
+                                   e_direction, i_buf, p_buf);
+
   p_env->gen.scsi_mmc_sense_valid = 0;
 
   memset(&cgc, 0, sizeof (struct cdrom_generic_command));
@@ -1288,21 +1510,7 @@ run_mmc_cmd_linux(void *p_user_data,
                 mmc_cmd2str((uint8_t) p_cdb->field[0]),
                 p_cdb->field[0],
                 strerror(errno));
-      switch (errno) {
-      case EPERM:
-        return DRIVER_OP_NOT_PERMITTED;
-        break;
-      case EINVAL:
-        return DRIVER_OP_BAD_PARAMETER;
-        break;
-      case EFAULT:
-        return DRIVER_OP_BAD_POINTER;
-        break;
-      case EIO:
-      default:
-        return DRIVER_OP_ERROR;
-        break;
-      }
+      return errno_to_status_linux(errno);
     } else if (i_rc < -1)
       return DRIVER_OP_ERROR;
     else
@@ -1352,9 +1560,15 @@ get_disc_last_lsn_linux (void *p_user_data)
 
 /*!
   Set the arg "key" with "value" in the source device.
-  Currently "source" and "access-mode" are valid keys.
+  Currently "source", "access-mode", "direct-io" and "mmc-transport"
+  are valid keys.
   "source" sets the source device in I/O operations
   "access-mode" sets the the method of CD access
+  "direct-io" is "true" to read data sectors with O_DIRECT, bypassing
+  the page cache, or "false" to go back to buffered reads
+  "mmc-transport" is "SG_IO" to send MMC commands with the SG_IO ioctl
+  or "CDROM_SEND_PACKET" to use the CD-ROM driver's ioctl, which is
+  the default for block devices. SCSI generic devices only take SG_IO.
 
   DRIVER_OP_SUCCESS is returned if no error was found,
   and nonzero if there as an error.
@@ -1374,6 +1588,48 @@ set_arg_linux (void *p_user_data, const char key[], const char value[])
     {
       p_env->access_mode = str_to_access_mode_linux(key);
     }
+  else if (!strcmp (key, "direct-io"))
+    {
+      bool b_direct_io;
+#ifdef O_DIRECT
+      int i_flags;
+#endif
+
+      if (!value) return DRIVER_OP_BAD_PARAMETER;
+      if (!strcmp (value, "true"))
+        b_direct_io = true;
+      else if (!strcmp (value, "false"))
+        b_direct_io = false;
+      else
+        return DRIVER_OP_BAD_PARAMETER;
+#ifdef O_DIRECT
+      if (p_env->gen.fd < 0) return DRIVER_OP_UNINIT;
+      i_flags = fcntl (p_env->gen.fd, F_GETFL);
+      if (i_flags < 0
+          || fcntl (p_env->gen.fd, F_SETFL,
+                    b_direct_io ? (i_flags | O_DIRECT)
+                                : (i_flags & ~O_DIRECT)) < 0)
+        {
+          cdio_warn ("can't %s direct I/O on %s: %s",
+                     b_direct_io ? "turn on" : "turn off",
+                     p_env->gen.source_name, strerror (errno));
+          return DRIVER_OP_ERROR;
+        }
+      p_env->gen.b_direct_io = b_direct_io;
+#else
+      if (b_direct_io) return DRIVER_OP_UNSUPPORTED;
+#endif
+    }
+  else if (!strcmp (key, "mmc-transport"))
+    {
+      if (!value) return DRIVER_OP_BAD_PARAMETER;
+      if (!strcmp (value, "SG_IO"))
+        p_env->transport = _TRANSPORT_SG_IO;
+      else if (!strcmp (value, "CDROM_SEND_PACKET") && !p_env->b_sg_async)
+        p_env->transport = _TRANSPORT_SEND_PACKET;
+      else
+        return DRIVER_OP_BAD_PARAMETER;
+    }
   else return DRIVER_OP_ERROR;
 
   return DRIVER_OP_SUCCESS;
@@ -1399,6 +1655,50 @@ checklist2[] =
   };
 static const int checklist2_size = sizeof(checklist2) / sizeof(checklist2[0]);
 
+/* Whether the block device psz_name in the sysfs directory
+   psz_sys_block is a CD drive: a SCSI device of type TYPE_ROM, or an
+   IDE one whose media is "cdrom". */
+static bool
+is_cdrom_sysfs_linux(const char *psz_sys_block, const char *psz_name)
+{
+  char psz_path[PATH_MAX];
+  char buf[16] = "";
+  bool b_cd = false;
+  FILE *fp;
+
+  snprintf(psz_path, sizeof(psz_path), "%s/%s/device/type", psz_sys_block,
+           psz_name);
+  if ((fp = fopen(psz_path, "r"))) {
+    b_cd = fgets(buf, sizeof(buf), fp) && TYPE_ROM == atoi(buf);
+    fclose(fp);
+    return b_cd;
+  }
+  snprintf(psz_path, sizeof(psz_path), "%s/%s/device/media", psz_sys_block,
+           psz_name);
+  if ((fp = fopen(psz_path, "r"))) {
+    b_cd = fgets(buf, sizeof(buf), fp) && 0 == strncmp(buf, "cdrom", 5);
+    fclose(fp);
+  }
+  return b_cd;
+}
+
+/* Order block device names as sr2 before sr10. */
+static int
+compare_block_names(const void *p1, const void *p2)
+{
+  const char *psz1 = *(const char * const *) p1;
+  const char *psz2 = *(const char * const *) p2;
+  const size_t i_len1 = strcspn(psz1, "0123456789");
+  const size_t i_len2 = strcspn(psz2, "0123456789");
+  const int i_cmp = strncmp(psz1, psz2, i_len1 < i_len2 ? i_len1 : i_len2);
+
+  if (i_cmp || i_len1 != i_len2)
+    return i_cmp ? i_cmp : (i_len1 < i_len2 ? -1 : 1);
+  if (strlen(psz1) != strlen(psz2))
+    return strlen(psz1) < strlen(psz2) ? -1 : 1;
+  return strcmp(psz1, psz2);
+}
+
 
 /* Set CD-ROM drive speed */
 static driver_return_code_t
@@ -1412,6 +1712,54 @@ set_speed_linux (void *p_user_data, int i_drive_speed)
 
 #endif /* HAVE_LINUX_CDROM */
 
+/*!
+  Return the CD drives in sysfs, as device names in psz_dev, or NULL
+  if psz_sys_block can't be read.
+ */
+char **
+cdio_get_devices_sysfs_linux (const char *psz_sys_block, const char *psz_dev)
+{
+#ifndef HAVE_LINUX_CDROM
+  return NULL;
+#else
+  DIR *p_dir;
+  struct dirent *p_entry;
+  char **ppsz_names = NULL;
+  char **drives = NULL;
+  unsigned int i, i_names = 0, num_drives = 0;
+
+  if (!psz_sys_block || !psz_dev) return NULL;
+  p_dir = opendir(psz_sys_block);
+  if (!p_dir) return NULL;
+  while ((p_entry = readdir(p_dir))) {
+    char **ppsz_more;
+
+    if ('.' == p_entry->d_name[0]
+        || !is_cdrom_sysfs_linux(psz_sys_block, p_entry->d_name))
+      continue;
+    ppsz_more = realloc(ppsz_names, (i_names + 1) * sizeof(char *));
+    if (!ppsz_more) break;
+    ppsz_names = ppsz_more;
+    if ((ppsz_names[i_names] = strdup(p_entry->d_name))) i_names++;
+  }
+  closedir(p_dir);
+
+  if (i_names) qsort(ppsz_names, i_names, sizeof(char *), compare_block_names);
+  for (i = 0; i < i_names; i++) {
+    char drive[PATH_MAX];
+
+    /* Without udev there may be no device for it. */
+    if (snprintf(drive, sizeof(drive), "%s/%s", psz_dev, ppsz_names[i]) > 0
+        && 0 == access(drive, F_OK))
+      cdio_add_device_list(&drives, drive, &num_drives);
+    free(ppsz_names[i]);
+  }
+  free(ppsz_names);
+  cdio_add_device_list(&drives, NULL, &num_drives);
+  return drives;
+#endif /*HAVE_LINUX_CDROM*/
+}
+
 /*!
   Return an array of strings giving possible CD devices.
  */
@@ -1425,6 +1773,7 @@ cdio_get_devices_linux (void)
   char drive[40];
   char *ret_drive;
   char **drives = NULL;
+  char **ppsz_sysfs;
   unsigned int num_drives=0;
 
   /* Scan the system for CD-ROM drives.
@@ -1449,16 +1798,23 @@ cdio_get_devices_linux (void)
     free(ret_drive);
   }
 
-  /* Scan the system for CD-ROM drives.
-     Not always 100% reliable, so use the USE_MNTENT code above first.
+  /* The kernel lists its CD drives in sysfs. Only without it are
+     the usual device names each opened to see.
   */
-  for ( i=0; i < checklist2_size; ++i ) {
-    unsigned int j;
-    for ( j=checklist2[i].num_min; j<=checklist2[i].num_max; ++j ) {
-      if (snprintf(drive, sizeof(drive), checklist2[i].format, j) < 0)
-        continue;
-      if ( (is_cdrom_linux(drive, NULL)) > 0 ) {
-        cdio_add_device_list(&drives, drive, &num_drives);
+  if (NULL != (ppsz_sysfs = cdio_get_devices_sysfs_linux("/sys/block",
+                                                         "/dev"))) {
+    for ( i=0; ppsz_sysfs[i]; ++i )
+      cdio_add_device_list(&drives, ppsz_sysfs[i], &num_drives);
+    cdio_free_device_list(ppsz_sysfs);
+  } else {
+    for ( i=0; i < checklist2_size; ++i ) {
+      unsigned int j;
+      for ( j=checklist2[i].num_min; j<=checklist2[i].num_max; ++j ) {
+        if (snprintf(drive, sizeof(drive), checklist2[i].format, j) < 0)
+          continue;
+        if ( (is_cdrom_linux(drive, NULL)) > 0 ) {
+          cdio_add_device_list(&drives, drive, &num_drives);
+        }
       }
     }
   }
@@ -1480,6 +1836,7 @@ cdio_get_default_device_linux(void)
   unsigned int i;
   char drive[40];
   char *ret_drive;
+  char **ppsz_sysfs;
 
   /* Scan the system for CD-ROM drives.
   */
@@ -1499,9 +1856,15 @@ cdio_get_default_device_linux(void)
   if (NULL != (ret_drive = check_mounts_linux("/etc/fstab")))
     return ret_drive;
 
-  /* Scan the system for CD-ROM drives.
-     Not always 100% reliable, so use the USE_MNTENT code above first.
+  /* The first CD drive in sysfs, or without it, the first of the
+     usual device names that is one.
   */
+  if (NULL != (ppsz_sysfs = cdio_get_devices_sysfs_linux("/sys/block",
+                                                         "/dev"))) {
+    ret_drive = ppsz_sysfs[0] ? strdup(ppsz_sysfs[0]) : NULL;
+    cdio_free_device_list(ppsz_sysfs);
+    return ret_drive;
+  }
   for ( i=0; i < checklist2_size; ++i ) {
     unsigned int j;
     for ( j=checklist2[i].num_min; j<=checklist2[i].num_max; ++j ) {
@@ -1563,6 +1926,48 @@ close_tray_linux (const char *psz_device)
 }
 
 #ifdef HAVE_LINUX_CDROM
+/*!
+  Return the most bytes a packet command sent to the device may
+  transfer, or 0 if that can't be found out. Packet commands are held
+  to the hardware limit of the request queue, max_hw_sectors_kb; the
+  BLKSECTGET ioctl gives the limit of regular I/O, which is no more
+  than that, so it is used only if sysfs can't be read.
+*/
+static uint32_t
+get_max_transfer_linux(const _img_private_t *p_env)
+{
+  char psz_device[PATH_MAX];
+  char psz_sysfs[PATH_MAX + 64];
+  unsigned short i_sectors = 0;
+
+  if (p_env->gen.source_name
+      && cdio_realpath(p_env->gen.source_name, psz_device)) {
+    const char *psz_name = strrchr(psz_device, '/');
+    FILE *p_file;
+
+    snprintf(psz_sysfs, sizeof(psz_sysfs),
+             "/sys/block/%s/queue/max_hw_sectors_kb",
+             psz_name ? psz_name + 1 : psz_device);
+    p_file = fopen(psz_sysfs, "r");
+    if (p_file) {
+      unsigned long int i_kb = 0;
+      const int i_read = fscanf(p_file, "%lu", &i_kb);
+
+      fclose(p_file);
+      if (1 == i_read && i_kb > 0) {
+        if (i_kb > 0xffffffffUL / 1024) i_kb = 0xffffffffUL / 1024;
+        return (uint32_t) i_kb * 1024;
+      }
+    }
+  }
+
+#ifdef BLKSECTGET
+  if (0 == ioctl(p_env->gen.fd, BLKSECTGET, &i_sectors) && i_sectors > 0)
+    return (uint32_t) i_sectors * 512;
+#endif
+  return 0;
+}
+
 /*!
   Produce a text composed from the system SCSI address tuple according to
   habits of Linux 2.4 and 2.6 :  "Bus,Host,Channel,Target,Lun" and store
@@ -1715,6 +2120,7 @@ cdio_open_am_linux (const char *psz_orig_source, const char *access_mode)
     .get_last_session      = get_last_session_linux,
     .get_media_changed     = get_media_changed_linux,
     .get_mcn               = get_mcn_linux,
+    .get_mmc_completion_fd = get_mmc_completion_fd_linux,
     .get_num_tracks        = get_num_tracks_generic,
     .get_track_channels    = get_track_channels_generic,
     .get_track_copy_permit = get_track_copy_permit_generic,
@@ -1737,6 +2143,7 @@ cdio_open_am_linux (const char *psz_orig_source, const char *access_mode)
     .read_mode2_sector     = _read_mode2_sector_linux,
     .read_mode2_sectors    = _read_mode2_sectors_linux,
     .read_toc              = read_toc_linux,
+    .reap_mmc_cmds         = reap_mmc_cmds_linux,
     .run_mmc_cmd           = run_mmc_cmd_linux,
     .set_arg               = set_arg_linux,
     .set_blocksize         = set_blocksize_mmc,
@@ -1745,6 +2152,7 @@ cdio_open_am_linux (const char *psz_orig_source, const char *access_mode)
 #else
     .set_speed             = set_speed_mmc,
 #endif
+    .submit_mmc_cmd        = submit_mmc_cmd_linux,
   };
 
   _data                 = calloc (1, sizeof (_img_private_t));
@@ -1794,7 +2202,22 @@ cdio_open_am_linux (const char *psz_orig_source, const char *access_mode)
   else
     open_access_mode |= O_RDONLY;
   if (cdio_generic_init(_data, open_access_mode)) {
+    char psz_max_transfer[11];
+    struct stat st;
+    int i_sg_version = 0;
+
+    /* SCSI generic devices take only SG_IO, but can queue commands. */
+    if (0 == fstat(_data->gen.fd, &st) && S_ISCHR(st.st_mode)
+        && 0 == ioctl(_data->gen.fd, SG_GET_VERSION_NUM, &i_sg_version)
+        && i_sg_version >= 30000) {
+      _data->transport  = _TRANSPORT_SG_IO;
+      _data->b_sg_async = true;
+    }
+
     set_scsi_tuple_linux(_data);
+    snprintf(psz_max_transfer, sizeof(psz_max_transfer), "%lu",
+             (unsigned long int) get_max_transfer_linux(_data));
+    cdio_set_arg(ret, "mmc-max-transfer", psz_max_transfer);
     return ret;
   }
   free(ret);
@@ -99,15 +99,11 @@ cdio_logv(cdio_log_level_t level, const char format[], va_list args)
   char buf[1024] = { 0, };
 
   /* _handler() is user defined and we want to make sure _handler()
-  doesn't call us, cdio_logv. in_recursion is used for that, however
-  it has a problem in multi-threaded programs. I'm not sure how to
-  handle multi-threading and recursion checking both. For now, we'll
-  leave in the recursion checking, at the expense of handling
-  multi-threaded log calls. To ameliorate this, we'll check the log
-  level and handle calls where there is no output, before the
-  recursion check.
+  doesn't call us, cdio_logv. in_recursion is used for that. It is
+  kept per thread, so that threads logging at the same time aren't
+  mistaken for recursion.
   */
- static int in_recursion = 0;
+  static TLS int in_recursion = 0;
 
   if (level < cdio_loglevel_default) return;
 
@@ -366,7 +366,6 @@ mmc_read_data_sectors ( CdIo_t *p_cdio, void *p_buf,
 
 /**
    Read sectors using SCSI-MMC GPCMD_READ_CD.
-   Can read only up to 25 blocks.
  */
 driver_return_code_t
 read_data_sectors_mmc ( void *p_user_data, void *p_buf,
@@ -1222,33 +1221,47 @@ mmc_have_interface( CdIo_t *p_cdio, cdio_mmc_feature_interface_t e_interface )
 
 /**
     Read sectors using SCSI-MMC GPCMD_READ_CD.
-    Can read only up to 25 blocks.
+    Reads are split into commands no bigger than the host allows, if
+    that is known.
 */
 driver_return_code_t
 mmc_read_sectors ( const CdIo_t *p_cdio, void *p_buf, lsn_t i_lsn,
                    int sector_type, uint32_t i_blocks )
 {
   mmc_cdb_t cdb = {{0, }};
-
+  uint32_t i_chunk;
   mmc_run_cmd_fn_t run_mmc_cmd;
 
   if (!p_cdio) return DRIVER_OP_UNINIT;
   if (!p_cdio->op.run_mmc_cmd ) return DRIVER_OP_UNSUPPORTED;
 
   run_mmc_cmd = p_cdio->op.run_mmc_cmd;
+  i_chunk = mmc_get_read_chunk(p_cdio, CDIO_CD_FRAMESIZE_RAW, i_blocks,
+                               0xFFFFFF);
 
   CDIO_MMC_SET_COMMAND(cdb.field, CDIO_MMC_GPCMD_READ_CD);
   CDIO_MMC_SET_READ_TYPE    (cdb.field, sector_type);
-  CDIO_MMC_SET_READ_LBA     (cdb.field, i_lsn);
-  CDIO_MMC_SET_READ_LENGTH24(cdb.field, i_blocks);
   CDIO_MMC_SET_MAIN_CHANNEL_SELECTION_BITS(cdb.field,
 					   CDIO_MMC_MCSB_ALL_HEADERS);
 
-  return run_mmc_cmd (p_cdio->env, mmc_timeout_ms,
-                      mmc_get_cmd_len(cdb.field[0]), &cdb,
-                      SCSI_MMC_DATA_READ,
-                      CDIO_CD_FRAMESIZE_RAW * i_blocks,
-                      p_buf);
+  do {
+    const uint32_t i_blocks2 = (i_blocks > i_chunk) ? i_chunk : i_blocks;
+    driver_return_code_t i_ret;
+
+    CDIO_MMC_SET_READ_LBA     (cdb.field, i_lsn);
+    CDIO_MMC_SET_READ_LENGTH24(cdb.field, i_blocks2);
+    i_ret = run_mmc_cmd (p_cdio->env, mmc_timeout_ms,
+                         mmc_get_cmd_len(cdb.field[0]), &cdb,
+                         SCSI_MMC_DATA_READ,
+                         CDIO_CD_FRAMESIZE_RAW * i_blocks2,
+                         p_buf);
+    if (DRIVER_OP_SUCCESS != i_ret) return i_ret;
+
+    p_buf     = (uint8_t *) p_buf + CDIO_CD_FRAMESIZE_RAW * i_blocks2;
+    i_lsn    += i_blocks2;
+    i_blocks -= i_blocks2;
+  } while (i_blocks > 0);
+  return DRIVER_OP_SUCCESS;
 }
 
 driver_return_code_t
@@ -0,0 +1,153 @@
+/* Running Multimedia Commands (MMC) without waiting for them.
+
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/mmc_async.h>
+#include "cdio_private.h"
+
+void
+mmc_prep_read_sectors(mmc_async_cmd_t *p_cmd, void *p_buf, lsn_t i_lsn,
+                      int sector_type, uint32_t i_blocks)
+{
+  memset(&p_cmd->cdb, 0, sizeof(p_cmd->cdb));
+  CDIO_MMC_SET_COMMAND(p_cmd->cdb.field, CDIO_MMC_GPCMD_READ_CD);
+  CDIO_MMC_SET_READ_TYPE(p_cmd->cdb.field, sector_type);
+  CDIO_MMC_SET_MAIN_CHANNEL_SELECTION_BITS(p_cmd->cdb.field,
+                                           CDIO_MMC_MCSB_ALL_HEADERS);
+  CDIO_MMC_SET_READ_LBA(p_cmd->cdb.field, i_lsn);
+  CDIO_MMC_SET_READ_LENGTH24(p_cmd->cdb.field, i_blocks);
+  p_cmd->i_cdb        = 0;
+  p_cmd->i_timeout_ms = mmc_timeout_ms;
+  p_cmd->e_direction  = SCSI_MMC_DATA_READ;
+  p_cmd->i_buf        = CDIO_CD_FRAMESIZE_RAW * i_blocks;
+  p_cmd->p_buf        = p_buf;
+}
+
+driver_return_code_t
+mmc_submit_cmd(CdIo_t *p_cdio, mmc_async_cmd_t *p_cmd)
+{
+  const generic_img_private_t *p_env;
+
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (!p_cmd)  return DRIVER_OP_BAD_POINTER;
+
+  if (0 == p_cmd->i_cdb)
+    p_cmd->i_cdb = mmc_get_cmd_len(p_cmd->cdb.field[0]);
+  p_cmd->i_status = DRIVER_OP_SUCCESS;
+  p_cmd->i_sense  = 0;
+  p_cmd->p_next   = NULL;
+
+  if (p_cdio->op.submit_mmc_cmd && p_cdio->op.reap_mmc_cmds) {
+    driver_return_code_t i_rc = p_cdio->op.submit_mmc_cmd(p_cdio->env, p_cmd);
+
+    if (DRIVER_OP_SUCCESS == i_rc) {
+      p_cdio->i_async_queued++;
+      return DRIVER_OP_SUCCESS;
+    }
+    if (DRIVER_OP_UNSUPPORTED != i_rc) return i_rc;
+  }
+
+  /* Run it now and keep it for mmc_reap_cmds(). */
+  if (!p_cdio->op.run_mmc_cmd) return DRIVER_OP_UNSUPPORTED;
+  p_cmd->i_status =
+    p_cdio->op.run_mmc_cmd(p_cdio->env, p_cmd->i_timeout_ms, p_cmd->i_cdb,
+                           &p_cmd->cdb, p_cmd->e_direction, p_cmd->i_buf,
+                           p_cmd->p_buf);
+  p_env = p_cdio->env;
+  if (p_env->scsi_mmc_sense_valid > 0) {
+    p_cmd->i_sense = p_env->scsi_mmc_sense_valid;
+    if (p_cmd->i_sense > sizeof(p_cmd->sense))
+      p_cmd->i_sense = sizeof(p_cmd->sense);
+    memcpy(&p_cmd->sense, p_env->scsi_mmc_sense, p_cmd->i_sense);
+  }
+
+  if (p_cdio->p_async_done_last)
+    p_cdio->p_async_done_last->p_next = p_cmd;
+  else
+    p_cdio->p_async_done = p_cmd;
+  p_cdio->p_async_done_last = p_cmd;
+  return DRIVER_OP_SUCCESS;
+}
+
+int
+mmc_reap_cmds(CdIo_t *p_cdio, mmc_async_cmd_t *ap_done[], unsigned int i_max,
+              int i_timeout_ms)
+{
+  unsigned int i_done = 0;
+
+  if (!p_cdio) return DRIVER_OP_UNINIT;
+  if (!ap_done) return DRIVER_OP_BAD_POINTER;
+  if (0 == i_max) return DRIVER_OP_BAD_PARAMETER;
+
+  while (i_done < i_max && p_cdio->p_async_done) {
+    ap_done[i_done++] = p_cdio->p_async_done;
+    p_cdio->p_async_done = p_cdio->p_async_done->p_next;
+  }
+  if (!p_cdio->p_async_done) p_cdio->p_async_done_last = NULL;
+
+  if (i_done < i_max && p_cdio->i_async_queued > 0) {
+    /* Don't wait when there is something to give already. */
+    const int i_reaped =
+      p_cdio->op.reap_mmc_cmds(p_cdio->env, ap_done + i_done,
+                               i_max - i_done, i_done ? 0 : i_timeout_ms);
+
+    if (i_reaped < 0) {
+      if (0 == i_done) return i_reaped;
+    } else {
+      p_cdio->i_async_queued -= i_reaped;
+      i_done += i_reaped;
+    }
+  }
+  return (int) i_done;
+}
+
+unsigned int
+mmc_get_cmds_pending(const CdIo_t *p_cdio)
+{
+  const mmc_async_cmd_t *p_cmd;
+  unsigned int i_pending;
+
+  if (!p_cdio) return 0;
+  i_pending = p_cdio->i_async_queued;
+  for (p_cmd = p_cdio->p_async_done; p_cmd; p_cmd = p_cmd->p_next)
+    i_pending++;
+  return i_pending;
+}
+
+int
+mmc_get_completion_fd(const CdIo_t *p_cdio)
+{
+  if (!p_cdio || !p_cdio->op.get_mmc_completion_fd) return -1;
+  return p_cdio->op.get_mmc_completion_fd(p_cdio->env);
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -184,6 +184,69 @@ mmc_mode_sense(CdIo_t *p_cdio, /*out*/ void *p_buf, unsigned int i_size,
     return mmc_mode_sense_10(p_cdio, p_buf, i_size, page);
 }
 
+/* Find the Read/Write Error Recovery page in a MODE SENSE (10) reply
+   of i_size bytes. */
+static uint8_t *
+find_r_w_error_page(uint8_t *p_buf, unsigned int i_size)
+{
+    const unsigned int i_page = 8 + CDIO_MMC_GETPOS_LEN16(p_buf, 6);
+    uint8_t *p = p_buf + i_page;
+
+    if (i_page + 4 > i_size || i_page + 2 + p[1] > i_size) return NULL;
+    if (CDIO_MMC_R_W_ERROR_PAGE != (p[0] & 0x3f) || p[1] < 2) return NULL;
+    return p;
+}
+
+/**
+  Get how many times the drive retries a read before giving up, from
+  the Read/Write Error Recovery mode page.
+
+  @param p_cdio the CD object to be acted upon.
+  @return the read retry count, or a negative driver_return_code_t.
+*/
+int
+mmc_get_read_retries(CdIo_t *p_cdio)
+{
+    uint8_t buf[8 + 255 + 12] = { 0, };
+    const uint8_t *p;
+    driver_return_code_t i_status =
+      mmc_mode_sense_10(p_cdio, buf, sizeof(buf), CDIO_MMC_R_W_ERROR_PAGE);
+
+    if (DRIVER_OP_SUCCESS != i_status) return i_status;
+    p = find_r_w_error_page(buf, sizeof(buf));
+    return p ? p[3] : DRIVER_OP_ERROR;
+}
+
+/**
+  Set how many times the drive retries a read before giving up, via
+  MODE SELECT of the Read/Write Error Recovery mode page. The rest of
+  the page is left as it is.
+
+  @param p_cdio the CD object to be acted upon.
+  @param i_retries the read retry count; 0 gives up at the first error.
+  @return DRIVER_OP_SUCCESS if we ran the commands ok.
+*/
+driver_return_code_t
+mmc_set_read_retries(CdIo_t *p_cdio, uint8_t i_retries)
+{
+    uint8_t buf[8 + 255 + 12] = { 0, };
+    uint8_t *p;
+    driver_return_code_t i_status =
+      mmc_mode_sense_10(p_cdio, buf, sizeof(buf), CDIO_MMC_R_W_ERROR_PAGE);
+
+    if (DRIVER_OP_SUCCESS != i_status) return i_status;
+    p = find_r_w_error_page(buf, sizeof(buf));
+    if (!p) return DRIVER_OP_ERROR;
+    if (p[3] == i_retries) return DRIVER_OP_SUCCESS;
+
+    /* The mode data length is reserved, and PS must be 0, in what is
+       sent back. */
+    buf[0] = buf[1] = 0;
+    p[0] &= 0x3f;
+    p[3] = i_retries;
+    return mmc_mode_select_10(p_cdio, buf, (p - buf) + 2 + p[1], 0x10, 0);
+}
+
 /**
   Set the drive speed in CD-ROM speed units.
 
@@ -200,11 +200,27 @@ mmc_prevent_allow_medium_removal(const CdIo_t *p_cdio,
     return MMC_RUN_CMD(SCSI_MMC_DATA_WRITE, i_timeout_ms);
 }
 
-/* Maximum blocks to retrieve. Would be nice to customize this based on
-   drive capabilities.
+/* Maximum blocks to retrieve when it isn't known how much the host
+   can transfer at once.
 */
 #define MAX_CD_READ_BLOCKS 16
 
+/*!
+  Return how many blocks of i_blocksize bytes a single read command
+  of p_cdio should ask for. See mmc_private.h.
+*/
+uint32_t
+mmc_get_read_chunk(const CdIo_t *p_cdio, uint16_t i_blocksize,
+                   uint32_t i_default, uint32_t i_max_blocks)
+{
+    uint32_t i_blocks = i_default;
+
+    if (p_cdio && p_cdio->i_max_transfer && i_blocksize)
+        i_blocks = p_cdio->i_max_transfer / i_blocksize;
+    if (i_blocks > i_max_blocks) i_blocks = i_max_blocks;
+    return i_blocks ? i_blocks : 1;
+}
+
 /**
    Issue a MMC READ_CD command.
    
@@ -316,7 +332,13 @@ mmc_read_cd(const CdIo_t *p_cdio, void *p_buf1, lsn_t i_lsn,
 {
     void *p_buf = p_buf1;
     uint8_t cdb9 = 0;
-    const unsigned int i_timeout = mmc_timeout_ms * (MAX_CD_READ_BLOCKS/2);
+    const uint32_t i_chunk =
+        mmc_get_read_chunk(p_cdio, i_blocksize, MAX_CD_READ_BLOCKS,
+                           0xFFFFFF);
+    /* What a MAX_CD_READ_BLOCKS read was always given, and more for
+       the larger reads a host may allow. */
+    const unsigned int i_timeout =
+        mmc_timeout_ms * (MAX_CD_READ_BLOCKS/2 + i_chunk/64);
 
     MMC_CMD_SETUP(CDIO_MMC_GPCMD_READ_CD);
 
@@ -339,8 +361,8 @@ mmc_read_cd(const CdIo_t *p_cdio, void *p_buf1, lsn_t i_lsn,
       int i_status = DRIVER_OP_SUCCESS;
       
       while (i_blocks > 0) {
-          const unsigned i_blocks2 = (i_blocks > MAX_CD_READ_BLOCKS) 
-              ? MAX_CD_READ_BLOCKS : i_blocks;
+          const unsigned i_blocks2 = (i_blocks > i_chunk)
+              ? i_chunk : i_blocks;
           
           const unsigned int i_size = i_blocksize * i_blocks2;
           
@@ -114,6 +114,17 @@ typedef driver_return_code_t (*mmc_run_cmd_fn_t)
        cdio_mmc_direction_t e_direction, 
        unsigned int i_buf, /*in/out*/ void *p_buf );
 			     
+/*!
+  Return how many blocks of i_blocksize bytes a single read command
+  of p_cdio should ask for: as many as the most the host can transfer
+  at once holds, if that is known (see cdio_set_arg() and
+  "mmc-max-transfer"), or else i_default. That is never more than
+  i_max_blocks, the most the length field of the command can hold, nor
+  less than 1.
+*/
+uint32_t mmc_get_read_chunk(const CdIo_t *p_cdio, uint16_t i_blocksize,
+                            uint32_t i_default, uint32_t i_max_blocks);
+
 int mmc_set_blocksize_mmc_private ( const void *p_env, const
 				    mmc_run_cmd_fn_t run_mmc_cmd,
 				    uint16_t i_blocksize );
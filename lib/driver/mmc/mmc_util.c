@@ -28,6 +28,7 @@
 
 #include <cdio/mmc.h>
 #include "mmc_private.h"
+#include "portable.h"
 
 /** The below variables are trickery to force enum symbol values to be
     recorded in debug symbol tables. They are used to allow one to refer
@@ -220,7 +221,7 @@ mmc_feature2str( int i_feature )
     return "The Logical Unit Unique Identifier";
   default: 
     {
-      static char buf[100];
+      static TLS char buf[100];
       if ( 0 != (i_feature & 0xFF00) ) {
         snprintf( buf, sizeof(buf),
                  "Vendor-specific code %x", i_feature );
@@ -305,7 +306,7 @@ mmc_feature_profile2str( int i_feature_profile )
     return "The Logical Unit does not conform to any Profile";
   default: 
     {
-      static char buf[100];
+      static TLS char buf[100];
       snprintf(buf, sizeof(buf), "Unknown Profile %x", i_feature_profile);
       return buf;
     }
@@ -0,0 +1,1687 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*! This driver emulates an MMC CD-ROM drive. The commands given to
+   run_mmc_cmd are decoded and answered from a BIN/CUE, cdrdao or NRG
+   disc image, and everything else goes through MMC commands as it
+   would for a drive. That way the MMC code can be run, timed and made
+   to fail without a drive.
+
+   Time is accounted for with a fixed cost per command, a seek time
+   that grows with how far the head moves and a cost per block read.
+   By default it is only added up, so that runs are repeatable; it can
+   also really be waited out.
+*/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <cdio/logging.h>
+#include <cdio/sector.h>
+#include <cdio/util.h>
+#include <cdio/mmc.h>
+#include <cdio/mmc_ll_cmds.h>
+#include "cdio_private.h"
+#include "cdtext_private.h"
+
+/* What INQUIRY reports. */
+#define EMU_VENDOR   "libcdio "
+#define EMU_MODEL    "MMC emulator    "
+#define EMU_REVISION "1.0 "
+
+/* How often an unreadable block is tried again unless MODE SELECT
+   says otherwise. */
+#define EMU_READ_RETRIES 16
+
+/* Read speed the capabilities page reports, in kB/s (40x). */
+#define EMU_READ_SPEED 7056
+
+/* The most READ CD gives back for one block: a whole raw frame, C2
+   error pointers with the block error byte, and raw P-W sub-channel. */
+#define EMU_C2_SIZE_MAX 296
+#define EMU_READ_CD_MAX \
+  (CDIO_CD_FRAMESIZE_RAW + EMU_C2_SIZE_MAX + CDIO_CD_FRAMESIZE_SUB)
+
+/* Sense keys and additional sense codes given back. */
+#define EMU_ASC_INVALID_OPCODE     0x20
+#define EMU_ASC_LBA_OUT_OF_RANGE   0x21
+#define EMU_ASC_INVALID_FIELD      0x24
+#define EMU_ASC_INVALID_PARAMETER  0x26
+#define EMU_ASC_UNRECOVERED_READ   0x11
+#define EMU_ASC_REMOVAL_PREVENTED  0x53
+#define EMU_ASC_NO_MEDIUM          0x3a
+#define EMU_ASC_ILLEGAL_MODE       0x64
+
+/* Kinds of sector on the emulated disc. */
+typedef enum {
+  EMU_SECTOR_AUDIO,
+  EMU_SECTOR_MODE1,
+  EMU_SECTOR_MODE2,       /**< mode 2 formless */
+  EMU_SECTOR_M2F1,
+  EMU_SECTOR_M2F2
+} emu_sector_t;
+
+/* A run of unreadable sectors. */
+typedef struct {
+  lsn_t i_first;
+  lsn_t i_last;
+} emu_lsn_range_t;
+
+typedef struct {
+  lsn_t          start_lsn;
+  uint8_t        i_control;   /**< Q sub-channel CONTROL bits */
+  track_format_t format;
+} emu_track_t;
+
+typedef struct {
+  /* Things common to all drivers like this.
+     This must be first. */
+  generic_img_private_t gen;
+
+  CdIo_t     *p_image;        /**< where the answers come from */
+
+  /* The disc as the image has it; entry i_tracks is the lead-out. */
+  emu_track_t disc[CDIO_CD_MAX_TRACKS+1];
+  track_t     i_first_track;
+  track_t     i_tracks;
+  uint8_t     i_disc_type;    /**< as READ TOC's full TOC gives it */
+  uint8_t    *p_cdtext;       /**< CD-Text packs, if any */
+  size_t      i_cdtext;
+
+  /* The disc as read back with READ TOC, for the generic routines. */
+  emu_track_t tocent[CDIO_CD_MAX_TRACKS+1];
+
+  /* The drive. */
+  bool        b_tray_open;
+  bool        b_locked;
+  bool        b_media_event;  /**< a disc went in since it was last asked */
+  uint32_t    i_blocksize;    /**< of READ (10) and READ (12) */
+  uint8_t     i_read_retries; /**< of the error recovery mode page */
+  lsn_t       i_head;         /**< where the last read left the head */
+
+  /* Timing, in microseconds. */
+  unsigned long i_command_us;   /**< each command */
+  unsigned long i_seek_min_us;  /**< the shortest seek */
+  unsigned long i_seek_max_us;  /**< a seek across the whole disc */
+  unsigned long i_block_us;     /**< each block read */
+  unsigned long i_error_us;     /**< each try at an unreadable block */
+  bool          b_sleep;        /**< wait the time out, not just count it */
+  uint64_t      i_elapsed_us;
+  unsigned long i_commands;
+
+  /* Faults. */
+  emu_lsn_range_t *p_bad;
+  unsigned int     i_bad;
+  uint32_t         i_max_transfer; /**< what the "host" takes; 0 is any */
+
+  char sz_arg[32];            /**< get_arg's answer, when it's a number */
+} _img_private_t;
+
+static bool read_toc_mmcemu (void *p_user_data);
+
+/* Binary and BCD minute, second, frame of an LSN. */
+static void
+lsn_to_msf_mmcemu (lsn_t i_lsn, uint8_t *p_msf, bool b_bcd)
+{
+  const lba_t i_lba = i_lsn + CDIO_PREGAP_SECTORS;
+  const uint8_t m = i_lba / CDIO_CD_FRAMES_PER_MIN;
+  const uint8_t s = (i_lba / CDIO_CD_FRAMES_PER_SEC) % CDIO_CD_SECS_PER_MIN;
+  const uint8_t f = i_lba % CDIO_CD_FRAMES_PER_SEC;
+
+  p_msf[0] = b_bcd ? cdio_to_bcd8(m) : m;
+  p_msf[1] = b_bcd ? cdio_to_bcd8(s) : s;
+  p_msf[2] = b_bcd ? cdio_to_bcd8(f) : f;
+}
+
+/* Put an address as READ TOC and READ SUB-CHANNEL give it: an LBA or,
+   with b_msf, 0 and a binary MSF. */
+static void
+set_addr_mmcemu (uint8_t *p, lsn_t i_lsn, bool b_msf)
+{
+  if (b_msf) {
+    p[0] = 0;
+    lsn_to_msf_mmcemu(i_lsn, p + 1, false);
+  } else {
+    p[0] = (i_lsn >> 24) & 0xff;
+    p[1] = (i_lsn >> 16) & 0xff;
+    p[2] = (i_lsn >>  8) & 0xff;
+    p[3] =  i_lsn        & 0xff;
+  }
+}
+
+/*!
+  End the command with CHECK CONDITION and the given sense. i_info,
+  when not negative, goes into the INFORMATION field, as the address
+  of a block that could not be read does.
+*/
+static driver_return_code_t
+check_condition_mmcemu (_img_private_t *p_env, uint8_t i_key, uint8_t i_asc,
+                        uint8_t i_ascq, lsn_t i_info)
+{
+  uint8_t *p_sense = p_env->gen.scsi_mmc_sense;
+
+  memset(p_sense, 0, 18);
+  p_sense[0]  = 0x70;
+  p_sense[2]  = i_key;
+  if (i_info >= 0) {
+    p_sense[0] |= 0x80;
+    set_addr_mmcemu(p_sense + 3, i_info, false);
+  }
+  p_sense[7]  = 10;
+  p_sense[12] = i_asc;
+  p_sense[13] = i_ascq;
+  p_env->gen.scsi_mmc_sense_valid = 18;
+  return DRIVER_OP_ERROR;
+}
+
+#define ILLEGAL_REQUEST(p_env, asc) \
+  check_condition_mmcemu(p_env, CDIO_MMC_SENSE_KEY_ILLEGAL_REQUEST, asc, 0, -1)
+
+/* Copy as much of a reply as the command and buffer have room for. */
+static void
+reply_mmcemu (void *p_buf, unsigned int i_buf, unsigned int i_alloc,
+              const uint8_t *p_reply, unsigned int i_reply)
+{
+  unsigned int i_copy = i_reply;
+
+  if (i_copy > i_alloc) i_copy = i_alloc;
+  if (i_copy > i_buf) i_copy = i_buf;
+  if (i_copy) memcpy(p_buf, p_reply, i_copy);
+}
+
+/* Sleep for the given time, if there is a way to. */
+static void
+wait_mmcemu (uint64_t i_us)
+{
+#ifdef HAVE_USLEEP
+  while (i_us > 0) {
+    const unsigned long i_wait = (i_us > 500000) ? 500000 : (unsigned long) i_us;
+
+    usleep(i_wait);
+    i_us -= i_wait;
+  }
+#else
+  (void) i_us;
+#endif
+}
+
+/* How long moving the head from where it is to i_lsn takes. */
+static uint64_t
+seek_us_mmcemu (const _img_private_t *p_env, lsn_t i_lsn)
+{
+  const uint64_t i_distance = (i_lsn > p_env->i_head)
+    ? i_lsn - p_env->i_head : p_env->i_head - i_lsn;
+  uint64_t i_disc = p_env->disc[p_env->i_tracks].start_lsn;
+
+  if (0 == i_distance) return 0;
+  if (i_disc == 0) i_disc = 1;
+  if (i_distance > i_disc) i_disc = i_distance;
+  if (p_env->i_seek_max_us <= p_env->i_seek_min_us)
+    return p_env->i_seek_min_us;
+  return p_env->i_seek_min_us
+    + (p_env->i_seek_max_us - p_env->i_seek_min_us) * i_distance / i_disc;
+}
+
+static bool
+is_bad_mmcemu (const _img_private_t *p_env, lsn_t i_lsn)
+{
+  unsigned int i;
+
+  for (i = 0; i < p_env->i_bad; i++)
+    if (i_lsn >= p_env->p_bad[i].i_first && i_lsn <= p_env->p_bad[i].i_last)
+      return true;
+  return false;
+}
+
+/* The track i_lsn is in, counting its pregap as part of it. */
+static track_t
+find_track_mmcemu (const _img_private_t *p_env, lsn_t i_lsn)
+{
+  track_t i;
+
+  for (i = p_env->i_tracks; i > 0; i--)
+    if (i_lsn >= p_env->disc[i-1].start_lsn) return i-1;
+  return 0;
+}
+
+/*!
+  Get the raw 2352-byte frame at i_lsn and what kind it is. When the
+  image doesn't keep raw data sectors, the sync pattern and header
+  are made up and the EDC/ECC left zero.
+*/
+static driver_return_code_t
+get_frame_mmcemu (_img_private_t *p_env, lsn_t i_lsn, uint8_t *p_frame,
+                  emu_sector_t *p_kind)
+{
+  const emu_track_t *p_track = &p_env->disc[find_track_mmcemu(p_env, i_lsn)];
+  uint8_t msf[3];
+  driver_return_code_t i_rc;
+
+  if (is_bad_mmcemu(p_env, i_lsn))
+    return check_condition_mmcemu(p_env, CDIO_MMC_SENSE_KEY_MEDIUM_ERROR,
+                                  EMU_ASC_UNRECOVERED_READ, 0, i_lsn);
+
+  i_rc = cdio_read_audio_sector(p_env->p_image, p_frame, i_lsn);
+  if (TRACK_FORMAT_AUDIO == p_track->format) {
+    *p_kind = EMU_SECTOR_AUDIO;
+    goto done;
+  }
+
+  lsn_to_msf_mmcemu(i_lsn, msf, true);
+  if (DRIVER_OP_SUCCESS != i_rc
+      || 0 != memcmp(p_frame, CDIO_SECTOR_SYNC_HEADER, CDIO_CD_SYNC_SIZE)
+      || 0 != memcmp(p_frame + CDIO_CD_SYNC_SIZE, msf, sizeof(msf))) {
+    memset(p_frame, 0, CDIO_CD_FRAMESIZE_RAW);
+    memcpy(p_frame, CDIO_SECTOR_SYNC_HEADER, CDIO_CD_SYNC_SIZE);
+    memcpy(p_frame + CDIO_CD_SYNC_SIZE, msf, sizeof(msf));
+    if (TRACK_FORMAT_DATA == p_track->format) {
+      p_frame[15] = 1;
+      i_rc = cdio_read_mode1_sector(p_env->p_image, p_frame + 16, i_lsn,
+                                    false);
+    } else {
+      p_frame[15] = 2;
+      i_rc = cdio_read_mode2_sector(p_env->p_image, p_frame + 16, i_lsn,
+                                    true);
+    }
+  }
+
+  if (1 == p_frame[15])
+    *p_kind = EMU_SECTOR_MODE1;
+  else if (TRACK_FORMAT_DATA == p_track->format)
+    *p_kind = EMU_SECTOR_MODE2;
+  else
+    *p_kind = (p_frame[18] & 0x20) ? EMU_SECTOR_M2F2 : EMU_SECTOR_M2F1;
+
+ done:
+  if (DRIVER_OP_SUCCESS != i_rc)
+    return check_condition_mmcemu(p_env, CDIO_MMC_SENSE_KEY_MEDIUM_ERROR,
+                                  EMU_ASC_UNRECOVERED_READ, 0, i_lsn);
+  return DRIVER_OP_SUCCESS;
+}
+
+/* The Q sub-channel of i_lsn, CRC included. */
+static void
+get_q_mmcemu (const _img_private_t *p_env, lsn_t i_lsn, uint8_t q[12])
+{
+  track_t i = find_track_mmcemu(p_env, i_lsn);
+  uint8_t i_index = 1;
+  lsn_t i_rel = i_lsn - p_env->disc[i].start_lsn;
+  uint16_t i_crc = 0;
+  unsigned int j, k;
+
+  if (i + 1 < p_env->i_tracks) {
+    const lsn_t i_pregap =
+      cdio_get_track_pregap_lsn(p_env->p_image, p_env->i_first_track + i + 1);
+
+    if (CDIO_INVALID_LSN != i_pregap && i_lsn >= i_pregap) {
+      i++;
+      i_index = 0;
+      i_rel = p_env->disc[i].start_lsn - i_lsn;
+    }
+  }
+
+  q[0] = (p_env->disc[i].i_control << 4) | 1;
+  q[1] = cdio_to_bcd8(p_env->i_first_track + i);
+  q[2] = cdio_to_bcd8(i_index);
+  lsn_to_msf_mmcemu(i_rel - CDIO_PREGAP_SECTORS, q + 3, true);
+  q[6] = 0;
+  lsn_to_msf_mmcemu(i_lsn, q + 7, true);
+
+  for (j = 0; j < 10; j++) {
+    i_crc ^= q[j] << 8;
+    for (k = 0; k < 8; k++)
+      i_crc = (i_crc & 0x8000) ? (i_crc << 1) ^ 0x1021 : i_crc << 1;
+  }
+  i_crc = ~i_crc;
+  q[10] = i_crc >> 8;
+  q[11] = i_crc & 0xff;
+}
+
+/*!
+  Append i_len bytes of p_data, or zeros if p_data is NULL, to the
+  READ CD block being built. Returns false if they don't fit.
+*/
+static bool
+append_mmcemu (uint8_t *block, unsigned int *pi_size,
+               const uint8_t *p_data, unsigned int i_len)
+{
+  if (*pi_size + i_len > EMU_READ_CD_MAX)
+    return false;
+  if (p_data)
+    memcpy(block + *pi_size, p_data, i_len);
+  else
+    memset(block + *pi_size, 0, i_len);
+  *pi_size += i_len;
+  return true;
+}
+
+/*!
+  Append to p_out what READ CD asks for of one block. Returns the
+  number of bytes, or 0 and sense if that can't be done.
+*/
+static unsigned int
+read_cd_block_mmcemu (_img_private_t *p_env, const uint8_t *cdb,
+                      lsn_t i_lsn, uint8_t *p_out, unsigned int i_room)
+{
+  const uint8_t i_type = (cdb[1] >> 2) & 7;
+  const uint8_t i_main = cdb[9];
+  const uint8_t i_sub  = cdb[10] & 7;
+  uint8_t frame[CDIO_CD_FRAMESIZE_RAW];
+  uint8_t block[EMU_READ_CD_MAX];
+  unsigned int i_size = 0;
+  emu_sector_t kind;
+  bool b_type_ok;
+  bool b_fits = true;
+
+  if (DRIVER_OP_SUCCESS != get_frame_mmcemu(p_env, i_lsn, frame, &kind))
+    return 0;
+
+  switch (i_type) {
+  case CDIO_MMC_READ_TYPE_ANY:   b_type_ok = true; break;
+  case CDIO_MMC_READ_TYPE_CDDA:  b_type_ok = EMU_SECTOR_AUDIO == kind; break;
+  case CDIO_MMC_READ_TYPE_MODE1: b_type_ok = EMU_SECTOR_MODE1 == kind; break;
+  case CDIO_MMC_READ_TYPE_MODE2:
+    b_type_ok = EMU_SECTOR_MODE2 == kind || EMU_SECTOR_M2F1 == kind
+      || EMU_SECTOR_M2F2 == kind;
+    break;
+  case CDIO_MMC_READ_TYPE_M2F1:  b_type_ok = EMU_SECTOR_M2F1 == kind; break;
+  case CDIO_MMC_READ_TYPE_M2F2:  b_type_ok = EMU_SECTOR_M2F2 == kind; break;
+  default:
+    ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+    return 0;
+  }
+  if (!b_type_ok) {
+    check_condition_mmcemu(p_env, CDIO_MMC_SENSE_KEY_ILLEGAL_REQUEST,
+                           EMU_ASC_ILLEGAL_MODE, 0, i_lsn);
+    return 0;
+  }
+
+  /* The main channel. */
+  if (EMU_SECTOR_AUDIO == kind) {
+    if (i_main & 0xf8)
+      b_fits = append_mmcemu(block, &i_size, frame, CDIO_CD_FRAMESIZE_RAW);
+  } else {
+    const bool b_xa = EMU_SECTOR_M2F1 == kind || EMU_SECTOR_M2F2 == kind;
+    const unsigned int i_user = b_xa ? CDIO_CD_XA_SYNC_HEADER
+      : CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE;
+    unsigned int i_user_size, i_edc_size;
+
+    switch (kind) {
+    case EMU_SECTOR_MODE1: i_user_size = CDIO_CD_FRAMESIZE;    break;
+    case EMU_SECTOR_M2F1:  i_user_size = CDIO_CD_FRAMESIZE;    break;
+    case EMU_SECTOR_M2F2:  i_user_size = M2F2_SECTOR_SIZE;     break;
+    default:               i_user_size = M2RAW_SECTOR_SIZE;    break;
+    }
+    i_edc_size = CDIO_CD_FRAMESIZE_RAW - i_user - i_user_size;
+
+    if (i_main & 0x80)
+      b_fits = b_fits
+        && append_mmcemu(block, &i_size, frame, CDIO_CD_SYNC_SIZE);
+    if (i_main & 0x20)
+      b_fits = b_fits
+        && append_mmcemu(block, &i_size, frame + CDIO_CD_SYNC_SIZE,
+                         CDIO_CD_HEADER_SIZE);
+    if ((i_main & 0x40) && b_xa)
+      b_fits = b_fits
+        && append_mmcemu(block, &i_size,
+                         frame + CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE,
+                         CDIO_CD_SUBHEADER_SIZE);
+    if (i_main & 0x10)
+      b_fits = b_fits
+        && append_mmcemu(block, &i_size, frame + i_user, i_user_size);
+    if ((i_main & 0x08) && i_edc_size)
+      b_fits = b_fits
+        && append_mmcemu(block, &i_size, frame + i_user + i_user_size,
+                         i_edc_size);
+  }
+
+  /* C2 error pointers; there are never any errors to point at. */
+  switch ((i_main >> 1) & 3) {
+  case 0: break;
+  case 1:
+    b_fits = b_fits
+      && append_mmcemu(block, &i_size, NULL, EMU_C2_SIZE_MAX - 2);
+    break;
+  case 2:
+    b_fits = b_fits && append_mmcemu(block, &i_size, NULL, EMU_C2_SIZE_MAX);
+    break;
+  default:
+    ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+    return 0;
+  }
+
+  /* The sub-channel; P marks pauses and R-W are left empty. */
+  switch (i_sub) {
+  case 0: break;
+  case 1:
+  case 2:
+    {
+      uint8_t q[16] = { 0, };
+      uint8_t pw[CDIO_CD_FRAMESIZE_SUB];
+      unsigned int i;
+
+      get_q_mmcemu(p_env, i_lsn, q);
+      if (2 == i_sub) {
+        b_fits = b_fits && append_mmcemu(block, &i_size, q, sizeof(q));
+        break;
+      }
+      for (i = 0; i < CDIO_CD_FRAMESIZE_SUB; i++)
+        pw[i] = ((0 == q[2]) ? 0x80 : 0)
+          | (((q[i / 8] >> (7 - i % 8)) & 1) << 6);
+      b_fits = b_fits && append_mmcemu(block, &i_size, pw, sizeof(pw));
+    }
+    break;
+  case 4:
+    b_fits = b_fits
+      && append_mmcemu(block, &i_size, NULL, CDIO_CD_FRAMESIZE_SUB);
+    break;
+  default:
+    ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+    return 0;
+  }
+
+  if (!b_fits || i_size > i_room) {
+    /* More was asked for than a block holds or the caller has room for. */
+    ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+    return 0;
+  }
+  memcpy(p_out, block, i_size);
+  return i_size;
+}
+
+/*!
+  READ CD, READ (10) and READ (12). i_blocksize is 0 for READ CD,
+  whose blocks are as the CDB says; otherwise blocks are cut from the
+  raw frame as MODE SELECT set them.
+*/
+static driver_return_code_t
+read_mmcemu (_img_private_t *p_env, const uint8_t *cdb, lsn_t i_lsn,
+             uint32_t i_blocks, uint32_t i_blocksize,
+             unsigned int i_buf, uint8_t *p_buf, uint64_t *p_us)
+{
+  const lsn_t i_end = p_env->disc[p_env->i_tracks].start_lsn;
+  unsigned int i_done = 0;
+  driver_return_code_t i_rc = DRIVER_OP_SUCCESS;
+  uint32_t i;
+
+  if (i_lsn < 0 || i_lsn >= i_end || i_blocks > (uint32_t) (i_end - i_lsn))
+    return check_condition_mmcemu(p_env, CDIO_MMC_SENSE_KEY_ILLEGAL_REQUEST,
+                                  EMU_ASC_LBA_OUT_OF_RANGE, 0, -1);
+
+  *p_us += seek_us_mmcemu(p_env, i_lsn);
+  p_env->i_head = i_lsn;
+
+  for (i = 0; i < i_blocks; i++) {
+    const lsn_t i_block = i_lsn + i;
+
+    if (0 == i_blocksize) {
+      const unsigned int i_size =
+        read_cd_block_mmcemu(p_env, cdb, i_block, p_buf + i_done,
+                             i_buf - i_done);
+
+      if (0 == i_size) {
+        i_rc = DRIVER_OP_ERROR;
+        break;
+      }
+      i_done += i_size;
+    } else {
+      uint8_t frame[CDIO_CD_FRAMESIZE_RAW];
+      emu_sector_t kind;
+      unsigned int i_offset;
+
+      if (i_done + i_blocksize > i_buf) {
+        i_rc = ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+        break;
+      }
+      if (DRIVER_OP_SUCCESS !=
+          (i_rc = get_frame_mmcemu(p_env, i_block, frame, &kind)))
+        break;
+      switch (i_blocksize) {
+      case CDIO_CD_FRAMESIZE_RAW:
+        i_offset = 0;
+        break;
+      case M2RAW_SECTOR_SIZE:
+        i_offset = CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE;
+        break;
+      default:
+        i_offset = (EMU_SECTOR_M2F1 == kind) ? CDIO_CD_XA_SYNC_HEADER
+          : CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE;
+        if (EMU_SECTOR_MODE1 != kind && EMU_SECTOR_M2F1 != kind)
+          i_rc = check_condition_mmcemu(p_env,
+                                        CDIO_MMC_SENSE_KEY_ILLEGAL_REQUEST,
+                                        EMU_ASC_ILLEGAL_MODE, 0, i_block);
+      }
+      if (DRIVER_OP_SUCCESS != i_rc) break;
+      memcpy(p_buf + i_done, frame + i_offset, i_blocksize);
+      i_done += i_blocksize;
+    }
+    p_env->i_head = i_block + 1;
+    *p_us += p_env->i_block_us;
+  }
+
+  if (DRIVER_OP_SUCCESS != i_rc && is_bad_mmcemu(p_env, i_lsn + i))
+    *p_us += (uint64_t) p_env->i_error_us * (1 + p_env->i_read_retries);
+  return i_rc;
+}
+
+/* READ TOC/PMA/ATIP */
+static driver_return_code_t
+read_toc_cmd_mmcemu (_img_private_t *p_env, const uint8_t *cdb,
+                     unsigned int i_alloc, unsigned int i_buf, void *p_buf)
+{
+  const bool b_msf = (cdb[1] & 2) != 0;
+  const track_t i_last = p_env->i_first_track + p_env->i_tracks - 1;
+  uint8_t *p_reply;
+  unsigned int i_reply = 4;
+  track_t i;
+
+  p_reply = calloc(1, 4 + 11 * (CDIO_CD_MAX_TRACKS + 3) + p_env->i_cdtext);
+  if (!p_reply) return DRIVER_OP_ERROR;
+
+  switch (cdb[2] & 0x0f) {
+  case CDIO_MMC_READTOC_FMT_TOC:
+    if (cdb[6] > i_last && CDIO_CDROM_LEADOUT_TRACK != cdb[6]) {
+      free(p_reply);
+      return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+    }
+    for (i = 0; i <= p_env->i_tracks; i++) {
+      const bool b_leadout = (i == p_env->i_tracks);
+      const track_t i_track = b_leadout
+        ? CDIO_CDROM_LEADOUT_TRACK : p_env->i_first_track + i;
+
+      if (i_track < cdb[6]) continue;
+      p_reply[i_reply + 1] = 0x10 | p_env->disc[i].i_control;
+      p_reply[i_reply + 2] = i_track;
+      set_addr_mmcemu(p_reply + i_reply + 4, p_env->disc[i].start_lsn, b_msf);
+      i_reply += 8;
+    }
+    p_reply[2] = p_env->i_first_track;
+    p_reply[3] = i_last;
+    break;
+
+  case CDIO_MMC_READTOC_FMT_SESSION:
+    p_reply[1 + 4] = 0x10 | p_env->disc[0].i_control;
+    p_reply[2 + 4] = p_env->i_first_track;
+    set_addr_mmcemu(p_reply + 8, p_env->disc[0].start_lsn, b_msf);
+    i_reply += 8;
+    p_reply[2] = 1;
+    p_reply[3] = 1;
+    break;
+
+  case CDIO_MMC_READTOC_FMT_FULTOC:
+    /* The A0, A1 and A2 points and then the tracks, all in session 1. */
+    for (i = 0; i < p_env->i_tracks + 3; i++) {
+      uint8_t *p = p_reply + i_reply;
+
+      p[0] = 1;
+      switch (i) {
+      case 0:
+        p[1] = 0x10 | p_env->disc[0].i_control;
+        p[3] = 0xa0;
+        p[8] = p_env->i_first_track;
+        p[9] = p_env->i_disc_type;
+        break;
+      case 1:
+        p[1] = 0x10 | p_env->disc[p_env->i_tracks - 1].i_control;
+        p[3] = 0xa1;
+        p[8] = i_last;
+        break;
+      case 2:
+        p[1] = 0x10 | p_env->disc[p_env->i_tracks - 1].i_control;
+        p[3] = 0xa2;
+        lsn_to_msf_mmcemu(p_env->disc[p_env->i_tracks].start_lsn, p + 8,
+                          false);
+        break;
+      default:
+        p[1] = 0x10 | p_env->disc[i-3].i_control;
+        p[3] = p_env->i_first_track + i - 3;
+        lsn_to_msf_mmcemu(p_env->disc[i-3].start_lsn, p + 8, false);
+      }
+      i_reply += 11;
+    }
+    p_reply[2] = 1;
+    p_reply[3] = 1;
+    break;
+
+  case CDIO_MMC_READTOC_FMT_CDTEXT:
+    if (p_env->i_cdtext)
+      memcpy(p_reply + 4, p_env->p_cdtext, p_env->i_cdtext);
+    i_reply += p_env->i_cdtext;
+    break;
+
+  default:
+    free(p_reply);
+    return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+  }
+
+  p_reply[0] = ((i_reply - 2) >> 8) & 0xff;
+  p_reply[1] =  (i_reply - 2)       & 0xff;
+  reply_mmcemu(p_buf, i_buf, i_alloc, p_reply, i_reply);
+  free(p_reply);
+  return DRIVER_OP_SUCCESS;
+}
+
+/* READ SUB-CHANNEL */
+static driver_return_code_t
+read_subchannel_cmd_mmcemu (_img_private_t *p_env, const uint8_t *cdb,
+                            unsigned int i_alloc, unsigned int i_buf,
+                            void *p_buf)
+{
+  uint8_t reply[24] = { 0, };
+  unsigned int i_reply = 4;
+
+  reply[1] = CDIO_MMC_READ_SUB_ST_NO_STATUS;
+  if (cdb[2] & 0x40) {
+    reply[4] = cdb[3];
+    switch (cdb[3]) {
+    case CDIO_SUBCHANNEL_CURRENT_POSITION:
+      {
+        const lsn_t i_lsn = p_env->i_head;
+        const track_t i = find_track_mmcemu(p_env, i_lsn);
+
+        reply[5] = 0x10 | p_env->disc[i].i_control;
+        reply[6] = p_env->i_first_track + i;
+        reply[7] = 1;
+        set_addr_mmcemu(reply + 8, i_lsn, cdb[1] & 2);
+        if (cdb[1] & 2)
+          lsn_to_msf_mmcemu(i_lsn - p_env->disc[i].start_lsn
+                            - CDIO_PREGAP_SECTORS, reply + 13, false);
+        else
+          set_addr_mmcemu(reply + 12, i_lsn - p_env->disc[i].start_lsn,
+                          false);
+        i_reply = 16;
+      }
+      break;
+    case CDIO_SUBCHANNEL_MEDIA_CATALOG:
+      {
+        char *psz_mcn = cdio_get_mcn(p_env->p_image);
+
+        if (psz_mcn && strlen(psz_mcn) == CDIO_MCN_SIZE) {
+          reply[8] = 0x80;
+          memcpy(reply + 9, psz_mcn, CDIO_MCN_SIZE);
+        }
+        cdio_free(psz_mcn);
+        i_reply = 24;
+      }
+      break;
+    case CDIO_SUBCHANNEL_TRACK_ISRC:
+      {
+        char *psz_isrc;
+
+        if (cdb[6] < p_env->i_first_track
+            || cdb[6] >= p_env->i_first_track + p_env->i_tracks)
+          return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+        psz_isrc = cdio_get_track_isrc(p_env->p_image, cdb[6]);
+        reply[5] = 0x10
+          | p_env->disc[cdb[6] - p_env->i_first_track].i_control;
+        reply[6] = cdb[6];
+        if (psz_isrc && strlen(psz_isrc) == CDIO_ISRC_SIZE) {
+          reply[8] = 0x80;
+          memcpy(reply + 9, psz_isrc, CDIO_ISRC_SIZE);
+        }
+        cdio_free(psz_isrc);
+        i_reply = 24;
+      }
+      break;
+    default:
+      return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+    }
+  }
+  reply[3] = i_reply - 4;
+  reply_mmcemu(p_buf, i_buf, i_alloc, reply, i_reply);
+  return DRIVER_OP_SUCCESS;
+}
+
+/* GET CONFIGURATION */
+static driver_return_code_t
+get_configuration_cmd_mmcemu (_img_private_t *p_env, const uint8_t *cdb,
+                              unsigned int i_alloc, unsigned int i_buf,
+                              void *p_buf)
+{
+  /* Feature descriptors; the current bit of those needing a disc is
+     cleared when the tray is open. */
+  static const uint8_t features[] = {
+    0x00, 0x00, 0x03, 0x04,  0x00, 0x08, 0x01, 0x00,  /* Profile List */
+    0x00, 0x01, 0x0b, 0x08,  0x00, 0x00, 0x00, 0x02,  /* Core, ATAPI */
+                             0x00, 0x00, 0x00, 0x00,
+    0x00, 0x03, 0x03, 0x04,  0x29, 0x00, 0x00, 0x00,  /* Removable Medium */
+    0x00, 0x10, 0x01, 0x08,  0x00, 0x00, 0x08, 0x00,  /* Random Readable */
+                             0x00, 0x01, 0x00, 0x00,
+    0x00, 0x1d, 0x01, 0x00,                           /* Multi-Read */
+    0x00, 0x1e, 0x09, 0x04,  0x03, 0x00, 0x00, 0x00   /* CD Read */
+  };
+  const unsigned int i_rt = cdb[1] & 3;
+  const unsigned int i_start = (cdb[2] << 8) | cdb[3];
+  uint8_t reply[8 + sizeof(features)] = { 0, };
+  unsigned int i_reply = 8, i = 0;
+
+  if (3 == i_rt) return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+
+  if (!p_env->b_tray_open) reply[7] = 0x08; /* CD-ROM */
+  while (i < sizeof(features)) {
+    const unsigned int i_feature = (features[i] << 8) | features[i+1];
+    const unsigned int i_size = 4 + features[i+3];
+    bool b_current = (features[i+2] & 1) != 0;
+
+    if (p_env->b_tray_open && i_feature != CDIO_MMC_FEATURE_CORE
+        && i_feature != CDIO_MMC_FEATURE_REMOVABLE_MEDIUM)
+      b_current = false;
+    if (i_feature >= i_start
+        && (0 == i_rt || (1 == i_rt && b_current)
+            || (2 == i_rt && i_feature == i_start))) {
+      memcpy(reply + i_reply, features + i, i_size);
+      if (!b_current) reply[i_reply + 2] &= ~1;
+      if (CDIO_MMC_FEATURE_PROFILE_LIST == i_feature && !reply[7])
+        reply[i_reply + 6] = 0;
+      i_reply += i_size;
+    }
+    i += i_size;
+  }
+  reply[2] = ((i_reply - 4) >> 8) & 0xff;
+  reply[3] =  (i_reply - 4)       & 0xff;
+  reply_mmcemu(p_buf, i_buf, i_alloc, reply, i_reply);
+  return DRIVER_OP_SUCCESS;
+}
+
+/* MODE SENSE (6) and (10) */
+static driver_return_code_t
+mode_sense_cmd_mmcemu (_img_private_t *p_env, const uint8_t *cdb,
+                       unsigned int i_alloc, unsigned int i_buf, void *p_buf)
+{
+  const bool b_10 = CDIO_MMC_GPCMD_MODE_SENSE_10 == cdb[0];
+  const unsigned int i_page = cdb[2] & 0x3f;
+  const unsigned int i_header = b_10 ? 8 : 4;
+  uint8_t reply[8 + 8 + 12 + 30] = { 0, };
+  unsigned int i_reply = i_header;
+
+  /* Block descriptors only come with MODE SENSE (6), as with most
+     ATAPI drives. */
+  if (!b_10 && !(cdb[1] & 0x08)) {
+    const lsn_t i_blocks = p_env->disc[p_env->i_tracks].start_lsn;
+
+    reply[3] = 8;
+    reply[i_reply + 1] = (i_blocks >> 16) & 0xff;
+    reply[i_reply + 2] = (i_blocks >>  8) & 0xff;
+    reply[i_reply + 3] =  i_blocks        & 0xff;
+    reply[i_reply + 5] = (p_env->i_blocksize >> 16) & 0xff;
+    reply[i_reply + 6] = (p_env->i_blocksize >>  8) & 0xff;
+    reply[i_reply + 7] =  p_env->i_blocksize        & 0xff;
+    i_reply += 8;
+  }
+
+  if (CDIO_MMC_R_W_ERROR_PAGE != i_page && CDIO_MMC_CAPABILITIES_PAGE != i_page
+      && CDIO_MMC_ALL_PAGES != i_page)
+    return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+
+  if (CDIO_MMC_CAPABILITIES_PAGE != i_page) {
+    reply[i_reply]     = CDIO_MMC_R_W_ERROR_PAGE;
+    reply[i_reply + 1] = 10;
+    reply[i_reply + 3] = p_env->i_read_retries;
+    i_reply += 12;
+  }
+  if (CDIO_MMC_R_W_ERROR_PAGE != i_page) {
+    uint8_t *p = reply + i_reply;
+
+    p[0]  = CDIO_MMC_CAPABILITIES_PAGE;
+    p[1]  = 28;
+    p[2]  = 0x03;                       /* reads CD-R and CD-RW */
+    p[4]  = 0x71;                       /* audio, XA forms, multi-session */
+    p[5]  = 0x77;                       /* CD-DA, R-W, C2, ISRC, MCN */
+    p[6]  = 0x29 | (p_env->b_locked ? 0x02 : 0); /* tray, eject, lock */
+    p[8]  = (EMU_READ_SPEED >> 8) & 0xff;
+    p[9]  =  EMU_READ_SPEED       & 0xff;
+    p[14] = (EMU_READ_SPEED >> 8) & 0xff;
+    p[15] =  EMU_READ_SPEED       & 0xff;
+    i_reply += 30;
+  }
+
+  if (b_10) {
+    reply[0] = ((i_reply - 2) >> 8) & 0xff;
+    reply[1] =  (i_reply - 2)       & 0xff;
+  } else
+    reply[0] = i_reply - 1;
+  reply_mmcemu(p_buf, i_buf, i_alloc, reply, i_reply);
+  return DRIVER_OP_SUCCESS;
+}
+
+/* MODE SELECT (6) and (10): the block size and the read retry count
+   can be changed. Nothing is changed unless all of it is good. */
+static driver_return_code_t
+mode_select_cmd_mmcemu (_img_private_t *p_env, const uint8_t *cdb,
+                        unsigned int i_alloc, unsigned int i_buf,
+                        const uint8_t *p_buf)
+{
+  const bool b_10 = CDIO_MMC_GPCMD_MODE_SELECT_10 == cdb[0];
+  const unsigned int i_header = b_10 ? 8 : 4;
+  uint32_t i_blocksize = p_env->i_blocksize;
+  uint8_t i_read_retries = p_env->i_read_retries;
+  unsigned int i_descriptors, i;
+
+  if (i_alloc > i_buf) i_alloc = i_buf;
+  if (i_alloc < i_header)
+    return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_PARAMETER);
+  i_descriptors = b_10 ? (p_buf[6] << 8) | p_buf[7] : p_buf[3];
+  if (i_descriptors) {
+    if (i_descriptors < 8 || i_header + i_descriptors > i_alloc)
+      return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_PARAMETER);
+    i = i_header;
+    i_blocksize = (p_buf[i+5] << 16) | (p_buf[i+6] << 8) | p_buf[i+7];
+    if (CDIO_CD_FRAMESIZE != i_blocksize && M2RAW_SECTOR_SIZE != i_blocksize
+        && CDIO_CD_FRAMESIZE_RAW != i_blocksize)
+      return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_PARAMETER);
+  }
+
+  for (i = i_header + i_descriptors; i < i_alloc; i += 2 + p_buf[i+1]) {
+    if (i + 2 > i_alloc || i + 2 + p_buf[i+1] > i_alloc
+        || CDIO_MMC_R_W_ERROR_PAGE != (p_buf[i] & 0x3f) || p_buf[i+1] < 2)
+      return ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_PARAMETER);
+    i_read_retries = p_buf[i+3];
+  }
+
+  p_env->i_blocksize = i_blocksize;
+  p_env->i_read_retries = i_read_retries;
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Run a SCSI MMC command, answering it from the image.
+
+  p_user_data   internal CD structure.
+  i_timeout_ms  ignored; commands take the time the model gives them.
+  i_cdb         Size of p_cdb
+  p_cdb         CDB bytes.
+  e_direction   direction the transfer is to go.
+  i_buf         Size of buffer
+  p_buf         Buffer for data, both sending and receiving
+*/
+static driver_return_code_t
+run_mmc_cmd_mmcemu (void *p_user_data, unsigned int i_timeout_ms,
+                    unsigned int i_cdb, const mmc_cdb_t *p_cdb,
+                    cdio_mmc_direction_t e_direction,
+                    unsigned int i_buf, /*in/out*/ void *p_buf)
+{
+  _img_private_t *p_env = p_user_data;
+  const uint8_t *cdb = p_cdb->field;
+  const unsigned int i_alloc16 = (cdb[7] << 8) | cdb[8];
+  uint8_t last_sense[18];
+  uint64_t i_us = p_env->i_command_us;
+  driver_return_code_t i_rc;
+
+  (void) i_timeout_ms;
+  (void) i_cdb;
+
+  memcpy(last_sense, p_env->gen.scsi_mmc_sense, sizeof(last_sense));
+  if (p_env->gen.scsi_mmc_sense_valid <= 0) last_sense[0] = 0;
+  p_env->gen.scsi_mmc_sense_valid = 0;
+  p_env->i_commands++;
+  if (!p_buf) i_buf = 0;
+
+  /* Something between us and the drive can't take it. */
+  if (p_env->i_max_transfer && i_buf > p_env->i_max_transfer) {
+    cdio_info("MMC emulator: %s of %u bytes is more than %lu",
+              mmc_cmd2str(cdb[0]), i_buf,
+              (unsigned long) p_env->i_max_transfer);
+    return DRIVER_OP_BAD_PARAMETER;
+  }
+
+  /* Commands which need a disc. */
+  switch (cdb[0]) {
+  case CDIO_MMC_GPCMD_TEST_UNIT_READY:
+  case CDIO_MMC_GPCMD_READ_CAPACITIY:
+  case CDIO_MMC_GPCMD_READ_10:
+  case CDIO_MMC_GPCMD_READ_12:
+  case CDIO_MMC_GPCMD_READ_CD:
+  case CDIO_MMC_GPCMD_READ_SUBCHANNEL:
+  case CDIO_MMC_GPCMD_READ_TOC:
+  case CDIO_MMC_GPCMD_READ_DISC_INFORMATION:
+  case CDIO_MMC_GPCMD_SEEK_10:
+    if (p_env->b_tray_open) {
+      i_rc = check_condition_mmcemu(p_env, CDIO_MMC_SENSE_KEY_NOT_READY,
+                                    EMU_ASC_NO_MEDIUM, 2, -1);
+      goto done;
+    }
+  default: ;
+  }
+
+  switch (cdb[0]) {
+  case CDIO_MMC_GPCMD_TEST_UNIT_READY:
+  case CDIO_MMC_GPCMD_SET_SPEED:
+    i_rc = DRIVER_OP_SUCCESS;
+    break;
+
+  case CDIO_MMC_GPCMD_REQUEST_SENSE:
+    if (!last_sense[0]) {
+      memset(last_sense, 0, sizeof(last_sense));
+      last_sense[0] = 0x70;
+      last_sense[7] = 10;
+    }
+    reply_mmcemu(p_buf, i_buf, cdb[4], last_sense, sizeof(last_sense));
+    i_rc = DRIVER_OP_SUCCESS;
+    break;
+
+  case CDIO_MMC_GPCMD_INQUIRY:
+    {
+      uint8_t reply[36] = { 0x05, 0x80, 0x00, 0x02, 31, };
+
+      if (cdb[1] & 1) {
+        i_rc = ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+        break;
+      }
+      memcpy(reply + 8,  EMU_VENDOR,   CDIO_MMC_HW_VENDOR_LEN);
+      memcpy(reply + 16, EMU_MODEL,    CDIO_MMC_HW_MODEL_LEN);
+      memcpy(reply + 32, EMU_REVISION, CDIO_MMC_HW_REVISION_LEN);
+      reply_mmcemu(p_buf, i_buf, (cdb[3] << 8) | cdb[4], reply,
+                   sizeof(reply));
+      i_rc = DRIVER_OP_SUCCESS;
+    }
+    break;
+
+  case CDIO_MMC_GPCMD_START_STOP_UNIT:
+    i_rc = DRIVER_OP_SUCCESS;
+    if ((cdb[4] & 0xf0) || !(cdb[4] & 2)) break;
+    if (cdb[4] & 1) {
+      if (p_env->b_tray_open) p_env->b_media_event = true;
+      p_env->b_tray_open = false;
+    } else if (p_env->b_locked) {
+      i_rc = ILLEGAL_REQUEST(p_env, EMU_ASC_REMOVAL_PREVENTED);
+      p_env->gen.scsi_mmc_sense[13] = 2;
+    } else
+      p_env->b_tray_open = true;
+    break;
+
+  case CDIO_MMC_GPCMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
+    p_env->b_locked = (cdb[4] & 1) != 0;
+    i_rc = DRIVER_OP_SUCCESS;
+    break;
+
+  case CDIO_MMC_GPCMD_GET_EVENT_STATUS:
+    {
+      uint8_t reply[8] = { 0, };
+      unsigned int i_reply = 4;
+
+      if (!(cdb[1] & 1)) {
+        /* Only polling is done. */
+        i_rc = ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+        break;
+      }
+      reply[3] = 0x10;
+      if (cdb[4] & 0x10) {
+        reply[2] = 4;
+        reply[4] = p_env->b_media_event ? 2 : 0;
+        reply[5] = p_env->b_tray_open ? 1 : 2;
+        p_env->b_media_event = false;
+        i_reply = 8;
+      } else
+        reply[2] = 0x80;
+      reply[1] = i_reply - 2;
+      reply_mmcemu(p_buf, i_buf, i_alloc16, reply, i_reply);
+      i_rc = DRIVER_OP_SUCCESS;
+    }
+    break;
+
+  case CDIO_MMC_GPCMD_READ_CAPACITIY:
+    {
+      const lsn_t i_last = p_env->disc[p_env->i_tracks].start_lsn - 1;
+      uint8_t reply[8] = { 0, };
+
+      set_addr_mmcemu(reply, i_last, false);
+      reply[6] = (CDIO_CD_FRAMESIZE >> 8) & 0xff;
+      reply_mmcemu(p_buf, i_buf, sizeof(reply), reply, sizeof(reply));
+      i_rc = DRIVER_OP_SUCCESS;
+    }
+    break;
+
+  case CDIO_MMC_GPCMD_READ_DISC_INFORMATION:
+    {
+      uint8_t reply[34] = { 0, };
+
+      reply[1] = 32;
+      reply[2] = 0x0e;                  /* complete, and so is its session */
+      reply[3] = p_env->i_first_track;
+      reply[4] = 1;
+      reply[5] = p_env->i_first_track;
+      reply[6] = p_env->i_first_track + p_env->i_tracks - 1;
+      reply[8] = p_env->i_disc_type;
+      reply_mmcemu(p_buf, i_buf, i_alloc16, reply, sizeof(reply));
+      i_rc = DRIVER_OP_SUCCESS;
+    }
+    break;
+
+  case CDIO_MMC_GPCMD_READ_10:
+  case CDIO_MMC_GPCMD_READ_12:
+  case CDIO_MMC_GPCMD_READ_CD:
+    {
+      const lsn_t i_lsn = (lsn_t) (((uint32_t) cdb[2] << 24) | (cdb[3] << 16)
+                                   | (cdb[4] << 8) | cdb[5]);
+      uint32_t i_blocks;
+
+      if (SCSI_MMC_DATA_READ != e_direction) {
+        i_rc = ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_FIELD);
+        break;
+      }
+      if (CDIO_MMC_GPCMD_READ_10 == cdb[0])
+        i_blocks = i_alloc16;
+      else if (CDIO_MMC_GPCMD_READ_12 == cdb[0])
+        i_blocks = ((uint32_t) cdb[6] << 24) | (cdb[7] << 16) | (cdb[8] << 8)
+          | cdb[9];
+      else
+        i_blocks = (cdb[6] << 16) | (cdb[7] << 8) | cdb[8];
+      i_rc = read_mmcemu(p_env, cdb, i_lsn, i_blocks,
+                         (CDIO_MMC_GPCMD_READ_CD == cdb[0])
+                         ? 0 : p_env->i_blocksize,
+                         i_buf, p_buf, &i_us);
+    }
+    break;
+
+  case CDIO_MMC_GPCMD_SEEK_10:
+    {
+      const lsn_t i_lsn = (lsn_t) (((uint32_t) cdb[2] << 24) | (cdb[3] << 16)
+                                   | (cdb[4] << 8) | cdb[5]);
+
+      if (i_lsn < 0 || i_lsn >= p_env->disc[p_env->i_tracks].start_lsn) {
+        i_rc = ILLEGAL_REQUEST(p_env, EMU_ASC_LBA_OUT_OF_RANGE);
+        break;
+      }
+      i_us += seek_us_mmcemu(p_env, i_lsn);
+      p_env->i_head = i_lsn;
+      i_rc = DRIVER_OP_SUCCESS;
+    }
+    break;
+
+  case CDIO_MMC_GPCMD_READ_TOC:
+    i_rc = read_toc_cmd_mmcemu(p_env, cdb, i_alloc16, i_buf, p_buf);
+    break;
+
+  case CDIO_MMC_GPCMD_READ_SUBCHANNEL:
+    i_rc = read_subchannel_cmd_mmcemu(p_env, cdb, i_alloc16, i_buf, p_buf);
+    break;
+
+  case CDIO_MMC_GPCMD_GET_CONFIGURATION:
+    i_rc = get_configuration_cmd_mmcemu(p_env, cdb, i_alloc16, i_buf, p_buf);
+    break;
+
+  case CDIO_MMC_GPCMD_MODE_SENSE_6:
+    i_rc = mode_sense_cmd_mmcemu(p_env, cdb, cdb[4], i_buf, p_buf);
+    break;
+
+  case CDIO_MMC_GPCMD_MODE_SENSE_10:
+    i_rc = mode_sense_cmd_mmcemu(p_env, cdb, i_alloc16, i_buf, p_buf);
+    break;
+
+  case CDIO_MMC_GPCMD_MODE_SELECT_6:
+    i_rc = mode_select_cmd_mmcemu(p_env, cdb, cdb[4], i_buf, p_buf);
+    break;
+
+  case CDIO_MMC_GPCMD_MODE_SELECT_10:
+    i_rc = mode_select_cmd_mmcemu(p_env, cdb, i_alloc16, i_buf, p_buf);
+    break;
+
+  default:
+    i_rc = ILLEGAL_REQUEST(p_env, EMU_ASC_INVALID_OPCODE);
+  }
+
+ done:
+  p_env->i_elapsed_us += i_us;
+  if (p_env->b_sleep) wait_mmcemu(i_us);
+  if (DRIVER_OP_SUCCESS != i_rc)
+    cdio_debug("MMC emulator: %s failed, sense key %d ASC 0x%02x",
+               mmc_cmd2str(cdb[0]),
+               p_env->gen.scsi_mmc_sense_valid
+               ? p_env->gen.scsi_mmc_sense[2] & 0x0f : -1,
+               p_env->gen.scsi_mmc_sense[12]);
+  return i_rc;
+}
+
+/*!
+  Parse a list of LSNs and LSN ranges, such as "100,200-210", into
+  p_env's unreadable sectors. An empty list clears them.
+*/
+static bool
+set_bad_mmcemu (_img_private_t *p_env, const char *psz_list)
+{
+  emu_lsn_range_t *p_bad = NULL;
+  unsigned int i_bad = 0;
+  const char *p = psz_list;
+
+  while (*p) {
+    emu_lsn_range_t range, *p_new;
+    char *psz_end;
+
+    errno = 0;
+    range.i_first = range.i_last = strtol(p, &psz_end, 10);
+    if (psz_end == p || errno) goto bad;
+    if ('-' == *psz_end) {
+      p = psz_end + 1;
+      range.i_last = strtol(p, &psz_end, 10);
+      if (psz_end == p || errno || range.i_last < range.i_first) goto bad;
+    }
+    if (*psz_end && ',' != *psz_end) goto bad;
+    p = *psz_end ? psz_end + 1 : psz_end;
+
+    p_new = realloc(p_bad, (i_bad + 1) * sizeof(*p_bad));
+    if (!p_new) goto bad;
+    p_bad = p_new;
+    p_bad[i_bad++] = range;
+  }
+
+  free(p_env->p_bad);
+  p_env->p_bad = p_bad;
+  p_env->i_bad = i_bad;
+  return true;
+
+ bad:
+  free(p_bad);
+  return false;
+}
+
+/* Load CD-Text packs, as cdrecord and cdrdao write them, from a file. */
+static bool
+set_cdtext_mmcemu (_img_private_t *p_env, const char *psz_file)
+{
+  uint8_t *p_cdtext;
+  FILE *fp;
+  size_t i_read;
+
+  p_cdtext = malloc(CDTEXT_LEN_BINARY_MAX);
+  if (!p_cdtext) return false;
+  fp = fopen(psz_file, "rb");
+  if (!fp) {
+    cdio_warn("can't open CD-Text file %s: %s", psz_file, strerror(errno));
+    free(p_cdtext);
+    return false;
+  }
+  i_read = fread(p_cdtext, 1, CDTEXT_LEN_BINARY_MAX, fp);
+  fclose(fp);
+
+  /* Some writers end the packs with a NUL. */
+  i_read -= i_read % CDTEXT_LEN_PACK;
+  if (0 == i_read) {
+    free(p_cdtext);
+    return false;
+  }
+  free(p_env->p_cdtext);
+  p_env->p_cdtext = p_cdtext;
+  p_env->i_cdtext = i_read;
+  /* What was read before may be different now. */
+  if (p_env->gen.cdtext) {
+    cdtext_destroy(p_env->gen.cdtext);
+    p_env->gen.cdtext = NULL;
+  }
+  p_env->gen.b_cdtext_error = false;
+  return true;
+}
+
+/* Parse a decimal number as the "emu-" arguments take them. */
+static bool
+get_number_mmcemu (const char *psz_value, unsigned long *p_value)
+{
+  char *psz_end;
+
+  if (!psz_value || psz_value[0] < '0' || psz_value[0] > '9') return false;
+  errno = 0;
+  *p_value = strtoul(psz_value, &psz_end, 10);
+  return !*psz_end && !errno;
+}
+
+/*!
+  Set the arg "key" with "value" in the emulated drive.
+*/
+static driver_return_code_t
+set_arg_mmcemu (void *p_user_data, const char key[], const char value[])
+{
+  _img_private_t *p_env = p_user_data;
+  unsigned long i_value;
+  unsigned long *p_us = NULL;
+
+  if (!strcmp(key, "emu-command-us"))
+    p_us = &p_env->i_command_us;
+  else if (!strcmp(key, "emu-seek-min-us"))
+    p_us = &p_env->i_seek_min_us;
+  else if (!strcmp(key, "emu-seek-max-us"))
+    p_us = &p_env->i_seek_max_us;
+  else if (!strcmp(key, "emu-block-us"))
+    p_us = &p_env->i_block_us;
+  else if (!strcmp(key, "emu-error-us"))
+    p_us = &p_env->i_error_us;
+  if (p_us) {
+    if (!get_number_mmcemu(value, &i_value)) return DRIVER_OP_BAD_PARAMETER;
+    *p_us = i_value;
+    return DRIVER_OP_SUCCESS;
+  }
+
+  if (!strcmp(key, "emu-sleep")) {
+    if (!value) return DRIVER_OP_BAD_PARAMETER;
+    if (!strcmp(value, "true"))
+      p_env->b_sleep = true;
+    else if (!strcmp(value, "false"))
+      p_env->b_sleep = false;
+    else
+      return DRIVER_OP_BAD_PARAMETER;
+  } else if (!strcmp(key, "emu-elapsed-us") || !strcmp(key, "emu-commands")) {
+    /* These can only be started again. */
+    if (!value || strcmp(value, "0")) return DRIVER_OP_BAD_PARAMETER;
+    if ('e' == key[4])
+      p_env->i_elapsed_us = 0;
+    else
+      p_env->i_commands = 0;
+  } else if (!strcmp(key, "emu-head")) {
+    if (!get_number_mmcemu(value, &i_value)
+        || i_value >= (unsigned long) p_env->disc[p_env->i_tracks].start_lsn)
+      return DRIVER_OP_BAD_PARAMETER;
+    p_env->i_head = (lsn_t) i_value;
+  } else if (!strcmp(key, "emu-bad-sectors")) {
+    if (!set_bad_mmcemu(p_env, value ? value : ""))
+      return DRIVER_OP_BAD_PARAMETER;
+  } else if (!strcmp(key, "emu-max-transfer")) {
+    if (!get_number_mmcemu(value, &i_value) || i_value > 0xffffffffUL)
+      return DRIVER_OP_BAD_PARAMETER;
+    p_env->i_max_transfer = (uint32_t) i_value;
+  } else if (!strcmp(key, "emu-cdtext")) {
+    if (!value || !set_cdtext_mmcemu(p_env, value))
+      return DRIVER_OP_BAD_PARAMETER;
+  } else
+    return DRIVER_OP_UNSUPPORTED;
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Return the value associated with the key "arg".
+*/
+static const char *
+get_arg_mmcemu (void *p_user_data, const char key[])
+{
+  _img_private_t *p_env = p_user_data;
+  unsigned long i_value;
+
+  if (!strcmp(key, "source"))
+    return p_env->gen.source_name;
+  else if (!strcmp(key, "access-mode"))
+    return "emulated";
+  else if (!strcmp(key, "mmc-supported"))
+    return "true";
+  else if (!strcmp(key, "emu-sleep"))
+    return p_env->b_sleep ? "true" : "false";
+  else if (!strcmp(key, "emu-image-driver"))
+    return cdio_get_driver_name(p_env->p_image);
+  else if (!strcmp(key, "emu-elapsed-us")) {
+    snprintf(p_env->sz_arg, sizeof(p_env->sz_arg), "%llu",
+             (unsigned long long) p_env->i_elapsed_us);
+    return p_env->sz_arg;
+  } else if (!strcmp(key, "emu-command-us"))
+    i_value = p_env->i_command_us;
+  else if (!strcmp(key, "emu-seek-min-us"))
+    i_value = p_env->i_seek_min_us;
+  else if (!strcmp(key, "emu-seek-max-us"))
+    i_value = p_env->i_seek_max_us;
+  else if (!strcmp(key, "emu-block-us"))
+    i_value = p_env->i_block_us;
+  else if (!strcmp(key, "emu-error-us"))
+    i_value = p_env->i_error_us;
+  else if (!strcmp(key, "emu-commands"))
+    i_value = p_env->i_commands;
+  else if (!strcmp(key, "emu-head"))
+    i_value = p_env->i_head;
+  else if (!strcmp(key, "emu-max-transfer"))
+    i_value = p_env->i_max_transfer;
+  else
+    return NULL;
+
+  snprintf(p_env->sz_arg, sizeof(p_env->sz_arg), "%lu", i_value);
+  return p_env->sz_arg;
+}
+
+/*!
+  Read and cache the TOC with READ TOC, as it would be from a drive.
+*/
+static bool
+read_toc_mmcemu (void *p_user_data)
+{
+  _img_private_t *p_env = p_user_data;
+  uint8_t buf[4 + 8 * (CDIO_CD_MAX_TRACKS + 1)] = { 0, };
+  mmc_cdb_t cdb = {{0, }};
+  unsigned int i, i_entries;
+
+  CDIO_MMC_SET_COMMAND(cdb.field, CDIO_MMC_GPCMD_READ_TOC);
+  cdb.field[2] = CDIO_MMC_READTOC_FMT_TOC;
+  CDIO_MMC_SET_READ_LENGTH16(cdb.field, sizeof(buf));
+  if (DRIVER_OP_SUCCESS !=
+      mmc_run_cmd(p_env->gen.cdio, mmc_timeout_ms, &cdb, SCSI_MMC_DATA_READ,
+                  sizeof(buf), buf))
+    return false;
+
+  i_entries = ((buf[0] << 8 | buf[1]) - 2) / 8;
+  if (i_entries < 2 || i_entries > CDIO_CD_MAX_TRACKS + 1) return false;
+  p_env->gen.i_first_track = buf[2];
+  p_env->gen.i_tracks      = i_entries - 1;
+  for (i = 0; i < i_entries; i++) {
+    const uint8_t *p = buf + 4 + 8 * i;
+    emu_track_t *p_toc = &p_env->tocent[i];
+
+    p_toc->i_control = p[1] & 0x0f;
+    p_toc->start_lsn = (lsn_t) (((uint32_t) p[4] << 24) | (p[5] << 16)
+                                | (p[6] << 8) | p[7]);
+    /* Data tracks are as the full TOC's disc type says. */
+    if (!(p_toc->i_control & CDIO_CDROM_DATA_TRACK))
+      p_toc->format = TRACK_FORMAT_AUDIO;
+    else if (0x20 == p_env->i_disc_type)
+      p_toc->format = TRACK_FORMAT_XA;
+    else if (0x10 == p_env->i_disc_type)
+      p_toc->format = TRACK_FORMAT_CDI;
+    else
+      p_toc->format = TRACK_FORMAT_DATA;
+    set_track_flags(&p_env->gen.track_flags[i + 1], p_toc->i_control);
+  }
+  if (mmc_get_discmode(p_env->gen.cdio) == CDIO_DISC_MODE_CD_XA)
+    for (i = 0; i < i_entries; i++)
+      if (TRACK_FORMAT_DATA == p_env->tocent[i].format)
+        p_env->tocent[i].format = TRACK_FORMAT_XA;
+
+  p_env->gen.toc_init = true;
+  return true;
+}
+
+static track_format_t
+get_track_format_mmcemu (void *p_user_data, track_t i_track)
+{
+  _img_private_t *p_env = p_user_data;
+
+  if (!p_env->gen.toc_init) read_toc_mmcemu(p_user_data);
+  if (!p_env->gen.toc_init || i_track < p_env->gen.i_first_track
+      || i_track >= p_env->gen.i_first_track + p_env->gen.i_tracks)
+    return TRACK_FORMAT_ERROR;
+  return p_env->tocent[i_track - p_env->gen.i_first_track].format;
+}
+
+static bool
+get_track_green_mmcemu (void *p_user_data, track_t i_track)
+{
+  return TRACK_FORMAT_XA == get_track_format_mmcemu(p_user_data, i_track);
+}
+
+static lba_t
+get_track_lba_mmcemu (void *p_user_data, track_t i_track)
+{
+  _img_private_t *p_env = p_user_data;
+
+  if (!p_env->gen.toc_init) read_toc_mmcemu(p_user_data);
+  if (!p_env->gen.toc_init) return CDIO_INVALID_LBA;
+  if (CDIO_CDROM_LEADOUT_TRACK == i_track)
+    i_track = p_env->gen.i_first_track + p_env->gen.i_tracks;
+  if (i_track < p_env->gen.i_first_track
+      || i_track > p_env->gen.i_first_track + p_env->gen.i_tracks)
+    return CDIO_INVALID_LBA;
+  return cdio_lsn_to_lba(p_env->tocent[i_track
+                                       - p_env->gen.i_first_track].start_lsn);
+}
+
+static char *
+get_track_isrc_mmcemu (const void *p_user_data, track_t i_track)
+{
+  const _img_private_t *p_env = p_user_data;
+  return mmc_get_track_isrc(p_env->gen.cdio, i_track);
+}
+
+static driver_return_code_t
+read_audio_sectors_mmcemu (void *p_user_data, void *p_buf, lsn_t i_lsn,
+                           unsigned int i_blocks)
+{
+  const _img_private_t *p_env = p_user_data;
+  return mmc_read_sectors(p_env->gen.cdio, p_buf, i_lsn,
+                          CDIO_MMC_READ_TYPE_CDDA, i_blocks);
+}
+
+/* With b_form2, the EDC and ECC come after the user data. */
+static driver_return_code_t
+read_mode1_sectors_mmcemu (void *p_user_data, void *p_buf, lsn_t i_lsn,
+                           bool b_form2, unsigned int i_blocks)
+{
+  const _img_private_t *p_env = p_user_data;
+  return mmc_read_cd(p_env->gen.cdio, p_buf, i_lsn, CDIO_MMC_READ_TYPE_MODE1,
+                     false, false, 0, true, b_form2, 0, 0,
+                     b_form2 ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE,
+                     i_blocks);
+}
+
+static driver_return_code_t
+read_mode1_sector_mmcemu (void *p_user_data, void *p_buf, lsn_t i_lsn,
+                          bool b_form2)
+{
+  return read_mode1_sectors_mmcemu(p_user_data, p_buf, i_lsn, b_form2, 1);
+}
+
+/* With b_form2, sectors of either form are read with their sub-header
+   and EDC; otherwise only form 1 user data is. */
+static driver_return_code_t
+read_mode2_sectors_mmcemu (void *p_user_data, void *p_buf, lsn_t i_lsn,
+                           bool b_form2, unsigned int i_blocks)
+{
+  const _img_private_t *p_env = p_user_data;
+
+  if (b_form2)
+    return mmc_read_cd(p_env->gen.cdio, p_buf, i_lsn,
+                       CDIO_MMC_READ_TYPE_MODE2, false, false, 2, true, true,
+                       0, 0, M2RAW_SECTOR_SIZE, i_blocks);
+  return mmc_read_cd(p_env->gen.cdio, p_buf, i_lsn, CDIO_MMC_READ_TYPE_M2F1,
+                     false, false, 0, true, false, 0, 0, CDIO_CD_FRAMESIZE,
+                     i_blocks);
+}
+
+static driver_return_code_t
+read_mode2_sector_mmcemu (void *p_user_data, void *p_buf, lsn_t i_lsn,
+                          bool b_form2)
+{
+  return read_mode2_sectors_mmcemu(p_user_data, p_buf, i_lsn, b_form2, 1);
+}
+
+static void
+free_mmcemu (void *p_user_data)
+{
+  _img_private_t *p_env = p_user_data;
+
+  if (!p_env) return;
+  cdio_destroy(p_env->p_image);
+  free(p_env->p_bad);
+  free(p_env->p_cdtext);
+  cdio_generic_free(p_env);
+}
+
+/* Open psz_source with the image driver that fits it. */
+static CdIo_t *
+open_image_mmcemu (const char *psz_source)
+{
+  if (cdio_is_tocfile(psz_source))
+    return cdio_open(psz_source, DRIVER_CDRDAO);
+  if (cdio_is_nrg(psz_source))
+    return cdio_open(psz_source, DRIVER_NRG);
+  return cdio_open(psz_source, DRIVER_BINCUE);
+}
+
+/* Take what the emulated disc holds from the image. */
+static bool
+load_disc_mmcemu (_img_private_t *p_env)
+{
+  CdIo_t *p_image = p_env->p_image;
+  const track_t i_first = cdio_get_first_track_num(p_image);
+  const track_t i_tracks = cdio_get_num_tracks(p_image);
+  uint8_t *p_cdtext;
+  track_t i;
+
+  if (CDIO_INVALID_TRACK == i_first || CDIO_INVALID_TRACK == i_tracks
+      || 0 == i_tracks || i_first + i_tracks - 1 > CDIO_CD_MAX_TRACKS)
+    return false;
+  p_env->i_first_track = i_first;
+  p_env->i_tracks      = i_tracks;
+
+  for (i = 0; i <= i_tracks; i++) {
+    emu_track_t *p_track = &p_env->disc[i];
+    const track_t i_track = (i == i_tracks) ? CDIO_CDROM_LEADOUT_TRACK
+      : i_first + i;
+
+    p_track->start_lsn = cdio_get_track_lsn(p_image, i_track);
+    if (CDIO_INVALID_LSN == p_track->start_lsn) return false;
+    if (i == i_tracks) break;
+
+    p_track->format = cdio_get_track_format(p_image, i_track);
+    if (TRACK_FORMAT_AUDIO == p_track->format) {
+      if (CDIO_TRACK_FLAG_TRUE == cdio_get_track_preemphasis(p_image, i_track))
+        p_track->i_control |= CDIO_TRACK_FLAG_PRE_EMPHASIS;
+      if (4 == cdio_get_track_channels(p_image, i_track))
+        p_track->i_control |= CDIO_TRACK_FLAG_FOUR_CHANNEL_AUDIO;
+    } else {
+      p_track->i_control |= CDIO_CDROM_DATA_TRACK;
+      if (TRACK_FORMAT_XA == p_track->format)
+        p_env->i_disc_type = 0x20;
+      else if (TRACK_FORMAT_CDI == p_track->format && !p_env->i_disc_type)
+        p_env->i_disc_type = 0x10;
+    }
+    if (CDIO_TRACK_FLAG_TRUE == cdio_get_track_copy_permit(p_image, i_track))
+      p_track->i_control |= CDIO_TRACK_FLAG_COPY_PERMITTED;
+  }
+  p_env->disc[i_tracks].i_control = p_env->disc[i_tracks - 1].i_control;
+
+  /* CD-Text packs, without READ TOC's header, if the image has them. */
+  p_cdtext = cdio_get_cdtext_raw(p_image);
+  if (p_cdtext) {
+    const size_t i_cdtext = CDIO_MMC_GET_LEN16(p_cdtext);
+
+    if (i_cdtext > 2 && (i_cdtext - 2) % CDTEXT_LEN_PACK == 0
+        && (p_env->p_cdtext = malloc(i_cdtext - 2))) {
+      memcpy(p_env->p_cdtext, p_cdtext + 4, i_cdtext - 2);
+      p_env->i_cdtext = i_cdtext - 2;
+    }
+    free(p_cdtext);
+  }
+  return true;
+}
+
+/*!
+  Initialization routine. This is the only thing that doesn't
+  get called via a function pointer. In fact *we* are the
+  ones to set that up.
+ */
+CdIo_t *
+cdio_open_am_mmc_emu (const char *psz_source, const char *psz_access_mode)
+{
+  if (psz_access_mode != NULL)
+    cdio_warn ("there is only one access mode for the MMC emulator. "
+               "Arg %s ignored", psz_access_mode);
+  return cdio_open_mmc_emu(psz_source);
+}
+
+/*!
+  Initialization routine. This is the only thing that doesn't
+  get called via a function pointer. In fact *we* are the
+  ones to set that up.
+ */
+CdIo_t *
+cdio_open_mmc_emu (const char *psz_source)
+{
+  CdIo_t *ret;
+  _img_private_t *p_env;
+  cdio_funcs_t _funcs;
+
+  memset( &_funcs, 0, sizeof(_funcs) );
+
+  _funcs.audio_read_subchannel  = audio_read_subchannel_mmc;
+  _funcs.free                   = free_mmcemu;
+  _funcs.get_arg                = get_arg_mmcemu;
+  _funcs.get_blocksize          = get_blocksize_mmc;
+  _funcs.get_cdtext             = get_cdtext_generic;
+  _funcs.get_cdtext_raw         = read_cdtext_generic;
+  _funcs.get_disc_last_lsn      = get_disc_last_lsn_mmc;
+  _funcs.get_discmode           = get_discmode_generic;
+  _funcs.get_drive_cap          = get_drive_cap_mmc;
+  _funcs.get_first_track_num    = get_first_track_num_generic;
+  _funcs.get_media_changed      = get_media_changed_mmc;
+  _funcs.get_mcn                = get_mcn_mmc;
+  _funcs.get_num_tracks         = get_num_tracks_generic;
+  _funcs.get_track_channels     = get_track_channels_generic;
+  _funcs.get_track_copy_permit  = get_track_copy_permit_generic;
+  _funcs.get_track_format       = get_track_format_mmcemu;
+  _funcs.get_track_green        = get_track_green_mmcemu;
+  _funcs.get_track_lba          = get_track_lba_mmcemu;
+  _funcs.get_track_preemphasis  = get_track_preemphasis_generic;
+  _funcs.get_track_isrc         = get_track_isrc_mmcemu;
+  _funcs.read_audio_sectors     = read_audio_sectors_mmcemu;
+  _funcs.read_data_sectors      = read_data_sectors_mmc;
+  _funcs.read_mode1_sector      = read_mode1_sector_mmcemu;
+  _funcs.read_mode1_sectors     = read_mode1_sectors_mmcemu;
+  _funcs.read_mode2_sector      = read_mode2_sector_mmcemu;
+  _funcs.read_mode2_sectors     = read_mode2_sectors_mmcemu;
+  _funcs.read_toc               = read_toc_mmcemu;
+  _funcs.run_mmc_cmd            = run_mmc_cmd_mmcemu;
+  _funcs.set_arg                = set_arg_mmcemu;
+  _funcs.set_blocksize          = set_blocksize_mmc;
+  _funcs.set_speed              = set_drive_speed_mmc;
+
+  if (NULL == psz_source) return NULL;
+
+  p_env = calloc(1, sizeof (_img_private_t));
+  if (NULL == p_env) return NULL;
+  p_env->gen.fd      = -1;
+  p_env->i_blocksize = CDIO_CD_FRAMESIZE;
+  p_env->i_read_retries = EMU_READ_RETRIES;
+
+  p_env->p_image = open_image_mmcemu(psz_source);
+  if (NULL == p_env->p_image || !load_disc_mmcemu(p_env)) {
+    cdio_warn ("MMC emulator: can't use %s as a disc image", psz_source);
+    free_mmcemu(p_env);
+    return NULL;
+  }
+  p_env->gen.source_name = strdup(psz_source);
+
+  ret = cdio_new ((void *)p_env, &_funcs);
+  if (ret == NULL) {
+    free_mmcemu(p_env);
+    return NULL;
+  }
+  ret->driver_id = DRIVER_MMC_EMU;
+  p_env->gen.init = true;
+  return ret;
+}
+
+bool
+cdio_have_mmc_emu (void)
+{
+  return true;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -47,6 +47,15 @@
 # endif
 #endif /*HAVE_SNPRINTF*/
 
+/* config.h gives TLS; builds without one get it here. */
+#if !defined(TLS)
+# if defined (_MSC_VER)
+#  define TLS __declspec(thread)
+# else
+#  define TLS
+# endif
+#endif /*TLS*/
+
 #if !defined(HAVE_DRAND48) && defined(HAVE_RAND)
 # define drand48()   (rand() / (double)RAND_MAX)
 #endif
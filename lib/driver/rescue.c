@@ -0,0 +1,573 @@
+/* Reading as much as can be read from a damaged disc.
+
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+
+#include <cdio/logging.h>
+#include <cdio/mmc_hl_cmds.h>
+#include <cdio/rescue.h>
+#include "cdio_private.h"
+
+#define RESCUE_READ_BLOCKS 32
+
+/* A run of sectors of one status. */
+typedef struct {
+  lsn_t                i_lsn;
+  uint32_t             i_blocks;
+  cdio_rescue_status_t status;
+} rescue_region_t;
+
+struct cdio_rescue_s {
+  CdIo_t      *p_cdio;
+  lsn_t        i_lsn;           /**< the area */
+  uint32_t     i_blocks;
+  uint16_t     i_blocksize;
+
+  uint32_t     i_read_blocks;
+  uint32_t     i_max_skip;
+  unsigned int i_retry_passes;
+  int          i_drive_retries;
+
+  /* The map: runs covering the area in order, no two neighbours with
+     the same status. */
+  rescue_region_t *p_regions;
+  unsigned int     i_regions;
+  unsigned int     i_alloc;
+
+  /* While running. */
+  uint8_t               *p_buf;
+  cdio_rescue_write_fn_t write_fn;
+  void                  *p_user_data;
+};
+
+/* The run i_lsn is in, or i_regions past the end. */
+static unsigned int
+find_region(const cdio_rescue_t *p_rescue, lsn_t i_lsn)
+{
+  unsigned int i_low = 0, i_high = p_rescue->i_regions;
+
+  if (i_lsn < p_rescue->i_lsn
+      || i_lsn >= p_rescue->i_lsn + (lsn_t) p_rescue->i_blocks)
+    return p_rescue->i_regions;
+  while (i_high - i_low > 1) {
+    const unsigned int i_mid = (i_low + i_high) / 2;
+
+    if (p_rescue->p_regions[i_mid].i_lsn <= i_lsn)
+      i_low = i_mid;
+    else
+      i_high = i_mid;
+  }
+  return i_low;
+}
+
+/* Make a run start at i_lsn and return it. */
+static unsigned int
+split_region(cdio_rescue_t *p_rescue, lsn_t i_lsn)
+{
+  const unsigned int i = find_region(p_rescue, i_lsn);
+  rescue_region_t *p_region;
+
+  if (i == p_rescue->i_regions || p_rescue->p_regions[i].i_lsn == i_lsn)
+    return i;
+  p_region = &p_rescue->p_regions[i];
+  memmove(p_region + 2, p_region + 1,
+          (p_rescue->i_regions - i - 1) * sizeof(*p_region));
+  p_region[1].i_lsn    = i_lsn;
+  p_region[1].i_blocks = p_region->i_lsn + p_region->i_blocks - i_lsn;
+  p_region[1].status   = p_region->status;
+  p_region->i_blocks  -= p_region[1].i_blocks;
+  p_rescue->i_regions++;
+  return i + 1;
+}
+
+/* Give i_blocks sectors from i_lsn, all inside the area, a status. */
+static bool
+set_status(cdio_rescue_t *p_rescue, lsn_t i_lsn, uint32_t i_blocks,
+           cdio_rescue_status_t status)
+{
+  rescue_region_t *p_regions;
+  unsigned int i_first, i_end;
+
+  if (0 == i_blocks) return true;
+  if (p_rescue->i_regions + 2 > p_rescue->i_alloc) {
+    const unsigned int i_alloc = 2 * p_rescue->i_alloc + 2;
+
+    p_regions = realloc(p_rescue->p_regions, i_alloc * sizeof(*p_regions));
+    if (!p_regions) return false;
+    p_rescue->p_regions = p_regions;
+    p_rescue->i_alloc = i_alloc;
+  }
+
+  i_first = split_region(p_rescue, i_lsn);
+  i_end   = split_region(p_rescue, i_lsn + i_blocks);
+  p_regions = p_rescue->p_regions;
+  p_regions[i_first].i_blocks = i_blocks;
+  p_regions[i_first].status   = status;
+  memmove(&p_regions[i_first + 1], &p_regions[i_end],
+          (p_rescue->i_regions - i_end) * sizeof(*p_regions));
+  p_rescue->i_regions -= i_end - i_first - 1;
+
+  /* Join it to its neighbours. */
+  if (i_first + 1 < p_rescue->i_regions
+      && p_regions[i_first + 1].status == status) {
+    p_regions[i_first].i_blocks += p_regions[i_first + 1].i_blocks;
+    memmove(&p_regions[i_first + 1], &p_regions[i_first + 2],
+            (p_rescue->i_regions - i_first - 2) * sizeof(*p_regions));
+    p_rescue->i_regions--;
+  }
+  if (i_first > 0 && p_regions[i_first - 1].status == status) {
+    p_regions[i_first - 1].i_blocks += p_regions[i_first].i_blocks;
+    memmove(&p_regions[i_first], &p_regions[i_first + 1],
+            (p_rescue->i_regions - i_first - 1) * sizeof(*p_regions));
+    p_rescue->i_regions--;
+  }
+  return true;
+}
+
+cdio_rescue_t *
+cdio_rescue_new(CdIo_t *p_cdio, lsn_t i_lsn, uint32_t i_blocks,
+                uint16_t i_blocksize)
+{
+  cdio_rescue_t *p_rescue;
+
+  if (!p_cdio || i_lsn < 0 || 0 == i_blocks || 0 == i_blocksize
+      || i_blocks > (uint32_t) (CDIO_INVALID_LSN - 1 - i_lsn))
+    return NULL;
+  p_rescue = calloc(1, sizeof(*p_rescue));
+  if (!p_rescue) return NULL;
+  p_rescue->p_regions = calloc(4, sizeof(*p_rescue->p_regions));
+  if (!p_rescue->p_regions) {
+    free(p_rescue);
+    return NULL;
+  }
+  p_rescue->p_cdio          = p_cdio;
+  p_rescue->i_lsn           = i_lsn;
+  p_rescue->i_blocks        = i_blocks;
+  p_rescue->i_blocksize     = i_blocksize;
+  p_rescue->i_read_blocks   = RESCUE_READ_BLOCKS;
+  p_rescue->i_drive_retries = -1;
+  p_rescue->i_alloc         = 4;
+  p_rescue->i_regions       = 1;
+  p_rescue->p_regions[0].i_lsn    = i_lsn;
+  p_rescue->p_regions[0].i_blocks = i_blocks;
+  p_rescue->p_regions[0].status   = CDIO_RESCUE_UNTRIED;
+  return p_rescue;
+}
+
+void
+cdio_rescue_destroy(cdio_rescue_t *p_rescue)
+{
+  if (!p_rescue) return;
+  free(p_rescue->p_regions);
+  free(p_rescue->p_buf);
+  free(p_rescue);
+}
+
+driver_return_code_t
+cdio_rescue_set_read_blocks(cdio_rescue_t *p_rescue, uint32_t i_blocks)
+{
+  if (!p_rescue) return DRIVER_OP_UNINIT;
+  if (0 == i_blocks || i_blocks > 0xffff) return DRIVER_OP_BAD_PARAMETER;
+  p_rescue->i_read_blocks = i_blocks;
+  return DRIVER_OP_SUCCESS;
+}
+
+void
+cdio_rescue_set_max_skip(cdio_rescue_t *p_rescue, uint32_t i_blocks)
+{
+  if (p_rescue) p_rescue->i_max_skip = i_blocks;
+}
+
+void
+cdio_rescue_set_retry_passes(cdio_rescue_t *p_rescue, unsigned int i_passes)
+{
+  if (p_rescue) p_rescue->i_retry_passes = i_passes;
+}
+
+void
+cdio_rescue_set_drive_retries(cdio_rescue_t *p_rescue, int i_retries)
+{
+  if (p_rescue) p_rescue->i_drive_retries = (i_retries > 255) ? 255 : i_retries;
+}
+
+/*!
+  Read i_blocks sectors from i_lsn and hand them over, or give them
+  i_fail_status. *pb_read says which happened. A driver error other
+  than not being able to read is returned.
+*/
+static driver_return_code_t
+read_region(cdio_rescue_t *p_rescue, lsn_t i_lsn, uint32_t i_blocks,
+            cdio_rescue_status_t i_fail_status, bool *pb_read)
+{
+  driver_return_code_t i_rc;
+
+  if (CDIO_CD_FRAMESIZE_RAW == p_rescue->i_blocksize)
+    i_rc = cdio_read_audio_sectors(p_rescue->p_cdio, p_rescue->p_buf, i_lsn,
+                                   i_blocks);
+  else
+    i_rc = cdio_read_data_sectors(p_rescue->p_cdio, p_rescue->p_buf, i_lsn,
+                                  p_rescue->i_blocksize, i_blocks);
+
+  *pb_read = (DRIVER_OP_SUCCESS == i_rc);
+  if (*pb_read) {
+    i_rc = p_rescue->write_fn(p_rescue->p_user_data, i_lsn, p_rescue->p_buf,
+                              i_blocks);
+    if (DRIVER_OP_SUCCESS != i_rc) return i_rc;
+    return set_status(p_rescue, i_lsn, i_blocks, CDIO_RESCUE_FINISHED)
+      ? DRIVER_OP_SUCCESS : DRIVER_OP_ERROR;
+  }
+  if (DRIVER_OP_ERROR != i_rc) return i_rc;
+  cdio_debug("rescue: %u sector(s) at %d can't be read", i_blocks, i_lsn);
+  return set_status(p_rescue, i_lsn, i_blocks, i_fail_status)
+    ? DRIVER_OP_SUCCESS : DRIVER_OP_ERROR;
+}
+
+/*!
+  Read the untried sectors in large reads. With b_skip, each failure
+  skips further ahead than the last, up to i_max_skip sectors; what is
+  skipped stays untried.
+*/
+static driver_return_code_t
+copy_pass(cdio_rescue_t *p_rescue, bool b_skip)
+{
+  const lsn_t i_end = p_rescue->i_lsn + (lsn_t) p_rescue->i_blocks;
+  uint32_t i_skip = 0;
+  lsn_t i_lsn = p_rescue->i_lsn;
+
+  while (i_lsn < i_end) {
+    const rescue_region_t region =
+      p_rescue->p_regions[find_region(p_rescue, i_lsn)];
+    const lsn_t i_region_end = region.i_lsn + (lsn_t) region.i_blocks;
+    uint32_t i_blocks;
+    driver_return_code_t i_rc;
+    bool b_read;
+
+    if (CDIO_RESCUE_UNTRIED != region.status) {
+      i_lsn = i_region_end;
+      continue;
+    }
+    i_blocks = p_rescue->i_read_blocks;
+    if (i_blocks > (uint32_t) (i_region_end - i_lsn))
+      i_blocks = i_region_end - i_lsn;
+    i_rc = read_region(p_rescue, i_lsn, i_blocks, CDIO_RESCUE_UNTRIMMED,
+                       &b_read);
+    if (DRIVER_OP_SUCCESS != i_rc) return i_rc;
+    i_lsn += i_blocks;
+
+    if (b_read)
+      i_skip = 0;
+    else if (b_skip) {
+      i_skip = i_skip ? 2 * i_skip : p_rescue->i_read_blocks;
+      if (i_skip > p_rescue->i_max_skip) i_skip = p_rescue->i_max_skip;
+      i_lsn = (i_skip < (uint32_t) (i_end - i_lsn)) ? i_lsn + i_skip : i_end;
+    }
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Halve a run that couldn't be read until what can't be read on its
+   own is found. */
+static driver_return_code_t
+bisect(cdio_rescue_t *p_rescue, lsn_t i_lsn, uint32_t i_blocks)
+{
+  const uint32_t i_half = i_blocks / 2;
+  const lsn_t ai_lsn[2] = { i_lsn, i_lsn + i_half };
+  const uint32_t ai_blocks[2] = { i_half, i_blocks - i_half };
+  unsigned int i;
+
+  for (i = 0; i < 2; i++) {
+    driver_return_code_t i_rc;
+    bool b_read;
+
+    if (0 == ai_blocks[i]) continue;
+    i_rc = read_region(p_rescue, ai_lsn[i], ai_blocks[i],
+                       (1 == ai_blocks[i])
+                       ? CDIO_RESCUE_BAD : CDIO_RESCUE_UNTRIMMED,
+                       &b_read);
+    if (DRIVER_OP_SUCCESS != i_rc) return i_rc;
+    if (!b_read && ai_blocks[i] > 1
+        && DRIVER_OP_SUCCESS != (i_rc = bisect(p_rescue, ai_lsn[i],
+                                               ai_blocks[i])))
+      return i_rc;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Narrow down the runs that couldn't be read, a read's worth at a
+   time. */
+static driver_return_code_t
+trim_pass(cdio_rescue_t *p_rescue)
+{
+  const lsn_t i_end = p_rescue->i_lsn + (lsn_t) p_rescue->i_blocks;
+  lsn_t i_lsn = p_rescue->i_lsn;
+
+  while (i_lsn < i_end) {
+    const rescue_region_t region =
+      p_rescue->p_regions[find_region(p_rescue, i_lsn)];
+    const lsn_t i_region_end = region.i_lsn + (lsn_t) region.i_blocks;
+    uint32_t i_blocks;
+    driver_return_code_t i_rc;
+
+    if (CDIO_RESCUE_UNTRIMMED != region.status) {
+      i_lsn = i_region_end;
+      continue;
+    }
+    i_blocks = p_rescue->i_read_blocks;
+    if (i_blocks > (uint32_t) (i_region_end - i_lsn))
+      i_blocks = i_region_end - i_lsn;
+    if (1 == i_blocks) {
+      bool b_read;
+      i_rc = read_region(p_rescue, i_lsn, 1, CDIO_RESCUE_BAD, &b_read);
+    } else
+      i_rc = bisect(p_rescue, i_lsn, i_blocks);
+    if (DRIVER_OP_SUCCESS != i_rc) return i_rc;
+    i_lsn += i_blocks;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Try each sector that couldn't be read once more. */
+static driver_return_code_t
+retry_pass(cdio_rescue_t *p_rescue)
+{
+  const lsn_t i_end = p_rescue->i_lsn + (lsn_t) p_rescue->i_blocks;
+  lsn_t i_lsn = p_rescue->i_lsn;
+
+  while (i_lsn < i_end) {
+    const rescue_region_t region =
+      p_rescue->p_regions[find_region(p_rescue, i_lsn)];
+    driver_return_code_t i_rc;
+    bool b_read;
+
+    if (CDIO_RESCUE_BAD != region.status) {
+      i_lsn = region.i_lsn + (lsn_t) region.i_blocks;
+      continue;
+    }
+    i_rc = read_region(p_rescue, i_lsn, 1, CDIO_RESCUE_BAD, &b_read);
+    if (DRIVER_OP_SUCCESS != i_rc) return i_rc;
+    i_lsn++;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+driver_return_code_t
+cdio_rescue_run(cdio_rescue_t *p_rescue, cdio_rescue_write_fn_t write_fn,
+                void *p_user_data, const char *psz_map)
+{
+  int i_old_retries = -1;
+  driver_return_code_t i_rc;
+  unsigned int i_pass;
+
+  if (!p_rescue) return DRIVER_OP_UNINIT;
+  if (!write_fn) return DRIVER_OP_BAD_POINTER;
+
+  free(p_rescue->p_buf);
+  p_rescue->p_buf = malloc((size_t) p_rescue->i_read_blocks
+                           * p_rescue->i_blocksize);
+  if (!p_rescue->p_buf) return DRIVER_OP_ERROR;
+  p_rescue->write_fn    = write_fn;
+  p_rescue->p_user_data = p_user_data;
+  if (0 == p_rescue->i_max_skip) {
+    p_rescue->i_max_skip = p_rescue->i_blocks / 64;
+    if (p_rescue->i_max_skip < p_rescue->i_read_blocks)
+      p_rescue->i_max_skip = p_rescue->i_read_blocks;
+  }
+
+  if (p_rescue->i_drive_retries >= 0) {
+    i_old_retries = mmc_get_read_retries(p_rescue->p_cdio);
+    if (i_old_retries < 0
+        || DRIVER_OP_SUCCESS !=
+        mmc_set_read_retries(p_rescue->p_cdio, p_rescue->i_drive_retries)) {
+      cdio_info("rescue: can't set the drive's read retries");
+      i_old_retries = -1;
+    }
+  }
+
+  /* Harvest what reads easily first, then narrow down what didn't. */
+  i_rc = copy_pass(p_rescue, true);
+  if (DRIVER_OP_SUCCESS == i_rc && psz_map)
+    cdio_rescue_save_map(p_rescue, psz_map);
+  if (DRIVER_OP_SUCCESS == i_rc) i_rc = copy_pass(p_rescue, false);
+  if (DRIVER_OP_SUCCESS == i_rc && psz_map)
+    cdio_rescue_save_map(p_rescue, psz_map);
+  if (DRIVER_OP_SUCCESS == i_rc) i_rc = trim_pass(p_rescue);
+
+  /* Trying hard is the point of the retry passes, so the drive is
+     let to as well. */
+  if (i_old_retries >= 0) {
+    mmc_set_read_retries(p_rescue->p_cdio, i_old_retries);
+    i_old_retries = -1;
+  }
+  for (i_pass = 0; DRIVER_OP_SUCCESS == i_rc
+         && i_pass < p_rescue->i_retry_passes
+         && cdio_rescue_get_count(p_rescue, CDIO_RESCUE_BAD) > 0; i_pass++) {
+    if (psz_map) cdio_rescue_save_map(p_rescue, psz_map);
+    i_rc = retry_pass(p_rescue);
+  }
+
+  if (psz_map) {
+    const driver_return_code_t i_save_rc =
+      cdio_rescue_save_map(p_rescue, psz_map);
+
+    if (DRIVER_OP_SUCCESS == i_rc) i_rc = i_save_rc;
+  }
+  free(p_rescue->p_buf);
+  p_rescue->p_buf = NULL;
+  return i_rc;
+}
+
+driver_return_code_t
+cdio_rescue_save_map(const cdio_rescue_t *p_rescue, const char *psz_map)
+{
+  char *psz_tmp;
+  FILE *fp;
+  unsigned int i;
+  bool b_ok;
+
+  if (!p_rescue) return DRIVER_OP_UNINIT;
+  if (!psz_map) return DRIVER_OP_BAD_POINTER;
+  psz_tmp = malloc(strlen(psz_map) + 5);
+  if (!psz_tmp) return DRIVER_OP_ERROR;
+  sprintf(psz_tmp, "%s.new", psz_map);
+
+  fp = fopen(psz_tmp, "w");
+  if (!fp) {
+    cdio_warn("can't write rescue map %s: %s", psz_tmp, strerror(errno));
+    free(psz_tmp);
+    return DRIVER_OP_ERROR;
+  }
+  fprintf(fp, "# Rescue map written by libcdio\n"
+          "# lsn blocks status\n");
+  for (i = 0; i < p_rescue->i_regions; i++)
+    fprintf(fp, "%ld %lu %c\n", (long) p_rescue->p_regions[i].i_lsn,
+            (unsigned long) p_rescue->p_regions[i].i_blocks,
+            (char) p_rescue->p_regions[i].status);
+  b_ok = !ferror(fp);
+  b_ok = (0 == fclose(fp)) && b_ok;
+  if (b_ok && 0 != rename(psz_tmp, psz_map)) b_ok = false;
+  if (!b_ok) {
+    cdio_warn("can't write rescue map %s: %s", psz_map, strerror(errno));
+    remove(psz_tmp);
+  }
+  free(psz_tmp);
+  return b_ok ? DRIVER_OP_SUCCESS : DRIVER_OP_ERROR;
+}
+
+driver_return_code_t
+cdio_rescue_load_map(cdio_rescue_t *p_rescue, const char *psz_map)
+{
+  const lsn_t i_end = p_rescue ? p_rescue->i_lsn + (lsn_t) p_rescue->i_blocks
+    : 0;
+  driver_return_code_t i_rc = DRIVER_OP_SUCCESS;
+  char line[128];
+  FILE *fp;
+
+  if (!p_rescue) return DRIVER_OP_UNINIT;
+  if (!psz_map) return DRIVER_OP_BAD_POINTER;
+  fp = fopen(psz_map, "r");
+  if (!fp) {
+    cdio_info("can't read rescue map %s: %s", psz_map, strerror(errno));
+    return DRIVER_OP_ERROR;
+  }
+
+  while (DRIVER_OP_SUCCESS == i_rc && fgets(line, sizeof(line), fp)) {
+    long int i_lsn;
+    unsigned long int i_blocks;
+    char c_status, c_extra;
+    int i_fields;
+
+    if ('#' == line[0] || '\n' == line[0]) continue;
+    i_fields = sscanf(line, "%ld %lu %c %c", &i_lsn, &i_blocks, &c_status,
+                      &c_extra);
+    if (3 != i_fields || i_lsn < 0 || 0 == i_blocks
+        || i_blocks > (unsigned long) CDIO_INVALID_LSN
+        || (CDIO_RESCUE_UNTRIED != c_status
+            && CDIO_RESCUE_UNTRIMMED != c_status
+            && CDIO_RESCUE_BAD != c_status
+            && CDIO_RESCUE_FINISHED != c_status)) {
+      cdio_warn("%s isn't a rescue map: %s", psz_map, line);
+      i_rc = DRIVER_OP_BAD_PARAMETER;
+      break;
+    }
+
+    /* Only what is in the area. */
+    if (i_lsn < p_rescue->i_lsn) {
+      if (i_blocks <= (unsigned long) (p_rescue->i_lsn - i_lsn)) continue;
+      i_blocks -= p_rescue->i_lsn - i_lsn;
+      i_lsn = p_rescue->i_lsn;
+    }
+    if (i_lsn >= i_end) continue;
+    if (i_blocks > (unsigned long) (i_end - i_lsn)) i_blocks = i_end - i_lsn;
+    if (!set_status(p_rescue, i_lsn, i_blocks,
+                    (cdio_rescue_status_t) c_status))
+      i_rc = DRIVER_OP_ERROR;
+  }
+  if (DRIVER_OP_SUCCESS == i_rc && ferror(fp)) i_rc = DRIVER_OP_ERROR;
+  fclose(fp);
+  return i_rc;
+}
+
+uint32_t
+cdio_rescue_get_count(const cdio_rescue_t *p_rescue,
+                      cdio_rescue_status_t status)
+{
+  uint32_t i_count = 0;
+  unsigned int i;
+
+  if (!p_rescue) return 0;
+  for (i = 0; i < p_rescue->i_regions; i++)
+    if (p_rescue->p_regions[i].status == status)
+      i_count += p_rescue->p_regions[i].i_blocks;
+  return i_count;
+}
+
+bool
+cdio_rescue_get_region(const cdio_rescue_t *p_rescue, unsigned int i_region,
+                       lsn_t *pi_lsn, uint32_t *pi_blocks,
+                       cdio_rescue_status_t *p_status)
+{
+  if (!p_rescue || i_region >= p_rescue->i_regions) return false;
+  if (pi_lsn)    *pi_lsn    = p_rescue->p_regions[i_region].i_lsn;
+  if (pi_blocks) *pi_blocks = p_rescue->p_regions[i_region].i_blocks;
+  if (p_status)  *p_status  = p_rescue->p_regions[i_region].status;
+  return true;
+}
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -314,7 +314,7 @@ cdio_get_track_isrc (const CdIo_t *p_cdio, track_t u_track)
   }
 
   if (p_cdio->op.get_track_isrc) {
-    return p_cdio->op.get_track_isrc (p_cdio->env, u_track);
+    return cdio_disc_cache_get_isrc (p_cdio, u_track);
   } else {
     return NULL;
   }
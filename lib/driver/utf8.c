@@ -115,6 +115,74 @@ FILE* fopen_utf8(const char* filename, const char* mode)
 }
 #endif
 
+/* Bytes of four UTF-16BE code units that must be 0 for all four to
+   be ASCII. */
+static const uint8_t utf16be_ascii_mask[8] =
+  { 0xff, 0x80, 0xff, 0x80, 0xff, 0x80, 0xff, 0x80 };
+
+size_t
+cdio_utf16be_to_utf8(const uint8_t *src, size_t src_len, cdio_utf8_t *dst)
+{
+  const uint8_t *end = src + (src_len & ~(size_t) 1);
+  uint64_t ascii_mask;
+  char *out = dst;
+
+  memcpy(&ascii_mask, utf16be_ascii_mask, sizeof(ascii_mask));
+
+  while (src < end) {
+    uint32_t c;
+
+    /* Most names are plain ASCII: test four code units at a time. */
+    while (end - src >= 8) {
+      uint64_t units;
+
+      memcpy(&units, src, sizeof(units));
+      if (units & ascii_mask)
+        break;
+      out[0] = (char) src[1];
+      out[1] = (char) src[3];
+      out[2] = (char) src[5];
+      out[3] = (char) src[7];
+      out += 4;
+      src += 8;
+    }
+    if (src == end)
+      break;
+
+    c = (src[0] << 8) | src[1];
+    src += 2;
+
+    if (c < 0x80) {
+      *out++ = (char) c;
+    } else if (c < 0x800) {
+      *out++ = (char) (0xc0 | (c >> 6));
+      *out++ = (char) (0x80 | (c & 0x3f));
+    } else {
+      if (c >= 0xd800 && c <= 0xdfff) {
+        uint32_t low = (end - src >= 2) ? (uint32_t) ((src[0] << 8) | src[1])
+          : 0;
+
+        if (c <= 0xdbff && low >= 0xdc00 && low <= 0xdfff) {
+          c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+          src += 2;
+          *out++ = (char) (0xf0 | (c >> 18));
+          *out++ = (char) (0x80 | ((c >> 12) & 0x3f));
+          *out++ = (char) (0x80 | ((c >> 6) & 0x3f));
+          *out++ = (char) (0x80 | (c & 0x3f));
+          continue;
+        }
+        c = 0xfffd;
+      }
+      *out++ = (char) (0xe0 | (c >> 12));
+      *out++ = (char) (0x80 | ((c >> 6) & 0x3f));
+      *out++ = (char) (0x80 | (c & 0x3f));
+    }
+  }
+
+  *out = '\0';
+  return (size_t) (out - dst);
+}
+
 #ifdef HAVE_ICONV
 #include <iconv.h>
 struct cdio_charset_coverter_s
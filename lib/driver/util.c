@@ -72,34 +72,36 @@ _cdio_strfreev(char **strv)
 }
 
 char **
-_cdio_strsplit(const char str[], char delim) /* fixme -- non-reentrant */
+_cdio_strsplit(const char str[], char delim)
 {
   int n;
   char **strv = NULL;
-  char *_str, *p;
-  char _delim[2] = { 0, 0 };
+  const char *p, *q;
 
   cdio_assert (str != NULL);
 
-  _str = strdup(str);
-  _delim[0] = delim;
-
-  cdio_assert (_str != NULL);
-
   n = 1;
-  p = _str;
-  while(*p)
-    if (*(p++) == delim)
+  for (p = str; *p; p++)
+    if (*p == delim)
       n++;
 
   strv = calloc (n+1, sizeof (char *));
   cdio_assert (strv != NULL);
 
+  /* Like strtok(), empty fields are dropped. */
   n = 0;
-  while((p = strtok(n ? NULL : _str, _delim)) != NULL)
-    strv[n++] = strdup(p);
-
-  free(_str);
+  for (p = str; *p; p = q) {
+    while (*p == delim)
+      p++;
+    if (!*p)
+      break;
+    for (q = p; *q && *q != delim; q++)
+      ;
+    strv[n] = malloc (q - p + 1);
+    cdio_assert (strv[n] != NULL);
+    memcpy (strv[n], p, q - p);
+    strv[n++][q - p] = '\0';
+  }
 
   return strv;
 }
@@ -27,6 +27,8 @@ const char ISO_STANDARD_ID[] = {'C', 'D', '0', '0', '1'};
 /* Private headers */
 #include "iso9660_private.h"
 #include "cdio_assert.h"
+#include "cdio_time.h"
+#include "portable.h"
 
 /* Public headers */
 #include <cdio/bytesex.h>
@@ -55,56 +57,6 @@ const char ISO_STANDARD_ID[] = {'C', 'D', '0', '0', '1'};
 #include <errno.h>
 #endif
 
-#ifndef HAVE_SETENV
-static int
-setenv(const char *envname, const char *envval, int overwrite)
-{
-  return -1;
-}
-#endif
-
-#ifndef HAVE_UNSETENV
-static int
-unsetenv(const char *envname)
-{
-  return -1;
-}
-#endif
-
-#ifndef HAVE_TIMEGM
-static time_t
-timegm(struct tm *tm)
-{
-  time_t ret;
-  char *tz;
-
-  tz = getenv("TZ");
-  setenv("TZ", "UTC", 1);
-  tzset();
-  ret = mktime(tm);
-  if (tz)
-    setenv("TZ", tz, 1);
-  else
-    unsetenv("TZ");
-  tzset();
-  return ret;
-}
-#endif
-
-#ifndef HAVE_GMTIME_R
-static struct tm *
-gmtime_r(const time_t *timer, struct tm *result)
-{
-    struct tm *tmp = gmtime(timer);
-
-    if (tmp) {
-        *result = *tmp;
-        return result;
-    }
-    return tmp;
-}
-#endif
-
 #ifndef HAVE_LOCALTIME_R
 static struct tm *
 localtime_r(const time_t *timer, struct tm *result)
@@ -136,7 +88,7 @@ enum iso_extension_enum_s iso_extension_enums;
 static char *
 strip_trail (const char str[], size_t n)
 {
-  static char buf[1025];
+  static TLS char buf[1025];
   int j;
 
   cdio_assert (n < 1024);
@@ -210,22 +162,16 @@ iso9660_get_dtime (const iso9660_dtime_t *idr_date, bool b_localtime,
   p_tm->tm_zone   = 0;
 #endif
 
-  /* Recompute tm_wday and tm_yday via mktime. mktime will also renormalize
-     date values to account for the timezone offset. */
-  {
-    time_t t = 0;
+  /* Recompute tm_wday and tm_yday. This also renormalizes date
+     values to account for the timezone offset. */
+  if (b_localtime) {
+    time_t t = (time_t) _cdio_timegm(p_tm);
     struct tm temp_tm;
 
-    t = timegm(p_tm);
-
-    if (b_localtime)
-      localtime_r(&t, &temp_tm);
-    else
-      gmtime_r(&t, &temp_tm);
-
+    localtime_r(&t, &temp_tm);
     memcpy(p_tm, &temp_tm, sizeof(struct tm));
-  }
-
+  } else
+    _cdio_gmtime(_cdio_timegm(p_tm), p_tm);
 
   return true;
 }
@@ -282,18 +228,13 @@ iso9660_get_ltime (const iso9660_ltime_t *p_ldate,
   p_tm->tm_zone = 0;
 #endif
 
-  /* Recompute tm_wday and tm_yday via mktime. mktime will also renormalize
-     date values to account for the timezone offset. */
-  {
-    time_t t;
-    struct tm temp_tm;
-
-    t = mktime(p_tm);
-
-    localtime_r(&t, &temp_tm);
-
-    memcpy(p_tm, &temp_tm, sizeof(struct tm));
-  }
+  /* Recompute tm_wday and tm_yday and renormalize the date values.
+     The fields are in the recorded time zone, so this is plain
+     calendar arithmetic. */
+  _cdio_gmtime(_cdio_timegm(p_tm), p_tm);
+#ifdef HAVE_STRUCT_TM_TM_ZONE
+  p_tm->tm_zone = 0;
+#endif
   p_tm->tm_isdst= -1; /* information not available */
 #ifdef HAVE_TM_GMTOFF
   p_tm->tm_gmtoff = -p_ldate->lt_gmtoff * (15 * 60);
@@ -676,9 +617,8 @@ iso9660_set_pvd(void *pd,
   iso9660_strncpy_pad (ipd.abstract_file_id     , "", 37, ISO9660_DCHARS);
   iso9660_strncpy_pad (ipd.bibliographic_file_id, "", 37, ISO9660_DCHARS);
 
-  gmtime_r(pvd_time, &temp_tm);
+  _cdio_gmtime(*pvd_time, &temp_tm);
   iso9660_set_ltime (&temp_tm, &(ipd.creation_date));
-  gmtime_r(pvd_time, &temp_tm);
   iso9660_set_ltime (&temp_tm, &(ipd.modification_date));
   iso9660_set_ltime (NULL,     &(ipd.expiration_date));
   iso9660_set_ltime (NULL,     &(ipd.effective_date));
@@ -778,7 +718,7 @@ iso9660_dir_add_entry_su(void *dir,
   idr->extent = to_733(extent);
   idr->size = to_733(size);
 
-  gmtime_r(entry_time, &temp_tm);
+  _cdio_gmtime(*entry_time, &temp_tm);
   iso9660_set_dtime (&temp_tm, &(idr->recording_time));
 
   idr->file_flags = to_711(file_flags);
@@ -0,0 +1,706 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/* Bulk extraction of an ISO 9660 directory tree: all file extents are
+   gathered first and then read front to back in large reads. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+# define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+# include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+# include <string.h>
+#endif
+#ifdef HAVE_ERRNO_H
+# include <errno.h>
+#endif
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>
+#endif
+#ifdef HAVE_FCNTL_H
+# include <fcntl.h>
+#endif
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
+#if defined(_WIN32)
+# include <direct.h>
+# define mkdir(path, mode) _mkdir(path)
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/iso9660.h>
+#include <cdio/logging.h>
+#include <cdio/util.h>
+
+#include "filemode.h"
+
+#ifndef O_BINARY
+# define O_BINARY 0
+#endif
+#ifndef O_NOFOLLOW
+# define O_NOFOLLOW 0
+#endif
+
+/* Number of read buffers: one being written out while the others are
+   filled. */
+#define EXTRACT_BUFFERS 3
+#define EXTRACT_DEFAULT_READ_BLOCKS 512
+
+typedef struct {
+  char         *psz_path;   /* local path */
+  lsn_t         i_lsn;
+  uint64_t      i_size;
+  uint64_t      i_written;
+  posix_mode_t  st_mode;
+  bool          b_mode;     /* apply st_mode once written */
+  bool          b_done;
+  FILE         *p_fd;       /* open while being written */
+} extract_file_t;
+
+typedef struct {
+  char         *psz_path;   /* local path */
+  posix_mode_t  st_mode;
+  bool          b_mode;     /* apply st_mode when all is extracted */
+} extract_dir_t;
+
+typedef struct {
+  uint8_t      *p_buf;
+  lsn_t         i_lsn;
+  uint32_t      i_blocks;
+} extract_chunk_t;
+
+typedef struct {
+  iso9660_t       *p_iso;
+  const char      *psz_dst_dir;
+  uint8_t          u_joliet_level;
+  bool             b_rock_ridge;
+  uint32_t         i_max_read_blocks;
+  uint32_t         i_max_gap_blocks;
+
+  /* Filled in while walking the tree. */
+  extract_file_t  *p_file;        /* sorted by LSN before reading */
+  size_t           i_files, i_files_alloc;
+  extract_dir_t   *p_dir;         /* in the order created */
+  size_t           i_dirs, i_dirs_alloc;
+
+  /* The directory being visited, and the local paths of directories
+     still to be visited in the same order iso9660_ifs_walk() reports
+     them: the top of the stack comes next. */
+  char            *psz_cur_iso_dir;
+  size_t           i_cur_dir;     /* index into p_dir, or -1 for the top */
+  size_t          *p_pending;     /* subdirectories of the current one */
+  size_t           i_pending, i_pending_alloc;
+  size_t          *p_stack;
+  size_t           i_stack, i_stack_alloc;
+
+  /* Used while writing. */
+  size_t           i_first;       /* first file not completely written */
+  extract_chunk_t  chunk[EXTRACT_BUFFERS];
+  unsigned long    i_read_seq;    /* chunks read so far */
+  unsigned long    i_write_seq;   /* chunks written so far */
+  bool             b_eof;
+  bool             b_failed;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_t  lock;
+  pthread_cond_t   cond;
+#endif
+} extract_t;
+
+static bool
+_extract_grow(void **pp_array, size_t *p_alloc, size_t i_count,
+              size_t i_size)
+{
+  if (i_count == *p_alloc) {
+    size_t i_alloc = *p_alloc ? 2 * *p_alloc : 64;
+    void *p_array = realloc(*pp_array, i_alloc * i_size);
+
+    if (!p_array) {
+      cdio_warn("Couldn't realloc(%lu)", (unsigned long) (i_alloc * i_size));
+      return false;
+    }
+    *pp_array = p_array;
+    *p_alloc  = i_alloc;
+  }
+  return true;
+}
+
+static const char *
+_extract_cur_dir(const extract_t *p_extract)
+{
+  return ((size_t) -1 == p_extract->i_cur_dir)
+    ? p_extract->psz_dst_dir
+    : p_extract->p_dir[p_extract->i_cur_dir].psz_path;
+}
+
+/* Whether psz_name can be used as the name of something in a local
+   directory: a name from the image mustn't lead out of the one it is
+   extracted into. A NUL can't be in it; Rock Ridge names with one are
+   dropped when parsed. */
+static bool
+_extract_is_safe_name(const char *psz_name)
+{
+  return '\0' != psz_name[0]
+    && 0 != strcmp(psz_name, ".") && 0 != strcmp(psz_name, "..")
+    && NULL == strchr(psz_name, '/')
+#if defined(_WIN32)
+    && NULL == strchr(psz_name, '\\') && NULL == strchr(psz_name, ':')
+#endif
+    ;
+}
+
+/* Local path for an entry of the current directory. Plain ISO 9660
+   and Joliet names lose their version number, as in
+   iso9660_name_translate_ext(); Rock Ridge names are kept as they are.
+   NULL if the name isn't safe to use. */
+static char *
+_extract_local_path(const extract_t *p_extract, const iso9660_stat_t *p_stat)
+{
+  const char *psz_dir = _extract_cur_dir(p_extract);
+  size_t len = strlen(psz_dir) + strlen(p_stat->filename) + 2;
+  char *psz_path = malloc(len);
+  int i;
+
+  if (!psz_path) {
+    cdio_warn("Couldn't malloc(%lu)", (unsigned long) len);
+    return NULL;
+  }
+  i = snprintf(psz_path, len, "%s/", psz_dir);
+  if (yep == p_stat->rr.b3_rock)
+    strcpy(psz_path + i, p_stat->filename);
+  else
+    iso9660_name_translate_ext(p_stat->filename, psz_path + i,
+                               p_extract->u_joliet_level);
+  if (!_extract_is_safe_name(psz_path + i)) {
+    cdio_warn("Refusing to extract %s/%s: unsafe name",
+              p_extract->psz_cur_iso_dir, p_stat->filename);
+    free(psz_path);
+    return NULL;
+  }
+  return psz_path;
+}
+
+/* Make the directory psz_path, or use the one there. Something else
+   there, a symbolic link to a directory included, isn't used. */
+static bool
+_extract_mkdir(const char *psz_path)
+{
+  struct stat st;
+
+  if (0 == mkdir(psz_path, 0700)) return true;
+  if (EEXIST != errno) {
+    cdio_warn("Couldn't create directory %s: %s", psz_path,
+              strerror(errno));
+    return false;
+  }
+#if defined(_WIN32)
+  if (0 == stat(psz_path, &st) && S_ISDIR(st.st_mode)) return true;
+#else
+  if (0 == lstat(psz_path, &st) && S_ISDIR(st.st_mode)) return true;
+#endif
+  cdio_warn("Couldn't create directory %s: something else is there",
+            psz_path);
+  return false;
+}
+
+/* Create the file psz_path afresh for writing. Whatever was there is
+   removed rather than written through, so a symbolic link in the way
+   isn't followed. */
+static FILE *
+_extract_create(const char *psz_path)
+{
+  const int i_flags = O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_BINARY;
+  FILE *p_fd;
+  int fd = open(psz_path, i_flags, 0600);
+
+  if (-1 == fd && EEXIST == errno && 0 == unlink(psz_path))
+    fd = open(psz_path, i_flags, 0600);
+  if (-1 == fd) {
+    cdio_warn("Couldn't create %s: %s", psz_path, strerror(errno));
+    return NULL;
+  }
+  p_fd = fdopen(fd, "wb");
+  if (!p_fd) {
+    cdio_warn("Couldn't create %s: %s", psz_path, strerror(errno));
+    close(fd);
+  }
+  return p_fd;
+}
+
+/* A new directory is being reported. iso9660_ifs_walk() reports the
+   subdirectories of a directory depth-first in on-disk order once
+   that directory is done, so it is the next one on the stack. */
+static bool
+_extract_enter_dir(extract_t *p_extract, const char psz_iso_dir[])
+{
+  const bool b_top = (NULL == p_extract->psz_cur_iso_dir);
+
+  free(p_extract->psz_cur_iso_dir);
+  p_extract->psz_cur_iso_dir = strdup(psz_iso_dir);
+  if (!p_extract->psz_cur_iso_dir) return false;
+  if (b_top) return true;
+
+  while (p_extract->i_pending > 0) {
+    if (!_extract_grow((void **) &p_extract->p_stack,
+                       &p_extract->i_stack_alloc, p_extract->i_stack,
+                       sizeof(size_t)))
+      return false;
+    p_extract->p_stack[p_extract->i_stack++] =
+      p_extract->p_pending[--p_extract->i_pending];
+  }
+  if (0 == p_extract->i_stack) {
+    cdio_warn("Directory %s reported out of order", psz_iso_dir);
+    return false;
+  }
+  p_extract->i_cur_dir = p_extract->p_stack[--p_extract->i_stack];
+  return true;
+}
+
+static bool
+_extract_symlink(const char *psz_target, const char *psz_path)
+{
+#ifdef HAVE_SYMLINK
+  if (0 == symlink(psz_target, psz_path)) return true;
+  if (EEXIST == errno && 0 == unlink(psz_path)
+      && 0 == symlink(psz_target, psz_path))
+    return true;
+  cdio_warn("Couldn't create symbolic link %s: %s", psz_path,
+            strerror(errno));
+  return false;
+#else
+  cdio_info("Symbolic link %s -> %s not created", psz_path, psz_target);
+  return true;
+#endif
+}
+
+static bool
+_extract_chmod(const char *psz_path, posix_mode_t st_mode)
+{
+#ifdef HAVE_CHMOD
+  if (0 != chmod(psz_path, st_mode & 07777)) {
+    cdio_warn("Couldn't set permissions of %s: %s", psz_path,
+              strerror(errno));
+    return false;
+  }
+#endif
+  return true;
+}
+
+/* iso9660_ifs_walk() visitor: create directories and symbolic links
+   and note down the files. */
+static int
+_extract_visit(const char psz_iso_dir[], const iso9660_stat_t *p_stat,
+               void *p_user_data)
+{
+  extract_t *p_extract = p_user_data;
+  const bool b_rr = p_extract->b_rock_ridge && yep == p_stat->rr.b3_rock;
+  char *psz_path;
+
+  if (!p_extract->psz_cur_iso_dir
+      || 0 != strcmp(psz_iso_dir, p_extract->psz_cur_iso_dir))
+    if (!_extract_enter_dir(p_extract, psz_iso_dir))
+      return -1;
+
+  if (0 == strcmp(p_stat->filename, ".")
+      || 0 == strcmp(p_stat->filename, ".."))
+    return 0;
+
+  /* Permissions and link targets are needed after all. The entry
+     belongs to the walk, which lets us fill in its fields. */
+  if (b_rr && p_stat->rr.b_deferred
+      && !iso9660_ifs_get_rock_ridge(p_extract->p_iso,
+                                     (iso9660_stat_t *) p_stat))
+    return -1;
+
+  psz_path = _extract_local_path(p_extract, p_stat);
+  if (!psz_path) return -1;
+
+  if (_STAT_DIR == p_stat->type) {
+    extract_dir_t *p_dir;
+
+    if (!_extract_mkdir(psz_path)) {
+      free(psz_path);
+      return -1;
+    }
+    if (!_extract_grow((void **) &p_extract->p_dir, &p_extract->i_dirs_alloc,
+                       p_extract->i_dirs, sizeof(extract_dir_t))
+        || !_extract_grow((void **) &p_extract->p_pending,
+                          &p_extract->i_pending_alloc, p_extract->i_pending,
+                          sizeof(size_t))) {
+      free(psz_path);
+      return -1;
+    }
+    p_dir = &p_extract->p_dir[p_extract->i_dirs];
+    p_dir->psz_path = psz_path;
+    p_dir->st_mode  = p_stat->rr.st_mode;
+    p_dir->b_mode   = b_rr;
+    p_extract->p_pending[p_extract->i_pending++] = p_extract->i_dirs++;
+    return 0;
+  }
+
+  if (b_rr && p_stat->rr.psz_symlink && S_ISLNK(p_stat->rr.st_mode)) {
+    bool b_ok = _extract_symlink(p_stat->rr.psz_symlink, psz_path);
+    free(psz_path);
+    return b_ok ? 0 : -1;
+  }
+
+  /* Devices, FIFOs and sockets can't be extracted as what they are,
+     and an empty file in their place would only mislead. */
+  if (b_rr && (S_ISCHR(p_stat->rr.st_mode) || S_ISBLK(p_stat->rr.st_mode)
+               || S_ISFIFO(p_stat->rr.st_mode)
+               || S_ISSOCK(p_stat->rr.st_mode))) {
+    cdio_warn("Skipping special file %s", psz_path);
+    free(psz_path);
+    return 0;
+  }
+
+  if (0 == p_stat->total_size) {
+    FILE *p_fd = _extract_create(psz_path);
+    bool b_ok = (NULL != p_fd);
+
+    if (b_ok && 0 != fclose(p_fd)) {
+      cdio_warn("Couldn't write %s: %s", psz_path, strerror(errno));
+      b_ok = false;
+    }
+    if (b_ok && b_rr)
+      b_ok = _extract_chmod(psz_path, p_stat->rr.st_mode);
+    free(psz_path);
+    return b_ok ? 0 : -1;
+  }
+
+  if (!_extract_grow((void **) &p_extract->p_file, &p_extract->i_files_alloc,
+                     p_extract->i_files, sizeof(extract_file_t))) {
+    free(psz_path);
+    return -1;
+  }
+  {
+    extract_file_t *p_file = &p_extract->p_file[p_extract->i_files++];
+
+    memset(p_file, 0, sizeof(extract_file_t));
+    p_file->psz_path = psz_path;
+    p_file->i_lsn    = p_stat->lsn;
+    p_file->i_size   = p_stat->total_size;
+    p_file->st_mode  = p_stat->rr.st_mode;
+    p_file->b_mode   = b_rr;
+  }
+  return 0;
+}
+
+static int
+_extract_file_cmp(const void *p1, const void *p2)
+{
+  const extract_file_t *p_file1 = p1;
+  const extract_file_t *p_file2 = p2;
+
+  if (p_file1->i_lsn != p_file2->i_lsn)
+    return (p_file1->i_lsn < p_file2->i_lsn) ? -1 : 1;
+  return 0;
+}
+
+/* Write out the parts of all files that lie in p_chunk. Files are
+   sorted by LSN and chunks come front to back, so each file is
+   written sequentially. */
+static bool
+_extract_write_chunk(extract_t *p_extract, const extract_chunk_t *p_chunk)
+{
+  const uint64_t i_chunk_start = (uint64_t) p_chunk->i_lsn * ISO_BLOCKSIZE;
+  const uint64_t i_chunk_end   =
+    i_chunk_start + (uint64_t) p_chunk->i_blocks * ISO_BLOCKSIZE;
+  size_t i;
+
+  for (i = p_extract->i_first; i < p_extract->i_files; i++) {
+    extract_file_t *p_file = &p_extract->p_file[i];
+    const uint64_t i_file_start = (uint64_t) p_file->i_lsn * ISO_BLOCKSIZE;
+    uint64_t i_start = i_file_start + p_file->i_written;
+    uint64_t i_end   = i_file_start + p_file->i_size;
+
+    if (i_file_start >= i_chunk_end) break;
+    if (p_file->b_done) continue;
+
+    if (i_start < i_chunk_start) {
+      cdio_warn("Data of %s was skipped", p_file->psz_path);
+      return false;
+    }
+    if (i_end > i_chunk_end) i_end = i_chunk_end;
+
+    if (!p_file->p_fd) {
+      p_file->p_fd = _extract_create(p_file->psz_path);
+      if (!p_file->p_fd) return false;
+    }
+    if (1 != fwrite(p_chunk->p_buf + (i_start - i_chunk_start),
+                    (size_t) (i_end - i_start), 1, p_file->p_fd)) {
+      cdio_warn("Couldn't write %s: %s", p_file->psz_path, strerror(errno));
+      return false;
+    }
+    p_file->i_written += i_end - i_start;
+
+    if (p_file->i_written == p_file->i_size) {
+      FILE *p_fd = p_file->p_fd;
+
+      p_file->p_fd   = NULL;
+      p_file->b_done = true;
+      if (0 != fclose(p_fd)) {
+        cdio_warn("Couldn't write %s: %s", p_file->psz_path,
+                  strerror(errno));
+        return false;
+      }
+      if (p_file->b_mode && !_extract_chmod(p_file->psz_path,
+                                            p_file->st_mode))
+        return false;
+    }
+  }
+
+  while (p_extract->i_first < p_extract->i_files
+         && p_extract->p_file[p_extract->i_first].b_done)
+    p_extract->i_first++;
+  return true;
+}
+
+#ifdef HAVE_PTHREAD
+/* Writer thread: write out chunks in the order they were read. */
+static void *
+_extract_writer(void *p_arg)
+{
+  extract_t *p_extract = p_arg;
+
+  pthread_mutex_lock(&p_extract->lock);
+  for (;;) {
+    extract_chunk_t *p_chunk;
+    bool b_ok;
+
+    while (p_extract->i_write_seq == p_extract->i_read_seq
+           && !p_extract->b_eof && !p_extract->b_failed)
+      pthread_cond_wait(&p_extract->cond, &p_extract->lock);
+    if (p_extract->b_failed
+        || p_extract->i_write_seq == p_extract->i_read_seq)
+      break;
+
+    p_chunk = &p_extract->chunk[p_extract->i_write_seq % EXTRACT_BUFFERS];
+    pthread_mutex_unlock(&p_extract->lock);
+
+    b_ok = _extract_write_chunk(p_extract, p_chunk);
+
+    pthread_mutex_lock(&p_extract->lock);
+    if (!b_ok) p_extract->b_failed = true;
+    p_extract->i_write_seq++;
+    pthread_cond_broadcast(&p_extract->cond);
+  }
+  pthread_mutex_unlock(&p_extract->lock);
+  return NULL;
+}
+#endif
+
+/* Read the blocks of all files front to back, merging extents that
+   are at most i_max_gap_blocks apart, and hand them to the writer. */
+static bool
+_extract_read_all(extract_t *p_extract)
+{
+  const size_t i_buf_size = (size_t) p_extract->i_max_read_blocks
+    * ISO_BLOCKSIZE;
+  bool b_threaded = false;
+  bool b_ok = true;
+  size_t i = 0;
+  unsigned int j;
+#ifdef HAVE_PTHREAD
+  pthread_t writer;
+#endif
+
+  for (j = 0; j < EXTRACT_BUFFERS; j++) {
+    p_extract->chunk[j].p_buf = malloc(i_buf_size);
+    if (!p_extract->chunk[j].p_buf) {
+      cdio_warn("Couldn't malloc(%lu)", (unsigned long) i_buf_size);
+      return false;
+    }
+  }
+
+#ifdef HAVE_PTHREAD
+  b_threaded = (0 == pthread_create(&writer, NULL, _extract_writer,
+                                    p_extract));
+#endif
+
+  while (b_ok && i < p_extract->i_files) {
+    lsn_t i_lsn = p_extract->p_file[i].i_lsn;
+    lsn_t i_end = i_lsn + CDIO_EXTENT_BLOCKS(p_extract->p_file[i].i_size);
+
+    for (i++; i < p_extract->i_files
+           && p_extract->p_file[i].i_lsn
+              <= i_end + p_extract->i_max_gap_blocks; i++) {
+      lsn_t i_file_end = p_extract->p_file[i].i_lsn
+        + CDIO_EXTENT_BLOCKS(p_extract->p_file[i].i_size);
+      if (i_file_end > i_end) i_end = i_file_end;
+    }
+
+    while (b_ok && i_lsn < i_end) {
+      extract_chunk_t *p_chunk;
+      uint32_t i_blocks = i_end - i_lsn;
+      long int i_read;
+
+      if (i_blocks > p_extract->i_max_read_blocks)
+        i_blocks = p_extract->i_max_read_blocks;
+
+#ifdef HAVE_PTHREAD
+      if (b_threaded) {
+        pthread_mutex_lock(&p_extract->lock);
+        while (p_extract->i_read_seq - p_extract->i_write_seq
+               == EXTRACT_BUFFERS && !p_extract->b_failed)
+          pthread_cond_wait(&p_extract->cond, &p_extract->lock);
+        b_ok = !p_extract->b_failed;
+        pthread_mutex_unlock(&p_extract->lock);
+        if (!b_ok) break;
+      }
+#endif
+      p_chunk = &p_extract->chunk[p_extract->i_read_seq % EXTRACT_BUFFERS];
+      p_chunk->i_lsn    = i_lsn;
+      p_chunk->i_blocks = i_blocks;
+
+      i_read = iso9660_iso_seek_read(p_extract->p_iso, p_chunk->p_buf,
+                                     i_lsn, i_blocks);
+      if (i_read != (long int) i_blocks * ISO_BLOCKSIZE) {
+        cdio_warn("Error reading ISO 9660 image at LSN %lu",
+                  (long unsigned int) i_lsn);
+        b_ok = false;
+      }
+
+#ifdef HAVE_PTHREAD
+      if (b_threaded) {
+        pthread_mutex_lock(&p_extract->lock);
+        if (b_ok)
+          p_extract->i_read_seq++;
+        else
+          p_extract->b_failed = true;
+        pthread_cond_broadcast(&p_extract->cond);
+        pthread_mutex_unlock(&p_extract->lock);
+      } else
+#endif
+      if (b_ok) {
+        b_ok = _extract_write_chunk(p_extract, p_chunk);
+        p_extract->i_read_seq++;
+        p_extract->i_write_seq++;
+      }
+      i_lsn += i_blocks;
+    }
+  }
+
+#ifdef HAVE_PTHREAD
+  if (b_threaded) {
+    pthread_mutex_lock(&p_extract->lock);
+    p_extract->b_eof = true;
+    pthread_cond_broadcast(&p_extract->cond);
+    pthread_mutex_unlock(&p_extract->lock);
+    pthread_join(writer, NULL);
+    if (p_extract->b_failed) b_ok = false;
+  }
+#endif
+
+  return b_ok;
+}
+
+/*!
+  Extract all files and directories below psz_src_dir of p_iso into
+  the local directory psz_dst_dir. See iso9660.h for details.
+*/
+int
+iso9660_ifs_extract_tree (iso9660_t *p_iso, const char psz_src_dir[],
+                          const char psz_dst_dir[],
+                          const iso9660_extract_opts_t *p_opts)
+{
+  static const iso9660_extract_opts_t default_opts;
+  extract_t extract;
+  size_t i;
+  int i_rc = -1;
+
+  if (!p_iso || !psz_src_dir || !psz_dst_dir) return -1;
+  if (!p_opts) p_opts = &default_opts;
+
+  memset(&extract, 0, sizeof(extract));
+  extract.p_iso             = p_iso;
+  extract.psz_dst_dir       = psz_dst_dir;
+  extract.u_joliet_level    = iso9660_ifs_get_joliet_level(p_iso);
+  extract.b_rock_ridge      = !p_opts->b_no_rock_ridge;
+  extract.i_max_read_blocks = p_opts->i_max_read_blocks
+    ? p_opts->i_max_read_blocks : EXTRACT_DEFAULT_READ_BLOCKS;
+  extract.i_max_gap_blocks  = p_opts->i_max_gap_blocks;
+  extract.i_cur_dir         = (size_t) -1;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&extract.lock, NULL);
+  pthread_cond_init(&extract.cond, NULL);
+#endif
+
+  /* The destination itself is the caller's, and may be a link. */
+  if (0 != mkdir(psz_dst_dir, 0700) && EEXIST != errno) {
+    cdio_warn("Couldn't create directory %s: %s", psz_dst_dir,
+              strerror(errno));
+    goto out;
+  }
+
+  if (0 != iso9660_ifs_walk(p_iso, psz_src_dir, _extract_visit, &extract,
+                            p_opts->i_threads, ISO9660_WALK_ORDERED))
+    goto out;
+
+  qsort(extract.p_file, extract.i_files, sizeof(extract_file_t),
+        _extract_file_cmp);
+  if (!_extract_read_all(&extract))
+    goto out;
+
+  /* Directory permissions go last, as they may forbid writing, and
+     subdirectories before their parents. */
+  for (i = extract.i_dirs; i > 0; i--)
+    if (extract.p_dir[i-1].b_mode
+        && !_extract_chmod(extract.p_dir[i-1].psz_path,
+                           extract.p_dir[i-1].st_mode))
+      goto out;
+
+  i_rc = 0;
+
+ out:
+  for (i = 0; i < extract.i_files; i++) {
+    if (extract.p_file[i].p_fd) fclose(extract.p_file[i].p_fd);
+    free(extract.p_file[i].psz_path);
+  }
+  for (i = 0; i < extract.i_dirs; i++)
+    free(extract.p_dir[i].psz_path);
+  for (i = 0; i < EXTRACT_BUFFERS; i++)
+    free(extract.chunk[i].p_buf);
+  free(extract.p_file);
+  free(extract.p_dir);
+  free(extract.p_pending);
+  free(extract.p_stack);
+  free(extract.psz_cur_iso_dir);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_destroy(&extract.lock);
+  pthread_cond_destroy(&extract.cond);
+#endif
+  return i_rc;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -44,6 +44,12 @@
 #include <errno.h>
 #endif
 
+#ifdef HAVE_LIMITS_H
+#include <limits.h>
+#endif
+
+#include <ctype.h>
+
 #ifdef HAVE_LANGINFO_CODESET
 #include <langinfo.h>
 #endif
@@ -57,7 +63,9 @@
 /* Private headers */
 #include "cdio_assert.h"
 #include "_cdio_stdio.h"
+#include "_cdio_workpool.h"
 #include "cdio_private.h"
+#include "iso9660_private.h"
 
 /** Implementation of iso9660_t type */
 struct _iso9660_s {
@@ -546,71 +554,167 @@ iso9660_ifs_read_superblock (iso9660_t *p_iso,
   return true;
 }
 
+/* Largest single read made while scanning for the fuzzy PVD. */
+#define FUZZY_READ_MAX (8 * 1024 * 1024)
+
+/* A place where ISO_STANDARD_ID was seen, and how early the search
+   order of the per-frame scan would have reached it. */
+typedef struct
+{
+  unsigned int i_rank;  /**< 3 * distance in search order + frame size
+                             index */
+  off_t        i_pos;   /**< byte offset of ISO_STANDARD_ID in the image */
+} fuzzy_candidate_t;
+
+static int
+fuzzy_candidate_cmp(const void *p1, const void *p2)
+{
+  const fuzzy_candidate_t *c1 = p1;
+  const fuzzy_candidate_t *c2 = p2;
+
+  if (c1->i_rank != c2->i_rank)
+    return c1->i_rank < c2->i_rank ? -1 : 1;
+  if (c1->i_pos != c2->i_pos)
+    return c1->i_pos < c2->i_pos ? -1 : 1;
+  return 0;
+}
+
 /*!
   Read the Super block of an ISO 9660 image but determine framesize
   and datastart and a possible additional offset. Generally here we are
   not reading an ISO 9660 image but a CD-Image which contains an ISO 9660
   filesystem.
+
+  The bytes that any frame size could place within i_fuzz sectors of
+  ISO_PVD_SECTOR are read in one pass and scanned once for
+  ISO_STANDARD_ID. Each hit is then ranked the way a sector-by-sector
+  search would have met it: nearest sector first, the sector after
+  ISO_PVD_SECTOR before the one before it, and ISO_BLOCKSIZE,
+  CDIO_CD_FRAMESIZE_RAW, M2RAW_SECTOR_SIZE frames in that order. Only
+  the first hit within a given frame is tried.
 */
 bool
 iso9660_ifs_fuzzy_read_superblock (iso9660_t *p_iso,
 				   iso_extension_mask_t iso_extension_mask,
 				   uint16_t i_fuzz)
 {
-  /* Got some work to do to find ISO_STANDARD_ID ("CD001") */
-  unsigned int i;
-
-  for (i=0; i<i_fuzz; i++) {
-    unsigned int j;
-    char *pvd = NULL;
+  const uint16_t framesizes[] = { ISO_BLOCKSIZE, CDIO_CD_FRAMESIZE_RAW,
+				  M2RAW_SECTOR_SIZE } ;
+  const size_t i_id_len = sizeof(ISO_STANDARD_ID) - 1;
+  fuzzy_candidate_t *p_cand = NULL;
+  size_t i_cands = 0, i_alloc = 0, i;
+  lsn_t lsn_lo, lsn_hi;
+  off_t i_start, i_end;
+  size_t i_chunk;
+  char *p_buf;
+  bool b_found = false;
+
+  if (0 == i_fuzz) return false;
+
+  lsn_lo = (i_fuzz > ISO_PVD_SECTOR) ? 0 : ISO_PVD_SECTOR - i_fuzz + 1;
+  lsn_hi = ISO_PVD_SECTOR + i_fuzz - 1;
+
+  /* ISO_BLOCKSIZE frames start lowest, CDIO_CD_FRAMESIZE_RAW frames
+     end highest. */
+  i_start = (off_t) lsn_lo * ISO_BLOCKSIZE;
+  i_end   = (off_t) (lsn_hi + 1) * CDIO_CD_FRAMESIZE_RAW + CDIO_CD_SYNC_SIZE;
+
+  i_chunk = (i_end - i_start > FUZZY_READ_MAX)
+    ? FUZZY_READ_MAX : (size_t) (i_end - i_start);
+  p_buf = malloc(i_chunk);
+  if (!p_buf) {
+    cdio_warn("Couldn't malloc(%lu)", (unsigned long) i_chunk);
+    return false;
+  }
 
-    for (j = 0; j <= 1; j++ ) {
-      lsn_t lsn;
-      uint16_t k;
-      const uint16_t framesizes[] = { ISO_BLOCKSIZE, CDIO_CD_FRAMESIZE_RAW,
-				      M2RAW_SECTOR_SIZE } ;
+  /* Collect every occurrence of ISO_STANDARD_ID up to the end of the
+     window or of the image. Consecutive reads overlap by less than the
+     ID, so each is seen exactly once. */
+  while (i_start < i_end) {
+    size_t i_want = (i_end - i_start > (off_t) i_chunk)
+      ? i_chunk : (size_t) (i_end - i_start);
+    ssize_t i_got = cdio_stream_pread(p_iso->stream, p_buf, 1, i_want,
+                                      i_start);
+    const char *p = p_buf;
+    const char *p_last;
+
+    if (i_got < (ssize_t) i_id_len) break;
+    p_last = p_buf + i_got - i_id_len;
+
+    while (p <= p_last
+           && (p = memchr(p, ISO_STANDARD_ID[0], p_last - p + 1))) {
+      if (0 == memcmp(p, ISO_STANDARD_ID, i_id_len)) {
+        off_t i_pos = i_start + (p - p_buf);
+        unsigned int k;
+
+        for (k = 0; k < 3; k++) {
+          const unsigned int i_datastart =
+            (ISO_BLOCKSIZE == framesizes[k]) ? 0 : CDIO_CD_SYNC_SIZE;
+          lsn_t lsn;
+          unsigned int i_dist;
+
+          if (i_pos < i_datastart) continue;
+          lsn = (i_pos - i_datastart) / framesizes[k];
+          if (lsn < lsn_lo || lsn > lsn_hi) continue;
+          i_dist = (lsn > ISO_PVD_SECTOR)
+            ? 2 * (lsn - ISO_PVD_SECTOR) - 1 : 2 * (ISO_PVD_SECTOR - lsn);
+
+          if (i_cands == i_alloc) {
+            size_t i_new = i_alloc ? 2 * i_alloc : 16;
+            fuzzy_candidate_t *p_new =
+              realloc(p_cand, i_new * sizeof(fuzzy_candidate_t));
+            if (!p_new) {
+              cdio_warn("Couldn't realloc(%lu)",
+                        (unsigned long) (i_new * sizeof(fuzzy_candidate_t)));
+              goto done;
+            }
+            p_cand  = p_new;
+            i_alloc = i_new;
+          }
+          p_cand[i_cands].i_rank = 3 * i_dist + k;
+          p_cand[i_cands].i_pos  = i_pos;
+          i_cands++;
+        }
+      }
+      p++;
+    }
 
-      /* We don't need to loop over a zero offset twice*/
-      if (0==i && j)
-	continue;
+    if ((size_t) i_got < i_want) break;
+    i_start += i_got - (i_id_len - 1);
+    if (i_end - i_start < (off_t) i_id_len) break;
+  }
 
-      lsn = (j) ? ISO_PVD_SECTOR - i : ISO_PVD_SECTOR + i;
-
-      for (k=0; k < 3; k++) {
-	char *p, *q;
-	char frame[CDIO_CD_FRAMESIZE_RAW] = {'\0',};
-	p_iso->i_framesize = framesizes[k];
-	p_iso->i_datastart = (ISO_BLOCKSIZE == framesizes[k]) ?
-			      0 : CDIO_CD_SYNC_SIZE;
-	p_iso->i_fuzzy_offset = 0;
-	if (0 == iso9660_seek_read_framesize (p_iso, frame, lsn, 1,
-					      p_iso->i_framesize)) {
-	  return false;
-	}
+  if (i_cands > 1)
+    qsort(p_cand, i_cands, sizeof(fuzzy_candidate_t), fuzzy_candidate_cmp);
 
-	q = memchr(frame, 'C', p_iso->i_framesize);
-	for ( p=q; p && p < frame + p_iso->i_framesize ; p=q+1 ) {
-	  q = memchr(p, 'C', p_iso->i_framesize - (p - frame));
-	  if ( !q || (pvd = strstr(q, ISO_STANDARD_ID)) )
-	    break;
-	}
+  for (i = 0; i < i_cands; i++) {
+    const unsigned int k = p_cand[i].i_rank % 3;
 
-	if (pvd) {
-	  /* Yay! Found something */
-	  p_iso->i_fuzzy_offset = (pvd - frame - 1) -
-	    ((ISO_PVD_SECTOR-lsn)*p_iso->i_framesize) ;
-	  /* But is it *really* a PVD? */
-	  if ( iso9660_ifs_read_pvd_loglevel(p_iso, &(p_iso->pvd),
-					     CDIO_LOG_DEBUG) ) {
-	    adjust_fuzzy_pvd(p_iso);
-	    return true;
-	  }
+    /* Same frame as the previous candidate: a per-frame scan stops at
+       the first hit. */
+    if (i > 0 && p_cand[i].i_rank == p_cand[i-1].i_rank)
+      continue;
 
-	}
-      }
+    p_iso->i_framesize = framesizes[k];
+    p_iso->i_datastart = (ISO_BLOCKSIZE == framesizes[k]) ?
+			  0 : CDIO_CD_SYNC_SIZE;
+    /* ISO_STANDARD_ID follows the one-byte descriptor type. */
+    p_iso->i_fuzzy_offset = p_cand[i].i_pos - 1 - p_iso->i_datastart
+      - (off_t) ISO_PVD_SECTOR * p_iso->i_framesize;
+
+    /* But is it *really* a PVD? */
+    if ( iso9660_ifs_read_pvd_loglevel(p_iso, &(p_iso->pvd),
+				       CDIO_LOG_DEBUG) ) {
+      adjust_fuzzy_pvd(p_iso);
+      b_found = true;
+      break;
     }
   }
-  return false;
+
+ done:
+  free(p_cand);
+  free(p_buf);
+  return b_found;
 }
 
 
@@ -716,16 +820,16 @@ iso9660_seek_read_framesize (const iso9660_t *p_iso, void *ptr,
 			     lsn_t start, long int size,
 			     uint16_t i_framesize)
 {
-  long int ret;
   int64_t i_byte_offset;
 
   if (!p_iso) return 0;
   i_byte_offset = (start * (int64_t)(p_iso->i_framesize))
     + p_iso->i_fuzzy_offset + p_iso->i_datastart;
 
-  ret = cdio_stream_seek (p_iso->stream, i_byte_offset, SEEK_SET);
-  if (ret!=0) return 0;
-  return cdio_stream_read (p_iso->stream, ptr, i_framesize, size);
+  /* Positionless, so that several threads can read from p_iso at once,
+     e.g. in iso9660_ifs_walk(). */
+  return cdio_stream_pread (p_iso->stream, ptr, i_framesize, size,
+			    i_byte_offset);
 }
 
 /*!
@@ -735,9 +839,90 @@ long int
 iso9660_iso_seek_read (const iso9660_t *p_iso, void *ptr, lsn_t start,
 		       long int size)
 {
+  if (p_iso && size > 1 && p_iso->i_framesize != ISO_BLOCKSIZE) {
+    /* With raw frames the user data of consecutive blocks is not
+       contiguous in the image, so read them one by one. */
+    long int i, ret = 0;
+
+    for (i = 0; i < size; i++) {
+      long int i_read =
+	iso9660_seek_read_framesize(p_iso, (uint8_t *) ptr + i * ISO_BLOCKSIZE,
+				    start + i, 1, ISO_BLOCKSIZE);
+      ret += i_read;
+      if (i_read != ISO_BLOCKSIZE) break;
+    }
+    return ret;
+  }
   return iso9660_seek_read_framesize(p_iso, ptr, start, size, ISO_BLOCKSIZE);
 }
 
+/*!
+  Read i_len bytes at byte i_offset of the file p_stat. Multi-extent
+  files are contiguous from p_stat->lsn (see _iso9660_dir_to_statbuf),
+  so a byte range maps onto one run of blocks: the whole blocks are
+  read directly into p_buf and only a partial first and last block are
+  bounced.
+*/
+ssize_t
+iso9660_ifs_file_pread (const iso9660_t *p_iso, const iso9660_stat_t *p_stat,
+			void *p_buf, size_t i_len, uint64_t i_offset)
+{
+  uint8_t *p_out = p_buf;
+  uint8_t *p_end;
+  uint8_t bounce[ISO_BLOCKSIZE];
+  lsn_t i_lsn;
+  size_t i_head, i_blocks;
+
+  if (!p_iso || !p_stat || (!p_buf && i_len)) return -1;
+  if (0 == i_len || i_offset >= p_stat->total_size) return 0;
+
+  if (i_len > p_stat->total_size - i_offset)
+    i_len = (size_t) (p_stat->total_size - i_offset);
+  if (i_len > (size_t) (((size_t) -1) >> 1))
+    i_len = ((size_t) -1) >> 1; /* keep the count representable */
+  p_end = p_out + i_len;
+
+  i_lsn  = p_stat->lsn + (lsn_t) (i_offset / ISO_BLOCKSIZE);
+  i_head = (size_t) (i_offset % ISO_BLOCKSIZE);
+
+  /* Partial first block, or a range within a single block. */
+  if (i_head || i_len < ISO_BLOCKSIZE) {
+    size_t i_part = ISO_BLOCKSIZE - i_head;
+
+    if (i_part > i_len) i_part = i_len;
+    if (ISO_BLOCKSIZE != iso9660_iso_seek_read(p_iso, bounce, i_lsn, 1))
+      return -1;
+    memcpy(p_out, bounce + i_head, i_part);
+    p_out += i_part;
+    i_lsn++;
+  }
+
+  /* Whole blocks, straight into the caller's buffer. */
+  i_blocks = (size_t) (p_end - p_out) / ISO_BLOCKSIZE;
+  while (i_blocks > 0) {
+    long int i_chunk = (i_blocks > LONG_MAX / ISO_BLOCKSIZE)
+      ? LONG_MAX / ISO_BLOCKSIZE : (long int) i_blocks;
+
+    if (i_chunk * ISO_BLOCKSIZE
+	!= iso9660_iso_seek_read(p_iso, p_out, i_lsn, i_chunk))
+      return -1;
+    p_out    += (size_t) i_chunk * ISO_BLOCKSIZE;
+    i_lsn    += i_chunk;
+    i_blocks -= i_chunk;
+  }
+
+  /* Partial last block. */
+  if (p_out < p_end) {
+    size_t i_tail = (size_t) (p_end - p_out);
+
+    if (ISO_BLOCKSIZE != iso9660_iso_seek_read(p_iso, bounce, i_lsn, 1))
+      return -1;
+    memcpy(p_out, bounce, i_tail);
+  }
+
+  return (ssize_t) i_len;
+}
+
 
 
 /*!
@@ -793,12 +978,82 @@ _iso9660_is_rock_ridge_enabled(void* p_image)
   return true;
 }
 
+/* Are Rock Ridge attributes other than names to be decoded only when
+   asked for? See iso9660_ifs_set_rock_ridge_lazy(). */
+static bool
+_iso9660_is_rock_ridge_lazy(void* p_image)
+{
+  cdio_header_t* p_header = (cdio_header_t*)p_image;
+
+  return p_header && p_header->u_type == CDIO_HEADER_TYPE_ISO
+    && (p_header->u_flags & CDIO_HEADER_FLAGS_LAZY_RR);
+}
+
+/* Note where the directory record of p_stat is, at byte offset of the
+   directory starting at i_lsn, for decoding deferred Rock Ridge
+   fields later on. */
+static void
+_iso9660_stat_set_dir_record(iso9660_stat_t *p_stat, lsn_t i_lsn,
+			     unsigned int offset)
+{
+  if (p_stat->rr.b_deferred) {
+    p_stat->rr.i_dir_lsn    = i_lsn + offset / ISO_BLOCKSIZE;
+    p_stat->rr.i_dir_offset = offset % ISO_BLOCKSIZE;
+  }
+}
+
+/* Allocate a zeroed iso9660_stat_t of i_len bytes, from p_arena if
+   that is not NULL. */
+static iso9660_stat_t *
+_iso9660_stat_alloc (iso9660_arena_t *p_arena, size_t i_len)
+{
+  iso9660_stat_t *p_stat;
+
+  if (!p_arena)
+    return calloc(1, i_len);
+
+  p_stat = _iso9660_arena_calloc(p_arena, i_len);
+  if (p_stat) {
+    p_stat->p_arena = p_arena;
+    _iso9660_arena_retain(p_arena);
+  }
+  return p_stat;
+}
+
+/* Return an individually allocated deep copy of p_stat, which
+   outlives the arena p_stat may have come from. */
+static iso9660_stat_t *
+_iso9660_stat_dup (const iso9660_stat_t *p_stat)
+{
+  const size_t len = sizeof(iso9660_stat_t) + strlen(p_stat->filename) + 1;
+  iso9660_stat_t *p_copy = calloc(1, len);
+
+  if (!p_copy) {
+    cdio_warn("Couldn't calloc(1, %lu)", (unsigned long) len);
+    return NULL;
+  }
+  memcpy(p_copy, p_stat, len);
+  p_copy->p_arena = NULL;
+  p_copy->rr.psz_symlink = NULL;
+  if (p_stat->rr.psz_symlink) {
+    p_copy->rr.psz_symlink = calloc(1, p_stat->rr.i_symlink_max);
+    if (!p_copy->rr.psz_symlink) {
+      free(p_copy);
+      return NULL;
+    }
+    memcpy(p_copy->rr.psz_symlink, p_stat->rr.psz_symlink,
+	   p_stat->rr.i_symlink_max);
+  }
+  return p_copy;
+}
+
 static iso9660_stat_t *
 _iso9660_dir_to_statbuf (iso9660_dir_t *p_iso9660_dir,
 			 iso9660_stat_t *last_p_stat,
 			 void* p_image,
 			 bool_3way_t b_xa,
-			 uint8_t u_joliet_level)
+			 uint8_t u_joliet_level,
+			 iso9660_arena_t *p_arena)
 {
   uint8_t dir_len= iso9660_get_dir_len(p_iso9660_dir);
   iso711_t i_fname;
@@ -815,10 +1070,17 @@ _iso9660_dir_to_statbuf (iso9660_dir_t *p_iso9660_dir,
 
   /* .. string in statbuf is one longer than in p_iso9660_dir's listing '\1' */
   stat_len = sizeof(iso9660_stat_t) + i_fname + 2;
+#ifdef HAVE_JOLIET
+  /* Joliet names are decoded straight into the filename, which still
+     needs room for "..". */
+  if (u_joliet_level
+      && CDIO_UTF16BE_TO_UTF8_SIZE(i_fname) + 1 > i_fname + 2)
+    stat_len = sizeof(iso9660_stat_t) + CDIO_UTF16BE_TO_UTF8_SIZE(i_fname) + 1;
+#endif
 
   /* Reuse multiextent p_stat if not NULL */
   if (!p_stat) {
-    p_stat = calloc(1, stat_len);
+    p_stat = _iso9660_stat_alloc(p_arena, stat_len);
     first_extent = true;
   } else {
     /* Ignore Rock Ridge Deep Directory RE entries */
@@ -875,20 +1137,26 @@ _iso9660_dir_to_statbuf (iso9660_dir_t *p_iso9660_dir,
     }
 
 #ifdef HAVE_ROCK
-    i_rr_fname = get_rock_ridge_filename(p_iso9660_dir, p_image, rr_fname, p_stat);
+    i_rr_fname = _iso9660_rr_parse(p_iso9660_dir, p_image, rr_fname, p_stat,
+				   _iso9660_is_rock_ridge_lazy(p_image)
+				   ? ISO_RR_PARSE_NAME : ISO_RR_PARSE_ALL);
 #endif
 
     if (i_rr_fname > 0) {
-      if (i_rr_fname > i_fname) {
+      /* A Joliet filename may have left room enough already. */
+      if (sizeof(iso9660_stat_t) + i_rr_fname + 1 > stat_len) {
 	/* realloc gives valgrind errors */
 	iso9660_stat_t *p_stat_new =
-	  calloc(1, sizeof(iso9660_stat_t)+i_rr_fname+2);
+	  _iso9660_stat_alloc(p_stat->p_arena,
+			      sizeof(iso9660_stat_t)+i_rr_fname+2);
 	if (!p_stat_new) {
 	  cdio_warn("Couldn't calloc(1, %d)", (int)(sizeof(iso9660_stat_t)+i_rr_fname+2));
 	  goto fail;
 	}
 	memcpy(p_stat_new, p_stat, stat_len);
-	free(p_stat);
+	/* The symlink now belongs to p_stat_new */
+	p_stat->rr.psz_symlink = NULL;
+	iso9660_stat_free(p_stat);
 	p_stat = p_stat_new;
       }
       strncpy(p_stat->filename, rr_fname, i_rr_fname+1);
@@ -899,15 +1167,8 @@ _iso9660_dir_to_statbuf (iso9660_dir_t *p_iso9660_dir,
 	strncpy (p_stat->filename, "..", strlen("..")+1);
 #ifdef HAVE_JOLIET
       else if (u_joliet_level) {
-	int i_inlen = i_fname;
-	cdio_utf8_t *p_psz_out = NULL;
-	if (cdio_charset_to_utf8(&p_iso9660_dir->filename.str[1], i_inlen,
-                             &p_psz_out, "UCS-2BE")) {
-          strncpy(p_stat->filename, p_psz_out, i_fname);
-          free(p_psz_out);
-        } else {
-          goto fail;
-        }
+	cdio_utf16be_to_utf8((const uint8_t *) &p_iso9660_dir->filename.str[1],
+			     i_fname, p_stat->filename);
       }
 #endif /*HAVE_JOLIET*/
       else {
@@ -1043,7 +1304,7 @@ _fs_stat_root (CdIo_t *p_cdio)
 #endif
 
     p_stat = _iso9660_dir_to_statbuf (p_iso9660_dir, NULL, p_cdio,
-				      b_xa, p_env->u_joliet_level);
+				      b_xa, p_env->u_joliet_level, NULL);
     return p_stat;
   }
 
@@ -1065,10 +1326,132 @@ _ifs_stat_root (iso9660_t *p_iso)
 
   p_stat = _iso9660_dir_to_statbuf (p_iso9660_dir, NULL,
 				    p_iso, p_iso->b_xa,
-				    p_iso->u_joliet_level);
+				    p_iso->u_joliet_level, NULL);
+
+  /* The record in the volume descriptor has no system use area. The
+     root's Rock Ridge fields are in the "." entry its extent starts
+     with, which iso9660_ifs_get_rock_ridge() can read later. */
+  if (p_stat && _iso9660_is_rock_ridge_enabled(p_iso)
+      && _iso9660_is_rock_ridge_lazy(p_iso)) {
+    p_stat->rr.b_deferred = true;
+    _iso9660_stat_set_dir_record(p_stat, p_stat->lsn, 0);
+  }
   return p_stat;
 }
 
+/* Is psz_want the i_len bytes of psz_name, either as they are or, if
+   b_translate, as iso9660_name_translate_ext() would turn them for a
+   non-Joliet image? Compared in place, without a translated copy. */
+static bool
+_iso9660_name_equal (const char *psz_want, const char *psz_name,
+		     size_t i_len, bool b_translate)
+{
+  size_t i;
+
+  if (0 == strncmp(psz_want, psz_name, i_len) && '\0' == psz_want[i_len])
+    return true;
+  if (!b_translate || 0 == i_len)
+    return false;
+
+  /* Drop a trailing ".;1" or ";1" */
+  if (i_len >= 3 && 0 == memcmp(psz_name + i_len - 3, ".;1", 3))
+    i_len -= 3;
+  else if (i_len >= 2 && 0 == memcmp(psz_name + i_len - 2, ";1", 2))
+    i_len -= 2;
+
+  for (i = 0; i < i_len; i++) {
+    unsigned char c = psz_name[i];
+
+    if (isupper(c)) c = tolower(c);
+    if (c == ';') c = '.';
+    if ((unsigned char) psz_want[i] != c)
+      return false;
+  }
+  return '\0' == psz_want[i_len];
+}
+
+/* Could the directory record p_iso9660_dir be named psz_want? This
+   looks at the raw record only, applying the same naming rules as
+   _iso9660_dir_to_statbuf(): a Rock Ridge NM name if there is one,
+   else the Joliet or plain ISO 9660 name. false means the record
+   certainly has another name; true means it has to be looked at in
+   full. Multi-extent parts are not handled here. */
+static bool
+_iso9660_dir_may_match (const iso9660_dir_t *p_iso9660_dir, void *p_image,
+			uint8_t u_joliet_level, const char *psz_want)
+{
+  const iso711_t i_fname = from_711(p_iso9660_dir->filename.len);
+  const char *psz_name = &p_iso9660_dir->filename.str[1];
+  size_t i_name;
+
+#ifdef HAVE_ROCK
+  if (_iso9660_is_rock_ridge_enabled(p_image)) {
+    /* Gather the NM name from the system use area, as
+       get_rock_ridge_filename() does. Anything unusual is left to it. */
+    char rr_fname[256];
+    size_t i_rr_fname = 0;
+    int len = sizeof(iso9660_dir_t) + i_fname;
+    const uint8_t *chr;
+
+    if (len & 1) len++;
+    chr = (const uint8_t *) p_iso9660_dir + len;
+    len = iso9660_get_dir_len(p_iso9660_dir) - len;
+
+    while (len > 1) {
+      const iso_extension_record_t *rr = (const void *) chr;
+
+      if (rr->len == 0) {
+	i_rr_fname = 0; /* the whole Rock Ridge entry is ignored */
+	break;
+      }
+      if (rr->len > len)
+	return true;
+      if ('S' == rr->signature[0] && 'P' == rr->signature[1]) {
+	if (rr->u.SP.magic[0] != 0xbe || rr->u.SP.magic[1] != 0xef) {
+	  i_rr_fname = 0;
+	  break;
+	}
+      } else if ('N' == rr->signature[0] && 'M' == rr->signature[1]) {
+	size_t i_part;
+
+	if (rr->len < 5 || (rr->u.NM.flags & ~ISO_ROCK_NM_CONTINUE))
+	  return true;
+	i_part = rr->len - 5;
+	if (i_rr_fname + i_part >= 254
+	    || memchr(rr->u.NM.name, '\0', i_part))
+	  return true;
+	memcpy(rr_fname + i_rr_fname, rr->u.NM.name, i_part);
+	i_rr_fname += i_part;
+      }
+      chr += rr->len;
+      len -= rr->len;
+    }
+
+    if (i_rr_fname > 0)
+      return _iso9660_name_equal(psz_want, rr_fname, i_rr_fname,
+				 0 == u_joliet_level);
+  }
+#endif
+
+  if (1 == i_fname && '\0' == psz_name[0])
+    return 0 == strcmp(psz_want, ".");
+  if (1 == i_fname && '\1' == psz_name[0])
+    return 0 == strcmp(psz_want, "..");
+
+#ifdef HAVE_JOLIET
+  if (u_joliet_level) {
+    char joliet_fname[CDIO_UTF16BE_TO_UTF8_SIZE(255)];
+
+    cdio_utf16be_to_utf8((const uint8_t *) psz_name, i_fname, joliet_fname);
+    return 0 == strcmp(psz_want, joliet_fname);
+  }
+#endif
+
+  for (i_name = 0; i_name < i_fname && psz_name[i_name]; i_name++)
+    ;
+  return _iso9660_name_equal(psz_want, psz_name, i_name, true);
+}
+
 static iso9660_stat_t *
 _fs_stat_traverse (const CdIo_t *p_cdio, const iso9660_stat_t *_root,
 		   char **splitpath)
@@ -1076,23 +1459,13 @@ _fs_stat_traverse (const CdIo_t *p_cdio, const iso9660_stat_t *_root,
   unsigned offset = 0;
   uint8_t *_dirbuf = NULL;
   uint32_t blocks;
-  iso9660_stat_t *p_stat;
   generic_img_private_t *p_env = (generic_img_private_t *) p_cdio->env;
   iso9660_stat_t *p_iso9660_stat = NULL;
+  iso9660_arena_t *p_arena;
   bool skip_following_extents = false;
 
   if (!splitpath[0])
-    {
-      unsigned int len=sizeof(iso9660_stat_t) + strlen(_root->filename)+1;
-      p_stat = calloc(1, len);
-      cdio_assert (p_stat != NULL);
-      memcpy(p_stat, _root, len);
-      p_stat->rr.psz_symlink = calloc(1, p_stat->rr.i_symlink_max);
-      cdio_assert (p_stat->rr.psz_symlink != NULL);
-      memcpy(p_stat->rr.psz_symlink, _root->rr.psz_symlink,
-	     p_stat->rr.i_symlink_max);
-      return p_stat;
-    }
+    return _iso9660_stat_dup(_root);
 
   if (_root->type == _STAT_FILE)
     return NULL;
@@ -1108,8 +1481,13 @@ _fs_stat_traverse (const CdIo_t *p_cdio, const iso9660_stat_t *_root,
     }
 
   if (cdio_read_data_sectors (p_cdio, _dirbuf, _root->lsn, ISO_BLOCKSIZE,
-			      blocks))
+			      blocks)) {
+      free (_dirbuf);
       return NULL;
+  }
+
+  /* Entries we only look at to compare names come from one arena. */
+  p_arena = _iso9660_arena_new();
 
   while (offset < (blocks * ISO_BLOCKSIZE))
     {
@@ -1119,12 +1497,20 @@ _fs_stat_traverse (const CdIo_t *p_cdio, const iso9660_stat_t *_root,
       if (iso9660_check_dir_block_end(p_iso9660_dir, &offset))
 	continue;
 
+      /* Only the entry looked for gets an iso9660_stat_t. */
+      if (NULL == p_iso9660_stat && !skip_following_extents
+	  && !(p_iso9660_dir->file_flags & ISO_MULTIEXTENT)
+	  && !_iso9660_dir_may_match(p_iso9660_dir, (CdIo_t*)p_cdio,
+				     p_env->u_joliet_level, splitpath[0]))
+	goto skip_to_next_record;
+
       if (skip_following_extents) {
 	/* Do not register remaining extents of ill file */
 	p_iso9660_stat = NULL;
       } else {
 	p_iso9660_stat = _iso9660_dir_to_statbuf (p_iso9660_dir, p_iso9660_stat,
-				(CdIo_t*)p_cdio, dunno, p_env->u_joliet_level);
+				(CdIo_t*)p_cdio, dunno, p_env->u_joliet_level,
+				p_arena);
 	if (NULL == p_iso9660_stat)
 	  skip_following_extents = true; /* Start ill file mode */
       }
@@ -1148,6 +1534,8 @@ _fs_stat_traverse (const CdIo_t *p_cdio, const iso9660_stat_t *_root,
 	    cdio_warn("can't allocate %lu bytes",
 		      (long unsigned int) strlen(p_iso9660_stat->filename));
 	    iso9660_stat_free(p_iso9660_stat);
+	    _iso9660_arena_release(p_arena);
+	    free (_dirbuf);
 	    return NULL;
 	  }
 	  iso9660_name_translate_ext(p_iso9660_stat->filename, trans_fname,
@@ -1161,6 +1549,7 @@ _fs_stat_traverse (const CdIo_t *p_cdio, const iso9660_stat_t *_root,
 	iso9660_stat_t *ret_stat
 	  = _fs_stat_traverse (p_cdio, p_iso9660_stat, &splitpath[1]);
 	iso9660_stat_free(p_iso9660_stat);
+	_iso9660_arena_release(p_arena);
 	free (_dirbuf);
 	return ret_stat;
       }
@@ -1176,6 +1565,8 @@ skip_to_next_record:;
   cdio_assert (offset == (blocks * ISO_BLOCKSIZE));
 
   /* not found */
+  iso9660_stat_free(p_iso9660_stat);
+  _iso9660_arena_release(p_arena);
   free (_dirbuf);
   return NULL;
 }
@@ -1190,19 +1581,10 @@ _fs_iso_stat_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
   int ret, cmp;
   iso9660_stat_t *p_stat = NULL;
   iso9660_dir_t *p_iso9660_dir = NULL;
+  iso9660_arena_t *p_arena;
 
   if (!splitpath[0])
-    {
-      unsigned int len=sizeof(iso9660_stat_t) + strlen(_root->filename)+1;
-      p_stat = calloc(1, len);
-      cdio_assert (p_stat != NULL);
-      memcpy(p_stat, _root, len);
-      p_stat->rr.psz_symlink = calloc(1, p_stat->rr.i_symlink_max);
-      cdio_assert (p_stat->rr.psz_symlink != NULL);
-      memcpy(p_stat->rr.psz_symlink, _root->rr.psz_symlink,
-	     p_stat->rr.i_symlink_max);
-      return p_stat;
-    }
+    return _iso9660_stat_dup(_root);
 
   if (_root->type == _STAT_FILE)
     return NULL;
@@ -1223,6 +1605,9 @@ _fs_iso_stat_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
     return NULL;
   }
 
+  /* Entries we only look at to compare names come from one arena. */
+  p_arena = _iso9660_arena_new();
+
   for (offset = 0; offset < (blocks * ISO_BLOCKSIZE);
        offset += iso9660_get_dir_len(p_iso9660_dir))
     {
@@ -1231,11 +1616,20 @@ _fs_iso_stat_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
       if (iso9660_check_dir_block_end(p_iso9660_dir, &offset))
 	continue;
 
+      /* Only the entry looked for gets an iso9660_stat_t. */
+      if (NULL == p_stat
+	  && !(p_iso9660_dir->file_flags & ISO_MULTIEXTENT)
+	  && !_iso9660_dir_may_match(p_iso9660_dir, p_iso,
+				     p_iso->u_joliet_level, splitpath[0]))
+	continue;
+
       p_stat = _iso9660_dir_to_statbuf (p_iso9660_dir, p_stat, p_iso,
-					p_iso->b_xa, p_iso->u_joliet_level);
+					p_iso->b_xa, p_iso->u_joliet_level,
+					p_arena);
 
       if (!p_stat) {
 	cdio_warn("Bad directory information for %s", splitpath[0]);
+	_iso9660_arena_release(p_arena);
 	free(_dirbuf);
 	return NULL;
       }
@@ -1257,6 +1651,8 @@ _fs_iso_stat_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
 	    cdio_warn("can't allocate %lu bytes",
 		      (long unsigned int) strlen(p_stat->filename));
 	    iso9660_stat_free(p_stat);
+	    _iso9660_arena_release(p_arena);
+	    free (_dirbuf);
 	    return NULL;
 	  }
 	  iso9660_name_translate_ext(p_stat->filename, trans_fname,
@@ -1267,9 +1663,12 @@ _fs_iso_stat_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
       }
 
       if (!cmp) {
-	iso9660_stat_t *ret_stat
-	  = _fs_iso_stat_traverse (p_iso, p_stat, &splitpath[1]);
+	iso9660_stat_t *ret_stat;
+
+	_iso9660_stat_set_dir_record(p_stat, _root->lsn, offset);
+	ret_stat = _fs_iso_stat_traverse (p_iso, p_stat, &splitpath[1]);
 	iso9660_stat_free(p_stat);
+	_iso9660_arena_release(p_arena);
 	free (_dirbuf);
 	return ret_stat;
       }
@@ -1280,6 +1679,8 @@ _fs_iso_stat_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
   cdio_assert (offset == (blocks * ISO_BLOCKSIZE));
 
   /* not found */
+  iso9660_stat_free(p_stat);
+  _iso9660_arena_release(p_arena);
   free (_dirbuf);
   return NULL;
 }
@@ -1464,6 +1865,7 @@ iso9660_fs_readdir (CdIo_t *p_cdio, const char psz_path[])
     uint8_t *_dirbuf = NULL;
     uint32_t blocks = CDIO_EXTENT_BLOCKS(p_stat->total_size);
     CdioISO9660DirList_t *retval = _cdio_list_new ();
+    iso9660_arena_t *p_arena;
     bool skip_following_extents = false;
 
     _dirbuf = calloc(1, blocks * ISO_BLOCKSIZE);
@@ -1479,9 +1881,13 @@ iso9660_fs_readdir (CdIo_t *p_cdio, const char psz_path[])
 				ISO_BLOCKSIZE, blocks)) {
       iso9660_stat_free(p_stat);
       iso9660_dirlist_free(retval);
+      free(_dirbuf);
       return NULL;
     }
 
+    /* All entries of the list share one arena, see iso9660_stat_free() */
+    p_arena = _iso9660_arena_new();
+
     while (offset < (blocks * ISO_BLOCKSIZE))
       {
 	p_iso9660_dir = (void *) &_dirbuf[offset];
@@ -1495,7 +1901,8 @@ iso9660_fs_readdir (CdIo_t *p_cdio, const char psz_path[])
 	} else {
 	  p_iso9660_stat = _iso9660_dir_to_statbuf(p_iso9660_dir,
 						   p_iso9660_stat, p_cdio,
-						   dunno, p_env->u_joliet_level);
+						   dunno, p_env->u_joliet_level,
+						   p_arena);
 	  if (NULL == p_iso9660_stat)
 	    skip_following_extents = true; /* Start ill file mode */
 	}
@@ -1513,12 +1920,101 @@ iso9660_fs_readdir (CdIo_t *p_cdio, const char psz_path[])
 
     cdio_assert (offset == (blocks * ISO_BLOCKSIZE));
 
+    _iso9660_arena_release(p_arena);
     free(_dirbuf);
     iso9660_stat_free(p_stat);
     return retval;
   }
 }
 
+/*
+  Read the directory whose extent starts at i_lsn and is i_size bytes
+  long and return a list of iso9660_stat_t of the files inside that.
+  The caller must free the returned result.
+*/
+static CdioISO9660FileList_t *
+_iso9660_ifs_read_dir (iso9660_t *p_iso, lsn_t i_lsn, uint32_t i_size)
+{
+  iso9660_dir_t *p_iso9660_dir;
+  iso9660_stat_t *p_iso9660_stat = NULL;
+  long int ret;
+  unsigned offset = 0;
+  uint8_t *_dirbuf = NULL;
+  uint32_t blocks = CDIO_EXTENT_BLOCKS(i_size);
+  CdioList_t *retval;
+  const size_t dirbuf_len = blocks * ISO_BLOCKSIZE;
+  iso9660_arena_t *p_arena;
+  bool skip_following_extents = false;
+
+  if (!dirbuf_len)
+    {
+      cdio_warn("Invalid directory buffer sector size %u", blocks);
+      return NULL;
+    }
+
+  _dirbuf = calloc(1, dirbuf_len);
+  if (!_dirbuf)
+    {
+      cdio_warn("Couldn't calloc(1, %lu)", (unsigned long)dirbuf_len);
+      return NULL;
+    }
+
+  ret = iso9660_iso_seek_read (p_iso, _dirbuf, i_lsn, blocks);
+  if (ret != dirbuf_len) 	  {
+    free (_dirbuf);
+    return NULL;
+  }
+
+  retval = _cdio_list_new ();
+
+  /* All entries of the list share one arena, see iso9660_stat_free() */
+  p_arena = _iso9660_arena_new();
+
+  while (offset < (dirbuf_len))
+    {
+      p_iso9660_dir = (void *) &_dirbuf[offset];
+
+      if (iso9660_check_dir_block_end(p_iso9660_dir, &offset))
+	continue;
+
+      if (skip_following_extents) {
+	/* Do not register remaining extents of ill file */
+	p_iso9660_stat = NULL;
+      } else {
+	p_iso9660_stat = _iso9660_dir_to_statbuf(p_iso9660_dir,
+						 p_iso9660_stat,
+						 p_iso,
+						 p_iso->b_xa,
+						 p_iso->u_joliet_level,
+						 p_arena);
+	if (NULL == p_iso9660_stat)
+	  skip_following_extents = true; /* Start ill file mode */
+	else if (p_iso9660_stat->rr.u_su_fields & ISO_ROCK_SUF_RE)
+	  continue; /* Ignore RE entries */
+      }
+      if ((p_iso9660_dir->file_flags & ISO_MULTIEXTENT) == 0)
+	skip_following_extents = false; /* Ill or not: The file ends now */
+      if ((p_iso9660_stat) &&
+	  ((p_iso9660_dir->file_flags & ISO_MULTIEXTENT) == 0)) {
+	_iso9660_stat_set_dir_record(p_iso9660_stat, i_lsn, offset);
+	_cdio_list_append(retval, p_iso9660_stat);
+	p_iso9660_stat = NULL;
+      }
+
+      offset += iso9660_get_dir_len(p_iso9660_dir);
+    }
+
+  _iso9660_arena_release(p_arena);
+  free (_dirbuf);
+
+  if (offset != dirbuf_len) {
+    _cdio_list_free (retval, true, (CdioDataFree_t) iso9660_stat_free);
+    return NULL;
+  }
+
+  return retval;
+}
+
 /*!
   Read psz_path (a directory) and return a list of iso9660_stat_t
   of the files inside that. The caller must free the returned result.
@@ -1526,9 +2022,8 @@ iso9660_fs_readdir (CdIo_t *p_cdio, const char psz_path[])
 CdioISO9660FileList_t *
 iso9660_ifs_readdir (iso9660_t *p_iso, const char psz_path[])
 {
-  iso9660_dir_t *p_iso9660_dir;
-  iso9660_stat_t *p_iso9660_stat = NULL;
   iso9660_stat_t *p_stat;
+  CdioISO9660FileList_t *retval;
 
   if (!p_iso)    return NULL;
   if (!psz_path) return NULL;
@@ -1541,82 +2036,258 @@ iso9660_ifs_readdir (iso9660_t *p_iso, const char psz_path[])
     return NULL;
   }
 
-  {
-    long int ret;
-    unsigned offset = 0;
-    uint8_t *_dirbuf = NULL;
-    uint32_t blocks = CDIO_EXTENT_BLOCKS(p_stat->total_size);
-    CdioList_t *retval = _cdio_list_new ();
-    const size_t dirbuf_len = blocks * ISO_BLOCKSIZE;
-    bool skip_following_extents = false;
+  retval = _iso9660_ifs_read_dir (p_iso, p_stat->lsn, p_stat->total_size);
+  iso9660_stat_free(p_stat);
+  return retval;
+}
 
-    if (!dirbuf_len)
-      {
-        cdio_warn("Invalid directory buffer sector size %u", blocks);
-	iso9660_stat_free(p_stat);
-	_cdio_list_free (retval, true, NULL);
-        return NULL;
-      }
+/* A directory of an iso9660_ifs_walk(). */
+typedef struct iso9660_walk_dir_s iso9660_walk_dir_t;
+struct iso9660_walk_dir_s {
+  char                   *psz_path;   /* ends in '/' */
+  lsn_t                   i_lsn;
+  uint32_t                i_size;
+  CdioISO9660FileList_t  *p_entlist;  /* NULL once reported */
+  iso9660_walk_dir_t    **pp_child;   /* subdirectories, in on-disk order */
+  unsigned int            i_children;
+  bool                    b_failed;   /* set by the worker reading it */
+  bool                    b_read;     /* set once handed back */
+};
 
-    _dirbuf = calloc(1, dirbuf_len);
-    if (!_dirbuf)
-      {
-        cdio_warn("Couldn't calloc(1, %lu)", (unsigned long)dirbuf_len);
-	iso9660_stat_free(p_stat);
-	_cdio_list_free (retval, true, NULL);
-        return NULL;
-      }
+typedef struct {
+  iso9660_t              *p_iso;
+  CdioWorkPool_t         *p_pool;
+  iso9660_walk_visitor_t  visitor;
+  void                   *p_user_data;
+  iso9660_walk_order_t    order;
+  /* ISO9660_WALK_ORDERED: directories still to be reported, as a
+     stack whose top is reported next. */
+  iso9660_walk_dir_t    **pp_next;
+  size_t                  i_next;
+  size_t                  i_next_alloc;
+} iso9660_walk_t;
+
+static iso9660_walk_dir_t *
+_iso9660_walk_dir_new (const char psz_parent[], const char psz_name[],
+		       lsn_t i_lsn, uint32_t i_size)
+{
+  iso9660_walk_dir_t *p_dir = calloc(1, sizeof(iso9660_walk_dir_t));
+  size_t i_parent = strlen(psz_parent);
+  size_t len = i_parent + (psz_name ? strlen(psz_name) : 0) + 2;
 
-    ret = iso9660_iso_seek_read (p_iso, _dirbuf, p_stat->lsn, blocks);
-    if (ret != dirbuf_len) 	  {
-      _cdio_list_free (retval, true, NULL);
-      iso9660_stat_free(p_stat);
-      free (_dirbuf);
-      return NULL;
-    }
+  if (!p_dir) {
+    cdio_warn("Couldn't calloc(1, %lu)",
+	      (unsigned long) sizeof(iso9660_walk_dir_t));
+    return NULL;
+  }
+  p_dir->psz_path = malloc(len);
+  if (!p_dir->psz_path) {
+    cdio_warn("Couldn't malloc(%lu)", (unsigned long) len);
+    free(p_dir);
+    return NULL;
+  }
+  if (psz_name)
+    snprintf(p_dir->psz_path, len, "%s%s/", psz_parent, psz_name);
+  else
+    snprintf(p_dir->psz_path, len, "%s%s", psz_parent,
+	     (i_parent && '/' == psz_parent[i_parent-1]) ? "" : "/");
+  p_dir->i_lsn  = i_lsn;
+  p_dir->i_size = i_size;
+  return p_dir;
+}
 
-    while (offset < (dirbuf_len))
-      {
-	p_iso9660_dir = (void *) &_dirbuf[offset];
+static void
+_iso9660_walk_dir_free (iso9660_walk_dir_t *p_dir)
+{
+  unsigned int i;
 
-	if (iso9660_check_dir_block_end(p_iso9660_dir, &offset))
-	  continue;
+  if (!p_dir) return;
+  for (i = 0; i < p_dir->i_children; i++)
+    _iso9660_walk_dir_free(p_dir->pp_child[i]);
+  if (p_dir->p_entlist)
+    iso9660_filelist_free(p_dir->p_entlist);
+  free(p_dir->pp_child);
+  free(p_dir->psz_path);
+  free(p_dir);
+}
 
-	if (skip_following_extents) {
-	  /* Do not register remaining extents of ill file */
-	  p_iso9660_stat = NULL;
-	} else {
-	  p_iso9660_stat = _iso9660_dir_to_statbuf(p_iso9660_dir,
-						   p_iso9660_stat,
-						   p_iso,
-						   p_iso->b_xa,
-						   p_iso->u_joliet_level);
-	  if (NULL == p_iso9660_stat)
-	    skip_following_extents = true; /* Start ill file mode */
-	  else if (p_iso9660_stat->rr.u_su_fields & ISO_ROCK_SUF_RE)
-	    continue; /* Ignore RE entries */
-	}
-	if ((p_iso9660_dir->file_flags & ISO_MULTIEXTENT) == 0)
-	  skip_following_extents = false; /* Ill or not: The file ends now */
-	if ((p_iso9660_stat) &&
-	    ((p_iso9660_dir->file_flags & ISO_MULTIEXTENT) == 0)) {
-	  _cdio_list_append(retval, p_iso9660_stat);
-	  p_iso9660_stat = NULL;
-	}
+static bool
+_iso9660_walk_is_subdir (const iso9660_stat_t *p_stat)
+{
+  return _STAT_DIR == p_stat->type
+    && strcmp(p_stat->filename, ".")
+    && strcmp(p_stat->filename, "..");
+}
 
-	offset += iso9660_get_dir_len(p_iso9660_dir);
-      }
+/* Worker: read a directory and queue its subdirectories. */
+static void
+_iso9660_walk_read (void *p_task, unsigned int i_worker, void *p_user_data)
+{
+  iso9660_walk_t *p_walk = p_user_data;
+  iso9660_walk_dir_t *p_dir = p_task;
+  CdioListNode_t *p_entnode;
+  unsigned int i_dirs = 0;
+
+  p_dir->p_entlist = _iso9660_ifs_read_dir(p_walk->p_iso, p_dir->i_lsn,
+					   p_dir->i_size);
+  if (!p_dir->p_entlist) {
+    p_dir->b_failed = true;
+    return;
+  }
 
-    free (_dirbuf);
-    iso9660_stat_free(p_stat);
+  _CDIO_LIST_FOREACH (p_entnode, p_dir->p_entlist) {
+    if (_iso9660_walk_is_subdir(_cdio_list_node_data(p_entnode)))
+      i_dirs++;
+  }
+  if (0 == i_dirs) return;
+
+  p_dir->pp_child = calloc(i_dirs, sizeof(iso9660_walk_dir_t *));
+  if (!p_dir->pp_child) {
+    cdio_warn("Couldn't calloc(%u, %lu)", i_dirs,
+	      (unsigned long) sizeof(iso9660_walk_dir_t *));
+    p_dir->b_failed = true;
+    return;
+  }
 
-    if (offset != dirbuf_len) {
-      _cdio_list_free (retval, true, (CdioDataFree_t) iso9660_stat_free);
-      return NULL;
+  _CDIO_LIST_FOREACH (p_entnode, p_dir->p_entlist) {
+    iso9660_stat_t *p_stat = _cdio_list_node_data(p_entnode);
+    iso9660_walk_dir_t *p_child;
+
+    if (!_iso9660_walk_is_subdir(p_stat)) continue;
+    p_child = _iso9660_walk_dir_new(p_dir->psz_path, p_stat->filename,
+				    p_stat->lsn, p_stat->total_size);
+    if (!p_child) {
+      p_dir->b_failed = true;
+      return;
     }
+    p_dir->pp_child[p_dir->i_children++] = p_child;
+  }
 
-    return retval;
+  /* Queue the first subdirectory last so that this worker continues
+     with it, which keeps reads roughly in on-disk order. */
+  while (i_dirs > 0)
+    if (!cdio_workpool_push(p_walk->p_pool, i_worker,
+			    p_dir->pp_child[--i_dirs])) {
+      p_dir->b_failed = true;
+      return;
+    }
+}
+
+/* Pass the entries of p_dir to the visitor and drop them. */
+static int
+_iso9660_walk_report (iso9660_walk_t *p_walk, iso9660_walk_dir_t *p_dir)
+{
+  CdioListNode_t *p_entnode;
+  int i_rc = 0;
+
+  _CDIO_LIST_FOREACH (p_entnode, p_dir->p_entlist) {
+    i_rc = p_walk->visitor(p_dir->psz_path, _cdio_list_node_data(p_entnode),
+			   p_walk->p_user_data);
+    if (i_rc) break;
   }
+  iso9660_filelist_free(p_dir->p_entlist);
+  p_dir->p_entlist = NULL;
+  return i_rc;
+}
+
+static bool
+_iso9660_walk_next_push (iso9660_walk_t *p_walk, iso9660_walk_dir_t *p_dir)
+{
+  if (p_walk->i_next == p_walk->i_next_alloc) {
+    size_t i_alloc = p_walk->i_next_alloc ? 2 * p_walk->i_next_alloc : 32;
+    iso9660_walk_dir_t **pp_next =
+      realloc(p_walk->pp_next, i_alloc * sizeof(iso9660_walk_dir_t *));
+    if (!pp_next) {
+      cdio_warn("Couldn't realloc(%lu)",
+		(unsigned long) (i_alloc * sizeof(iso9660_walk_dir_t *)));
+      return false;
+    }
+    p_walk->pp_next      = pp_next;
+    p_walk->i_next_alloc = i_alloc;
+  }
+  p_walk->pp_next[p_walk->i_next++] = p_dir;
+  return true;
+}
+
+/* Calling thread: a directory has been read. */
+static int
+_iso9660_walk_done (void *p_task, void *p_user_data)
+{
+  iso9660_walk_t *p_walk = p_user_data;
+  iso9660_walk_dir_t *p_dir = p_task;
+
+  p_dir->b_read = true;
+  if (p_dir->b_failed) return -1;
+
+  if (ISO9660_WALK_UNORDERED == p_walk->order)
+    return _iso9660_walk_report(p_walk, p_dir);
+
+  /* Report all directories that are next in depth-first order and
+     have been read by now. */
+  while (p_walk->i_next > 0 && p_walk->pp_next[p_walk->i_next-1]->b_read) {
+    iso9660_walk_dir_t *p_next = p_walk->pp_next[--p_walk->i_next];
+    unsigned int i;
+    int i_rc = _iso9660_walk_report(p_walk, p_next);
+
+    if (i_rc) return i_rc;
+    for (i = p_next->i_children; i > 0; i--)
+      if (!_iso9660_walk_next_push(p_walk, p_next->pp_child[i-1]))
+	return -1;
+  }
+  return 0;
+}
+
+/*!
+  Walk the directory tree of p_iso below psz_path, calling visitor for
+  every entry found. See iso9660.h for details.
+*/
+int
+iso9660_ifs_walk (iso9660_t *p_iso, const char psz_path[],
+		  iso9660_walk_visitor_t visitor, void *p_user_data,
+		  unsigned int i_threads, iso9660_walk_order_t order)
+{
+  iso9660_walk_t walk;
+  iso9660_walk_dir_t *p_root;
+  iso9660_stat_t *p_stat;
+  int i_rc = -1;
+
+  if (!p_iso || !psz_path || !visitor) return -1;
+
+  p_stat = iso9660_ifs_stat (p_iso, psz_path);
+  if (!p_stat) return -1;
+  if (p_stat->type != _STAT_DIR) {
+    iso9660_stat_free(p_stat);
+    return -1;
+  }
+  p_root = _iso9660_walk_dir_new(psz_path, NULL, p_stat->lsn,
+				 p_stat->total_size);
+  iso9660_stat_free(p_stat);
+  if (!p_root) return -1;
+
+  memset(&walk, 0, sizeof(walk));
+  walk.p_iso       = p_iso;
+  walk.visitor     = visitor;
+  walk.p_user_data = p_user_data;
+  walk.order       = order;
+
+  if (ISO9660_WALK_ORDERED == order
+      && !_iso9660_walk_next_push(&walk, p_root))
+    goto out;
+
+  walk.p_pool = cdio_workpool_new(i_threads, _iso9660_walk_read,
+				  _iso9660_walk_done, &walk);
+  if (!walk.p_pool || !cdio_workpool_push(walk.p_pool, 0, p_root))
+    goto out;
+
+  i_rc = cdio_workpool_run(walk.p_pool);
+  if (0 == i_rc && walk.i_next > 0)
+    i_rc = -1; /* some directory was never handed back */
+
+ out:
+  cdio_workpool_free(walk.p_pool);
+  free(walk.pp_next);
+  _iso9660_walk_dir_free(p_root);
+  return i_rc;
 }
 
 typedef CdioISO9660FileList_t * (iso9660_readdir_t)
@@ -1663,18 +2334,15 @@ find_lsn_recurse (void *p_image, iso9660_readdir_t iso9660_readdir,
       }
 
       if (statbuf->lsn == lsn) {
-	const unsigned int len2 = sizeof(iso9660_stat_t) +
-				  strlen(statbuf->filename) + 1;
-	iso9660_stat_t *ret_stat = calloc(1, len2);
+	iso9660_stat_t *ret_stat = _iso9660_stat_dup(statbuf);
 	if (!ret_stat)
 	  {
+	    iso9660_filelist_free (entlist);
 	    iso9660_dirlist_free(dirlist);
-	    cdio_warn("Couldn't calloc(1, %d)", len2);
 	    free(*ppsz_full_filename);
 	    *ppsz_full_filename = NULL;
 	    return NULL;
 	  }
-	memcpy(ret_stat, statbuf, len2);
 	iso9660_filelist_free (entlist);
 	iso9660_dirlist_free(dirlist);
 	return ret_stat;
@@ -1814,6 +2482,8 @@ _iso9660_dd_find_lsn(void* p_image, lsn_t i_lsn)
   /* Disable the deep directory flag so we can process all entries */
   p_header = (cdio_header_t*)p_image_dd;
   p_header->u_flags |= CDIO_HEADER_FLAGS_DISABLE_RR_DD;
+  /* The target's fields get copied; have them decoded in full. */
+  p_header->u_flags &= ~CDIO_HEADER_FLAGS_LAZY_RR;
   ret = find_lsn_recurse(p_image_dd, f_readdir, "/", i_lsn, &psz_full_filename);
   if (psz_full_filename != NULL)
     free(psz_full_filename);
@@ -1856,6 +2526,11 @@ void
 iso9660_stat_free(iso9660_stat_t *p_stat)
 {
   if (p_stat != NULL) {
+    if (p_stat->p_arena) {
+      /* Entry and symlink live in the arena; just drop our reference. */
+      _iso9660_arena_release(p_stat->p_arena);
+      return;
+    }
     if (p_stat->rr.psz_symlink) {
       CDIO_FREE_IF_NOT_NULL(p_stat->rr.psz_symlink);
     }
@@ -1863,6 +2538,114 @@ iso9660_stat_free(iso9660_stat_t *p_stat)
   }
 }
 
+/* Directory reads hand out many small iso9660_stat_t's that all die
+   together in iso9660_filelist_free(). Rather than one calloc per
+   entry (and per Rock Ridge symlink) they are carved out of large
+   blocks. The arena is reference counted: its creator holds one
+   reference while filling in entries and every live entry holds one,
+   so entries can still be freed one by one - or kept after the list
+   is gone, as the C++ bindings do - and the blocks are released in
+   one go with the last of them. */
+
+#define ISO9660_ARENA_BLOCK_SIZE (64 * 1024)
+#define ISO9660_ARENA_ALIGN      16
+#define ISO9660_ARENA_ROUND(n) \
+  (((n) + ISO9660_ARENA_ALIGN - 1) & ~((size_t) ISO9660_ARENA_ALIGN - 1))
+
+/* So that AddressSanitizer still sees an entry overrun its size, the
+   parts of a block not handed out are kept poisoned. */
+#if defined(__has_feature)
+# if __has_feature(address_sanitizer) && !defined(__SANITIZE_ADDRESS__)
+#  define __SANITIZE_ADDRESS__ 1
+# endif
+#endif
+#ifdef __SANITIZE_ADDRESS__
+# include <sanitizer/asan_interface.h>
+#else
+# define ASAN_POISON_MEMORY_REGION(p, n)   ((void) (p), (void) (n))
+# define ASAN_UNPOISON_MEMORY_REGION(p, n) ((void) (p), (void) (n))
+#endif
+
+typedef struct iso9660_arena_block_s {
+  struct iso9660_arena_block_s *p_next; /**< previously filled block */
+  size_t i_size;                        /**< usable bytes after the header */
+  size_t i_used;                        /**< bytes handed out so far */
+} iso9660_arena_block_t;
+
+struct iso9660_arena_s {
+  iso9660_arena_block_t *p_block;       /**< block currently carved from */
+  unsigned int i_refcount;
+};
+
+iso9660_arena_t *
+_iso9660_arena_new(void)
+{
+  iso9660_arena_t *p_arena = calloc(1, sizeof(iso9660_arena_t));
+
+  if (!p_arena) {
+    cdio_warn("Couldn't calloc(1, %lu)",
+	      (unsigned long) sizeof(iso9660_arena_t));
+    return NULL;
+  }
+  p_arena->i_refcount = 1;
+  return p_arena;
+}
+
+void *
+_iso9660_arena_calloc(iso9660_arena_t *p_arena, size_t i_size)
+{
+  const size_t i_header = ISO9660_ARENA_ROUND(sizeof(iso9660_arena_block_t));
+  const size_t i_round = ISO9660_ARENA_ROUND(i_size);
+  iso9660_arena_block_t *p_block;
+  void *p;
+
+  if (!p_arena) return NULL;
+
+  p_block = p_arena->p_block;
+
+  if (!p_block || p_block->i_size - p_block->i_used < i_round) {
+    const size_t i_block = (i_round > ISO9660_ARENA_BLOCK_SIZE - i_header)
+      ? i_round : ISO9660_ARENA_BLOCK_SIZE - i_header;
+    /* calloc'd memory is never handed out twice, so it stays zeroed. */
+    p_block = calloc(1, i_header + i_block);
+    if (!p_block) {
+      cdio_warn("Couldn't calloc(1, %lu)",
+		(unsigned long) (i_header + i_block));
+      return NULL;
+    }
+    p_block->i_size = i_block;
+    p_block->p_next = p_arena->p_block;
+    p_arena->p_block = p_block;
+    ASAN_POISON_MEMORY_REGION((uint8_t *) p_block + i_header, i_block);
+  }
+
+  p = (uint8_t *) p_block + i_header + p_block->i_used;
+  p_block->i_used += i_round;
+  ASAN_UNPOISON_MEMORY_REGION(p, i_size);
+  return p;
+}
+
+void
+_iso9660_arena_retain(iso9660_arena_t *p_arena)
+{
+  if (p_arena) p_arena->i_refcount++;
+}
+
+void
+_iso9660_arena_release(iso9660_arena_t *p_arena)
+{
+  if (!p_arena) return;
+  cdio_assert (p_arena->i_refcount > 0);
+  if (--p_arena->i_refcount > 0) return;
+
+  while (p_arena->p_block) {
+    iso9660_arena_block_t *p_next = p_arena->p_block->p_next;
+    free(p_arena->p_block);
+    p_arena->p_block = p_next;
+  }
+  free(p_arena);
+}
+
 /*!
   Free the passed CdioISOC9660FileList_t structure.
 */
@@ -1899,6 +2682,7 @@ iso_have_rr_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
   uint32_t blocks;
   int ret;
   bool_3way_t have_rr = nope;
+  iso9660_arena_t *p_arena;
 
   if (!splitpath[0]) return false;
 
@@ -1921,6 +2705,8 @@ iso_have_rr_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
     return false;
   }
 
+  p_arena = _iso9660_arena_new();
+
   while (offset < (blocks * ISO_BLOCKSIZE))
     {
       iso9660_dir_t *p_iso9660_dir = (void *) &_dirbuf[offset];
@@ -1931,7 +2717,13 @@ iso_have_rr_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
 	continue;
 
       p_stat = _iso9660_dir_to_statbuf (p_iso9660_dir, NULL, p_iso,
-					p_iso->b_xa, p_iso->u_joliet_level);
+					p_iso->b_xa, p_iso->u_joliet_level,
+					p_arena);
+      if (!p_stat) {
+	_iso9660_arena_release(p_arena);
+	free (_dirbuf);
+	return dunno;
+      }
       have_rr = p_stat->rr.b3_rock;
       if ( have_rr != yep) {
 	if (strlen(splitpath[0]) == 0)
@@ -1942,6 +2734,7 @@ iso_have_rr_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
       }
       iso9660_stat_free(p_stat);
       if (have_rr != nope) {
+	_iso9660_arena_release(p_arena);
 	free (_dirbuf);
 	return have_rr;
       }
@@ -1949,6 +2742,7 @@ iso_have_rr_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
       offset += iso9660_get_dir_len(p_iso9660_dir);
       *pu_file_limit = (*pu_file_limit)-1;
       if ((*pu_file_limit) == 0) {
+	_iso9660_arena_release(p_arena);
 	free (_dirbuf);
 	return dunno;
       }
@@ -1957,10 +2751,65 @@ iso_have_rr_traverse (iso9660_t *p_iso, const iso9660_stat_t *_root,
   cdio_assert (offset == (blocks * ISO_BLOCKSIZE));
 
   /* not found */
+  _iso9660_arena_release(p_arena);
   free (_dirbuf);
   return nope;
 }
 
+/*!
+  Decode only Rock Ridge names while reading directories of p_iso, and
+  leave the other Rock Ridge fields until iso9660_ifs_get_rock_ridge()
+  asks for them.
+*/
+void
+iso9660_ifs_set_rock_ridge_lazy(iso9660_t *p_iso, bool b_lazy)
+{
+  if (!p_iso) return;
+  if (b_lazy)
+    p_iso->header.u_flags |= CDIO_HEADER_FLAGS_LAZY_RR;
+  else
+    p_iso->header.u_flags &= ~CDIO_HEADER_FLAGS_LAZY_RR;
+}
+
+/*!
+  Return the Rock Ridge fields of p_stat, decoding any that were
+  deferred first. NULL is returned if p_stat has no Rock Ridge
+  extensions or its directory record can't be read again.
+*/
+const iso_rock_statbuf_t *
+iso9660_ifs_get_rock_ridge(iso9660_t *p_iso, iso9660_stat_t *p_stat)
+{
+  uint8_t buf[ISO_BLOCKSIZE];
+  iso9660_dir_t *p_iso9660_dir;
+  char rr_fname[256];
+
+  if (!p_stat) return NULL;
+  if (p_stat->rr.b_deferred) {
+    if (!p_iso || 0 == p_stat->rr.i_dir_lsn
+	|| ISO_BLOCKSIZE != iso9660_iso_seek_read(p_iso, buf,
+						  p_stat->rr.i_dir_lsn, 1))
+      return NULL;
+
+    p_iso9660_dir = (void *) &buf[p_stat->rr.i_dir_offset];
+    if (p_stat->rr.i_dir_offset + sizeof(iso9660_dir_t) > ISO_BLOCKSIZE
+	|| p_stat->rr.i_dir_offset + iso9660_get_dir_len(p_iso9660_dir)
+	   > ISO_BLOCKSIZE) {
+      cdio_warn("Bad directory record for %s", p_stat->filename);
+      return NULL;
+    }
+
+    /* The record is read on its own, so start from its own system
+       use area just as the first time round. */
+    p_stat->rr.s_rock_offset = 0;
+    p_stat->rr.b_deferred    = false;
+#ifdef HAVE_ROCK
+    _iso9660_rr_parse(p_iso9660_dir, p_iso, rr_fname, p_stat,
+		      ISO_RR_PARSE_ATTRS);
+#endif
+  }
+  return (yep == p_stat->rr.b3_rock) ? &p_stat->rr : NULL;
+}
+
 /*!
   Return "yup" if any file has Rock-Ridge extensions. Warning: this can
   be time consuming. On an ISO 9600 image with lots of files but no Rock-Ridge
@@ -75,6 +75,46 @@ typedef struct iso_path_table_s {
 
 PRAGMA_END_PACKED
 
+#include <cdio/iso9660.h>
+
+/** Block allocator backing the iso9660_stat_t entries (and their Rock
+    Ridge symlink buffers) produced by one directory read. */
+typedef struct iso9660_arena_s iso9660_arena_t;
+
+/*!
+  Create an arena. The caller holds the only reference and must drop
+  it with _iso9660_arena_release() when done handing out entries.
+*/
+iso9660_arena_t *_iso9660_arena_new(void);
+
+/*!
+  Return i_size bytes of zeroed memory carved out of p_arena, or NULL
+  if memory could not be allocated. The memory is never freed
+  individually; it goes away with the arena.
+*/
+void *_iso9660_arena_calloc(iso9660_arena_t *p_arena, size_t i_size);
+
+/*! Add a reference to p_arena. */
+void _iso9660_arena_retain(iso9660_arena_t *p_arena);
+
+/*! Drop a reference to p_arena, freeing all its blocks on the last one. */
+void _iso9660_arena_release(iso9660_arena_t *p_arena);
+
+/* What _iso9660_rr_parse() decodes. */
+#define ISO_RR_PARSE_NAME  0x01 /**< NM and the fields placing the entry */
+#define ISO_RR_PARSE_ATTRS 0x02 /**< PX, SL and TF */
+#define ISO_RR_PARSE_ALL   (ISO_RR_PARSE_NAME | ISO_RR_PARSE_ATTRS)
+
+/*!
+  get_rock_ridge_filename() restricted to the fields in u_parse. Fields
+  not decoded are still noted in p_stat->rr.u_su_fields, and
+  p_stat->rr.b_deferred is set if any PX, SL or TF field was skipped.
+*/
+int _iso9660_rr_parse(iso9660_dir_t *p_iso9660_dir, void *p_image,
+                      /*out*/ char *psz_name,
+                      /*in/out*/ iso9660_stat_t *p_stat,
+                      unsigned int u_parse);
+
 #endif /* CDIO_ISO0660_ISO9660_PRIVATE_H_ */
 
 
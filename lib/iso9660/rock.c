@@ -41,7 +41,9 @@
 #include <cdio/logging.h>
 #include <cdio/bytesex.h>
 #include "filemode.h"
+#include "portable.h"
 #include "cdio_private.h"
+#include "iso9660_private.h"
 
 #define CDIO_MKDEV(ma,mi)	((ma)<<16 | (mi))
 
@@ -54,6 +56,16 @@ iso_rock_tf_flag_t iso_rock_tf_flag;
 extern iso9660_stat_t*
 _iso9660_dd_find_lsn(void* p_image, lsn_t i_lsn);
 
+/* Allocate a zeroed symlink buffer for p_stat, from the arena p_stat
+   itself came from if any. */
+static char *
+alloc_symlink(const iso9660_stat_t *p_stat, size_t i_size)
+{
+  if (p_stat->p_arena)
+    return (char *) _iso9660_arena_calloc(p_stat->p_arena, i_size);
+  return (char *) calloc(1, i_size);
+}
+
 /* Our own realloc routine tailored for the iso9660_stat_t symlink
    field.  I can't figure out how to make realloc() work without
    valgrind complaint.
@@ -63,7 +75,7 @@ realloc_symlink(/*in/out*/ iso9660_stat_t *p_stat, uint8_t i_grow)
 {
   if (!p_stat->rr.i_symlink) {
     const uint16_t i_max = 2*i_grow+1;
-    p_stat->rr.psz_symlink = (char *) calloc(1, i_max);
+    p_stat->rr.psz_symlink = alloc_symlink(p_stat, i_max);
     p_stat->rr.i_symlink_max = i_max;
     return (NULL != p_stat->rr.psz_symlink);
   } else {
@@ -71,11 +83,13 @@ realloc_symlink(/*in/out*/ iso9660_stat_t *p_stat, uint8_t i_grow)
     if ( i_needed <= p_stat->rr.i_symlink_max)
       return true;
     else {
-      char * psz_newsymlink = (char *) calloc(1, 2*i_needed);
+      char * psz_newsymlink = alloc_symlink(p_stat, 2*i_needed);
       if (!psz_newsymlink) return false;
       p_stat->rr.i_symlink_max = 2*i_needed;
       memcpy(psz_newsymlink, p_stat->rr.psz_symlink, p_stat->rr.i_symlink);
-      free(p_stat->rr.psz_symlink);
+      /* Arena memory goes away with the arena */
+      if (!p_stat->p_arena)
+	free(p_stat->rr.psz_symlink);
       p_stat->rr.psz_symlink = psz_newsymlink;
       return true;
     }
@@ -166,6 +180,17 @@ get_rock_ridge_filename(iso9660_dir_t * p_iso9660_dir,
 			/*in*/ void * p_image,
 			/*out*/ char * psz_name,
 			/*in/out*/ iso9660_stat_t *p_stat)
+{
+  return _iso9660_rr_parse(p_iso9660_dir, p_image, psz_name, p_stat,
+			   ISO_RR_PARSE_ALL);
+}
+
+int
+_iso9660_rr_parse(iso9660_dir_t * p_iso9660_dir,
+		  /*in*/ void * p_image,
+		  /*out*/ char * psz_name,
+		  /*in/out*/ iso9660_stat_t *p_stat,
+		  unsigned int u_parse)
 {
   int len;
   unsigned char *chr;
@@ -206,6 +231,8 @@ get_rock_ridge_filename(iso9660_dir_t * p_iso9660_dir,
 	p_stat->rr.u_su_fields |= ISO_ROCK_SUF_SP;
 	break;
       case SIG('C','E'):
+	if (!(u_parse & ISO_RR_PARSE_NAME))
+	  break;
 	{
 	  iso711_t i_fname = from_711(p_iso9660_dir->filename.len);
 	  if ('\0' == p_iso9660_dir->filename.str[1] && 1 == i_fname)
@@ -217,6 +244,8 @@ get_rock_ridge_filename(iso9660_dir_t * p_iso9660_dir,
 	p_stat->rr.u_su_fields |= ISO_ROCK_SUF_CE;
 	break;
       case SIG('E','R'):
+	if (!(u_parse & ISO_RR_PARSE_NAME))
+	  break;
 	cdio_debug("ISO 9660 Extensions: ");
 	{
 	  int p;
@@ -225,6 +254,8 @@ get_rock_ridge_filename(iso9660_dir_t * p_iso9660_dir,
 	}
 	break;
       case SIG('N','M'):
+	if (!(u_parse & ISO_RR_PARSE_NAME))
+	  break;
 	/* Alternate name */
 	p_stat->rr.u_su_fields |= ISO_ROCK_SUF_NM;
 	if (truncate)
@@ -243,14 +274,29 @@ get_rock_ridge_filename(iso9660_dir_t * p_iso9660_dir,
 	  cdio_info("Unsupported NM flag settings (%d)",rr->u.NM.flags);
 	  break;
 	}
+	if (rr->len < 5)
+	  break;
 	if((strlen(psz_name) + rr->len - 5) >= 254) {
 	  truncate = 1;
 	  break;
 	}
+	if (memchr(rr->u.NM.name, '\0', rr->len - 5)) {
+	  /* Only part of it would be seen; use the ISO 9660 name. */
+	  cdio_warn("Rock Ridge name with a NUL in it ignored");
+	  psz_name[0] = '\0';
+	  i_namelen = 0;
+	  truncate = 1;
+	  break;
+	}
 	strncat(psz_name, rr->u.NM.name, rr->len - 5);
 	i_namelen += rr->len - 5;
 	break;
       case SIG('P','X'):
+	if (!(u_parse & ISO_RR_PARSE_ATTRS)) {
+	  p_stat->rr.u_su_fields |= ISO_ROCK_SUF_PX;
+	  p_stat->rr.b_deferred = true;
+	  break;
+	}
 	/* POSIX file attributes */
 	p_stat->rr.st_mode   = from_733(rr->u.PX.st_mode);
 	p_stat->rr.st_nlinks = from_733(rr->u.PX.st_nlinks);
@@ -259,6 +305,11 @@ get_rock_ridge_filename(iso9660_dir_t * p_iso9660_dir,
 	p_stat->rr.u_su_fields |= ISO_ROCK_SUF_PX;
 	break;
       case SIG('S','L'):
+	if (!(u_parse & ISO_RR_PARSE_ATTRS)) {
+	  p_stat->rr.u_su_fields |= ISO_ROCK_SUF_SL;
+	  p_stat->rr.b_deferred = true;
+	  break;
+	}
 	{
 	  /* Symbolic link */
 	  uint8_t slen;
@@ -317,6 +368,11 @@ get_rock_ridge_filename(iso9660_dir_t * p_iso9660_dir,
 	p_stat->rr.psz_symlink[symlink_len]='\0';
 	break;
       case SIG('T','F'):
+	if (!(u_parse & ISO_RR_PARSE_ATTRS)) {
+	  p_stat->rr.u_su_fields |= ISO_ROCK_SUF_TF;
+	  p_stat->rr.b_deferred = true;
+	  break;
+	}
 	/* Time stamp(s) for a file */
 	{
 	  int cnt = 0;
@@ -331,6 +387,8 @@ get_rock_ridge_filename(iso9660_dir_t * p_iso9660_dir,
 	  break;
 	}
       case SIG('C','L'):
+	if (!(u_parse & ISO_RR_PARSE_NAME))
+	  break;
 	/* Child Link for a deep directory */
 	if (!is_rr_dd_enabled(p_image))
 	  break;
@@ -342,23 +400,47 @@ get_rock_ridge_filename(iso9660_dir_t * p_iso9660_dir,
 	    cdio_warn("Could not get Rock Ridge deep directory child");
 	    break;
 	  }
-	  memcpy(p_stat, target, sizeof(iso9660_stat_t));
-	  /* Prevent the symlink from being freed on the duplicated struct */
-	  target->rr.psz_symlink = NULL;
+	  {
+	    /* Keep p_stat's own allocator; target is always malloc'd. */
+	    iso9660_arena_t *p_arena = p_stat->p_arena;
+	    memcpy(p_stat, target, sizeof(iso9660_stat_t));
+	    p_stat->p_arena = p_arena;
+	    if (p_arena && target->rr.psz_symlink) {
+	      p_stat->rr.psz_symlink = alloc_symlink(p_stat,
+						     target->rr.i_symlink_max);
+	      if (p_stat->rr.psz_symlink)
+		memcpy(p_stat->rr.psz_symlink, target->rr.psz_symlink,
+		       target->rr.i_symlink_max);
+	      else
+		p_stat->rr.i_symlink = p_stat->rr.i_symlink_max = 0;
+	    } else {
+	      /* Prevent the symlink from being freed on the duplicated struct */
+	      target->rr.psz_symlink = NULL;
+	    }
+	  }
 	  iso9660_stat_free(target);
+	  /* The fields now come from target, which is fully decoded;
+	     decode the rest of this entry in full too. */
+	  u_parse = ISO_RR_PARSE_ALL;
 	}
 	break;
       case SIG('P','L'):
+	if (!(u_parse & ISO_RR_PARSE_NAME))
+	  break;
 	/* Parent link of a deep directory */
 	if (is_rr_dd_enabled(p_image))
 	  p_stat->rr.u_su_fields |= ISO_ROCK_SUF_PL;
 	break;
       case SIG('R','E'):
+	if (!(u_parse & ISO_RR_PARSE_NAME))
+	  break;
 	/* Relocated entry for a deep directory */
 	if (is_rr_dd_enabled(p_image))
 	  p_stat->rr.u_su_fields |= ISO_ROCK_SUF_RE;
 	break;
       case SIG('S','F'):
+	if (!(u_parse & ISO_RR_PARSE_NAME))
+	  break;
 	/* Sparse File */
 	p_stat->rr.u_su_fields |= ISO_ROCK_SUF_SF;
 	cdio_warn("Rock Ridge Sparse File detected");
@@ -378,14 +460,15 @@ out:
 }
 
 #define BUF_COUNT 16
-#define BUF_SIZE sizeof("drwxrwxrwx")
+#define BUF_SIZE ISO_ROCK_ATTR_STR_SIZE
 
-/* Return a pointer to a internal free buffer */
+/* Return a pointer to a internal free buffer. Each thread has its own
+   set of buffers. */
 static char *
 _getbuf (void)
 {
-  static char _buf[BUF_COUNT][BUF_SIZE];
-  static int _i = -1;
+  static TLS char _buf[BUF_COUNT][BUF_SIZE];
+  static TLS int _i = -1;
 
   _i++;
   _i %= BUF_COUNT;
@@ -433,7 +516,17 @@ _getbuf (void)
 const char *
 iso9660_get_rock_attr_str(posix_mode_t st_mode)
 {
-  char *result = _getbuf();
+  return iso9660_get_rock_attr_str_r(st_mode, _getbuf());
+}
+
+/*!
+  Reentrant form of iso9660_get_rock_attr_str(). psz_buf must hold at
+  least ISO_ROCK_ATTR_STR_SIZE bytes.
+*/
+char *
+iso9660_get_rock_attr_str_r(posix_mode_t st_mode, char *psz_buf)
+{
+  char *result = psz_buf;
 
   if (S_ISBLK(st_mode))
     result[ 0] = 'b';
@@ -471,7 +564,7 @@ iso9660_get_rock_attr_str(posix_mode_t st_mode)
   result[ 8] = (st_mode & ISO_ROCK_IWOTH) ? 'w' : '-';
   result[ 9] = (st_mode & ISO_ROCK_IXOTH) ? 'x' : '-';
 
-  result[11] = '\0';
+  result[10] = '\0';
 
   return result;
 }
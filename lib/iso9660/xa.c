@@ -44,6 +44,7 @@ const char ISO_XA_MARKER_STRING[] = {'C', 'D', '-', 'X', 'A', '0', '0', '1'};
 /* Private headers */
 #include "cdio_assert.h"
 #include "filemode.h"
+#include "portable.h"
 
 /** The below variable is trickery to force enum symbol values to be
     recorded in debug symbol tables. It is used to allow one to refer
@@ -53,14 +54,15 @@ const char ISO_XA_MARKER_STRING[] = {'C', 'D', '-', 'X', 'A', '0', '0', '1'};
 xa_misc_enum_t debugger_xa_misc_enum;
 
 #define BUF_COUNT 16
-#define BUF_SIZE 80
+#define BUF_SIZE ISO_XA_ATTR_STR_SIZE
 
-/* Return a pointer to a internal free buffer */
+/* Return a pointer to a internal free buffer. Each thread has its own
+   set of buffers. */
 static char *
 _getbuf (void)
 {
-  static char _buf[BUF_COUNT][BUF_SIZE];
-  static int _num = -1;
+  static TLS char _buf[BUF_COUNT][BUF_SIZE];
+  static TLS int _num = -1;
   
   _num++;
   _num %= BUF_COUNT;
@@ -102,7 +104,17 @@ _getbuf (void)
 const char *
 iso9660_get_xa_attr_str (uint16_t xa_attr)
 {
-  char *result = _getbuf();
+  return iso9660_get_xa_attr_str_r (xa_attr, _getbuf());
+}
+
+/*!
+  Reentrant form of iso9660_get_xa_attr_str(). psz_buf must hold at
+  least ISO_XA_ATTR_STR_SIZE bytes.
+*/
+char *
+iso9660_get_xa_attr_str_r (uint16_t xa_attr, char *psz_buf)
+{
+  char *result = psz_buf;
 
   xa_attr = uint16_from_be (xa_attr);
 
@@ -26,6 +26,14 @@
 # include <string.h>
 #endif
 
+#ifdef HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+
+#ifdef HAVE_LIMITS_H
+# include <limits.h>
+#endif
+
 #ifdef HAVE_STDIO_H
 #include <stdio.h>  /* Remove when adding cdio/logging.h */
 #endif
@@ -51,7 +59,7 @@ bool
 udf_get_file_entry(const udf_dirent_t *p_udf_dirent, 
 		   /*out*/ udf_file_entry_t *p_udf_fe)
 {
-  if (!p_udf_dirent) return false;
+  if (!p_udf_dirent || !udf_dirent_load_fe(p_udf_dirent)) return false;
   memcpy(p_udf_fe, &p_udf_dirent->fe, sizeof(udf_file_entry_t));
   return true;
 }
@@ -78,7 +86,7 @@ bool udf_get_fileid_descriptor(const udf_dirent_t *p_udf_dirent,
 */
 uint16_t udf_get_link_count(const udf_dirent_t *p_udf_dirent) 
 {
-  if (p_udf_dirent) {
+  if (p_udf_dirent && udf_dirent_load_fe(p_udf_dirent)) {
     return uint16_from_le(p_udf_dirent->fe.link_count);
   }
   return 0; /* Error. Non-error case handled above. */
@@ -89,7 +97,7 @@ uint16_t udf_get_link_count(const udf_dirent_t *p_udf_dirent)
 */
 uint64_t udf_get_file_length(const udf_dirent_t *p_udf_dirent) 
 {
-  if (p_udf_dirent) {
+  if (p_udf_dirent && udf_dirent_load_fe(p_udf_dirent)) {
     return uint64_from_le(p_udf_dirent->fe.info_len);
   }
   return 2147483647L; /* Error. Non-error case handled above. */
@@ -104,120 +112,300 @@ udf_is_dir(const udf_dirent_t *p_udf_dirent)
   return p_udf_dirent->b_dir;
 }
 
+/*!
+  Return true if the data of the file with file entry p_udf_fe is
+  stored in the file entry itself, setting *pp_data and *pi_len to it.
+  *pp_data is NULL if it doesn't fit in the file entry.
+*/
+bool
+udf_fe_in_icb(const udf_file_entry_t *p_udf_fe,
+	      /*out*/ const uint8_t **pp_data, /*out*/ uint32_t *pi_len)
+{
+  const uint16_t addr_ilk =
+    uint16_from_le(p_udf_fe->icb_tag.flags) & ICBTAG_FLAG_AD_MASK;
+  const uint32_t i_ext_attr = uint32_from_le(p_udf_fe->i_extended_attr);
+  const uint32_t i_ads = uint32_from_le(p_udf_fe->i_alloc_descs);
+  const uint64_t i_info_len = uint64_from_le(p_udf_fe->info_len);
+
+  if (ICBTAG_FLAG_AD_IN_ICB != addr_ilk)
+    return false;
+
+  *pp_data = NULL;
+  *pi_len = 0;
+  if (i_ext_attr > sizeof(p_udf_fe->u)
+      || i_ads > sizeof(p_udf_fe->u) - i_ext_attr) {
+    cdio_warn("Data in the file entry overruns it");
+    return true;
+  }
+  *pp_data = GETICB(i_ext_attr);
+  *pi_len = (i_info_len < i_ads) ? (uint32_t) i_info_len : i_ads;
+  return true;
+}
+
+/* Enough allocation extent descriptors to describe a file filling any
+   disc. More than that means they point back at one another. */
+#define UDF_MAX_AED_CHAIN 65536
+
 /*
- * Translate a file offset into a logical block and then into a physical
- * block.
+ * Decode the allocation descriptor at p_ad, of type addr_ilk, into
+ * its extent length field, partition and partition block. Short ones
+ * are in i_part, the partition of the file entry. Return its size.
  */
-static lba_t
-offset_to_lba(const udf_dirent_t *p_udf_dirent, off_t i_offset, 
-	      /*out*/ lba_t *pi_lba, /*out*/ uint32_t *pi_max_size)
+static unsigned int
+decode_ad(const uint8_t *p_ad, uint16_t addr_ilk, uint16_t i_part,
+	  /*out*/ uint32_t *pi_len, /*out*/ uint16_t *pi_part,
+	  /*out*/ uint32_t *pi_lba)
 {
-  udf_t *p_udf = p_udf_dirent->p_udf;
-  const udf_file_entry_t *p_udf_fe = (udf_file_entry_t *) 
-    &p_udf_dirent->fe;
-  const udf_icbtag_t *p_icb_tag = &p_udf_fe->icb_tag;
-  const uint16_t strat_type= uint16_from_le(p_icb_tag->strat_type);
-
-  if (i_offset < 0) {
-    cdio_warn("Negative offset value");
-    return CDIO_INVALID_LBA;
+  switch (addr_ilk) {
+  case ICBTAG_FLAG_AD_SHORT:
+    {
+      const udf_short_ad_t *p_short = (const udf_short_ad_t *) p_ad;
+      *pi_len  = uint32_from_le(p_short->len);
+      *pi_part = i_part;
+      *pi_lba  = uint32_from_le(p_short->pos);
+      return sizeof(udf_short_ad_t);
+    }
+  case ICBTAG_FLAG_AD_LONG:
+    {
+      const udf_long_ad_t *p_long = (const udf_long_ad_t *) p_ad;
+      *pi_len  = uint32_from_le(p_long->len);
+      *pi_part = uint16_from_le(p_long->loc.partitionReferenceNum);
+      *pi_lba  = uint32_from_le(p_long->loc.lba);
+      return sizeof(udf_long_ad_t);
+    }
+  case ICBTAG_FLAG_AD_EXTENDED:
+    {
+      const udf_ext_ad_t *p_ext = (const udf_ext_ad_t *) p_ad;
+      *pi_len  = uint32_from_le(p_ext->len);
+      *pi_part = uint16_from_le(p_ext->ext_loc.partitionReferenceNum);
+      *pi_lba  = uint32_from_le(p_ext->ext_loc.lba);
+      return sizeof(udf_ext_ad_t);
+    }
+  default:
+    return 0;
+  }
+}
+
+static bool
+add_extent(udf_extent_t **pp_extents, unsigned int *pi_extents,
+	   /*in/out*/ unsigned int *pi_alloc, uint64_t i_offset,
+	   uint16_t i_part, uint32_t i_lba, uint32_t i_len, bool b_recorded)
+{
+  udf_extent_t *p_extent;
+
+  /* An extent that carries straight on from the previous one on disk
+     is merged into it, so that it is read in one go. */
+  if (*pi_extents > 0) {
+    p_extent = &(*pp_extents)[*pi_extents - 1];
+    if (p_extent->b_recorded == b_recorded
+	&& 0 == p_extent->i_len % UDF_BLOCKSIZE
+	&& (!b_recorded
+	    || (p_extent->i_part == i_part
+		&& p_extent->i_lba + p_extent->i_len / UDF_BLOCKSIZE
+		   == i_lba))) {
+      p_extent->i_len += i_len;
+      return true;
+    }
+  }
+
+  if (*pi_extents == *pi_alloc) {
+    unsigned int i_alloc = 2 * *pi_alloc;
+    udf_extent_t *p_extents =
+      realloc(*pp_extents, i_alloc * sizeof(udf_extent_t));
+
+    if (!p_extents) {
+      cdio_warn("Couldn't realloc(%lu)",
+		(unsigned long) (i_alloc * sizeof(udf_extent_t)));
+      return false;
+    }
+    *pp_extents = p_extents;
+    *pi_alloc = i_alloc;
   }
+  p_extent = &(*pp_extents)[(*pi_extents)++];
+  p_extent->i_offset   = i_offset;
+  p_extent->i_part     = i_part;
+  p_extent->i_lba      = i_lba;
+  p_extent->i_len      = i_len;
+  p_extent->b_recorded = b_recorded;
+  return true;
+}
+
+/*
+ * Decode the allocation descriptors of a file, including those in
+ * allocation extent descriptors they chain to, into its extent map.
+ * The extents come out in file offset order.
+ */
+bool
+udf_build_extents(const udf_t *p_udf, const udf_file_entry_t *p_udf_fe,
+		  uint16_t i_part, /*out*/ udf_extent_t **pp_extents,
+		  /*out*/ unsigned int *pi_extents)
+{
+  const uint16_t strat_type = uint16_from_le(p_udf_fe->icb_tag.strat_type);
+  const uint16_t addr_ilk =
+    uint16_from_le(p_udf_fe->icb_tag.flags) & ICBTAG_FLAG_AD_MASK;
+  const uint32_t i_ext_attr = uint32_from_le(p_udf_fe->i_extended_attr);
+  uint32_t i_ads = uint32_from_le(p_udf_fe->i_alloc_descs);
+  const uint8_t *p_ads = GETICB(i_ext_attr);
+  uint8_t aed[UDF_BLOCKSIZE];
+  unsigned int i_ad_size, i_alloc, i_chain = 0;
+  uint64_t i_offset = 0;
 
   switch (strat_type) {
+  case ICBTAG_STRATEGY_TYPE_4:
+    break;
   case 4096:
     cdio_warn("Cannot deal with strategy4096 yet!");
-    return CDIO_INVALID_LBA;
+    return false;
+  default:
+    cdio_warn("Unknown strategy type %d", strat_type);
+    return false;
+  }
+
+  switch (addr_ilk) {
+  case ICBTAG_FLAG_AD_SHORT:
+    i_ad_size = sizeof(udf_short_ad_t);
     break;
-  case ICBTAG_STRATEGY_TYPE_4:
-    {
-      off_t icblen = 0;
-      uint64_t lsector;
-      int ad_offset, ad_num = 0;
-      uint16_t addr_ilk = uint16_from_le(p_icb_tag->flags&ICBTAG_FLAG_AD_MASK);
-      
-      switch (addr_ilk) {
-      case ICBTAG_FLAG_AD_SHORT: 
-	{
-	  udf_short_ad_t *p_icb;
-	  /*
-	   * The allocation descriptor field is filled with short_ad's.
-	   * If the offset is beyond the current extent, look for the
-	   * next extent.
-	   */
-	  do {
-	    i_offset -= icblen;
-	    ad_offset = sizeof(udf_short_ad_t) * ad_num;
-	    if (ad_offset > uint32_from_le(p_udf_fe->i_alloc_descs)) {
-	      cdio_warn("File offset out of bounds");
-	      return CDIO_INVALID_LBA;
-	    }
-	    p_icb = (udf_short_ad_t *) 
-	      GETICB( uint32_from_le(p_udf_fe->i_extended_attr) 
-		      + ad_offset );
-	    icblen = p_icb->len;
-	    ad_num++;
-	  } while(i_offset >= icblen);
-	  
-	  lsector = (i_offset / UDF_BLOCKSIZE) + p_icb->pos;
-	  
-	  *pi_max_size = p_icb->len;
-	}
-	break;
-      case ICBTAG_FLAG_AD_LONG: 
-	{
-	  /*
-	   * The allocation descriptor field is filled with long_ad's
-	   * If the i_offset is beyond the current extent, look for the
-	   * next extent.
-	   */
-	  udf_long_ad_t *p_icb;
-	  do {
-	    i_offset -= icblen;
-	    ad_offset = sizeof(udf_long_ad_t) * ad_num;
-	    if (ad_offset > uint32_from_le(p_udf_fe->i_alloc_descs)) {
-	      cdio_warn("File offset out of bounds");
-	      return CDIO_INVALID_LBA;
-	    }
-	    p_icb = (udf_long_ad_t *) 
-	      GETICB( uint32_from_le(p_udf_fe->i_extended_attr)
-		      + ad_offset );
-	    icblen = p_icb->len;
-	    ad_num++;
-	  } while(i_offset >= icblen);
-	
-	  lsector = (i_offset / UDF_BLOCKSIZE) +
-	    uint32_from_le(((udf_long_ad_t *)(p_icb))->loc.lba);
-	  
-	  *pi_max_size = p_icb->len;
-	}
+  case ICBTAG_FLAG_AD_LONG:
+    i_ad_size = sizeof(udf_long_ad_t);
+    break;
+  case ICBTAG_FLAG_AD_EXTENDED:
+    i_ad_size = sizeof(udf_ext_ad_t);
+    break;
+  case ICBTAG_FLAG_AD_IN_ICB:
+    /*
+     * This type means that the file *data* is stored in the
+     * allocation descriptor field of the file entry, so there are
+     * no extents; see udf_fe_in_icb().
+     */
+    cdio_warn("File data is in the file entry, not in extents");
+    return false;
+  default:
+    cdio_warn("Unsupported allocation descriptor %d", addr_ilk);
+    return false;
+  }
+
+  if (i_ext_attr > sizeof(p_udf_fe->u)
+      || i_ads > sizeof(p_udf_fe->u) - i_ext_attr) {
+    cdio_warn("Allocation descriptors overrun the file entry");
+    return false;
+  }
+
+  i_alloc = i_ads / i_ad_size + 1;
+  *pp_extents = calloc(i_alloc, sizeof(udf_extent_t));
+  if (!*pp_extents) {
+    cdio_warn("Couldn't calloc(%u, %lu)", i_alloc,
+	      (unsigned long) sizeof(udf_extent_t));
+    return false;
+  }
+  *pi_extents = 0;
+
+  for (;;) {
+    const struct allocExtDesc *p_aed = (struct allocExtDesc *) aed;
+    bool b_next = false;
+    uint32_t i_len = 0, i_lba = 0;
+    uint16_t i_ad_part = i_part;
+    uint32_t i;
+
+    for (i = 0; i + i_ad_size <= i_ads; i += i_ad_size) {
+      uint32_t i_type;
+
+      decode_ad(p_ads + i, addr_ilk, i_part, &i_len, &i_ad_part, &i_lba);
+      i_type = i_len & ~UDF_LENGTH_MASK;
+      i_len &= UDF_LENGTH_MASK;
+      if (0 == i_len)
+	break; /* no more allocation descriptors */
+      if (EXT_NEXT_EXTENT_ALLOCDECS == i_type) {
+	b_next = true;
 	break;
-      case ICBTAG_FLAG_AD_IN_ICB:
-	/*
-	 * This type means that the file *data* is stored in the
-	 * allocation descriptor field of the file entry.
-	 */
-	*pi_max_size = 0;
-	cdio_warn("Don't know how to data in ICB handle yet");
-	return CDIO_INVALID_LBA;
-      case ICBTAG_FLAG_AD_EXTENDED:
-	cdio_warn("Don't know how to handle extended addresses yet");
-	return CDIO_INVALID_LBA;
-      default:
-	cdio_warn("Unsupported allocation descriptor %d", addr_ilk);
-	return CDIO_INVALID_LBA;
       }
+      if (!add_extent(pp_extents, pi_extents, &i_alloc, i_offset, i_ad_part,
+		      i_lba, i_len, EXT_RECORDED_ALLOCATED == i_type))
+	goto error;
+      i_offset += i_len;
+    }
+    if (!b_next)
+      return true;
 
-      *pi_lba = (lba_t)lsector + p_udf->i_part_start;
-      if (*pi_lba < 0) {
-	cdio_warn("Negative LBA value");
-	return CDIO_INVALID_LBA;
-      }
-      return *pi_lba;
+    /* The rest of the descriptors are in an allocation extent
+       descriptor at i_lba. */
+
+    if (++i_chain > UDF_MAX_AED_CHAIN) {
+      cdio_warn("Allocation extent descriptors loop");
+      goto error;
     }
-  default:
-    cdio_warn("Unknown strategy type %d", strat_type);
-    return DRIVER_OP_ERROR;
+    if (DRIVER_OP_SUCCESS !=
+	udf_read_part_sectors(p_udf, aed, i_ad_part, i_lba, 1))
+      goto error;
+    if (udf_checktag(&p_aed->tag, TAGID_AED)) {
+      cdio_warn("No allocation extent descriptor at block %u", i_lba);
+      goto error;
+    }
+    i_ads = uint32_from_le(p_aed->i_alloc_descs);
+    if (i_ads > UDF_BLOCKSIZE - sizeof(struct allocExtDesc)) {
+      cdio_warn("Allocation extent descriptor at block %u is too long",
+		i_lba);
+      goto error;
+    }
+    p_ads = aed + sizeof(struct allocExtDesc);
   }
+
+ error:
+  free(*pp_extents);
+  *pp_extents = NULL;
+  *pi_extents = 0;
+  return false;
+}
+
+/*
+ * Return the extent of p_extents holding file offset i_offset, or
+ * NULL if there is none.
+ */
+const udf_extent_t *
+udf_extent_at(const udf_extent_t *p_extents, unsigned int i_extents,
+	      uint64_t i_offset)
+{
+  unsigned int i_lo = 0, i_hi = i_extents;
+
+  /* Find the first extent starting after i_offset. */
+  while (i_lo < i_hi) {
+    unsigned int i_mid = i_lo + (i_hi - i_lo) / 2;
+    if (p_extents[i_mid].i_offset <= i_offset)
+      i_lo = i_mid + 1;
+    else
+      i_hi = i_mid;
+  }
+
+  if (i_lo > 0) {
+    const udf_extent_t *p_extent = &p_extents[i_lo - 1];
+    if (i_offset - p_extent->i_offset < p_extent->i_len)
+      return p_extent;
+  }
+  return NULL;
+}
+
+/*
+ * Find the extent holding byte i_offset of a file, decoding the
+ * extent map first if that hasn't been done yet.
+ */
+static const udf_extent_t *
+find_extent(const udf_dirent_t *p_udf_dirent, uint64_t i_offset)
+{
+  /* The extent map is a cache of what the file entry says, so it is
+     filled in even though the directory entry is const. */
+  udf_dirent_t *p_cache = (udf_dirent_t *) p_udf_dirent;
+  const udf_extent_t *p_extent;
+
+  if (!p_cache->p_extents
+      && !(udf_dirent_load_fe(p_cache)
+	   && udf_build_extents(p_cache->p_udf, &p_cache->fe,
+				p_cache->i_fe_part, &p_cache->p_extents,
+				&p_cache->i_extents)))
+    return NULL;
+
+  p_extent = udf_extent_at(p_cache->p_extents, p_cache->i_extents, i_offset);
+  if (!p_extent)
+    cdio_warn("File offset out of bounds");
+  return p_extent;
 }
 
 /**
@@ -240,28 +428,168 @@ udf_read_block(const udf_dirent_t *p_udf_dirent, void * buf, size_t count)
 {
   if (count == 0) return 0;
   else {
-    driver_return_code_t ret;
-    uint32_t i_max_size=0;
+    /* The file position belongs to the directory entry, which is
+       const only so that it can be passed around as such. */
+    udf_dirent_t *p_file = (udf_dirent_t *) p_udf_dirent;
     udf_t *p_udf = p_udf_dirent->p_udf;
-    lba_t i_lba = offset_to_lba(p_udf_dirent, p_udf->i_position, &i_lba, 
-				&i_max_size);
-    if (i_lba != CDIO_INVALID_LBA) {
-      uint32_t i_max_blocks = CEILING(i_max_size, UDF_BLOCKSIZE);
-      if ( i_max_blocks < count ) {
-	  cdio_warn("read count %u is larger than %u extent size.",
-		  (unsigned int)count, i_max_blocks);
-	  cdio_warn("read count truncated to %u", (unsigned int)count);
-	  count = i_max_blocks;
-      }
-      ret = udf_read_sectors(p_udf, buf, i_lba, count);
-      if (DRIVER_OP_SUCCESS == ret) {
-	ssize_t i_read_len = MIN(i_max_size, count * UDF_BLOCKSIZE);
-	p_udf->i_position += i_read_len;
-	return i_read_len;
+    const udf_extent_t *p_extent;
+    const uint8_t *p_data;
+    uint32_t i_data_len;
+    uint64_t i_skip, i_max_size, i_max_blocks;
+
+    if (!udf_dirent_load_fe(p_udf_dirent))
+      return DRIVER_OP_ERROR;
+
+    if (udf_fe_in_icb(&p_udf_dirent->fe, &p_data, &i_data_len)) {
+      /* The data has been read already, with the file entry. */
+      size_t i_copy;
+
+      if (!p_data || p_file->i_position >= i_data_len) {
+	cdio_warn("File offset out of bounds");
+	return DRIVER_OP_ERROR;
       }
-      return ret;
-    } else {
+      i_copy = i_data_len - p_file->i_position;
+      if (i_copy > count * UDF_BLOCKSIZE)
+	i_copy = count * UDF_BLOCKSIZE;
+      memcpy(buf, p_data + p_file->i_position, i_copy);
+      memset((uint8_t *) buf + i_copy, 0,
+	     CEILING(i_copy, UDF_BLOCKSIZE) * UDF_BLOCKSIZE - i_copy);
+      p_file->i_position += i_copy;
+      return i_copy;
+    }
+
+    p_extent = find_extent(p_udf_dirent, p_file->i_position);
+    if (!p_extent)
       return DRIVER_OP_ERROR;
+
+    i_skip = p_file->i_position - p_extent->i_offset;
+    i_max_size = p_extent->i_len - i_skip;
+    i_max_blocks = CEILING(i_max_size, UDF_BLOCKSIZE);
+    if ( i_max_blocks < count ) {
+      cdio_warn("read count %u is larger than %u extent size.",
+		(unsigned int)count, (unsigned int)i_max_blocks);
+      count = i_max_blocks;
+      cdio_warn("read count truncated to %u", (unsigned int)count);
+    }
+
+    if (p_extent->b_recorded) {
+      driver_return_code_t ret =
+	udf_read_part_sectors(p_udf, buf, p_extent->i_part,
+			      p_extent->i_lba
+			      + (uint32_t) (i_skip / UDF_BLOCKSIZE), count);
+
+      if (DRIVER_OP_SUCCESS != ret)
+	return ret;
+    } else {
+      memset(buf, 0, count * UDF_BLOCKSIZE);
+    }
+
+    {
+      ssize_t i_read_len = MIN(i_max_size, count * UDF_BLOCKSIZE);
+      p_file->i_position += i_read_len;
+      return i_read_len;
     }
   }
 }
+
+/*!
+  Read i_len bytes at byte i_offset of a file. The range is split at
+  the extents it crosses; within an extent the whole blocks are read
+  with a single udf_read_part_sectors() straight into p_buf and only a
+  partial first and last block are bounced.
+*/
+ssize_t
+udf_pread(const udf_dirent_t *p_udf_dirent, void *p_buf, size_t i_len,
+	  uint64_t i_offset)
+{
+  udf_t *p_udf;
+  uint8_t *p_out = p_buf;
+  uint8_t bounce[UDF_BLOCKSIZE];
+  const uint8_t *p_data;
+  uint32_t i_data_len;
+  uint64_t i_file_len;
+  size_t i_done = 0;
+
+  if (!p_udf_dirent || (!p_buf && i_len)) return -1;
+  if (!udf_dirent_load_fe(p_udf_dirent)) return -1;
+  p_udf = p_udf_dirent->p_udf;
+  i_file_len = uint64_from_le(p_udf_dirent->fe.info_len);
+  if (0 == i_len || i_offset >= i_file_len) return 0;
+
+  if (i_len > i_file_len - i_offset)
+    i_len = (size_t) (i_file_len - i_offset);
+  if (i_len > (size_t) (((size_t) -1) >> 1))
+    i_len = ((size_t) -1) >> 1; /* keep the count representable */
+
+  if (udf_fe_in_icb(&p_udf_dirent->fe, &p_data, &i_data_len)) {
+    /* The data has been read already, with the file entry. */
+    if (!p_data) return -1;
+    if (i_offset >= i_data_len) return 0;
+    if (i_len > i_data_len - i_offset)
+      i_len = (size_t) (i_data_len - i_offset);
+    memcpy(p_buf, p_data + i_offset, i_len);
+    return (ssize_t) i_len;
+  }
+
+  while (i_done < i_len) {
+    const uint64_t i_pos = i_offset + i_done;
+    const udf_extent_t *p_extent = find_extent(p_udf_dirent, i_pos);
+    uint64_t i_skip, i_run;
+    uint32_t i_lba;
+    size_t i_head;
+
+    if (!p_extent) return -1;
+    i_skip = i_pos - p_extent->i_offset;
+    i_run = p_extent->i_len - i_skip;
+    if (i_run > i_len - i_done)
+      i_run = i_len - i_done;
+
+    if (!p_extent->b_recorded) {
+      memset(p_out + i_done, 0, (size_t) i_run);
+      i_done += (size_t) i_run;
+      continue;
+    }
+
+    i_lba  = p_extent->i_lba + (uint32_t) (i_skip / UDF_BLOCKSIZE);
+    i_head = (size_t) (i_skip % UDF_BLOCKSIZE);
+
+    /* Partial first block, or a range within a single block. */
+    if (i_head || i_run < UDF_BLOCKSIZE) {
+      size_t i_part = UDF_BLOCKSIZE - i_head;
+
+      if (i_part > i_run) i_part = (size_t) i_run;
+      if (DRIVER_OP_SUCCESS != udf_read_part_sectors(p_udf, bounce,
+						     p_extent->i_part, i_lba, 1))
+	return -1;
+      memcpy(p_out + i_done, bounce + i_head, i_part);
+      i_done += i_part;
+      i_run  -= i_part;
+      i_lba++;
+    }
+
+    /* Whole blocks, straight into the caller's buffer. */
+    while (i_run >= UDF_BLOCKSIZE) {
+      long int i_blocks = (i_run / UDF_BLOCKSIZE > LONG_MAX / UDF_BLOCKSIZE)
+	? LONG_MAX / UDF_BLOCKSIZE : (long int) (i_run / UDF_BLOCKSIZE);
+
+      if (DRIVER_OP_SUCCESS
+	  != udf_read_part_sectors(p_udf, p_out + i_done, p_extent->i_part,
+				   i_lba, i_blocks))
+	return -1;
+      i_done += (size_t) i_blocks * UDF_BLOCKSIZE;
+      i_run  -= (uint64_t) i_blocks * UDF_BLOCKSIZE;
+      i_lba  += i_blocks;
+    }
+
+    /* Partial last block. */
+    if (i_run > 0) {
+      if (DRIVER_OP_SUCCESS != udf_read_part_sectors(p_udf, bounce,
+						     p_extent->i_part, i_lba, 1))
+	return -1;
+      memcpy(p_out + i_done, bounce, (size_t) i_run);
+      i_done += (size_t) i_run;
+    }
+  }
+
+  return (ssize_t) i_len;
+}
@@ -61,6 +61,10 @@
 # include <stdlib.h>
 #endif
 
+#ifdef HAVE_LIMITS_H
+# include <limits.h>
+#endif
+
 /* These definitions are also to make debugging easy. Note that they
    have to come *before* #include <cdio/ecma_167.h> which sets
    #defines for these.
@@ -78,6 +82,7 @@ const char VSD_STD_ID_TEA01[] = {'T', 'E', 'A', '0', '1'};
 
 #include "udf_private.h"
 #include "udf_fs.h"
+#include "_cdio_workpool.h"
 #include "cdio_assert.h"
 
 /*
@@ -125,7 +130,8 @@ const char VSD_STD_ID_TEA01[] = {'T', 'E', 'A', '0', '1'};
 
 static udf_dirent_t *
 udf_new_dirent(udf_file_entry_t *p_udf_fe, udf_t *p_udf,
-	       const char *psz_name, bool b_dir, bool b_parent);
+	       const char *psz_name, bool b_dir, bool b_parent,
+	       uint16_t i_fe_part, uint32_t i_fe_lba);
 
 /**
  * Check the descriptor tag for both the correct id and correct checksum.
@@ -157,6 +163,60 @@ udf_checktag(const udf_tag_t *p_tag, udf_Uint16_t tag_id)
   return -1;
 }
 
+/**
+ * Check that p_udf_fe holds a File Entry or an Extended File Entry,
+ * as UDF 2.50 and later record them, and turn the latter into the
+ * former. Return zero if all is good, -1 if not.
+ */
+int
+udf_checkfe(udf_file_entry_t *p_udf_fe)
+{
+  struct extended_file_entry efe;
+  uint32_t i_ext_attr, i_ads;
+
+  if (!udf_checktag(&p_udf_fe->tag, TAGID_FILE_ENTRY))
+    return 0;
+  if (udf_checktag(&p_udf_fe->tag, TAGID_EFE))
+    return -1;
+
+  memcpy(&efe, p_udf_fe, sizeof(efe));
+  i_ext_attr = uint32_from_le(efe.length_extended_attr);
+  i_ads = uint32_from_le(efe.length_alloc_descs);
+  if (i_ext_attr > sizeof(efe.u) || i_ads > sizeof(efe.u) - i_ext_attr)
+    return -1;
+
+  /* The object size, creation time and stream directory have no place
+     in a File Entry, and aren't used. */
+  memset(p_udf_fe, 0, sizeof(udf_file_entry_t));
+  p_udf_fe->tag               = efe.tag;
+  p_udf_fe->icb_tag           = efe.icb_tag;
+  p_udf_fe->uid               = efe.uid;
+  p_udf_fe->gid               = efe.gid;
+  p_udf_fe->permissions       = efe.permissions;
+  p_udf_fe->link_count        = efe.link_count;
+  p_udf_fe->rec_format        = efe.rec_format;
+  p_udf_fe->rec_disp_attr     = efe.rec_display_attr;
+  p_udf_fe->rec_len           = efe.record_len;
+  p_udf_fe->info_len          = efe.info_len;
+  p_udf_fe->logblks_recorded  = efe.logblks_recorded;
+  p_udf_fe->access_time       = efe.access_time;
+  p_udf_fe->modification_time = efe.modification_time;
+  p_udf_fe->attribute_time    = efe.attribute_time;
+  p_udf_fe->checkpoint        = efe.checkpoint;
+  p_udf_fe->ext_attr_ICB      = efe.ext_attr_ICB;
+  p_udf_fe->imp_id            = efe.imp_id;
+  p_udf_fe->unique_ID         = efe.unique_ID;
+  p_udf_fe->i_extended_attr   = efe.length_extended_attr;
+  p_udf_fe->i_alloc_descs     = efe.length_alloc_descs;
+  memcpy(p_udf_fe->u.ext_attr, efe.u.ext_attr, i_ext_attr + i_ads);
+
+  /* Both identifiers have the same high byte, so the checksum only
+     changes by the difference of the low ones. */
+  p_udf_fe->tag.id = uint16_to_le(TAGID_FILE_ENTRY);
+  p_udf_fe->tag.cksum -= TAGID_EFE - TAGID_FILE_ENTRY;
+  return 0;
+}
+
 bool
 udf_get_lba(const udf_file_entry_t *p_udf_fe,
 	    /*out*/ uint32_t *start, /*out*/ uint32_t *end)
@@ -208,71 +268,301 @@ udf_get_lba(const udf_file_entry_t *p_udf_fe,
 
 #define udf_PATH_DELIMITERS "/\\"
 
-/* Searches p_udf_dirent for a directory entry called psz_token.
-   Note that p_udf_dirent may be replaced or freed during this call
-   and only the returned udf_dirent_t must be used afterwards.
-*/
-static
-udf_dirent_t *
-udf_ff_traverse(udf_dirent_t *p_udf_dirent, char *psz_token)
+static uint32_t
+udf_name_hash(const char *psz_name)
 {
-  while ((p_udf_dirent = udf_readdir(p_udf_dirent))) {
-    if (strcmp(psz_token, p_udf_dirent->psz_name) == 0) {
-      char *next_tok = strtok(NULL, udf_PATH_DELIMITERS);
+  uint32_t i_hash = 2166136261U; /* FNV-1a */
 
-      if (!next_tok)
-	return p_udf_dirent; /* found */
-      else if (p_udf_dirent->b_dir) {
-	udf_dirent_t * p_udf_dirent_next = udf_opendir(p_udf_dirent);
+  while (*psz_name) {
+    i_hash ^= (uint8_t) *psz_name++;
+    i_hash *= 16777619U;
+  }
+  return i_hash;
+}
 
-	if (p_udf_dirent_next) {
-	  /* free p_udf_dirent to avoid leaking memory. */
-	  udf_dirent_free(p_udf_dirent);
+static void
+udf_dir_cache_free(udf_dir_cache_t *p_dir)
+{
+  unsigned int i;
 
-	  /* previous p_udf_dirent_next is freed by udf_ff_traverse. */
-	  p_udf_dirent_next = udf_ff_traverse(p_udf_dirent_next, next_tok);
+  for (i = 0; i < p_dir->i_entries; i++) {
+    free(p_dir->p_entries[i].psz_name);
+    free(p_dir->p_entries[i].p_fid);
+  }
+  free(p_dir->p_entries);
+  free(p_dir->pi_buckets);
+  free(p_dir);
+}
 
-	  return p_udf_dirent_next;
-	}
+/* Read the directory whose file entry is p_udf_fe, at block i_fe_lba
+   of partition i_fe_part, into a table of its entries hashed by
+   name. */
+static udf_dir_cache_t *
+udf_dir_cache_read(udf_t *p_udf, uint16_t i_fe_part, uint32_t i_fe_lba,
+		   udf_file_entry_t *p_udf_fe)
+{
+  udf_dir_cache_t *p_dir = calloc(1, sizeof(udf_dir_cache_t));
+  udf_dirent_t *p_udf_dirent;
+  unsigned int i, i_alloc = 0;
+
+  if (!p_dir) return NULL;
+  p_dir->i_fe_part = i_fe_part;
+  p_dir->i_fe_lba  = i_fe_lba;
+
+  p_udf_dirent = udf_new_dirent(p_udf_fe, p_udf, "", true, true,
+				i_fe_part, i_fe_lba);
+  if (!p_udf_dirent) goto error;
+
+  while ((p_udf_dirent = udf_readdir(p_udf_dirent))) {
+    const udf_fileid_desc_t *p_fid = p_udf_dirent->fid;
+    const uint8_t *p_end = p_udf_dirent->sector
+      + UDF_BLOCKSIZE * (p_udf_dirent->i_loc_end - p_udf_dirent->i_loc + 1);
+    udf_dir_entry_t *p_entry;
+    uint32_t i_fid_len = 4 *
+      ((sizeof(*p_fid) + p_fid->u.i_imp_use + p_fid->i_file_id + 3) / 4);
+
+    if (i_fid_len > (uint32_t) (p_end - (const uint8_t *) p_fid))
+      i_fid_len = p_end - (const uint8_t *) p_fid;
+
+    if (p_dir->i_entries == i_alloc) {
+      unsigned int i_new = i_alloc ? 2 * i_alloc : 16;
+      udf_dir_entry_t *p_entries =
+	realloc(p_dir->p_entries, i_new * sizeof(udf_dir_entry_t));
+
+      if (!p_entries) {
+	udf_dirent_free(p_udf_dirent);
+	goto error;
       }
+      p_dir->p_entries = p_entries;
+      i_alloc = i_new;
+    }
+    p_entry = &p_dir->p_entries[p_dir->i_entries++];
+    memset(p_entry, 0, sizeof(udf_dir_entry_t));
+    p_entry->psz_name  = strdup(p_udf_dirent->psz_name);
+    p_entry->i_hash    = udf_name_hash(p_udf_dirent->psz_name);
+    p_entry->b_dir     = p_udf_dirent->b_dir;
+    p_entry->b_parent  = p_udf_dirent->b_parent;
+    p_entry->i_fe_part = p_udf_dirent->i_fe_part;
+    p_entry->i_fe_lba  = p_udf_dirent->i_fe_lba;
+    p_entry->p_fid     = malloc(i_fid_len);
+    p_entry->i_fid_len = i_fid_len;
+    if (!p_entry->psz_name || !p_entry->p_fid) {
+      udf_dirent_free(p_udf_dirent);
+      goto error;
     }
+    memcpy(p_entry->p_fid, p_fid, i_fid_len);
+  }
+
+  for (p_dir->i_buckets = 8; p_dir->i_buckets < p_dir->i_entries; )
+    p_dir->i_buckets *= 2;
+  p_dir->pi_buckets = calloc(p_dir->i_buckets, sizeof(unsigned int));
+  if (!p_dir->pi_buckets) goto error;
+  /* Backwards, so that the chains keep entries in on-disc order and
+     the first of several entries with the same name is found. */
+  for (i = p_dir->i_entries; i > 0; i--) {
+    udf_dir_entry_t *p_entry = &p_dir->p_entries[i-1];
+    unsigned int *p_bucket =
+      &p_dir->pi_buckets[p_entry->i_hash & (p_dir->i_buckets - 1)];
+
+    p_entry->i_next = *p_bucket;
+    *p_bucket = i;
+  }
+  return p_dir;
+
+ error:
+  cdio_warn("Couldn't read directory at block %u", i_fe_lba);
+  udf_dir_cache_free(p_dir);
+  return NULL;
+}
+
+/* The cached entries of the directory at block i_fe_lba of partition
+   i_fe_part, read from p_udf_fe, or from the disc if that is NULL, the
+   first time. */
+static const udf_dir_cache_t *
+udf_dir_cache_get(udf_t *p_udf, uint16_t i_fe_part, uint32_t i_fe_lba,
+		  const udf_file_entry_t *p_udf_fe)
+{
+  udf_dir_cache_t **pp_bucket =
+    &p_udf->ap_dir_cache[i_fe_lba % UDF_DIR_CACHE_BUCKETS];
+  udf_dir_cache_t *p_dir;
+  udf_file_entry_t udf_fe;
+
+  for (p_dir = *pp_bucket; p_dir; p_dir = p_dir->p_next)
+    if (p_dir->i_fe_lba == i_fe_lba && p_dir->i_fe_part == i_fe_part)
+      return p_dir;
+
+  if (p_udf_fe)
+    memcpy(&udf_fe, p_udf_fe, sizeof(udf_file_entry_t));
+  else if (DRIVER_OP_SUCCESS !=
+	   udf_read_part_sectors(p_udf, &udf_fe, i_fe_part, i_fe_lba, 1)
+	   || udf_checkfe(&udf_fe))
+    return NULL;
+
+  p_dir = udf_dir_cache_read(p_udf, i_fe_part, i_fe_lba, &udf_fe);
+  if (!p_dir) return NULL;
+  p_dir->p_next = *pp_bucket;
+  *pp_bucket = p_dir;
+  return p_dir;
+}
+
+/* The first entry of p_dir called psz_name, and a directory if
+   b_want_dir. Return its index, or -1 if there is none. */
+static int
+udf_dir_cache_find(const udf_dir_cache_t *p_dir, const char *psz_name,
+		   bool b_want_dir)
+{
+  const uint32_t i_hash = udf_name_hash(psz_name);
+  unsigned int i = p_dir->pi_buckets[i_hash & (p_dir->i_buckets - 1)];
+
+  for (; i; i = p_dir->p_entries[i-1].i_next) {
+    const udf_dir_entry_t *p_entry = &p_dir->p_entries[i-1];
+
+    if (p_entry->i_hash == i_hash && 0 == strcmp(p_entry->psz_name, psz_name)
+	&& (!b_want_dir || (p_entry->b_dir && !p_entry->b_parent)))
+      return i-1;
   }
+  return -1;
+}
 
+/* A directory entry for entry i_entry of p_dir, as udf_readdir()
+   would have returned it, except that it is the last one. */
+static udf_dirent_t *
+udf_dir_cache_dirent(udf_t *p_udf, const udf_dir_cache_t *p_dir,
+		     unsigned int i_entry)
+{
+  const udf_dir_entry_t *p_entry = &p_dir->p_entries[i_entry];
+  udf_dirent_t *p_udf_dirent = calloc(1, sizeof(udf_dirent_t));
+
+  if (!p_udf_dirent) return NULL;
+  p_udf_dirent->psz_name     = strdup(p_entry->psz_name);
+  /* at least a whole udf_fileid_desc_t, for udf_get_fileid_descriptor() */
+  p_udf_dirent->sector       =
+    calloc(1, p_entry->i_fid_len < sizeof(udf_fileid_desc_t)
+	   ? sizeof(udf_fileid_desc_t) : p_entry->i_fid_len);
+  if (!p_udf_dirent->psz_name || !p_udf_dirent->sector) {
+    udf_dirent_free(p_udf_dirent);
+    return NULL;
+  }
+  memcpy(p_udf_dirent->sector, p_entry->p_fid, p_entry->i_fid_len);
+  p_udf_dirent->fid          = (udf_fileid_desc_t *) p_udf_dirent->sector;
+  p_udf_dirent->b_dir        = p_entry->b_dir;
+  p_udf_dirent->b_parent     = p_entry->b_parent;
+  p_udf_dirent->p_udf        = p_udf;
+  p_udf_dirent->i_part_start = p_udf->i_part_start;
+  p_udf_dirent->i_fe_part    = p_entry->i_fe_part;
+  p_udf_dirent->i_fe_lba     = p_entry->i_fe_lba;
+  return p_udf_dirent;
+}
+
+/* Remember that psz_path from the directory at block i_root_lba of
+   partition i_root_part is entry i_entry of p_dir. */
+static void
+udf_path_cache_add(udf_t *p_udf, uint16_t i_root_part, uint32_t i_root_lba,
+		   const char *psz_path, const udf_dir_cache_t *p_dir,
+		   unsigned int i_entry)
+{
+  udf_path_cache_t *p_slot = &p_udf->path_cache[0];
+  unsigned int i;
+
+  for (i = 1; i < UDF_PATH_CACHE_SIZE && p_slot->psz_path; i++)
+    if (!p_udf->path_cache[i].psz_path
+	|| p_udf->path_cache[i].i_used < p_slot->i_used)
+      p_slot = &p_udf->path_cache[i];
+
+  free(p_slot->psz_path);
+  p_slot->psz_path    = strdup(psz_path);
+  p_slot->i_root_part = i_root_part;
+  p_slot->i_root_lba  = i_root_lba;
+  p_slot->p_dir       = p_dir;
+  p_slot->i_entry     = i_entry;
+  p_slot->i_used      = ++p_udf->i_path_clock;
+}
+
+static udf_path_cache_t *
+udf_path_cache_find(udf_t *p_udf, uint16_t i_root_part, uint32_t i_root_lba,
+		    const char *psz_path)
+{
+  unsigned int i;
+
+  for (i = 0; i < UDF_PATH_CACHE_SIZE; i++) {
+    udf_path_cache_t *p_slot = &p_udf->path_cache[i];
+
+    if (p_slot->psz_path && p_slot->i_root_lba == i_root_lba
+	&& p_slot->i_root_part == i_root_part
+	&& 0 == strcmp(p_slot->psz_path, psz_path)) {
+      p_slot->i_used = ++p_udf->i_path_clock;
+      return p_slot;
+    }
+  }
   return NULL;
 }
 
 /* FIXME! */
 #define udf_MAX_PATHLEN 2048
 
+/*!
+  Return a file pointer matching psz_name, a path relative to the
+  directory p_udf_root.
+
+  Directories are read once per udf_t into tables of their entries
+  hashed by name, and the last paths looked up are remembered, so
+  repeated lookups in the same directories don't read the disc.
+*/
 udf_dirent_t *
 udf_fopen(udf_dirent_t *p_udf_root, const char *psz_name)
 {
-  udf_dirent_t *p_udf_file = NULL;
+  udf_t *p_udf;
+  const udf_dir_cache_t *p_dir;
+  const udf_path_cache_t *p_cached;
+  char tokenline[udf_MAX_PATHLEN];
+  char *psz_token;
+  int i_entry = -1;
 
-  if (p_udf_root) {
-    char tokenline[udf_MAX_PATHLEN];
-    char *psz_token;
+  if (!p_udf_root || !psz_name || !udf_dirent_load_fe(p_udf_root))
+    return NULL;
+  p_udf = p_udf_root->p_udf;
 
-    /* file position must be reset when accessing a new file */
-    p_udf_root->p_udf->i_position = 0;
+  strncpy(tokenline, psz_name, udf_MAX_PATHLEN-1);
+  tokenline[udf_MAX_PATHLEN-1] = '\0';
+  psz_token = tokenline + strspn(tokenline, udf_PATH_DELIMITERS);
+  if (!*psz_token) {
+    if (0 != strncmp("/", psz_name, sizeof("/")))
+      return NULL;
+    return udf_new_dirent(&p_udf_root->fe, p_udf, p_udf_root->psz_name,
+			  p_udf_root->b_dir, p_udf_root->b_parent,
+			  p_udf_root->i_fe_part, p_udf_root->i_fe_lba);
+  }
 
-    strncpy(tokenline, psz_name, udf_MAX_PATHLEN-1);
-    tokenline[udf_MAX_PATHLEN-1] = '\0';
-    psz_token = strtok(tokenline, udf_PATH_DELIMITERS);
-    if (psz_token) {
-      udf_dirent_t *p_udf_dirent =
-	udf_new_dirent(&p_udf_root->fe, p_udf_root->p_udf,
-		       p_udf_root->psz_name, p_udf_root->b_dir,
-		       p_udf_root->b_parent);
-      p_udf_file = udf_ff_traverse(p_udf_dirent, psz_token);
-    }
-    else if ( 0 == strncmp("/", psz_name, sizeof("/")) ) {
-      return udf_new_dirent(&p_udf_root->fe, p_udf_root->p_udf,
-			    p_udf_root->psz_name, p_udf_root->b_dir,
-			    p_udf_root->b_parent);
-    }
+  p_cached = udf_path_cache_find(p_udf, p_udf_root->i_fe_part,
+				 p_udf_root->i_fe_lba, psz_name);
+  if (p_cached)
+    return udf_dir_cache_dirent(p_udf, p_cached->p_dir, p_cached->i_entry);
+
+  p_dir = udf_dir_cache_get(p_udf, p_udf_root->i_fe_part,
+			    p_udf_root->i_fe_lba, &p_udf_root->fe);
+  while (p_dir) {
+    size_t i_len = strcspn(psz_token, udf_PATH_DELIMITERS);
+    char *psz_next = psz_token + i_len;
+
+    psz_next += strspn(psz_next, udf_PATH_DELIMITERS);
+    psz_token[i_len] = '\0';
+
+    i_entry = udf_dir_cache_find(p_dir, psz_token, '\0' != *psz_next);
+    if (i_entry < 0)
+      return NULL;
+    if (!*psz_next)
+      break; /* found */
+
+    p_dir = udf_dir_cache_get(p_udf, p_dir->p_entries[i_entry].i_fe_part,
+			      p_dir->p_entries[i_entry].i_fe_lba, NULL);
+    psz_token = psz_next;
   }
-  return p_udf_file;
+  if (!p_dir)
+    return NULL;
+
+  udf_path_cache_add(p_udf, p_udf_root->i_fe_part, p_udf_root->i_fe_lba,
+		     psz_name, p_dir, i_entry);
+  return udf_dir_cache_dirent(p_udf, p_dir, i_entry);
 }
 
 /* Convert unicode16 to UTF-8.
@@ -284,7 +574,7 @@ unicode16_decode(const uint8_t *data, int i_len)
   int i;
   char* r = NULL;
 
-  switch (data[0])
+  switch (i_len > 0 ? data[0] : 0)
   {
   case 8:
     r = (char*)calloc(i_len, 1);
@@ -294,7 +584,10 @@ unicode16_decode(const uint8_t *data, int i_len)
       r[i] = data[i+1];
     return r;
   case 16:
-    cdio_charset_to_utf8((char*)&data[1], i_len-1, &r, "UCS-2BE");
+    r = (char*)malloc(CDIO_UTF16BE_TO_UTF8_SIZE(i_len-1));
+    if (r == NULL)
+      return r;
+    cdio_utf16be_to_utf8(&data[1], i_len-1, r);
     return r;
   default:
     /* Empty string, as some existing sections can't take a NULL pointer */
@@ -306,7 +599,8 @@ unicode16_decode(const uint8_t *data, int i_len)
 
 static udf_dirent_t *
 udf_new_dirent(udf_file_entry_t *p_udf_fe, udf_t *p_udf,
-	       const char *psz_name, bool b_dir, bool b_parent)
+	       const char *psz_name, bool b_dir, bool b_parent,
+	       uint16_t i_fe_part, uint32_t i_fe_lba)
 {
   udf_dirent_t *p_udf_dirent = (udf_dirent_t *)
     calloc(1, sizeof(udf_dirent_t));
@@ -318,6 +612,9 @@ udf_new_dirent(udf_file_entry_t *p_udf_fe, udf_t *p_udf,
   p_udf_dirent->p_udf        = p_udf;
   p_udf_dirent->i_part_start = p_udf->i_part_start;
   p_udf_dirent->dir_left     = uint64_from_le(p_udf_fe->info_len);
+  p_udf_dirent->b_fe         = true;
+  p_udf_dirent->i_fe_part    = i_fe_part;
+  p_udf_dirent->i_fe_lba     = i_fe_lba;
 
   memcpy(&(p_udf_dirent->fe), p_udf_fe,
 	 sizeof(udf_file_entry_t));
@@ -334,7 +631,6 @@ driver_return_code_t
 udf_read_sectors (const udf_t *p_udf, void *ptr, lsn_t i_start,
 		 long i_blocks)
 {
-  driver_return_code_t ret;
   long i_read;
   off_t i_byte_offset;
 
@@ -349,9 +645,9 @@ udf_read_sectors (const udf_t *p_udf, void *ptr, lsn_t i_start,
   }
 
   if (p_udf->b_stream) {
-    ret = cdio_stream_seek (p_udf->stream, i_byte_offset, SEEK_SET);
-    if (DRIVER_OP_SUCCESS != ret) return ret;
-    i_read = cdio_stream_read (p_udf->stream, ptr, UDF_BLOCKSIZE, i_blocks);
+    /* Positionless, so that several threads can read at once. */
+    i_read = cdio_stream_pread (p_udf->stream, ptr, UDF_BLOCKSIZE, i_blocks,
+				i_byte_offset);
     if (i_read) return DRIVER_OP_SUCCESS;
     return DRIVER_OP_ERROR;
   } else {
@@ -360,6 +656,384 @@ udf_read_sectors (const udf_t *p_udf, void *ptr, lsn_t i_start,
   }
 }
 
+/* Read i_blocks blocks from block i_lba on of a file whose extents are
+   p_extents, as many at once as are in the same extent. */
+static driver_return_code_t
+udf_read_extents(const udf_t *p_udf, uint8_t *p_out,
+		 const udf_extent_t *p_extents, unsigned int i_extents,
+		 uint32_t i_lba, long int i_blocks)
+{
+  while (i_blocks > 0) {
+    const uint64_t i_offset = (uint64_t) i_lba * UDF_BLOCKSIZE;
+    const udf_extent_t *p_extent =
+      udf_extent_at(p_extents, i_extents, i_offset);
+    uint64_t i_skip, i_left;
+    long int i_run;
+
+    if (!p_extent) {
+      cdio_warn("Block %u is past the end of the metadata file", i_lba);
+      return DRIVER_OP_ERROR;
+    }
+    i_skip = i_offset - p_extent->i_offset;
+    i_left = (p_extent->i_len - i_skip + UDF_BLOCKSIZE - 1) / UDF_BLOCKSIZE;
+    i_run  = (i_left < (uint64_t) i_blocks) ? (long int) i_left : i_blocks;
+
+    if (p_extent->b_recorded) {
+      driver_return_code_t i_ret =
+	udf_read_part_sectors(p_udf, p_out, p_extent->i_part,
+			      p_extent->i_lba
+			      + (uint32_t) (i_skip / UDF_BLOCKSIZE), i_run);
+      if (DRIVER_OP_SUCCESS != i_ret)
+	return i_ret;
+    } else
+      memset(p_out, 0, (size_t) i_run * UDF_BLOCKSIZE);
+
+    p_out    += (size_t) i_run * UDF_BLOCKSIZE;
+    i_lba    += (uint32_t) i_run;
+    i_blocks -= i_run;
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/*!
+  Read i_blocks blocks from block i_lba on of the partition with
+  partition reference number i_part. The blocks of a metadata
+  partition are those of its metadata file, which is read from memory
+  if it has been pinned there, or else from the disc, falling back on
+  its mirror.
+*/
+driver_return_code_t
+udf_read_part_sectors(const udf_t *p_udf, void *ptr, uint16_t i_part,
+		      uint32_t i_lba, long int i_blocks)
+{
+  const udf_part_map_t *p_map;
+  driver_return_code_t i_ret;
+
+  if (!p_udf) return DRIVER_OP_BAD_PARAMETER;
+
+  /* Without partition maps, there is just the partition picked by
+     udf_get_root(). */
+  if (0 == p_udf->i_part_maps)
+    return udf_read_sectors(p_udf, ptr, p_udf->i_part_start + i_lba,
+			    i_blocks);
+  if (i_part >= p_udf->i_part_maps) {
+    cdio_warn("There is no partition %u", i_part);
+    return DRIVER_OP_BAD_PARAMETER;
+  }
+
+  p_map = &p_udf->part_maps[i_part];
+  switch (p_map->type) {
+  case UDF_PART_PHYSICAL:
+    return udf_read_sectors(p_udf, ptr, p_map->i_start + i_lba, i_blocks);
+  case UDF_PART_METADATA:
+    break;
+  default:
+    cdio_warn("Partition %u can't be read", i_part);
+    return DRIVER_OP_UNSUPPORTED;
+  }
+
+  if (p_map->p_pinned) {
+    const uint64_t i_offset = (uint64_t) i_lba * UDF_BLOCKSIZE;
+    const uint64_t i_len = (uint64_t) i_blocks * UDF_BLOCKSIZE;
+
+    if (i_blocks < 0 || i_offset > p_map->i_pinned_len
+	|| i_len > p_map->i_pinned_len - i_offset) {
+      cdio_warn("Block %u is past the end of the metadata file", i_lba);
+      return DRIVER_OP_ERROR;
+    }
+    memcpy(ptr, p_map->p_pinned + i_offset, (size_t) i_len);
+    return DRIVER_OP_SUCCESS;
+  }
+
+  i_ret = udf_read_extents(p_udf, ptr, p_map->p_extents, p_map->i_extents,
+			   i_lba, i_blocks);
+  if (DRIVER_OP_SUCCESS != i_ret && p_map->p_mirror_extents)
+    i_ret = udf_read_extents(p_udf, ptr, p_map->p_mirror_extents,
+			     p_map->i_mirror_extents, i_lba, i_blocks);
+  return i_ret;
+}
+
+/* Read the extents of the metadata file, or of its mirror, whose file
+   entry is at block i_lba of the physical partition of p_map. They
+   must all be in that partition. */
+static bool
+udf_read_metadata_file(const udf_t *p_udf, const udf_part_map_t *p_map,
+		       uint32_t i_lba, /*out*/ udf_extent_t **pp_extents,
+		       /*out*/ unsigned int *pi_extents)
+{
+  udf_file_entry_t udf_fe;
+  unsigned int i;
+
+  if (DRIVER_OP_SUCCESS !=
+      udf_read_part_sectors(p_udf, &udf_fe, p_map->i_phys, i_lba, 1)
+      || udf_checkfe(&udf_fe)
+      || !udf_build_extents(p_udf, &udf_fe, p_map->i_phys, pp_extents,
+			    pi_extents))
+    return false;
+
+  for (i = 0; i < *pi_extents; i++)
+    if ((*pp_extents)[i].i_part != p_map->i_phys) {
+      free(*pp_extents);
+      *pp_extents = NULL;
+      *pi_extents = 0;
+      return false;
+    }
+  return true;
+}
+
+/* Work out from the partition maps of the Logical Volume Descriptor
+   where the partitions the volume refers to are. Metadata partitions
+   get the extent maps of their metadata file and its mirror. */
+static void
+udf_map_partitions(udf_t *p_udf)
+{
+  const udf_vds_t *p_vds = &p_udf->vds;
+  const uint8_t *p_map = p_vds->lvd.desc.partition_maps;
+  const uint8_t *p_end = p_vds->lvd.data + UDF_BLOCKSIZE;
+  const uint32_t i_maps = uint32_from_le(p_vds->lvd.desc.i_partition_maps);
+  const uint32_t i_table_len = uint32_from_le(p_vds->lvd.desc.maptable_len);
+  unsigned int i, j;
+
+  if (!p_vds->lvd_lba) return;
+  if (i_table_len < (uint32_t) (p_end - p_map))
+    p_end = p_map + i_table_len;
+
+  for (i = 0; i < i_maps && i < UDF_MAX_PARTITIONS; i++) {
+    const struct generic_partition_map *p_generic =
+      (const struct generic_partition_map *) p_map;
+    udf_part_map_t *p_part = &p_udf->part_maps[i];
+
+    if (p_end - p_map < 2 || p_generic->partition_map_length < 2
+	|| p_end - p_map < p_generic->partition_map_length) {
+      cdio_warn("Partition map %u is cut short", i);
+      break;
+    }
+
+    if (GP_PARTIITON_MAP_TYPE_1 == p_generic->partition_map_type
+	&& p_generic->partition_map_length >=
+	   sizeof(struct generic_partition_map1)) {
+      const struct generic_partition_map1 *p_map1 =
+	(const struct generic_partition_map1 *) p_map;
+
+      p_part->i_partition = uint16_from_le(p_map1->i_partition);
+      for (j = 0; j < p_vds->i_partitions; j++)
+	if (uint16_from_le(p_vds->partitions[j].number) == p_part->i_partition) {
+	  p_part->type = UDF_PART_PHYSICAL;
+	  p_part->i_start = uint32_from_le(p_vds->partitions[j].start_loc);
+	}
+    } else if (GP_PARTITION_MAP_TYPE_2 == p_generic->partition_map_type
+	       && p_generic->partition_map_length >=
+		  sizeof(struct metadata_partition_map)
+	       && 0 == memcmp(((const struct metadata_partition_map *) p_map)
+			      ->partition_type_id.id, UDF_ID_METADATA,
+			      strlen(UDF_ID_METADATA))) {
+      const struct metadata_partition_map *p_meta =
+	(const struct metadata_partition_map *) p_map;
+
+      /* Its extent maps are read once all physical partitions are
+	 known. */
+      p_part->type = UDF_PART_METADATA;
+      p_part->i_partition = uint16_from_le(p_meta->i_partition);
+    } else
+      cdio_warn("Partition map %u is of a kind that isn't supported", i);
+
+    p_map += p_generic->partition_map_length;
+  }
+  p_udf->i_part_maps = i;
+
+  for (i = 0, p_map = p_vds->lvd.desc.partition_maps;
+       i < p_udf->i_part_maps;
+       p_map += ((const struct generic_partition_map *) p_map)
+	 ->partition_map_length, i++) {
+    const struct metadata_partition_map *p_meta =
+      (const struct metadata_partition_map *) p_map;
+    udf_part_map_t *p_part = &p_udf->part_maps[i];
+    uint32_t i_file, i_mirror;
+    bool b_file, b_mirror = false;
+
+    /* Only a metadata map is long enough to have these. */
+    if (UDF_PART_METADATA != p_part->type) continue;
+    i_file = uint32_from_le(p_meta->metadata_file_loc);
+    i_mirror = uint32_from_le(p_meta->metadata_mirror_file_loc);
+
+    p_part->type = UDF_PART_NONE;
+    for (j = 0; j < p_udf->i_part_maps; j++)
+      if (UDF_PART_PHYSICAL == p_udf->part_maps[j].type
+	  && p_udf->part_maps[j].i_partition == p_part->i_partition)
+	break;
+    if (j == p_udf->i_part_maps) {
+      cdio_warn("Metadata partition %u is in no physical partition", i);
+      continue;
+    }
+    p_part->i_phys = j;
+
+    b_file = udf_read_metadata_file(p_udf, p_part, i_file,
+				    &p_part->p_extents, &p_part->i_extents);
+    if (i_mirror != i_file)
+      b_mirror = udf_read_metadata_file(p_udf, p_part, i_mirror,
+					&p_part->p_mirror_extents,
+					&p_part->i_mirror_extents);
+    if (!b_file && b_mirror) {
+      cdio_warn("Metadata file of partition %u is damaged; "
+		"using its mirror", i);
+      p_part->p_extents = p_part->p_mirror_extents;
+      p_part->i_extents = p_part->i_mirror_extents;
+      p_part->p_mirror_extents = NULL;
+      p_part->i_mirror_extents = 0;
+    } else if (!b_file) {
+      cdio_warn("Metadata file of partition %u can't be read", i);
+      continue;
+    }
+    p_part->type = UDF_PART_METADATA;
+  }
+}
+
+/*!
+  Read the whole metadata file of each metadata partition, as UDF 2.50
+  and later volumes have, into memory if it takes no more than
+  i_max_bytes. See udf.h for details.
+*/
+bool
+udf_pin_metadata(udf_t *p_udf, uint64_t i_max_bytes)
+{
+  bool b_any = false;
+  unsigned int i;
+
+  if (!p_udf) return false;
+  for (i = 0; i < p_udf->i_part_maps; i++) {
+    udf_part_map_t *p_map = &p_udf->part_maps[i];
+    const udf_extent_t *p_last;
+    uint64_t i_len;
+    uint8_t *p_buf;
+
+    if (UDF_PART_METADATA != p_map->type) continue;
+    b_any = true;
+    if (p_map->p_pinned) continue;
+    if (0 == p_map->i_extents) return false;
+
+    p_last = &p_map->p_extents[p_map->i_extents - 1];
+    i_len = p_last->i_offset + p_last->i_len;
+    i_len = (i_len + UDF_BLOCKSIZE - 1) / UDF_BLOCKSIZE * UDF_BLOCKSIZE;
+    if (i_len > i_max_bytes || i_len != (size_t) i_len
+	|| i_len / UDF_BLOCKSIZE > LONG_MAX)
+      return false;
+
+    p_buf = malloc((size_t) i_len);
+    if (!p_buf) {
+      cdio_warn("Couldn't malloc(%lu)", (unsigned long) i_len);
+      return false;
+    }
+    if (DRIVER_OP_SUCCESS !=
+	udf_read_part_sectors(p_udf, p_buf, (uint16_t) i, 0,
+			      (long int) (i_len / UDF_BLOCKSIZE))) {
+      free(p_buf);
+      return false;
+    }
+    p_map->p_pinned = p_buf;
+    p_map->i_pinned_len = i_len;
+  }
+  return b_any;
+}
+
+/* Keep in p_vds the descriptors of the Volume Descriptor Sequence in
+   p_ext that are used. Each extent of the sequence is read
+   UDF_VDS_MAX_BLOCKS blocks at a time until its end or a Terminating
+   Descriptor. Returns true if a Primary Volume Descriptor, a
+   Logical Volume Descriptor and a Partition Descriptor were found. */
+static bool
+udf_read_vds(const udf_t *p_udf, const udf_extent_ad_t *p_ext,
+	     /*out*/ udf_vds_t *p_vds)
+{
+  uint32_t i_loc = uint32_from_le(p_ext->loc);
+  uint32_t i_len = uint32_from_le(p_ext->len);
+  unsigned int i_extents;
+  uint8_t *p_buf;
+
+  memset(p_vds, 0, sizeof(udf_vds_t));
+  p_buf = (uint8_t *) malloc(UDF_VDS_MAX_BLOCKS * UDF_BLOCKSIZE);
+  if (!p_buf) return false;
+
+  for (i_extents = 0; i_len && i_extents < UDF_VDS_MAX_EXTENTS; i_extents++) {
+    uint32_t i_start = i_loc;
+    uint32_t i_left = (i_len - 1) / UDF_BLOCKSIZE + 1;
+
+    i_len = 0;
+    while (i_left) {
+      const uint32_t i_blocks = (i_left > UDF_VDS_MAX_BLOCKS)
+	? UDF_VDS_MAX_BLOCKS : i_left;
+      uint32_t i;
+
+      /* A short read must not leave the previous piece behind. */
+      memset(p_buf, 0, i_blocks * UDF_BLOCKSIZE);
+      if (DRIVER_OP_SUCCESS != udf_read_sectors(p_udf, p_buf, i_start,
+						i_blocks))
+	break;
+
+      i_left -= i_blocks;
+      for (i = 0; i < i_blocks; i++) {
+	const udf_tag_t *p_tag = (udf_tag_t *) (p_buf + i * UDF_BLOCKSIZE);
+
+	if (!udf_checktag(p_tag, TAGID_PRI_VOL)) {
+	  const udf_pvd_t *p_pvd = (const udf_pvd_t *) p_tag;
+
+	  if (!p_vds->pvd_lba
+	      || uint32_from_le(p_pvd->vol_desc_seq_num)
+		 >= uint32_from_le(p_vds->pvd.vol_desc_seq_num)) {
+	    memcpy(&p_vds->pvd, p_pvd, sizeof(udf_pvd_t));
+	    p_vds->pvd_lba = i_start + i;
+	  }
+	} else if (!udf_checktag(p_tag, TAGID_LOGVOL)) {
+	  const logical_vol_desc_t *p_logvol =
+	    (const logical_vol_desc_t *) p_tag;
+
+	  if (UDF_BLOCKSIZE == uint32_from_le(p_logvol->logical_blocksize)
+	      && (!p_vds->lvd_lba
+		  || uint32_from_le(p_logvol->seq_num)
+		     >= uint32_from_le(p_vds->lvd.desc.seq_num))) {
+	    memcpy(p_vds->lvd.data, p_logvol, UDF_BLOCKSIZE);
+	    p_vds->lvd_lba = i_start + i;
+	  }
+	} else if (!udf_checktag(p_tag, TAGID_PARTITION)) {
+	  const partition_desc_t *p_partition =
+	    (const partition_desc_t *) p_tag;
+	  unsigned int j;
+
+	  for (j = 0; j < p_vds->i_partitions; j++)
+	    if (p_vds->partitions[j].number == p_partition->number)
+	      break;
+	  if (j == p_vds->i_partitions) {
+	    if (j == UDF_MAX_PARTITIONS) {
+	      cdio_warn("More than %d partitions; ignoring the rest",
+			UDF_MAX_PARTITIONS);
+	      continue;
+	    }
+	    p_vds->i_partitions++;
+	  } else if (uint32_from_le(p_partition->vol_desc_seq_num)
+		     < uint32_from_le(p_vds->partitions[j].vol_desc_seq_num))
+	    continue;
+	  memcpy(&p_vds->partitions[j], p_partition, sizeof(partition_desc_t));
+	} else if (!udf_checktag(p_tag, TAGID_VOL)) {
+	  /* The sequence goes on elsewhere. */
+	  const struct vol_desc_ptr_s *p_vdp =
+	    (const struct vol_desc_ptr_s *) p_tag;
+
+	  i_loc = uint32_from_le(p_vdp->next_vol_desc_set_ext.loc);
+	  i_len = uint32_from_le(p_vdp->next_vol_desc_set_ext.len);
+	  i_left = 0;
+	  break;
+	} else if (!udf_checktag(p_tag, TAGID_TERM)) {
+	  i_left = 0;
+	  break;
+	}
+      }
+      i_start += i_blocks;
+    }
+  }
+
+  free(p_buf);
+  return p_vds->pvd_lba && p_vds->lvd_lba && p_vds->i_partitions;
+}
+
 /*!
   Open an UDF for reading. Maybe in the future we will have
   a mode. NULL is returned on error.
@@ -400,38 +1074,32 @@ udf_open (const char *psz_path)
     goto error;
 
   /*
-   * Then try to find a reference to a Primary Volume Descriptor.
+   * Then load the Main Volume Descriptor Sequence, or if that is
+   * damaged the Reserve one.
    */
   {
-    anchor_vol_desc_ptr_t *p_avdp = &p_udf->anchor_vol_desc_ptr;
-
-    const uint32_t mvds_start =
-      uint32_from_le(p_avdp->main_vol_desc_seq_ext.loc);
-    const uint32_t mvds_end   = mvds_start +
-      (uint32_from_le(p_avdp->main_vol_desc_seq_ext.len) - 1) / UDF_BLOCKSIZE;
-
-    uint32_t i_lba;
+    const anchor_vol_desc_ptr_t *p_avdp = &p_udf->anchor_vol_desc_ptr;
 
-    for (i_lba = mvds_start; i_lba < mvds_end; i_lba++) {
-      udf_pvd_t *p_pvd = (udf_pvd_t *) &data;
+    if (!udf_read_vds(p_udf, &p_avdp->main_vol_desc_seq_ext, &p_udf->vds)) {
+      udf_vds_t *p_reserve = (udf_vds_t *) malloc(sizeof(udf_vds_t));
 
-      if (DRIVER_OP_SUCCESS != udf_read_sectors (p_udf, p_pvd, i_lba, 1) )
+      if (!p_reserve)
 	goto error;
-
-      if (!udf_checktag(&p_pvd->tag, TAGID_PRI_VOL)) {
-	p_udf->pvd_lba = i_lba;
-	break;
-      }
-
+      if (udf_read_vds(p_udf, &p_avdp->reserve_vol_desc_seq_ext, p_reserve)
+	  || (!p_udf->vds.pvd_lba && p_reserve->pvd_lba))
+	memcpy(&p_udf->vds, p_reserve, sizeof(udf_vds_t));
+      free(p_reserve);
     }
 
     /*
-     * If we couldn't find a reference, bail out.
+     * If we couldn't find a Primary Volume Descriptor, bail out.
      */
-    if (i_lba == mvds_end)
+    if (!p_udf->vds.pvd_lba)
       goto error;
   }
 
+  udf_map_partitions(p_udf);
+
   return p_udf;
 
  error:
@@ -450,8 +1118,7 @@ udf_open (const char *psz_path)
 int
 udf_get_volume_id(udf_t *p_udf, /*out*/ char *psz_volid, unsigned int i_volid)
 {
-  uint8_t data[UDF_BLOCKSIZE];
-  const udf_pvd_t *p_pvd = (udf_pvd_t *) &data;
+  const udf_pvd_t *p_pvd = &p_udf->vds.pvd;
   char* r;
   unsigned int volid_len;
 
@@ -459,10 +1126,6 @@ udf_get_volume_id(udf_t *p_udf, /*out*/ char *psz_volid, unsigned int i_volid)
   if (psz_volid != NULL)
     psz_volid[0] = 0;
 
-  /* get primary volume descriptor */
-  if ( DRIVER_OP_SUCCESS != udf_read_sectors(p_udf, &data, p_udf->pvd_lba, 1) )
-    return 0;
-
   volid_len = p_pvd->vol_ident[UDF_VOLID_SIZE-1];
   if(volid_len > UDF_VOLID_SIZE-1) {
     /* this field is only UDF_VOLID_SIZE bytes something is wrong */
@@ -496,12 +1159,7 @@ int
 udf_get_volumeset_id(udf_t *p_udf, /*out*/ uint8_t *volsetid,
 		     unsigned int i_volsetid)
 {
-  uint8_t data[UDF_BLOCKSIZE];
-  const udf_pvd_t *p_pvd = (udf_pvd_t *) &data;
-
-  /* get primary volume descriptor */
-  if ( DRIVER_OP_SUCCESS != udf_read_sectors(p_udf, &data, p_udf->pvd_lba, 1) )
-    return 0;
+  const udf_pvd_t *p_pvd = &p_udf->vds.pvd;
 
   if (i_volsetid > UDF_VOLSET_ID_SIZE) {
     i_volsetid = UDF_VOLSET_ID_SIZE;
@@ -517,14 +1175,12 @@ udf_get_volumeset_id(udf_t *p_udf, /*out*/ uint8_t *volsetid,
  * psz_logvolid, place to put the string (should be at least 64 bytes)
  * i_logvolid, size of the buffer psz_logvolid points to
  * returns the size of buffer needed for all data, including NUL terminator
- * A call to udf_get_root() should have been issued before this call
  * Note: this call accepts a NULL psz_volid, to retrieve the length required.
  */
 int
 udf_get_logical_volume_id(udf_t *p_udf, /*out*/ char *psz_logvolid, unsigned int i_logvolid)
 {
-  uint8_t data[UDF_BLOCKSIZE];
-  logical_vol_desc_t *p_logvol = (logical_vol_desc_t *) &data;
+  const logical_vol_desc_t *p_logvol = &p_udf->vds.lvd.desc;
   char* r;
   int logvolid_len;
 
@@ -532,7 +1188,7 @@ udf_get_logical_volume_id(udf_t *p_udf, /*out*/ char *psz_logvolid, unsigned int
   if (psz_logvolid != NULL)
     psz_logvolid[0] = 0;
 
-  if (DRIVER_OP_SUCCESS != udf_read_sectors (p_udf, p_logvol, p_udf->lvd_lba, 1) )
+  if (!p_udf->vds.lvd_lba)
     return 0;
 
   r = unicode16_decode((uint8_t *) p_logvol->logvol_id, p_logvol->logvol_id[127]);
@@ -560,74 +1216,51 @@ udf_get_logical_volume_id(udf_t *p_udf, /*out*/ char *psz_logvolid, unsigned int
 udf_dirent_t *
 udf_get_root (udf_t *p_udf, bool b_any_partition, partition_num_t i_partition)
 {
-  const anchor_vol_desc_ptr_t *p_avdp = &p_udf->anchor_vol_desc_ptr;
-  const uint32_t mvds_start =
-    uint32_from_le(p_avdp->main_vol_desc_seq_ext.loc);
-  const uint32_t mvds_end   = mvds_start +
-    (uint32_from_le(p_avdp->main_vol_desc_seq_ext.len) - 1) / UDF_BLOCKSIZE;
-  uint32_t i_lba;
+  const udf_vds_t *p_vds = &p_udf->vds;
+  const partition_desc_t *p_partition = NULL;
   uint8_t data[UDF_BLOCKSIZE];
+  unsigned int i;
 
   /*
-     Now we have the joy of finding the Partition Descriptor and the
-     Logical Volume Descriptor for the Main Volume Descriptor
-     Sequence. Once we've got that, we use the Logical Volume
-     Descriptor to get a Fileset Descriptor and that has the Root
-     Directory File Entry.
+     The Partition Descriptor and the Logical Volume Descriptor were
+     kept by udf_open(). We use the Logical Volume Descriptor to get a
+     Fileset Descriptor and that has the Root Directory File Entry.
   */
-  for (i_lba = mvds_start; i_lba < mvds_end; i_lba++) {
-    uint8_t data2[UDF_BLOCKSIZE];
-
-    partition_desc_t *p_partition = (partition_desc_t *) &data2;
-
-    if (DRIVER_OP_SUCCESS != udf_read_sectors (p_udf, p_partition, i_lba, 1) )
-      return NULL;
-
-    if (!udf_checktag(&p_partition->tag, TAGID_PARTITION)) {
-      const partition_num_t i_partition_check
-	= uint16_from_le(p_partition->number);
-      if (b_any_partition || i_partition_check == i_partition) {
-	/* Squirrel away some data regarding partition */
-	p_udf->i_partition = uint16_from_le(p_partition->number);
-	p_udf->i_part_start = uint32_from_le(p_partition->start_loc);
-	if (p_udf->lvd_lba) break;
-      }
-    } else if (!udf_checktag(&p_partition->tag, TAGID_LOGVOL)) {
-      /* Get fileset descriptor */
-      logical_vol_desc_t *p_logvol = (logical_vol_desc_t *) &data2;
-      bool b_valid =
-	UDF_BLOCKSIZE == uint32_from_le(p_logvol->logical_blocksize);
-
-      if (b_valid) {
-	p_udf->lvd_lba = i_lba;
-	p_udf->fsd_offset =
-	  uint32_from_le(p_logvol->lvd_use.fsd_loc.loc.lba);
-	if (p_udf->i_part_start) break;
-      }
+  for (i = 0; i < p_vds->i_partitions; i++)
+    if (b_any_partition
+	|| uint16_from_le(p_vds->partitions[i].number) == i_partition) {
+      p_partition = &p_vds->partitions[i];
+      break;
     }
+
+  if (p_vds->lvd_lba && p_partition) {
+    /* Squirrel away some data regarding partition */
+    p_udf->i_partition = uint16_from_le(p_partition->number);
+    p_udf->i_part_start = uint32_from_le(p_partition->start_loc);
+    p_udf->fsd_offset =
+      uint32_from_le(p_vds->lvd.desc.lvd_use.fsd_loc.loc.lba);
   }
-  if (p_udf->lvd_lba && p_udf->i_part_start) {
+
+  if (p_vds->lvd_lba && p_partition) {
     udf_fsd_t *p_fsd = (udf_fsd_t *) &data;
+    const uint16_t i_fsd_part =
+      uint16_from_le(p_vds->lvd.desc.lvd_use.fsd_loc.loc.partitionReferenceNum);
 
     driver_return_code_t ret =
-      udf_read_sectors(p_udf, p_fsd, p_udf->i_part_start + p_udf->fsd_offset,
-		       1);
+      udf_read_part_sectors(p_udf, p_fsd, i_fsd_part, p_udf->fsd_offset, 1);
 
     if (DRIVER_OP_SUCCESS == ret && !udf_checktag(&p_fsd->tag, TAGID_FSD)) {
       udf_file_entry_t *p_udf_fe = (udf_file_entry_t *) &data;
       const uint32_t parent_icb = uint32_from_le(p_fsd->root_icb.loc.lba);
+      const uint16_t i_parent_part =
+	uint16_from_le(p_fsd->root_icb.loc.partitionReferenceNum);
 
-      /* Check partition numbers match of last-read block?  */
-
-      ret = udf_read_sectors(p_udf, p_udf_fe,
-			     p_udf->i_part_start + parent_icb, 1);
-      if (ret == DRIVER_OP_SUCCESS &&
-	  !udf_checktag(&p_udf_fe->tag, TAGID_FILE_ENTRY)) {
-
-	/* Check partition numbers match of last-read block? */
-
+      ret = udf_read_part_sectors(p_udf, p_udf_fe, i_parent_part,
+				  parent_icb, 1);
+      if (ret == DRIVER_OP_SUCCESS && !udf_checkfe(p_udf_fe)) {
 	/* We win! - Save root directory information. */
-	return udf_new_dirent(p_udf_fe, p_udf, "/", true, false );
+	return udf_new_dirent(p_udf_fe, p_udf, "/", true, false,
+			      i_parent_part, parent_icb);
       }
     }
   }
@@ -652,7 +1285,25 @@ udf_close (udf_t *p_udf)
     cdio_destroy(p_udf->cdio);
   }
 
-  /* Get rid of root directory if allocated. */
+  /* Get rid of the directories and paths udf_fopen() cached. */
+  {
+    unsigned int i;
+
+    for (i = 0; i < UDF_DIR_CACHE_BUCKETS; i++)
+      while (p_udf->ap_dir_cache[i]) {
+	udf_dir_cache_t *p_dir = p_udf->ap_dir_cache[i];
+
+	p_udf->ap_dir_cache[i] = p_dir->p_next;
+	udf_dir_cache_free(p_dir);
+      }
+    for (i = 0; i < UDF_PATH_CACHE_SIZE; i++)
+      free(p_udf->path_cache[i].psz_path);
+    for (i = 0; i < p_udf->i_part_maps; i++) {
+      free(p_udf->part_maps[i].p_extents);
+      free(p_udf->part_maps[i].p_mirror_extents);
+      free(p_udf->part_maps[i].p_pinned);
+    }
+  }
 
   free_and_null(p_udf);
   return true;
@@ -664,19 +1315,18 @@ udf_opendir(const udf_dirent_t *p_udf_dirent)
   if (p_udf_dirent->b_dir && !p_udf_dirent->b_parent && p_udf_dirent->fid) {
     udf_t *p_udf = p_udf_dirent->p_udf;
     udf_file_entry_t udf_fe;
+    const uint16_t i_fe_part =
+      uint16_from_le(p_udf_dirent->fid->icb.loc.partitionReferenceNum);
+    const uint32_t i_fe_lba = uint32_from_le(p_udf_dirent->fid->icb.loc.lba);
 
     driver_return_code_t i_ret =
-      udf_read_sectors(p_udf, &udf_fe, p_udf->i_part_start
-		       + p_udf_dirent->fid->icb.loc.lba, 1);
+      udf_read_part_sectors(p_udf, &udf_fe, i_fe_part, i_fe_lba, 1);
 
-    if (DRIVER_OP_SUCCESS == i_ret
-	&& !udf_checktag(&udf_fe.tag, TAGID_FILE_ENTRY)) {
+    if (DRIVER_OP_SUCCESS == i_ret && !udf_checkfe(&udf_fe)) {
 
-      if (ICBTAG_FILE_TYPE_DIRECTORY == udf_fe.icb_tag.file_type) {
-	udf_dirent_t *p_udf_dirent_new =
-	  udf_new_dirent(&udf_fe, p_udf, p_udf_dirent->psz_name, true, true);
-	return p_udf_dirent_new;
-      }
+      if (ICBTAG_FILE_TYPE_DIRECTORY == udf_fe.icb_tag.file_type)
+	return udf_new_dirent(&udf_fe, p_udf, p_udf_dirent->psz_name, true,
+			      true, i_fe_part, i_fe_lba);
     }
   }
   return NULL;
@@ -685,7 +1335,6 @@ udf_opendir(const udf_dirent_t *p_udf_dirent)
 udf_dirent_t *
 udf_readdir(udf_dirent_t *p_udf_dirent)
 {
-  udf_t *p_udf;
   uint8_t* p;
 
   if (p_udf_dirent->dir_left <= 0) {
@@ -693,10 +1342,6 @@ udf_readdir(udf_dirent_t *p_udf_dirent)
     return NULL;
   }
 
-  /* file position must be reset when accessing a new file */
-  p_udf = p_udf_dirent->p_udf;
-  p_udf->i_position = 0;
-
   if (p_udf_dirent->fid) {
     /* advance to next File Identifier Descriptor */
     /* FIXME: need to advance file entry (fe) as well.  */
@@ -709,20 +1354,22 @@ udf_readdir(udf_dirent_t *p_udf_dirent)
   }
 
   if (!p_udf_dirent->fid) {
-    uint32_t i_sectors =
-      (p_udf_dirent->i_loc_end - p_udf_dirent->i_loc + 1);
-    uint32_t size = UDF_BLOCKSIZE * i_sectors;
-    driver_return_code_t i_ret;
-
-    if (!p_udf_dirent->sector)
-      p_udf_dirent->sector = (uint8_t*) malloc(size);
-    i_ret = udf_read_sectors(p_udf, p_udf_dirent->sector,
-			     p_udf_dirent->i_part_start+p_udf_dirent->i_loc,
-			     i_sectors);
-    if (DRIVER_OP_SUCCESS == i_ret)
+    /* This is the first call, so p_udf_dirent is still the directory
+       itself. Its File Identifier Descriptors may be in its file
+       entry, or in extents of any partition. */
+    const uint64_t i_dir_len = uint64_from_le(p_udf_dirent->fe.info_len);
+    const uint64_t i_sectors =
+      i_dir_len ? (i_dir_len + UDF_BLOCKSIZE - 1) / UDF_BLOCKSIZE : 1;
+    const size_t size = (size_t) (i_sectors * UDF_BLOCKSIZE);
+
+    if (!p_udf_dirent->sector && size == i_sectors * UDF_BLOCKSIZE)
+      p_udf_dirent->sector = (uint8_t*) calloc(1, size);
+    if (p_udf_dirent->sector
+	&& udf_pread(p_udf_dirent, p_udf_dirent->sector, (size_t) i_dir_len,
+		     0) == (ssize_t) i_dir_len) {
+      p_udf_dirent->i_loc_end = p_udf_dirent->i_loc + i_sectors - 1;
       p_udf_dirent->fid = (udf_fileid_desc_t *) p_udf_dirent->sector;
-    else
-      p_udf_dirent->fid = NULL;
+    }
   }
 
   if (p_udf_dirent->fid && !udf_checktag(&(p_udf_dirent->fid->tag), TAGID_FID))
@@ -740,11 +1387,16 @@ udf_readdir(udf_dirent_t *p_udf_dirent)
       {
 	const unsigned int i_len = p_udf_dirent->fid->i_file_id;
 
-	if (DRIVER_OP_SUCCESS != udf_read_sectors(p_udf, &p_udf_dirent->fe, p_udf->i_part_start
-			 + uint32_from_le(p_udf_dirent->fid->icb.loc.lba), 1)) {
-		udf_dirent_free(p_udf_dirent);
-		return NULL;
-	}
+	/* The file entry, file position and extent map were those of
+	   the previous entry. The file entry is only read when needed. */
+	p_udf_dirent->b_fe = false;
+	p_udf_dirent->i_fe_part =
+	  uint16_from_le(p_udf_dirent->fid->icb.loc.partitionReferenceNum);
+	p_udf_dirent->i_fe_lba =
+	  uint32_from_le(p_udf_dirent->fid->icb.loc.lba);
+	p_udf_dirent->i_position = 0;
+	free_and_null(p_udf_dirent->p_extents);
+	p_udf_dirent->i_extents = 0;
 
        free_and_null(p_udf_dirent->psz_name);
        p = (uint8_t*)p_udf_dirent->fid->u.imp_use.data + p_udf_dirent->fid->u.i_imp_use;
@@ -756,6 +1408,407 @@ udf_readdir(udf_dirent_t *p_udf_dirent)
   return NULL;
 }
 
+/*!
+  Read the file entry of p_udf_dirent unless that has been done
+  already. Return false if it can't be read.
+*/
+bool
+udf_dirent_load_fe(const udf_dirent_t *p_udf_dirent)
+{
+  /* The file entry is a copy of what is on the disc, so it is filled
+     in even though the directory entry is const. */
+  udf_dirent_t *p_cache = (udf_dirent_t *) p_udf_dirent;
+  udf_t *p_udf = p_udf_dirent->p_udf;
+
+  if (p_cache->b_fe) return true;
+  if (DRIVER_OP_SUCCESS !=
+      udf_read_part_sectors(p_udf, &p_cache->fe, p_cache->i_fe_part,
+			    p_cache->i_fe_lba, 1)
+      || udf_checkfe(&p_cache->fe))
+    return false;
+  p_cache->b_fe = true;
+  return true;
+}
+
+/* At most this many blocks are read at once by udf_load_fes(). */
+#define UDF_FE_READ_MAX 32
+
+static int
+udf_fe_lba_cmp(const void *p1, const void *p2)
+{
+  const udf_dirent_t *p_dirent1 = *(udf_dirent_t * const *) p1;
+  const udf_dirent_t *p_dirent2 = *(udf_dirent_t * const *) p2;
+
+  if (p_dirent1->i_fe_part != p_dirent2->i_fe_part)
+    return p_dirent1->i_fe_part < p_dirent2->i_fe_part ? -1 : 1;
+  if (p_dirent1->i_fe_lba < p_dirent2->i_fe_lba) return -1;
+  return p_dirent1->i_fe_lba > p_dirent2->i_fe_lba;
+}
+
+/* Read the file entries of i_dirents directory entries of one udf_t
+   that haven't been read yet, in block order. File entries in
+   consecutive blocks are read together. */
+static bool
+udf_load_fes(void *const pp_dirent[], unsigned int i_dirents)
+{
+  udf_dirent_t **pp_sorted;
+  uint8_t *p_buf;
+  unsigned int i, j, i_todo = 0;
+  bool b_ok = true;
+
+  if (0 == i_dirents) return true;
+  pp_sorted = malloc(i_dirents * sizeof(udf_dirent_t *));
+  p_buf = malloc(UDF_FE_READ_MAX * UDF_BLOCKSIZE);
+  if (!pp_sorted || !p_buf) {
+    cdio_warn("Couldn't allocate memory to read file entries");
+    free(pp_sorted);
+    free(p_buf);
+    return false;
+  }
+
+  for (i = 0; i < i_dirents; i++) {
+    udf_dirent_t *p_udf_dirent = pp_dirent[i];
+    if (!p_udf_dirent->b_fe)
+      pp_sorted[i_todo++] = p_udf_dirent;
+  }
+  qsort(pp_sorted, i_todo, sizeof(udf_dirent_t *), udf_fe_lba_cmp);
+
+  for (i = 0; i < i_todo; i = j) {
+    udf_t *p_udf = pp_sorted[i]->p_udf;
+    const uint16_t i_part = pp_sorted[i]->i_fe_part;
+    const uint32_t i_first = pp_sorted[i]->i_fe_lba;
+    uint32_t i_blocks = 1;
+
+    /* Entries sharing a file entry, or in the blocks right after */
+    for (j = i + 1; j < i_todo; j++) {
+      const uint32_t i_lba = pp_sorted[j]->i_fe_lba;
+      if (pp_sorted[j]->i_fe_part != i_part
+	  || i_lba > i_first + i_blocks || i_lba - i_first >= UDF_FE_READ_MAX)
+	break;
+      i_blocks = i_lba - i_first + 1;
+    }
+
+    if (DRIVER_OP_SUCCESS !=
+	udf_read_part_sectors(p_udf, p_buf, i_part, i_first, i_blocks)) {
+      b_ok = false;
+      continue;
+    }
+    for (; i < j; i++) {
+      udf_dirent_t *p_udf_dirent = pp_sorted[i];
+      memcpy(&p_udf_dirent->fe,
+	     p_buf + (p_udf_dirent->i_fe_lba - i_first) * UDF_BLOCKSIZE,
+	     sizeof(udf_file_entry_t));
+      if (udf_checkfe(&p_udf_dirent->fe))
+	b_ok = false;
+      else
+	p_udf_dirent->b_fe = true;
+    }
+  }
+
+  free(pp_sorted);
+  free(p_buf);
+  return b_ok;
+}
+
+/* A directory of an udf_walk(). */
+typedef struct udf_walk_dir_s udf_walk_dir_t;
+struct udf_walk_dir_s {
+  char             *psz_path;    /* ends in '/' */
+  void            **pp_entry;    /* udf_dirent_t copies of its entries,
+                                    NULL once reported */
+  unsigned int      i_entries, i_entries_alloc;
+  void            **pp_child;    /* udf_walk_dir_t of subdirectories,
+                                    in on-disk order */
+  unsigned int      i_children, i_children_alloc;
+  bool              b_failed;    /* set by the worker reading it */
+  bool              b_read;      /* set once handed back */
+  uint16_t          i_fe_part;   /* where fe is */
+  uint32_t          i_fe_lba;
+  /* This field has to come last because it is variable in length. */
+  udf_file_entry_t  fe;
+};
+
+typedef struct {
+  udf_t              *p_udf;
+  CdioWorkPool_t     *p_pool;
+  udf_walk_visitor_t  visitor;
+  void               *p_user_data;
+  udf_walk_order_t    order;
+  /* UDF_WALK_ORDERED: directories still to be reported, as a stack
+     whose top is reported next. */
+  void              **pp_next;
+  unsigned int        i_next, i_next_alloc;
+} udf_walk_t;
+
+static udf_walk_dir_t *
+udf_walk_dir_new(const char *psz_parent, const char *psz_name,
+		 const udf_dirent_t *p_udf_dirent)
+{
+  udf_walk_dir_t *p_dir = calloc(1, sizeof(udf_walk_dir_t));
+  size_t i_parent = strlen(psz_parent);
+  size_t len = i_parent + (psz_name ? strlen(psz_name) : 0) + 2;
+
+  if (!p_dir) {
+    cdio_warn("Couldn't calloc(1, %lu)",
+	      (unsigned long) sizeof(udf_walk_dir_t));
+    return NULL;
+  }
+  p_dir->psz_path = malloc(len);
+  if (!p_dir->psz_path) {
+    cdio_warn("Couldn't malloc(%lu)", (unsigned long) len);
+    free(p_dir);
+    return NULL;
+  }
+  if (psz_name)
+    snprintf(p_dir->psz_path, len, "%s%s/", psz_parent, psz_name);
+  else
+    snprintf(p_dir->psz_path, len, "%s%s", psz_parent,
+	     (i_parent && '/' == psz_parent[i_parent-1]) ? "" : "/");
+  p_dir->i_fe_part = p_udf_dirent->i_fe_part;
+  p_dir->i_fe_lba  = p_udf_dirent->i_fe_lba;
+  memcpy(&p_dir->fe, &p_udf_dirent->fe, sizeof(udf_file_entry_t));
+  return p_dir;
+}
+
+static void
+udf_walk_dir_free_entries(udf_walk_dir_t *p_dir)
+{
+  unsigned int i;
+
+  for (i = 0; i < p_dir->i_entries; i++)
+    udf_dirent_free(p_dir->pp_entry[i]);
+  free_and_null(p_dir->pp_entry);
+  p_dir->i_entries = p_dir->i_entries_alloc = 0;
+}
+
+static void
+udf_walk_dir_free(udf_walk_dir_t *p_dir)
+{
+  unsigned int i;
+
+  if (!p_dir) return;
+  for (i = 0; i < p_dir->i_children; i++)
+    udf_walk_dir_free(p_dir->pp_child[i]);
+  udf_walk_dir_free_entries(p_dir);
+  free(p_dir->pp_child);
+  free(p_dir->psz_path);
+  free(p_dir);
+}
+
+/* Copy the current entry of a directory being read, without the
+   directory buffer it points into. */
+static udf_dirent_t *
+udf_walk_copy_entry(const udf_dirent_t *p_udf_dirent)
+{
+  udf_dirent_t *p_copy = malloc(sizeof(udf_dirent_t));
+
+  if (!p_copy) {
+    cdio_warn("Couldn't malloc(%lu)", (unsigned long) sizeof(udf_dirent_t));
+    return NULL;
+  }
+  memcpy(p_copy, p_udf_dirent, sizeof(udf_dirent_t));
+  p_copy->psz_name = strdup(p_udf_dirent->psz_name);
+  p_copy->sector    = NULL;
+  p_copy->fid       = NULL;
+  p_copy->dir_left  = 0;
+  p_copy->p_extents = NULL;
+  p_copy->i_extents = 0;
+  if (!p_copy->psz_name) {
+    free(p_copy);
+    return NULL;
+  }
+  return p_copy;
+}
+
+static bool
+udf_walk_append(void ***ppp_array, unsigned int *p_count,
+		unsigned int *p_alloc, void *p_item)
+{
+  if (*p_count == *p_alloc) {
+    unsigned int i_alloc = *p_alloc ? 2 * *p_alloc : 16;
+    void **pp_array = realloc(*ppp_array, i_alloc * sizeof(void *));
+
+    if (!pp_array) {
+      cdio_warn("Couldn't realloc(%lu)",
+		(unsigned long) (i_alloc * sizeof(void *)));
+      return false;
+    }
+    *ppp_array = pp_array;
+    *p_alloc   = i_alloc;
+  }
+  (*ppp_array)[(*p_count)++] = p_item;
+  return true;
+}
+
+/* Worker: read a directory and queue its subdirectories. */
+static void
+udf_walk_read(void *p_task, unsigned int i_worker, void *p_user_data)
+{
+  udf_walk_t *p_walk = p_user_data;
+  udf_walk_dir_t *p_dir = p_task;
+  udf_dirent_t *p_udf_dirent =
+    udf_new_dirent(&p_dir->fe, p_walk->p_udf, "", true, true,
+		   p_dir->i_fe_part, p_dir->i_fe_lba);
+  unsigned int i;
+
+  if (!p_udf_dirent) {
+    p_dir->b_failed = true;
+    return;
+  }
+
+  while ((p_udf_dirent = udf_readdir(p_udf_dirent))) {
+    udf_dirent_t *p_copy = udf_walk_copy_entry(p_udf_dirent);
+
+    if (!p_copy
+	|| !udf_walk_append(&p_dir->pp_entry, &p_dir->i_entries,
+			    &p_dir->i_entries_alloc, p_copy)) {
+      udf_dirent_free(p_copy);
+      p_dir->b_failed = true;
+      break;
+    }
+  }
+  if (p_dir->b_failed) {
+    udf_dirent_free(p_udf_dirent);
+    return;
+  }
+
+  /* The visitor gets entries with their file entries read, and
+     subdirectories are read from theirs. Reading them all here, in
+     block order, is cheaper than one by one later. */
+  if (!udf_load_fes(p_dir->pp_entry, p_dir->i_entries)) {
+    p_dir->b_failed = true;
+    return;
+  }
+
+  for (i = 0; i < p_dir->i_entries; i++) {
+    udf_dirent_t *p_entry = p_dir->pp_entry[i];
+
+    if (p_entry->b_dir && !p_entry->b_parent) {
+      udf_walk_dir_t *p_child =
+	udf_walk_dir_new(p_dir->psz_path, p_entry->psz_name, p_entry);
+
+      if (!p_child
+	  || !udf_walk_append(&p_dir->pp_child, &p_dir->i_children,
+			      &p_dir->i_children_alloc, p_child)) {
+	udf_walk_dir_free(p_child);
+	p_dir->b_failed = true;
+	return;
+      }
+    }
+  }
+
+  /* Queue the first subdirectory last so that this worker continues
+     with it, which keeps reads roughly in on-disk order. */
+  for (i = p_dir->i_children; i > 0; i--)
+    if (!cdio_workpool_push(p_walk->p_pool, i_worker, p_dir->pp_child[i-1])) {
+      p_dir->b_failed = true;
+      return;
+    }
+}
+
+/* Pass the entries of p_dir to the visitor and drop them. */
+static int
+udf_walk_report(udf_walk_t *p_walk, udf_walk_dir_t *p_dir)
+{
+  unsigned int i;
+  int i_rc = 0;
+
+  for (i = 0; i < p_dir->i_entries && !i_rc; i++)
+    i_rc = p_walk->visitor(p_dir->psz_path, p_dir->pp_entry[i],
+			   p_walk->p_user_data);
+  udf_walk_dir_free_entries(p_dir);
+  return i_rc;
+}
+
+/* Calling thread: a directory has been read. */
+static int
+udf_walk_done(void *p_task, void *p_user_data)
+{
+  udf_walk_t *p_walk = p_user_data;
+  udf_walk_dir_t *p_dir = p_task;
+
+  p_dir->b_read = true;
+  if (p_dir->b_failed) return -1;
+
+  if (UDF_WALK_UNORDERED == p_walk->order)
+    return udf_walk_report(p_walk, p_dir);
+
+  /* Report all directories that are next in depth-first order and
+     have been read by now. */
+  while (p_walk->i_next > 0
+	 && ((udf_walk_dir_t *) p_walk->pp_next[p_walk->i_next-1])->b_read) {
+    udf_walk_dir_t *p_next = p_walk->pp_next[--p_walk->i_next];
+    unsigned int i;
+    int i_rc = udf_walk_report(p_walk, p_next);
+
+    if (i_rc) return i_rc;
+    for (i = p_next->i_children; i > 0; i--)
+      if (!udf_walk_append(&p_walk->pp_next, &p_walk->i_next,
+			   &p_walk->i_next_alloc, p_next->pp_child[i-1]))
+	return -1;
+  }
+  return 0;
+}
+
+/*!
+  Walk the directory tree below psz_path, which is looked up as with
+  udf_fopen(), calling visitor for every entry found. See udf_file.h
+  for details.
+*/
+int
+udf_walk(udf_dirent_t *p_udf_root, const char psz_path[],
+	 udf_walk_visitor_t visitor, void *p_user_data,
+	 unsigned int i_threads, udf_walk_order_t order)
+{
+  udf_walk_t walk;
+  udf_walk_dir_t *p_root;
+  udf_dirent_t *p_udf_dirent;
+  int i_rc = -1;
+
+  if (!p_udf_root || !psz_path || !visitor) return -1;
+
+  p_udf_dirent = udf_fopen(p_udf_root, psz_path);
+  if (!p_udf_dirent) return -1;
+  if (!p_udf_dirent->b_dir || !udf_dirent_load_fe(p_udf_dirent)) {
+    udf_dirent_free(p_udf_dirent);
+    return -1;
+  }
+  p_root = udf_walk_dir_new(psz_path, NULL, p_udf_dirent);
+  udf_dirent_free(p_udf_dirent);
+  if (!p_root) return -1;
+
+  memset(&walk, 0, sizeof(walk));
+  walk.p_udf       = p_udf_root->p_udf;
+  walk.visitor     = visitor;
+  walk.p_user_data = p_user_data;
+  walk.order       = order;
+
+  /* Reads through a CdIo_t device share its state, so only image
+     files are read from several threads. */
+  if (!walk.p_udf->b_stream)
+    i_threads = 1;
+
+  if (UDF_WALK_ORDERED == order
+      && !udf_walk_append(&walk.pp_next, &walk.i_next,
+			  &walk.i_next_alloc, p_root))
+    goto out;
+
+  walk.p_pool = cdio_workpool_new(i_threads, udf_walk_read, udf_walk_done,
+				  &walk);
+  if (!walk.p_pool || !cdio_workpool_push(walk.p_pool, 0, p_root))
+    goto out;
+
+  i_rc = cdio_workpool_run(walk.p_pool);
+  if (0 == i_rc && walk.i_next > 0)
+    i_rc = -1; /* some directory was never handed back */
+
+ out:
+  cdio_workpool_free(walk.p_pool);
+  free(walk.pp_next);
+  udf_walk_dir_free(p_root);
+  return i_rc;
+}
+
 /*!
   free free resources associated with p_udf_dirent.
 */
@@ -766,6 +1819,7 @@ udf_dirent_free(udf_dirent_t *p_udf_dirent)
     p_udf_dirent->fid = NULL;
     free_and_null(p_udf_dirent->psz_name);
     free_and_null(p_udf_dirent->sector);
+    free_and_null(p_udf_dirent->p_extents);
     free_and_null(p_udf_dirent);
   }
   return true;
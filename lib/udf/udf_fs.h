@@ -19,12 +19,59 @@
 #define CDIO_UDF_UDF_FS_H_
 
 #include <cdio/ecma_167.h>
+#include <cdio/udf.h>
 /**
  * Check the descriptor tag for both the correct id and correct checksum.
  * Return zero if all is good, -1 if not.
  */
 int udf_checktag(const udf_tag_t *p_tag, udf_Uint16_t tag_id);
 
+/**
+ * Check that p_udf_fe holds a File Entry or an Extended File Entry,
+ * and turn the latter into the former, so that the rest of libudf
+ * only deals with one kind. Return zero if all is good, -1 if not.
+ */
+int udf_checkfe(udf_file_entry_t *p_udf_fe);
+
+/**
+ * Read i_blocks blocks from block i_lba on of the partition with
+ * partition reference number i_part.
+ */
+driver_return_code_t udf_read_part_sectors(const udf_t *p_udf, void *ptr,
+                                           uint16_t i_part, uint32_t i_lba,
+                                           long int i_blocks);
+
+/**
+ * Decode the allocation descriptors of the file with file entry
+ * p_udf_fe, which is in partition i_part, into an array of extents in
+ * file offset order. Return false on error.
+ */
+bool udf_build_extents(const udf_t *p_udf, const udf_file_entry_t *p_udf_fe,
+                       uint16_t i_part, /*out*/ udf_extent_t **pp_extents,
+                       /*out*/ unsigned int *pi_extents);
+
+/**
+ * Return the extent of p_extents holding file offset i_offset, or
+ * NULL if there is none.
+ */
+const udf_extent_t *udf_extent_at(const udf_extent_t *p_extents,
+                                  unsigned int i_extents, uint64_t i_offset);
+
+/**
+ * Read the file entry of p_udf_dirent unless that has been done
+ * already. Return false if it can't be read.
+ */
+bool udf_dirent_load_fe(const udf_dirent_t *p_udf_dirent);
+
+/**
+ * Return true if the data of the file with file entry p_udf_fe is
+ * stored in the file entry itself, setting *pp_data and *pi_len to
+ * it. *pp_data is NULL if it doesn't fit in the file entry.
+ */
+bool udf_fe_in_icb(const udf_file_entry_t *p_udf_fe,
+                   /*out*/ const uint8_t **pp_data,
+                   /*out*/ uint32_t *pi_len);
+
 #endif /* CDIO_UDF_UDF_FS_H_ */
 
 
@@ -34,17 +34,124 @@
 
 /* Implementation of opaque types */
 
+/* i_len bytes of a file starting at file offset i_offset. They are
+   stored from block i_lba of partition i_part on, unless b_recorded is
+   false, in which case they read as zeros. */
+struct udf_extent_s {
+  uint64_t              i_offset;
+  uint16_t              i_part;       /* partition reference number */
+  uint32_t              i_lba;
+  uint64_t              i_len;
+  bool                  b_recorded;
+};
+
+/* What udf_fopen() needs of an entry of a directory. */
+typedef struct udf_dir_entry_s {
+  char                 *psz_name;
+  uint32_t              i_hash;       /* of psz_name */
+  unsigned int          i_next;       /* next entry with the same hash
+                                         bucket, plus 1; 0 if none */
+  bool                  b_dir;
+  bool                  b_parent;
+  uint16_t              i_fe_part;    /* partition of its file entry */
+  uint32_t              i_fe_lba;     /* and block there */
+  udf_fileid_desc_t    *p_fid;        /* copy of its File Identifier
+                                         Descriptor */
+  uint32_t              i_fid_len;
+} udf_dir_entry_t;
+
+/* The entries of a directory, hashed by name. */
+typedef struct udf_dir_cache_s udf_dir_cache_t;
+struct udf_dir_cache_s {
+  uint16_t              i_fe_part;    /* partition of the directory's
+                                         file entry */
+  uint32_t              i_fe_lba;     /* and block there */
+  udf_dir_entry_t      *p_entries;    /* in on-disc order */
+  unsigned int          i_entries;
+  unsigned int         *pi_buckets;   /* first entry of each, plus 1 */
+  unsigned int          i_buckets;    /* a power of 2 */
+  udf_dir_cache_t      *p_next;       /* in the same udf_s bucket */
+};
+
+#define UDF_DIR_CACHE_BUCKETS 64
+#define UDF_PATH_CACHE_SIZE   64
+
+/* A path udf_fopen() has looked up. */
+typedef struct udf_path_cache_s {
+  char                 *psz_path;     /* as passed; NULL if slot unused */
+  uint16_t              i_root_part;  /* file entry of the directory it is */
+  uint32_t              i_root_lba;   /* relative to */
+  const udf_dir_cache_t *p_dir;       /* directory it was found in */
+  unsigned int          i_entry;      /* and its entry there */
+  unsigned long         i_used;       /* i_path_clock when last used */
+} udf_path_cache_t;
+
+#define UDF_VDS_MAX_BLOCKS  64  /* most blocks of a Volume Descriptor
+                                   Sequence read */
+#define UDF_VDS_MAX_EXTENTS  8  /* most Volume Descriptor Pointers
+                                   followed */
+#define UDF_MAX_PARTITIONS   8
+
+/* The descriptors of a Volume Descriptor Sequence that are used. Of
+   several with the same purpose, the one with the highest Volume
+   Descriptor Sequence Number is kept. */
+typedef struct udf_vds_s {
+  udf_pvd_t             pvd;
+  uint32_t              pvd_lba;      /* 0 if there is no Primary Volume
+                                         Descriptor */
+  union {
+    logical_vol_desc_t  desc;
+    uint8_t             data[UDF_BLOCKSIZE];
+  } lvd;                              /* with its partition maps */
+  uint32_t              lvd_lba;      /* 0 if there is no usable Logical
+                                         Volume Descriptor */
+  partition_desc_t      partitions[UDF_MAX_PARTITIONS];
+  unsigned int          i_partitions;
+} udf_vds_t;
+
+typedef enum {
+  UDF_PART_NONE,                      /* can't be read */
+  UDF_PART_PHYSICAL,
+  UDF_PART_METADATA                   /* UDF 2.50 metadata partition */
+} udf_part_type_t;
+
+/* Where the blocks of a partition, as referred to by its index in the
+   partition maps of the Logical Volume Descriptor, are. */
+typedef struct udf_part_map_s {
+  udf_part_type_t       type;
+  partition_num_t       i_partition;  /* partition number */
+  uint32_t              i_start;      /* UDF_PART_PHYSICAL: its first
+                                         sector */
+  /* UDF_PART_METADATA: the extents of the metadata file and of its
+     mirror, in partition i_phys. The mirror is only used when the
+     metadata file can't be read. */
+  uint16_t              i_phys;
+  udf_extent_t         *p_extents;
+  unsigned int          i_extents;
+  udf_extent_t         *p_mirror_extents;
+  unsigned int          i_mirror_extents;
+  uint8_t              *p_pinned;     /* the metadata file, if
+                                         udf_pin_metadata() read it */
+  uint64_t              i_pinned_len;
+} udf_part_map_t;
+
 struct udf_s {
   bool                  b_stream;     /* Use stream pointer, else use p_cdio */
-  off_t                 i_position;   /* Position in file if positive */
   CdioDataSource_t      *stream;      /* Stream pointer if stream */
   CdIo_t                *cdio;        /* Cdio pointer if read device */
   anchor_vol_desc_ptr_t anchor_vol_desc_ptr;
-  uint32_t              pvd_lba;      /* sector of Primary Volume Descriptor */
+  udf_vds_t             vds;          /* from the Main Volume Descriptor
+                                         Sequence, or else the Reserve */
+  udf_part_map_t        part_maps[UDF_MAX_PARTITIONS];
+  unsigned int          i_part_maps;
   partition_num_t       i_partition;  /* partition number */
   uint32_t              i_part_start; /* start of Partition Descriptor */
-  uint32_t              lvd_lba;      /* sector of Logical Volume Descriptor */
   uint32_t              fsd_offset;   /* lba of fileset descriptor */
+  /* Directories udf_fopen() has read, hashed by i_fe_lba */
+  udf_dir_cache_t      *ap_dir_cache[UDF_DIR_CACHE_BUCKETS];
+  /* Paths udf_fopen() has looked up, least recently used replaced */
+  udf_path_cache_t      path_cache[UDF_PATH_CACHE_SIZE];
+  unsigned long         i_path_clock;
 };
 
 #endif /* CDIO_UDF_UDF_PRIVATE_H_ */
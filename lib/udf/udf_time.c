@@ -48,6 +48,8 @@
 #endif
 
 #include "udf_private.h"
+#include "udf_fs.h"
+#include "cdio_time.h"
 #include <cdio/udf.h>
 
 /**
@@ -64,45 +66,6 @@ enum {
   SECS_PER_DAY	   = SECS_PER_HOUR * HOURS_PER_DAY
 } debug_udf_time_enum;
   
-#ifndef __isleap
-/* Nonzero if YEAR is a leap year (every 4 years,
-   except every 100th isn't, and every 400th is).  */
-#define	__isleap(year)	\
-  ((year) % 4 == 0 && ((year) % 100 != 0 || (year) % 400 == 0))
-#endif
-
-/* How many days come before each month (0-12).  */
-static const unsigned short int __mon_yday[2][13] =
-  {
-    /* Normal years.  */
-    { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, DAYS_PER_YEAR },
-    /* Leap years.  */
-    { 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, DAYS_PER_YEAR+1 }
-  };
-
-#define SPY(y,l,s) (SECS_PER_DAY * (DAYS_PER_YEAR*y+l)+s) /* Seconds per year */
-
-static time_t year_seconds[MAX_YEAR_SECONDS]= {
-  /*1970*/ SPY( 0, 0,0), SPY( 1, 0,0), SPY( 2, 0,0), SPY( 3, 1,0), 
-  /*1974*/ SPY( 4, 1,0), SPY( 5, 1,0), SPY( 6, 1,0), SPY( 7, 2,0), 
-  /*1978*/ SPY( 8, 2,0), SPY( 9, 2,0), SPY(10, 2,0), SPY(11, 3,0), 
-  /*1982*/ SPY(12, 3,0), SPY(13, 3,0), SPY(14, 3,0), SPY(15, 4,0), 
-  /*1986*/ SPY(16, 4,0), SPY(17, 4,0), SPY(18, 4,0), SPY(19, 5,0), 
-  /*1990*/ SPY(20, 5,0), SPY(21, 5,0), SPY(22, 5,0), SPY(23, 6,0), 
-  /*1994*/ SPY(24, 6,0), SPY(25, 6,0), SPY(26, 6,0), SPY(27, 7,0), 
-  /*1998*/ SPY(28, 7,0), SPY(29, 7,0), SPY(30, 7,0), SPY(31, 8,0), 
-  /*2002*/ SPY(32, 8,0), SPY(33, 8,0), SPY(34, 8,0), SPY(35, 9,0), 
-  /*2006*/ SPY(36, 9,0), SPY(37, 9,0), SPY(38, 9,0), SPY(39,10,0), 
-  /*2010*/ SPY(40,10,0), SPY(41,10,0), SPY(42,10,0), SPY(43,11,0), 
-  /*2014*/ SPY(44,11,0), SPY(45,11,0), SPY(46,11,0), SPY(47,12,0), 
-  /*2018*/ SPY(48,12,0), SPY(49,12,0), SPY(50,12,0), SPY(51,13,0), 
-  /*2022*/ SPY(52,13,0), SPY(53,13,0), SPY(54,13,0), SPY(55,14,0), 
-  /*2026*/ SPY(56,14,0), SPY(57,14,0), SPY(58,14,0), SPY(59,15,0), 
-  /*2030*/ SPY(60,15,0), SPY(61,15,0), SPY(62,15,0), SPY(63,16,0), 
-  /*2034*/ SPY(64,16,0), SPY(65,16,0), SPY(66,16,0), SPY(67,17,0), 
-  /*2038*/ SPY(68,17,0)
-};
-
 #if defined(HAVE_TIMEZONE_VAR) && !defined(_WIN32)
 extern long timezone;
 #endif
@@ -111,9 +74,9 @@ time_t *
 udf_stamp_to_time(time_t *dest, long int *dest_usec, 
 		  const udf_timestamp_t src)
 {
-  int yday;
   uint8_t type = src.type_tz >> 12;
   int16_t offset;
+  int64_t i_time;
   
   if (type == 1) {
     offset = src.type_tz << 4;
@@ -125,26 +88,27 @@ udf_stamp_to_time(time_t *dest, long int *dest_usec,
   else
     offset = 0;
   
-  if ((src.year < EPOCH_YEAR) ||
-      (src.year >= EPOCH_YEAR+MAX_YEAR_SECONDS))
-    {
-      *dest = -1;
-      *dest_usec = -1;
-      return NULL;
-    }
-  *dest = year_seconds[src.year - EPOCH_YEAR];
-  *dest -= offset * SECS_PER_MINUTE;
-  
-  yday = ((__mon_yday[__isleap (src.year)]
-	   [src.month-1]) + (src.day-1));
-  *dest += src.second + 
-    ( SECS_PER_MINUTE *
-      ( ( (yday* HOURS_PER_DAY) + src.hour ) * 60 + src.minute ) );
+  if (src.month < 1 || src.month > 12)
+    goto invalid;
+
+  i_time = _cdio_days_from_civil(src.year, src.month, src.day) * SECS_PER_DAY
+    + src.second
+    + SECS_PER_MINUTE * ( (int64_t) src.hour * 60 + src.minute - offset );
+
+  /* Doesn't fit in this platform's time_t. */
+  if ((int64_t) (time_t) i_time != i_time)
+    goto invalid;
+  *dest = (time_t) i_time;
 
   *dest_usec = src.microseconds
     + (src.centiseconds * 10000)
     + (src.hundreds_of_microseconds * 100);
   return dest;
+
+ invalid:
+  *dest = -1;
+  *dest_usec = -1;
+  return NULL;
 }
 
 #ifdef HAVE_STRUCT_TIMESPEC
@@ -154,13 +118,13 @@ udf_stamp_to_time(time_t *dest, long int *dest_usec,
 udf_timestamp_t *
 udf_timespec_to_stamp(const struct timespec ts, udf_timestamp_t *dest)
 {
-  long int days, rem, y;
-  const unsigned short int *ip;
+  int64_t i_secs, i_days, i_year;
+  int i_rem, i_month, i_mday, i_yday, i_wday;
   int16_t offset = 0;
-  int16_t tv_sec;
 
 #ifdef HAVE_TIMEZONE_VAR  
-  offset = -timezone;
+  /* timezone is in seconds west of UTC, offset in minutes east. */
+  offset = -timezone / SECS_PER_MINUTE;
 #endif
   
   if (!dest)
@@ -168,34 +132,19 @@ udf_timespec_to_stamp(const struct timespec ts, udf_timestamp_t *dest)
   
   dest->type_tz = 0x1000 | (offset & 0x0FFF);
   
-  tv_sec       = ts.tv_sec + (offset * SECS_PER_MINUTE);
-  days         = tv_sec / SECS_PER_DAY;
-  rem          = tv_sec % SECS_PER_DAY;
-  dest->hour   = rem / SECS_PER_HOUR;
-  rem         %= SECS_PER_HOUR;
-  dest->minute = rem / SECS_PER_MINUTE;
-  dest->second = rem % SECS_PER_MINUTE;
-  y            = EPOCH_YEAR;
-  
-#define DIV(a,b) ((a) / (b) - ((a) % (b) < 0))
-#define LEAPS_THRU_END_OF(y) (DIV (y, 4) - DIV (y, 100) + DIV (y, 400))
-  
-  while (days < 0 || days >= (__isleap(y) ? DAYS_PER_YEAR+1 : DAYS_PER_YEAR)) {
-    long int yg = y + days / DAYS_PER_YEAR - (days % DAYS_PER_YEAR < 0);
-    
-    /* Adjust DAYS and Y to match the guessed year.  */
-    days -= ((yg - y) * DAYS_PER_YEAR
-	     + LEAPS_THRU_END_OF (yg - 1)
-	     - LEAPS_THRU_END_OF (y - 1));
-    y = yg;
-  }
-  dest->year = y;
-  ip = __mon_yday[__isleap(y)];
-  for (y = 11; days < (long int) ip[y]; --y)
-    continue;
-  days -= ip[y];
-  dest->month = y + 1;
-  dest->day   = days + 1;
+  i_secs       = (int64_t) ts.tv_sec + (offset * SECS_PER_MINUTE);
+  i_days       = CDIO_FLOOR_DIV(i_secs, SECS_PER_DAY);
+  i_rem        = (int) (i_secs - i_days * SECS_PER_DAY);
+  dest->hour   = i_rem / SECS_PER_HOUR;
+  i_rem       %= SECS_PER_HOUR;
+  dest->minute = i_rem / SECS_PER_MINUTE;
+  dest->second = i_rem % SECS_PER_MINUTE;
+
+  _cdio_civil_from_days(i_days, &i_year, &i_month, &i_mday, &i_yday,
+                        &i_wday);
+  dest->year  = i_year;
+  dest->month = i_month;
+  dest->day   = i_mday;
   
   dest->centiseconds = ts.tv_nsec / 10000000;
   dest->hundreds_of_microseconds = ( (ts.tv_nsec / 1000)
@@ -213,7 +162,7 @@ udf_timespec_to_stamp(const struct timespec ts, udf_timestamp_t *dest)
 time_t
 udf_get_modification_time(const udf_dirent_t *p_udf_dirent)
 {
-  if (p_udf_dirent) {
+  if (p_udf_dirent && udf_dirent_load_fe(p_udf_dirent)) {
     time_t ret_time;
     long int usec;
     udf_stamp_to_time(&ret_time, &usec, p_udf_dirent->fe.modification_time);
@@ -228,7 +177,7 @@ udf_get_modification_time(const udf_dirent_t *p_udf_dirent)
 time_t
 udf_get_access_time(const udf_dirent_t *p_udf_dirent)
 {
-  if (p_udf_dirent) {
+  if (p_udf_dirent && udf_dirent_load_fe(p_udf_dirent)) {
     time_t ret_time;
     long int usec;
     udf_stamp_to_time(&ret_time, &usec, p_udf_dirent->fe.access_time);
@@ -243,7 +192,7 @@ udf_get_access_time(const udf_dirent_t *p_udf_dirent)
 time_t
 udf_get_attribute_time(const udf_dirent_t *p_udf_dirent)
 {
-  if (p_udf_dirent) {
+  if (p_udf_dirent && udf_dirent_load_fe(p_udf_dirent)) {
     time_t ret_time;
     long int usec;
     udf_stamp_to_time(&ret_time, &usec, p_udf_dirent->fe.attribute_time);
@@ -0,0 +1,890 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Program to measure how fast a drive or disc image reads: sequential
+   throughput in zones from the inside of the disc out, random seeks,
+   and how the read size and the drive speed setting change things.
+
+   Reads are made with cdio_read_data_sectors() ("data") or as raw
+   sectors with mmc_read_cd() ("mmc"). With the MMC emulator, time is
+   taken from the emulator unless it really waits, so results on it are
+   the same every run and can be used to check the library's read
+   paths. */
+
+#include "util.h"
+#include <cdio/mmc.h>
+#include <cdio/mmc_cmds.h>
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#include "getopt.h"
+
+/* Configuration option codes */
+enum {
+  OP_HANDLED = 0,
+
+  OP_SOURCE_AUTO,
+  OP_SOURCE_DEVICE,
+  OP_SOURCE_EMULATE,
+
+  OP_USAGE,
+};
+
+typedef enum {
+  FORMAT_TEXT,
+  FORMAT_CSV,
+  FORMAT_JSON
+} format_t;
+
+typedef enum {
+  METHOD_DATA,  /* cdio_read_data_sectors(), 2048-byte blocks */
+  METHOD_MMC,   /* mmc_read_cd(), raw 2352-byte blocks */
+  METHOD_COUNT
+} method_t;
+
+static const char *method_names[METHOD_COUNT] = { "data", "mmc" };
+
+/* Most numbers a list option takes. */
+#define MAX_LIST 16
+
+/* Most arguments given with --arg. */
+#define MAX_ARGS 16
+
+/* Speed list entry for the fastest speed. */
+#define SPEED_MAX 0
+
+/* Used by `main' to communicate with `parse_opt'. And global options
+ */
+static struct arguments
+{
+  int            debug_level;
+  int            version_only;
+  int            no_header;
+  int            emulate;
+  source_image_t source_image;
+  format_t       format;
+  track_t        i_track;        /* 0 for the whole disc */
+  unsigned int   i_zones;
+  unsigned int   i_zone_blocks;
+  unsigned int   i_chunk;        /* blocks per read in zones and seeks */
+  unsigned int   i_seeks;
+  unsigned long  i_seed;
+  unsigned int   ai_chunks[MAX_LIST];
+  unsigned int   i_chunks;
+  unsigned int   ai_speeds[MAX_LIST];
+  unsigned int   i_speeds;
+  bool           ab_method[METHOD_COUNT];
+  char          *apsz_args[MAX_ARGS];
+  unsigned int   i_args;
+} opts;
+
+/* One measurement: some reads and how long they took. */
+typedef struct {
+  const char   *psz_test;
+  method_t      method;
+  unsigned long i_param;      /* zone, read size, seeks or speed */
+  lsn_t         i_lsn;
+  uint32_t      i_blocks;
+  unsigned int  i_reads;
+  unsigned int  i_errors;
+  uint64_t      i_us;
+  uint64_t      i_min_us;
+  uint64_t      i_max_us;
+} result_t;
+
+/* Where time comes from: the emulator's count, or the clock. */
+static bool b_emulated_clock = false;
+
+static unsigned int i_results = 0;
+
+/* Parse a comma-separated list of numbers. "max" is SPEED_MAX if
+   b_max. */
+static bool
+parse_list(const char *psz_list, unsigned int ai_list[], unsigned int *pi_list,
+           bool b_max, const char *psz_option)
+{
+  const char *p = psz_list;
+
+  *pi_list = 0;
+  while (*p) {
+    char *psz_end;
+    unsigned long i_value;
+
+    if (*pi_list == MAX_LIST) {
+      report(stderr, "%s: at most %d values can be given to %s\n",
+             program_name, MAX_LIST, psz_option);
+      return false;
+    }
+    if (b_max && !strncmp(p, "max", 3)) {
+      i_value = SPEED_MAX;
+      psz_end = (char *) p + 3;
+    } else {
+      i_value = strtoul(p, &psz_end, 10);
+      if (psz_end == p || 0 == i_value || i_value > 0xffff) {
+        report(stderr, "%s: bad value in %s: %s\n", program_name, psz_option,
+               psz_list);
+        return false;
+      }
+    }
+    ai_list[(*pi_list)++] = (unsigned int) i_value;
+    p = psz_end;
+    if (',' == *p) p++;
+    else if (*p) {
+      report(stderr, "%s: bad value in %s: %s\n", program_name, psz_option,
+             psz_list);
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Parse a number an option takes, which must be at least i_min. */
+static bool
+parse_number(const char *psz_value, unsigned long i_min, unsigned long i_max,
+             unsigned long *p_value, const char *psz_option)
+{
+  char *psz_end;
+
+  *p_value = strtoul(psz_value, &psz_end, 10);
+  if (psz_end == psz_value || *psz_end || *p_value < i_min
+      || *p_value > i_max) {
+    report(stderr, "%s: bad value for %s: %s\n", program_name, psz_option,
+           psz_value);
+    return false;
+  }
+  return true;
+}
+
+/* Parse source options. */
+static void
+parse_source(int opt)
+{
+  if (opts.source_image != INPUT_UNKNOWN) {
+    report( stderr, "%s: another source type option given before.\n",
+            program_name );
+    report( stderr, "%s: give only one source type option.\n",
+            program_name );
+    return;
+  }
+
+  switch (opt) {
+  case OP_SOURCE_AUTO:
+    opts.source_image  = INPUT_AUTO;
+    if (optarg != NULL) source_name = strdup(optarg);
+    break;
+  case OP_SOURCE_EMULATE:
+    opts.source_image  = INPUT_AUTO;
+    opts.emulate       = 1;
+    if (optarg != NULL) source_name = strdup(optarg);
+    break;
+  case OP_SOURCE_DEVICE:
+    opts.source_image  = INPUT_DEVICE;
+    if (optarg != NULL) source_name = fillout_device_name(optarg);
+    break;
+  }
+}
+
+/* Parse options. */
+static bool
+parse_options (int argc, char *argv[])
+{
+  int opt;
+  int rc = EXIT_FAILURE;
+  unsigned long i_value;
+
+  static const char helpText[] =
+    "Usage: %s [OPTION...]\n"
+    " Measures how fast a CD-ROM drive or image reads.\n"
+    "options: \n"
+    "  -i, --input[=FILE]              set source and determine if \"bin\" image or\n"
+    "                                  device\n"
+    "  -C, --cdrom-device[=DEVICE]     set CD-ROM device as source\n"
+    "  -E, --emulate[=FILE]            read a disc image through the MMC drive\n"
+    "                                  emulator\n"
+    "  -A, --arg=KEY=VALUE             set a driver argument, e.g.\n"
+    "                                  emu-block-us=100; may be given more\n"
+    "                                  than once\n"
+    "  -m, --method=LIST               read methods: data (cdio_read_data_sectors)\n"
+    "                                  and/or mmc (mmc_read_cd, raw). The\n"
+    "                                  default is data,mmc\n"
+    "  -T, --track=INT                 measure only this track. The default is\n"
+    "                                  the whole disc\n"
+    "  -z, --zones=INT                 number of zones read, inside to outside\n"
+    "                                  (default 10)\n"
+    "  -n, --zone-blocks=INT           sectors read in each zone (default 1000)\n"
+    "  -c, --chunk=INT                 sectors per read in zones, seeks and speeds\n"
+    "                                  (default 16)\n"
+    "  -k, --chunks=LIST               read sizes to compare, in sectors\n"
+    "                                  (default 1,4,16,26)\n"
+    "  -s, --seeks=INT                 number of random seeks (default 100)\n"
+    "  -r, --seed=INT                  seed for the random seeks (default 1)\n"
+    "  -S, --speeds=LIST               drive speeds to compare, in X or \"max\".\n"
+    "                                  The drive is left at max speed. The\n"
+    "                                  default is not to change speed\n"
+    "  -f, --format=FORMAT             output as text, csv or json (default\n"
+    "                                  text)\n"
+    "  -d, --debug=INT                 Set debugging to LEVEL\n"
+    "  --no-header                     Don't display header and copyright (for\n"
+    "                                  regression testing)\n"
+    "  -V, --version                   display version and copyright information\n"
+    "                                  and exit\n"
+    "\n"
+    "Help options:\n"
+    "  -?, --help                      Show this help message\n"
+    "  --usage                         Display brief usage message\n";
+
+  static const char usageText[] =
+    "Usage: %s [-i|--input FILE] [-C|--cdrom-device DEVICE]\n"
+    "        [-E|--emulate FILE] [-A|--arg KEY=VALUE] [-m|--method LIST]\n"
+    "        [-T|--track INT] [-z|--zones INT] [-n|--zone-blocks INT]\n"
+    "        [-c|--chunk INT] [-k|--chunks LIST] [-s|--seeks INT]\n"
+    "        [-r|--seed INT] [-S|--speeds LIST] [-f|--format FORMAT]\n"
+    "        [-d|--debug INT] [--no-header] [-V|--version] [-?|--help]\n"
+    "        [--usage]\n";
+
+  /* Command-line options */
+  static const char optionsString[] = "i::C::E::A:m:T:z:n:c:k:s:r:S:f:d:V?";
+  static const struct option optionsTable[] = {
+
+    {"input", optional_argument, NULL, 'i'},
+    {"cdrom-device", optional_argument, NULL, 'C'},
+    {"emulate", optional_argument, NULL, 'E'},
+    {"arg", required_argument, NULL, 'A'},
+    {"method", required_argument, NULL, 'm'},
+    {"track", required_argument, NULL, 'T'},
+    {"zones", required_argument, NULL, 'z'},
+    {"zone-blocks", required_argument, NULL, 'n'},
+    {"chunk", required_argument, NULL, 'c'},
+    {"chunks", required_argument, NULL, 'k'},
+    {"seeks", required_argument, NULL, 's'},
+    {"seed", required_argument, NULL, 'r'},
+    {"speeds", required_argument, NULL, 'S'},
+    {"format", required_argument, NULL, 'f'},
+    {"debug", required_argument, NULL, 'd'},
+    {"no-header", no_argument, &opts.no_header, 1},
+    {"version", no_argument, NULL, 'V'},
+
+    {"help", no_argument, NULL, '?' },
+    {"usage", no_argument, NULL, OP_USAGE },
+    { NULL, 0, NULL, 0 }
+  };
+
+  program_name = strrchr(argv[0],'/');
+  program_name = program_name ? strdup(program_name+1) : strdup(argv[0]);
+
+  while ((opt = getopt_long(argc, argv, optionsString, optionsTable, NULL)) >= 0)
+    switch (opt)
+      {
+      case 'i': parse_source(OP_SOURCE_AUTO); break;
+      case 'C': parse_source(OP_SOURCE_DEVICE); break;
+      case 'E': parse_source(OP_SOURCE_EMULATE); break;
+
+      case 'A':
+        if (opts.i_args == MAX_ARGS || !strchr(optarg, '=')) {
+          report(stderr, "%s: bad --arg: %s\n", program_name, optarg);
+          goto error_exit;
+        }
+        opts.apsz_args[opts.i_args++] = strdup(optarg);
+        break;
+
+      case 'm':
+        {
+          char *psz_list = strdup(optarg);
+          char *psz_method = strtok(psz_list, ",");
+          unsigned int i;
+
+          memset(opts.ab_method, 0, sizeof(opts.ab_method));
+          for ( ; psz_method; psz_method = strtok(NULL, ",")) {
+            for (i = 0; i < METHOD_COUNT; i++)
+              if (!strcmp(psz_method, method_names[i])) break;
+            if (METHOD_COUNT == i) {
+              report(stderr, "%s: unknown read method %s; should be data "
+                     "or mmc\n", program_name, psz_method);
+              free(psz_list);
+              goto error_exit;
+            }
+            opts.ab_method[i] = true;
+          }
+          free(psz_list);
+        }
+        break;
+
+      case 'T':
+        if (!parse_number(optarg, 1, CDIO_CD_MAX_TRACKS, &i_value, "--track"))
+          goto error_exit;
+        opts.i_track = (track_t) i_value;
+        break;
+      case 'z':
+        if (!parse_number(optarg, 1, 1000, &i_value, "--zones"))
+          goto error_exit;
+        opts.i_zones = (unsigned int) i_value;
+        break;
+      case 'n':
+        if (!parse_number(optarg, 1, CDIO_CD_MAX_LSN, &i_value,
+                          "--zone-blocks"))
+          goto error_exit;
+        opts.i_zone_blocks = (unsigned int) i_value;
+        break;
+      case 'c':
+        if (!parse_number(optarg, 1, 0xffff, &i_value, "--chunk"))
+          goto error_exit;
+        opts.i_chunk = (unsigned int) i_value;
+        break;
+      case 'k':
+        if (!parse_list(optarg, opts.ai_chunks, &opts.i_chunks, false,
+                        "--chunks"))
+          goto error_exit;
+        break;
+      case 's':
+        if (!parse_number(optarg, 0, 1000000, &i_value, "--seeks"))
+          goto error_exit;
+        opts.i_seeks = (unsigned int) i_value;
+        break;
+      case 'r':
+        if (!parse_number(optarg, 0, 0xffffffffUL, &opts.i_seed, "--seed"))
+          goto error_exit;
+        break;
+      case 'S':
+        if (!parse_list(optarg, opts.ai_speeds, &opts.i_speeds, true,
+                        "--speeds"))
+          goto error_exit;
+        break;
+
+      case 'f':
+        if (!strcmp(optarg, "text"))
+          opts.format = FORMAT_TEXT;
+        else if (!strcmp(optarg, "csv"))
+          opts.format = FORMAT_CSV;
+        else if (!strcmp(optarg, "json"))
+          opts.format = FORMAT_JSON;
+        else {
+          report(stderr, "%s: unknown format %s; should be text, csv or "
+                 "json\n", program_name, optarg);
+          goto error_exit;
+        }
+        break;
+
+      case 'd': opts.debug_level = atoi(optarg); break;
+
+      case 'V':
+        print_version(program_name, VERSION, 0, true);
+        rc = EXIT_SUCCESS;
+        goto error_exit;
+
+      case '?':
+        fprintf(stdout, helpText, program_name);
+        rc = EXIT_INFO;
+        goto error_exit;
+
+      case OP_USAGE:
+        fprintf(stderr, usageText, program_name);
+        goto error_exit;
+
+      case OP_HANDLED:
+        break;
+      }
+
+  if (optind < argc) {
+    const char *remaining_arg = argv[optind++];
+
+    if (source_name != NULL) {
+      report( stderr, "%s: Source specified in option %s and as %s\n",
+              program_name, source_name, remaining_arg );
+      goto error_exit;
+    }
+
+    if (opts.source_image == INPUT_DEVICE)
+      source_name = fillout_device_name(remaining_arg);
+    else
+      source_name = strdup(remaining_arg);
+
+    if (optind < argc) {
+      report( stderr, "%s: Source specified in previously %s and %s\n",
+              program_name, source_name, remaining_arg );
+      goto error_exit;
+    }
+  }
+
+  if (opts.emulate && !source_name) {
+    report( stderr, "%s: --emulate needs a disc image\n", program_name );
+    goto error_exit;
+  }
+
+  return true;
+ error_exit:
+  free(program_name);
+  exit(rc);
+}
+
+static void
+log_handler (cdio_log_level_t level, const char message[])
+{
+  if (level == CDIO_LOG_DEBUG && opts.debug_level < 2)
+    return;
+
+  if (level == CDIO_LOG_INFO  && opts.debug_level < 1)
+    return;
+
+  if (level == CDIO_LOG_WARN  && opts.debug_level < 0)
+    return;
+
+  gl_default_cdio_log_handler (level, message);
+}
+
+static void
+init(void)
+{
+  opts.debug_level   = 0;
+  opts.source_image  = INPUT_UNKNOWN;
+  opts.format        = FORMAT_TEXT;
+  opts.i_zones       = 10;
+  opts.i_zone_blocks = 1000;
+  opts.i_chunk       = 16;
+  opts.i_seeks       = 100;
+  opts.i_seed        = 1;
+  opts.ai_chunks[0]  = 1;
+  opts.ai_chunks[1]  = 4;
+  opts.ai_chunks[2]  = 16;
+  opts.ai_chunks[3]  = 26;
+  opts.i_chunks      = 4;
+  opts.ab_method[METHOD_DATA] = true;
+  opts.ab_method[METHOD_MMC]  = true;
+
+  gl_default_cdio_log_handler = cdio_log_set_handler (log_handler);
+}
+
+/* Microseconds from some fixed time. */
+static uint64_t
+get_us(const CdIo_t *p_cdio)
+{
+  if (b_emulated_clock) {
+    const char *psz_us = cdio_get_arg(p_cdio, "emu-elapsed-us");
+    return psz_us ? strtoull(psz_us, NULL, 10) : 0;
+  } else {
+#ifdef HAVE_GETTIMEOFDAY
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t) tv.tv_sec * 1000000 + (uint64_t) tv.tv_usec;
+#else
+    return (uint64_t) time(NULL) * 1000000;
+#endif
+  }
+}
+
+/* A small generator of our own, so a seed gives the same seeks
+   everywhere. */
+static uint32_t
+next_random(unsigned long *p_state)
+{
+  uint32_t x = (uint32_t) *p_state;
+
+  if (!x) x = 0x9e3779b9;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *p_state = x;
+  return x;
+}
+
+static uint16_t
+get_blocksize(method_t method)
+{
+  return (METHOD_DATA == method) ? ISO_BLOCKSIZE : CDIO_CD_FRAMESIZE_RAW;
+}
+
+static driver_return_code_t
+read_blocks(const CdIo_t *p_cdio, method_t method, void *p_buf, lsn_t i_lsn,
+            uint32_t i_blocks)
+{
+  if (METHOD_DATA == method)
+    return cdio_read_data_sectors(p_cdio, p_buf, i_lsn, ISO_BLOCKSIZE,
+                                  i_blocks);
+  /* Any sector type, everything in it but subchannels. */
+  return mmc_read_cd(p_cdio, p_buf, i_lsn, 0, false, true, 3, true, true,
+                     0, 0, CDIO_CD_FRAMESIZE_RAW, i_blocks);
+}
+
+/* Read i_blocks sectors from i_lsn, i_chunk at a time, timing each
+   read. */
+static void
+time_reads(const CdIo_t *p_cdio, method_t method, uint8_t *p_buf,
+           lsn_t i_lsn, uint32_t i_blocks, uint32_t i_chunk,
+           result_t *p_result)
+{
+  uint32_t i_done;
+
+  p_result->method   = method;
+  p_result->i_lsn    = i_lsn;
+  p_result->i_blocks = i_blocks;
+  for (i_done = 0; i_done < i_blocks; i_done += i_chunk) {
+    const uint32_t i_count =
+      (i_blocks - i_done < i_chunk) ? i_blocks - i_done : i_chunk;
+    const uint64_t i_start = get_us(p_cdio);
+    driver_return_code_t rc =
+      read_blocks(p_cdio, method, p_buf, i_lsn + i_done, i_count);
+    const uint64_t i_us = get_us(p_cdio) - i_start;
+
+    if (DRIVER_OP_SUCCESS != rc) {
+      dbg_print(1, "%s read of %u at %lu: %s\n", method_names[method],
+                (unsigned int) i_count, (long unsigned int) (i_lsn + i_done),
+                cdio_driver_errmsg(rc));
+      p_result->i_errors++;
+    }
+    if (!p_result->i_reads || i_us < p_result->i_min_us)
+      p_result->i_min_us = i_us;
+    if (i_us > p_result->i_max_us)
+      p_result->i_max_us = i_us;
+    p_result->i_us += i_us;
+    p_result->i_reads++;
+  }
+}
+
+/* Write a string as JSON. */
+static void
+print_json_string(const char *psz)
+{
+  putchar('"');
+  for ( ; *psz; psz++) {
+    const unsigned char c = (unsigned char) *psz;
+    if ('"' == c || '\\' == c)
+      printf("\\%c", c);
+    else if (c < 0x20)
+      printf("\\u%04x", c);
+    else
+      putchar(c);
+  }
+  putchar('"');
+}
+
+static void
+print_start(const CdIo_t *p_cdio, lsn_t i_start, lsn_t i_end)
+{
+  switch (opts.format) {
+  case FORMAT_TEXT:
+    printf("Source %s, driver %s, sectors %lu-%lu, %s time\n\n",
+           source_name ? source_name : cdio_get_arg(p_cdio, "source"),
+           cdio_get_driver_name(p_cdio), (long unsigned int) i_start,
+           (long unsigned int) i_end - 1,
+           b_emulated_clock ? "emulated" : "elapsed");
+    printf("%-6s %-6s %6s %7s %7s %6s %12s %9s %9s %9s %9s\n",
+           "test", "method", "param", "lsn", "blocks", "errors", "us",
+           "kB/s", "min ms", "avg ms", "max ms");
+    break;
+  case FORMAT_CSV:
+    printf("test,method,param,lsn,blocks,errors,us,kb_per_s,"
+           "min_ms,avg_ms,max_ms\n");
+    break;
+  case FORMAT_JSON:
+    printf("{\n  \"source\": ");
+    print_json_string(source_name ? source_name
+                      : cdio_get_arg(p_cdio, "source"));
+    printf(",\n  \"driver\": ");
+    print_json_string(cdio_get_driver_name(p_cdio));
+    printf(",\n  \"start\": %lu,\n  \"end\": %lu,\n  \"clock\": \"%s\",\n"
+           "  \"results\": [",
+           (long unsigned int) i_start, (long unsigned int) i_end,
+           b_emulated_clock ? "emulated" : "elapsed");
+    break;
+  }
+}
+
+static void
+print_result(const result_t *p_result)
+{
+  const uint32_t i_blocksize = get_blocksize(p_result->method);
+  const double f_kbs = p_result->i_us
+    ? (double) p_result->i_blocks * i_blocksize / 1024.0
+      / ((double) p_result->i_us / 1000000.0)
+    : 0.0;
+  const double f_min = p_result->i_min_us / 1000.0;
+  const double f_max = p_result->i_max_us / 1000.0;
+  const double f_avg = p_result->i_reads
+    ? p_result->i_us / 1000.0 / p_result->i_reads : 0.0;
+  const char *psz_method = method_names[p_result->method];
+
+  switch (opts.format) {
+  case FORMAT_TEXT:
+    printf("%-6s %-6s %6lu %7lu %7lu %6u %12llu %9.1f %9.3f %9.3f %9.3f\n",
+           p_result->psz_test, psz_method, p_result->i_param,
+           (long unsigned int) p_result->i_lsn,
+           (long unsigned int) p_result->i_blocks, p_result->i_errors,
+           (long long unsigned int) p_result->i_us, f_kbs, f_min, f_avg,
+           f_max);
+    break;
+  case FORMAT_CSV:
+    printf("%s,%s,%lu,%lu,%lu,%u,%llu,%.1f,%.3f,%.3f,%.3f\n",
+           p_result->psz_test, psz_method, p_result->i_param,
+           (long unsigned int) p_result->i_lsn,
+           (long unsigned int) p_result->i_blocks, p_result->i_errors,
+           (long long unsigned int) p_result->i_us, f_kbs, f_min, f_avg,
+           f_max);
+    break;
+  case FORMAT_JSON:
+    printf("%s\n    {\"test\": \"%s\", \"method\": \"%s\", \"param\": %lu, "
+           "\"lsn\": %lu, \"blocks\": %lu, \"errors\": %u, \"us\": %llu, "
+           "\"kb_per_s\": %.1f, \"min_ms\": %.3f, \"avg_ms\": %.3f, "
+           "\"max_ms\": %.3f}",
+           i_results ? "," : "", p_result->psz_test, psz_method,
+           p_result->i_param, (long unsigned int) p_result->i_lsn,
+           (long unsigned int) p_result->i_blocks, p_result->i_errors,
+           (long long unsigned int) p_result->i_us, f_kbs, f_min, f_avg,
+           f_max);
+    break;
+  }
+  i_results++;
+  fflush(stdout);
+}
+
+static void
+print_end(void)
+{
+  if (FORMAT_JSON == opts.format)
+    printf("%s]\n}\n", i_results ? "\n  " : "");
+}
+
+/* Set the drive speed, with MMC SET CD SPEED if the driver can, or
+   else as the driver does it. */
+static driver_return_code_t
+set_speed(const CdIo_t *p_cdio, unsigned int i_speed)
+{
+  driver_return_code_t rc =
+    mmc_set_speed(p_cdio, SPEED_MAX == i_speed ? 0xffff : (int) (176 * i_speed),
+                  0);
+  if (DRIVER_OP_UNSUPPORTED == rc || DRIVER_OP_NO_DRIVER == rc)
+    rc = cdio_set_speed(p_cdio, SPEED_MAX == i_speed ? 0xffff : (int) i_speed);
+  return rc;
+}
+
+/* Whether every sector from i_start up to i_end is in a data track. */
+static bool
+is_data_area(const CdIo_t *p_cdio, lsn_t i_start, lsn_t i_end)
+{
+  const track_t i_first = cdio_get_first_track_num(p_cdio);
+  const track_t i_last = cdio_get_last_track_num(p_cdio);
+  track_t i;
+
+  for (i = i_first; i <= i_last; i++) {
+    const lsn_t i_track_start = cdio_get_track_lsn(p_cdio, i);
+    const lsn_t i_track_end = cdio_get_track_lsn(p_cdio, i + 1);
+    if (i_track_start < i_end && i_track_end > i_start
+        && TRACK_FORMAT_AUDIO == cdio_get_track_format(p_cdio, i))
+      return false;
+  }
+  return true;
+}
+
+/* Run the tests with one read method. */
+static void
+bench_method(CdIo_t *p_cdio, method_t method, lsn_t i_start, lsn_t i_end,
+             uint8_t *p_buf)
+{
+  const uint32_t i_area = (uint32_t) (i_end - i_start);
+  const uint32_t i_zone_size = i_area / opts.i_zones;
+  unsigned long i_state = opts.i_seed;
+  unsigned int i;
+
+  /* Probe first, so a method the driver doesn't have is reported once
+     rather than as errors in every test. */
+  {
+    driver_return_code_t rc = read_blocks(p_cdio, method, p_buf, i_start, 1);
+    if (DRIVER_OP_UNSUPPORTED == rc || DRIVER_OP_NO_DRIVER == rc
+        || DRIVER_OP_NOT_PERMITTED == rc) {
+      report(stderr, "%s: skipping %s reads: %s\n", program_name,
+             method_names[method], cdio_driver_errmsg(rc));
+      return;
+    }
+  }
+  if (METHOD_DATA == method && !is_data_area(p_cdio, i_start, i_end)) {
+    report(stderr, "%s: skipping data reads: there are audio tracks here; "
+           "try --track\n", program_name);
+    return;
+  }
+
+  /* Sequential throughput, inside to outside. */
+  for (i = 0; i < opts.i_zones; i++) {
+    result_t result;
+    const lsn_t i_zone = i_start + (lsn_t) (i * i_zone_size);
+    uint32_t i_blocks = opts.i_zone_blocks;
+
+    if (i_blocks > i_zone_size) i_blocks = i_zone_size;
+    if (!i_blocks) break;
+    memset(&result, 0, sizeof(result));
+    result.psz_test = "zone";
+    result.i_param  = i;
+    /* Get the head there first, so it isn't counted. */
+    read_blocks(p_cdio, method, p_buf, i_zone, 1);
+    time_reads(p_cdio, method, p_buf, i_zone, i_blocks, opts.i_chunk,
+               &result);
+    print_result(&result);
+  }
+
+  /* Random seeks, each reading a chunk. */
+  if (opts.i_seeks && i_area > opts.i_chunk) {
+    result_t result;
+
+    memset(&result, 0, sizeof(result));
+    result.psz_test = "seek";
+    result.i_param  = opts.i_seeks;
+    for (i = 0; i < opts.i_seeks; i++) {
+      const lsn_t i_lsn =
+        i_start + (lsn_t) (next_random(&i_state) % (i_area - opts.i_chunk));
+      result_t one;
+
+      memset(&one, 0, sizeof(one));
+      time_reads(p_cdio, method, p_buf, i_lsn, opts.i_chunk, opts.i_chunk,
+                 &one);
+      result.i_errors += one.i_errors;
+      result.i_us     += one.i_us;
+      if (!result.i_reads || one.i_min_us < result.i_min_us)
+        result.i_min_us = one.i_min_us;
+      if (one.i_max_us > result.i_max_us)
+        result.i_max_us = one.i_max_us;
+      result.i_reads++;
+      result.i_blocks += opts.i_chunk;
+    }
+    result.method = method;
+    result.i_lsn  = i_start;
+    print_result(&result);
+  }
+
+  /* Read sizes, from the start of the area. */
+  for (i = 0; i < opts.i_chunks; i++) {
+    result_t result;
+    uint32_t i_blocks = opts.i_zone_blocks;
+
+    if (i_blocks > i_area) i_blocks = i_area;
+    memset(&result, 0, sizeof(result));
+    result.psz_test = "chunk";
+    result.i_param  = opts.ai_chunks[i];
+    read_blocks(p_cdio, method, p_buf, i_start, 1);
+    time_reads(p_cdio, method, p_buf, i_start, i_blocks, opts.ai_chunks[i],
+               &result);
+    print_result(&result);
+  }
+
+  /* Drive speeds, in the outermost zone, where they make the most
+     difference. */
+  for (i = 0; i < opts.i_speeds; i++) {
+    result_t result;
+    const lsn_t i_zone = i_start + (lsn_t) ((opts.i_zones - 1) * i_zone_size);
+    uint32_t i_blocks = opts.i_zone_blocks;
+    driver_return_code_t rc = set_speed(p_cdio, opts.ai_speeds[i]);
+
+    if (DRIVER_OP_SUCCESS != rc)
+      report(stderr, "%s: setting speed %u: %s\n", program_name,
+             opts.ai_speeds[i], cdio_driver_errmsg(rc));
+    if (i_blocks > (uint32_t) (i_end - i_zone))
+      i_blocks = (uint32_t) (i_end - i_zone);
+    memset(&result, 0, sizeof(result));
+    result.psz_test = "speed";
+    result.i_param  = opts.ai_speeds[i];
+    read_blocks(p_cdio, method, p_buf, i_zone, 1);
+    time_reads(p_cdio, method, p_buf, i_zone, i_blocks, opts.i_chunk,
+               &result);
+    print_result(&result);
+  }
+  if (opts.i_speeds)
+    set_speed(p_cdio, SPEED_MAX);
+}
+
+int
+main(int argc, char *argv[])
+{
+  CdIo_t *p_cdio = NULL;
+  uint8_t *p_buf;
+  lsn_t i_start, i_end;
+  unsigned int i, i_max_chunk;
+  int rc = EXIT_SUCCESS;
+
+  init();
+
+  parse_options(argc, argv);
+
+  print_version(program_name, VERSION,
+                opts.no_header || FORMAT_TEXT != opts.format,
+                opts.version_only);
+
+  if (opts.emulate) {
+    p_cdio = cdio_open(source_name, DRIVER_MMC_EMU);
+    if (!p_cdio) {
+      err_exit("Can't emulate a drive for %s\n", source_name);
+    }
+  } else
+    p_cdio = open_input(source_name, opts.source_image, NULL);
+
+  for (i = 0; i < opts.i_args; i++) {
+    char *psz_value = strchr(opts.apsz_args[i], '=');
+    driver_return_code_t arg_rc;
+
+    *psz_value++ = '\0';
+    arg_rc = cdio_set_arg(p_cdio, opts.apsz_args[i], psz_value);
+    if (DRIVER_OP_SUCCESS != arg_rc) {
+      err_exit("Can't set %s to %s: %s\n", opts.apsz_args[i], psz_value,
+               cdio_driver_errmsg(arg_rc));
+    }
+  }
+
+  {
+    const char *psz_sleep = cdio_get_arg(p_cdio, "emu-sleep");
+    b_emulated_clock = psz_sleep && !strcmp(psz_sleep, "false");
+  }
+
+  if (opts.i_track) {
+    if (opts.i_track < cdio_get_first_track_num(p_cdio)
+        || opts.i_track > cdio_get_last_track_num(p_cdio)) {
+      err_exit("There is no track %u\n", (unsigned int) opts.i_track);
+    }
+    i_start = cdio_get_track_lsn(p_cdio, opts.i_track);
+    i_end   = cdio_get_track_lsn(p_cdio, opts.i_track + 1);
+  } else {
+    i_start = cdio_get_track_lsn(p_cdio, cdio_get_first_track_num(p_cdio));
+    i_end   = cdio_get_disc_last_lsn(p_cdio);
+  }
+  if (CDIO_INVALID_LSN == i_start || CDIO_INVALID_LSN == i_end
+      || i_end <= i_start) {
+    err_exit("%s\n", "Can't find the sectors on the disc");
+  }
+
+  i_max_chunk = opts.i_chunk;
+  for (i = 0; i < opts.i_chunks; i++)
+    if (opts.ai_chunks[i] > i_max_chunk) i_max_chunk = opts.ai_chunks[i];
+  p_buf = malloc((size_t) i_max_chunk * CDIO_CD_FRAMESIZE_RAW);
+  if (!p_buf) {
+    err_exit("%s\n", "Out of memory");
+  }
+
+  print_start(p_cdio, i_start, i_end);
+  for (i = 0; i < METHOD_COUNT; i++)
+    if (opts.ab_method[i])
+      bench_method(p_cdio, (method_t) i, i_start, i_end, p_buf);
+  print_end();
+  if (!i_results) {
+    report(stderr, "%s: nothing could be measured\n", program_name);
+    rc = EXIT_FAILURE;
+  }
+
+  free(p_buf);
+  for (i = 0; i < opts.i_args; i++)
+    free(opts.apsz_args[i]);
+  free(source_name);
+  free(program_name);
+  cdio_destroy(p_cdio);
+
+  return rc;
+}
@@ -46,7 +46,8 @@
 
 #include "getopt.h"
 
-#define CEILING(x, y) ((x+(y-1))/y)
+/* How much of a UDF file is read at a time */
+#define UDF_READ_CHUNK (1024 * UDF_BLOCKSIZE)
 
 /* Used by `main' to communicate with `parse_opt'. And global options
  */
@@ -304,17 +305,25 @@ static int read_udf_file(const char *iso_name, const char *src,
 
     {
       uint64_t i_file_length = udf_get_file_length(p_udf_file);
-      const unsigned int i_blocks = (unsigned int) CEILING(i_file_length, UDF_BLOCKSIZE);
-      unsigned int i;
-      for (i = 0; i < i_blocks ; i++) {
-        char buf[UDF_BLOCKSIZE] = {'\0',};
-        ssize_t i_read = udf_read_block(p_udf_file, buf, 1);
-
-        if ( i_read < 0 ) {
-          fprintf(stderr, "Error reading UDF file %s at block %u\n",
-                  src, i);
-	  free(p_udf_file);
-	  udf_dirent_free(p_udf_root);
+      uint64_t i_offset;
+      char *buf = malloc(UDF_READ_CHUNK);
+
+      if (!buf) {
+        fprintf(stderr, "Couldn't allocate %u bytes\n", UDF_READ_CHUNK);
+        udf_dirent_free(p_udf_file);
+        udf_dirent_free(p_udf_root);
+        return 4;
+      }
+
+      for (i_offset = 0; i_offset < i_file_length; ) {
+        ssize_t i_read = udf_pread(p_udf_file, buf, UDF_READ_CHUNK, i_offset);
+
+        if ( i_read <= 0 ) {
+          fprintf(stderr, "Error reading UDF file %s at block %lu\n",
+                  src, (unsigned long) (i_offset / UDF_BLOCKSIZE));
+          free(buf);
+          udf_dirent_free(p_udf_file);
+          udf_dirent_free(p_udf_root);
           return 4;
         }
 
@@ -322,13 +331,16 @@ static int read_udf_file(const char *iso_name, const char *src,
 
         if (ferror (outfd)) {
           perror ("fwrite()");
-	  free(p_udf_file);
-	  udf_dirent_free(p_udf_root);
+          free(buf);
+          udf_dirent_free(p_udf_file);
+          udf_dirent_free(p_udf_root);
           return 5;
         }
+        i_offset += i_read;
       }
 
-      free(p_udf_file);
+      free(buf);
+      udf_dirent_free(p_udf_file);
       udf_dirent_free(p_udf_root);
       udf_close(p_udf);
       *bytes_written = i_file_length;
@@ -0,0 +1,48 @@
+#!/bin/sh
+#   Copyright (C) 2026 agent <agent@local>
+#
+#   This program is free software: you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation, either version 3 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Tests cd-bench on the MMC drive emulator, whose time is counted
+# rather than measured, so the results are always the same.
+
+if test -z $srcdir ; then
+  srcdir=`pwd`
+fi
+
+if test "X$top_builddir" = "X" ; then
+  top_builddir=`pwd`/..
+fi
+
+. ${top_builddir}/test/check_common_fn
+
+if test ! -x ../src/cd-bench ; then
+  exit 77
+fi
+
+fname=isofs-m1
+testnum=EMULATED
+opts="-E ${srcdir}/data/${fname}.cue -f csv -z 4 -n 50 -s 10 -k 1,16 -S 4,max
+      -A emu-command-us=200 -A emu-block-us=100 -A emu-seek-min-us=1000
+      -A emu-seek-max-us=100000 -A emu-bad-sectors=20 -A emu-error-us=500"
+test_common cd-bench "$opts" cd-bench.dump ${srcdir}/cd-bench.right
+RC=$?
+check_result $RC "cd-bench test $testnum" "../src/cd-bench $opts"
+
+exit $RC
+
+#;;; Local Variables: ***
+#;;; mode:shell-script ***
+#;;; eval: (sh-set-shell "bash") ***
+#;;; End: ***
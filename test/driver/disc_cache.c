@@ -0,0 +1,252 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Unit test for the disc cache in lib/driver/disc_cache.c. A disc image
+   is opened several times with the MMC emulator, and the commands run
+   are counted to see what comes from the cache, in memory and on disk.
+   Only the first emulated drive is given CD-Text, so the others can
+   only have it from the cache.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/cdtext.h>
+#include <cdio/logging.h>
+#include <cdio/mmc_hl_cmds.h>
+
+#ifndef DATA_DIR
+#define DATA_DIR "../data"
+#endif
+
+#define IMAGE     DATA_DIR "/cdda.cue"
+#define CACHE_DIR "disc_cache.d"
+#define MCN       "0000010271955"
+#define TITLE     "Joyful Nights"
+
+static unsigned long
+get_commands(CdIo_t *p_cdio)
+{
+  const char *psz_value = cdio_get_arg(p_cdio, "emu-commands");
+  return psz_value ? strtoul(psz_value, NULL, 10) : 0;
+}
+
+/* Get the MCN, ISRC and CD-Text, and check them. The number of
+   commands it took is put in *pi_commands. */
+static int
+check_disc(CdIo_t *p_emu, const char *psz_what, unsigned long *pi_commands)
+{
+  const unsigned long i_before = get_commands(p_emu);
+  char *psz_mcn = cdio_get_mcn(p_emu);
+  char *psz_isrc = cdio_get_track_isrc(p_emu, 1);
+  uint8_t *p_cdtext_raw = cdio_get_cdtext_raw(p_emu);
+  cdtext_t *p_cdtext = cdio_get_cdtext(p_emu);
+  const char *psz_title = p_cdtext
+    ? cdtext_get_const(p_cdtext, CDTEXT_FIELD_TITLE, 0) : NULL;
+  int i_rc = 0;
+
+  *pi_commands = get_commands(p_emu) - i_before;
+  if (!psz_mcn || strcmp(psz_mcn, MCN) || psz_isrc
+      || !p_cdtext_raw || 1728 + 2 != CDIO_MMC_GET_LEN16(p_cdtext_raw)
+      || !psz_title || strcmp(psz_title, TITLE)) {
+    fprintf(stderr, "%s: MCN %s, ISRC %s, title %s\n", psz_what,
+            psz_mcn ? psz_mcn : "none", psz_isrc ? psz_isrc : "none",
+            psz_title ? psz_title : "none");
+    i_rc = 1;
+  }
+  cdio_free(psz_mcn);
+  cdio_free(psz_isrc);
+  cdio_free(p_cdtext_raw);
+  return i_rc;
+}
+
+static void
+clean_up(const char *psz_file)
+{
+  if (psz_file) remove(psz_file);
+#ifdef HAVE_UNISTD_H
+  rmdir(CACHE_DIR);
+#endif
+}
+
+int
+main(int argc, const char *argv[])
+{
+  CdIo_t *p_first, *p_emu = NULL;
+  char *psz_fingerprint, *psz_other;
+  char psz_file[sizeof(CACHE_DIR) + 32] = "";
+  unsigned long i_uncached, i_cached;
+  FILE *fp;
+  int i_rc = 0;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_ERROR;
+
+#ifdef HAVE_SYS_STAT_H
+  mkdir(CACHE_DIR, 0755);
+#endif
+  p_first = cdio_open(IMAGE, DRIVER_MMC_EMU);
+  if (!p_first
+      || DRIVER_OP_SUCCESS !=
+      cdio_set_arg(p_first, "emu-cdtext", DATA_DIR "/cdtext.cdt")
+      || DRIVER_OP_SUCCESS != cdio_disc_cache_enable(CACHE_DIR)) {
+    fprintf(stderr, "Can't set up %s with a cache in %s\n", IMAGE, CACHE_DIR);
+    cdio_destroy(p_first);
+    clean_up(NULL);
+    return 77;
+  }
+
+  /* Fingerprints. */
+  p_emu = cdio_open(IMAGE, DRIVER_BINCUE);
+  psz_fingerprint = cdio_get_disc_fingerprint(p_first);
+  psz_other = cdio_get_disc_fingerprint(p_emu);
+  cdio_destroy(p_emu);
+  p_emu = NULL;
+  if (!psz_fingerprint || 26 != strlen(psz_fingerprint)
+      || !psz_other || strcmp(psz_fingerprint, psz_other)
+      || DRIVER_OP_ERROR != cdio_disc_cache_enable(DATA_DIR "/cdda.cue")) {
+    fprintf(stderr, "Fingerprints %s and %s\n",
+            psz_fingerprint ? psz_fingerprint : "none",
+            psz_other ? psz_other : "none");
+    i_rc = 1;
+    goto done;
+  }
+  snprintf(psz_file, sizeof(psz_file), "%s/%s", CACHE_DIR, psz_fingerprint);
+
+  /* The first drive reads everything... */
+  if ((i_rc = check_disc(p_first, "first drive", &i_uncached)))
+    goto done;
+
+  /* ...and another has it all from memory. Once its driver has the
+     table of contents, each call only asks whether the media
+     changed. */
+  p_emu = cdio_open(IMAGE, DRIVER_MMC_EMU);
+  if (!p_emu || (i_rc = check_disc(p_emu, "second drive", &i_cached))) {
+    i_rc = 2;
+    goto done;
+  }
+  if (i_cached >= i_uncached
+      || (i_rc = check_disc(p_emu, "second drive", &i_cached))
+      || 4 != i_cached) {
+    fprintf(stderr, "Cached, %lu commands ran; not cached, %lu\n",
+            i_cached, i_uncached);
+    i_rc = 3;
+    goto done;
+  }
+  printf("-- Good! %lu commands from the cache, %lu without\n",
+         i_cached, i_uncached);
+
+  /* After a media change the table of contents is read again, and the
+     change is still reported. */
+  if (DRIVER_OP_SUCCESS != mmc_eject_media(p_emu)
+      || DRIVER_OP_SUCCESS != mmc_close_tray(p_emu)
+      || (i_rc = check_disc(p_emu, "changed media", &i_cached))
+      || i_cached <= 4
+      || 1 != cdio_get_media_changed(p_emu)
+      || 0 != cdio_get_media_changed(p_emu)) {
+    fprintf(stderr, "A media change wasn't noticed\n");
+    i_rc = 4;
+    goto done;
+  }
+  printf("-- Good! Media changes are noticed and still reported\n");
+
+  /* A new process would have it from the disk. */
+  cdio_destroy(p_emu);
+  cdio_disc_cache_disable();
+  cdio_disc_cache_enable(CACHE_DIR);
+  p_emu = cdio_open(IMAGE, DRIVER_MMC_EMU);
+  if (!p_emu || (i_rc = check_disc(p_emu, "from disk", &i_cached))
+      || i_cached >= i_uncached) {
+    fprintf(stderr, "The disk cache wasn't used\n");
+    i_rc = 5;
+    goto done;
+  }
+  printf("-- Good! %lu commands with the disk cache\n", i_cached);
+
+  /* A file for a different disc with the same fingerprint isn't
+     taken. */
+  cdio_destroy(p_emu);
+  cdio_disc_cache_disable();
+  fp = fopen(psz_file, "w");
+  if (fp) {
+    fprintf(fp, "# libcdio disc cache\ntoc 1 1 0:0 100\nmcn 9999999999999\n");
+    fclose(fp);
+  }
+  cdio_disc_cache_enable(CACHE_DIR);
+  p_emu = cdio_open(IMAGE, DRIVER_MMC_EMU);
+  cdio_set_arg(p_emu, "emu-cdtext", DATA_DIR "/cdtext.cdt");
+  if (!p_emu || (i_rc = check_disc(p_emu, "another disc's file", &i_cached))) {
+    fprintf(stderr, "Another disc's cache file was taken\n");
+    i_rc = 6;
+    goto done;
+  }
+  printf("-- Good! Another disc's cache file isn't taken\n");
+
+  /* CD-Text shorter than it says it is is read again. */
+  cdio_destroy(p_emu);
+  p_emu = NULL;
+  cdio_disc_cache_disable();
+  fp = fopen(psz_file, "r");
+  if (fp) {
+    char psz_header[100], psz_toc[1000];
+
+    if (fgets(psz_header, sizeof(psz_header), fp)
+        && fgets(psz_toc, sizeof(psz_toc), fp)) {
+      fclose(fp);
+      fp = fopen(psz_file, "w");
+      if (fp) fprintf(fp, "%s%scdtext 0026\n", psz_header, psz_toc);
+    }
+    if (fp) fclose(fp);
+  }
+  cdio_disc_cache_enable(CACHE_DIR);
+  p_emu = cdio_open(IMAGE, DRIVER_MMC_EMU);
+  cdio_set_arg(p_emu, "emu-cdtext", DATA_DIR "/cdtext.cdt");
+  if (!p_emu || (i_rc = check_disc(p_emu, "short CD-Text", &i_cached))) {
+    fprintf(stderr, "Short CD-Text in the cache was taken\n");
+    i_rc = 7;
+    goto done;
+  }
+  printf("-- Good! Short CD-Text in a cache file isn't taken\n");
+
+ done:
+  cdio_destroy(p_emu);
+  cdio_destroy(p_first);
+  cdio_disc_cache_disable();
+  clean_up(psz_file[0] ? psz_file : NULL);
+  cdio_free(psz_fingerprint);
+  cdio_free(psz_other);
+  return i_rc;
+}
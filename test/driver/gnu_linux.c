@@ -34,8 +34,158 @@
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
 
 #include "helper.h"
+#include <cdio/cd_types.h>
+
+#define SYS_BLOCK "gnu_linux.sys"
+#define DEV_DIR   "gnu_linux.dev"
+
+/* Make a file holding psz_text, or an empty one. */
+static void
+make_file(const char *psz_path, const char *psz_text)
+{
+  FILE *fp = fopen(psz_path, "w");
+  if (fp) {
+    if (psz_text) fputs(psz_text, fp);
+    fclose(fp);
+  }
+}
+
+/* Make or remove a fake /sys/block and /dev with 16 SCSI CD drives,
+   one IDE one, a disk, a loop device, and a CD drive with no device
+   node. */
+static void
+fake_sysfs(bool b_make)
+{
+  static const char *apsz_names[] = {"sda", "hdc", "loop0", "sr16"};
+  char psz_path[100];
+  unsigned int i;
+
+  for (i = 0; i < 20; i++) {
+    char psz_name[10];
+    const char *psz_type = "5\n";
+
+    if (i < 17)
+      snprintf(psz_name, sizeof(psz_name), "sr%u", i);
+    else
+      strcpy(psz_name, apsz_names[i - 17]);
+    if (!strcmp(psz_name, "sda")) psz_type = "0\n";
+    if (!strcmp(psz_name, "loop0")) psz_type = NULL;
+
+    if (b_make) {
+      snprintf(psz_path, sizeof(psz_path), "%s/%s", SYS_BLOCK, psz_name);
+      mkdir(psz_path, 0755);
+      if (psz_type) {
+        strcat(psz_path, "/device");
+        mkdir(psz_path, 0755);
+        if (strcmp(psz_name, "hdc")) {
+          strcat(psz_path, "/type");
+          make_file(psz_path, psz_type);
+        } else {
+          strcat(psz_path, "/media");
+          make_file(psz_path, "cdrom\n");
+        }
+      }
+      if (strcmp(psz_name, "sr16")) {
+        snprintf(psz_path, sizeof(psz_path), "%s/%s", DEV_DIR, psz_name);
+        make_file(psz_path, NULL);
+      }
+    } else {
+      snprintf(psz_path, sizeof(psz_path), "%s/%s/device/type", SYS_BLOCK,
+               psz_name);
+      remove(psz_path);
+      snprintf(psz_path, sizeof(psz_path), "%s/%s/device/media", SYS_BLOCK,
+               psz_name);
+      remove(psz_path);
+      snprintf(psz_path, sizeof(psz_path), "%s/%s/device", SYS_BLOCK,
+               psz_name);
+      rmdir(psz_path);
+      snprintf(psz_path, sizeof(psz_path), "%s/%s", SYS_BLOCK, psz_name);
+      rmdir(psz_path);
+      snprintf(psz_path, sizeof(psz_path), "%s/%s", DEV_DIR, psz_name);
+      remove(psz_path);
+    }
+  }
+  if (!b_make) {
+    rmdir(SYS_BLOCK);
+    rmdir(DEV_DIR);
+  }
+}
+
+static double
+get_ms(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/* Drives are found from a fake sysfs tree without opening any, in
+   order, and those that don't answer don't hold the others up. */
+static void
+check_sysfs(void)
+{
+  char **ppsz_drives, **ppsz_found;
+  char psz_expect[100];
+  driver_id_t driver_id;
+  unsigned int i;
+  double f_start;
+
+  mkdir(SYS_BLOCK, 0755);
+  mkdir(DEV_DIR, 0755);
+  fake_sysfs(true);
+  f_start = get_ms();
+  ppsz_drives = cdio_get_devices_sysfs_linux(SYS_BLOCK, DEV_DIR);
+  if (!ppsz_drives) {
+    printf("Can't scan a sysfs tree here. Skipping that test.\n");
+    fake_sysfs(false);
+    return;
+  }
+  for (i = 0; i < 17; i++) {
+    if (0 == i)
+      snprintf(psz_expect, sizeof(psz_expect), "%s/hdc", DEV_DIR);
+    else
+      snprintf(psz_expect, sizeof(psz_expect), "%s/sr%u", DEV_DIR, i - 1);
+    if (!ppsz_drives[i] || strcmp(ppsz_drives[i], psz_expect)) {
+      fprintf(stderr, "sysfs drive %u is %s, not %s\n", i,
+              ppsz_drives[i] ? ppsz_drives[i] : "missing", psz_expect);
+      fake_sysfs(false);
+      exit(10);
+    }
+  }
+  if (ppsz_drives[17]) {
+    fprintf(stderr, "sysfs gave another drive, %s\n", ppsz_drives[17]);
+    fake_sysfs(false);
+    exit(11);
+  }
+  printf("-- Good! 17 drives from sysfs in %.1f ms\n", get_ms() - f_start);
+
+  /* None of these can be opened. Whatever else, they are all looked
+     at together. */
+  cdio_set_device_probe_timeout(1000);
+  ppsz_found = cdio_get_devices_with_cap_ret(ppsz_drives, CDIO_FS_AUDIO,
+                                             false, &driver_id);
+  if (!ppsz_found || ppsz_found[0]) {
+    fprintf(stderr, "A drive that isn't there was matched\n");
+    fake_sysfs(false);
+    exit(12);
+  }
+  cdio_free_device_list(ppsz_found);
+  cdio_set_device_probe_timeout(0);
+  printf("-- Good! 17 drives probed in %.1f ms\n", get_ms() - f_start);
+  cdio_free_device_list(ppsz_drives);
+  fake_sysfs(false);
+}
 
 int
 main(int argc, const char *argv[])
@@ -45,6 +195,7 @@ main(int argc, const char *argv[])
   
   cdio_log_set_handler(log_handler);
   cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_INFO;
+  check_sysfs();
   /* snprintf(psz_nrgfile, sizeof(psz_nrgfile)-1,
              "%s/%s", TEST_DIR, cue_file[i]);
   */
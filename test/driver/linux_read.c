@@ -0,0 +1,243 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Unit test for data sector reads in lib/driver/gnu_linux.c. A scratch
+   file is attached to a loop device which the GNU/Linux driver then
+   reads, buffered and with direct I/O. Attaching needs root, so the
+   test is skipped without it.
+
+   A loop device has no TOC, which cdio_read_mode1_sectors() and the
+   like check reads against, so the driver's read routines are called
+   directly.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include "cdio_private.h"
+
+#ifdef HAVE_LINUX_CDROM
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/loop.h>
+
+#define IMAGE_BLOCKS 300
+
+/* Every block holds its LSN in each of its words. */
+static void
+fill_block(uint8_t *p_block, uint32_t i_lsn)
+{
+  unsigned int i;
+
+  for (i = 0; i < CDIO_CD_FRAMESIZE; i += sizeof(i_lsn))
+    memcpy(p_block + i, &i_lsn, sizeof(i_lsn));
+}
+
+static int
+check_blocks(const char *psz_what, driver_return_code_t rc,
+             const uint8_t *p_buf, lsn_t i_lsn, uint32_t i_blocks)
+{
+  uint8_t block[CDIO_CD_FRAMESIZE];
+  uint32_t i;
+
+  if (DRIVER_OP_SUCCESS != rc) {
+    fprintf(stderr, "%s of %u blocks at %d failed: %d\n", psz_what,
+            i_blocks, i_lsn, rc);
+    return 1;
+  }
+  for (i = 0; i < i_blocks; i++) {
+    fill_block(block, i_lsn + i);
+    if (0 != memcmp(block, p_buf + i * CDIO_CD_FRAMESIZE, sizeof(block))) {
+      fprintf(stderr, "%s: block %u of %u at %d is wrong\n", psz_what, i,
+              i_blocks, i_lsn);
+      return 2;
+    }
+  }
+  return 0;
+}
+
+/* The reads every way of opening the device must get right. p_buf
+   need not be aligned. */
+static int
+check_reads(CdIo_t *p_cdio, uint8_t *p_buf)
+{
+  int i_rc;
+
+  memset(p_buf, 0, IMAGE_BLOCKS * CDIO_CD_FRAMESIZE);
+  if ((i_rc = check_blocks("read_mode1_sectors",
+                           p_cdio->op.read_mode1_sectors(p_cdio->env, p_buf,
+                                                         10, false, 200),
+                           p_buf, 10, 200)))
+    return i_rc;
+  memset(p_buf, 0, IMAGE_BLOCKS * CDIO_CD_FRAMESIZE);
+  if ((i_rc = check_blocks("read_mode1_sector",
+                           p_cdio->op.read_mode1_sector(p_cdio->env, p_buf,
+                                                        299, false),
+                           p_buf, 299, 1)))
+    return i_rc;
+  memset(p_buf, 0, IMAGE_BLOCKS * CDIO_CD_FRAMESIZE);
+  if ((i_rc = check_blocks("read_data_sectors",
+                           p_cdio->op.read_data_sectors(p_cdio->env, p_buf, 0,
+                                                        CDIO_CD_FRAMESIZE,
+                                                        IMAGE_BLOCKS),
+                           p_buf, 0, IMAGE_BLOCKS)))
+    return i_rc;
+
+  /* The device ends before these do. */
+  if (DRIVER_OP_SUCCESS ==
+      p_cdio->op.read_mode1_sectors(p_cdio->env, p_buf, 290, false, 20)) {
+    fprintf(stderr, "a read past the end of the device succeeded\n");
+    return 3;
+  }
+  return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  char psz_image[] = "linux_read.XXXXXX";
+  char psz_loop[64];
+  uint8_t *p_buf = malloc(IMAGE_BLOCKS * CDIO_CD_FRAMESIZE + 1);
+  int i_image_fd, i_control_fd, i_loop_fd, i_loop;
+  CdIo_t *p_cdio;
+  const char *psz_direct_io;
+  uint32_t i;
+  int i_rc = 0;
+
+  if (!p_buf) return 20;
+  if (!cdio_have_driver(DRIVER_LINUX)) return 77;
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_ERROR;
+
+  i_control_fd = open("/dev/loop-control", O_RDWR);
+  if (i_control_fd < 0) {
+    printf("-- Can't use loop devices; skipping\n");
+    free(p_buf);
+    return 77;
+  }
+
+  i_image_fd = mkstemp(psz_image);
+  if (i_image_fd < 0) return 21;
+  for (i = 0; i < IMAGE_BLOCKS; i++) {
+    fill_block(p_buf, i);
+    if (CDIO_CD_FRAMESIZE != write(i_image_fd, p_buf, CDIO_CD_FRAMESIZE))
+      return 22;
+  }
+
+  i_loop = ioctl(i_control_fd, LOOP_CTL_GET_FREE);
+  close(i_control_fd);
+  snprintf(psz_loop, sizeof(psz_loop), "/dev/loop%d", i_loop);
+  i_loop_fd = (i_loop < 0) ? -1 : open(psz_loop, O_RDWR);
+  if (i_loop_fd < 0 || 0 != ioctl(i_loop_fd, LOOP_SET_FD, i_image_fd)) {
+    printf("-- Can't attach a loop device; skipping\n");
+    if (i_loop_fd >= 0) close(i_loop_fd);
+    close(i_image_fd);
+    unlink(psz_image);
+    free(p_buf);
+    return 77;
+  }
+
+  p_cdio = cdio_open_linux(psz_loop);
+  if (!p_cdio) {
+    fprintf(stderr, "cdio_open_linux(%s) failed\n", psz_loop);
+    i_rc = 23;
+    goto done;
+  }
+
+  /* Buffered, in as few reads as possible and then in many. */
+  if ((i_rc = check_reads(p_cdio, p_buf))) goto done;
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(p_cdio, "mmc-max-transfer", "6144")) {
+    i_rc = 24;
+    goto done;
+  }
+  if ((i_rc = check_reads(p_cdio, p_buf + 1))) goto done;
+
+  /* Direct, into aligned and unaligned memory. */
+  if (DRIVER_OP_BAD_PARAMETER !=
+      cdio_set_arg(p_cdio, "direct-io", "maybe")) {
+    i_rc = 25;
+    goto done;
+  }
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(p_cdio, "direct-io", "true")) {
+    printf("-- Direct I/O isn't available here; not checking it\n");
+  } else {
+    uint8_t *p_aligned = NULL;
+
+    psz_direct_io = cdio_get_arg(p_cdio, "direct-io");
+    if (!psz_direct_io || 0 != strcmp(psz_direct_io, "true")) {
+      i_rc = 26;
+      goto done;
+    }
+    if (0 != posix_memalign((void **) &p_aligned, 4096,
+                            IMAGE_BLOCKS * CDIO_CD_FRAMESIZE)) {
+      i_rc = 27;
+      goto done;
+    }
+    i_rc = check_reads(p_cdio, p_aligned);
+    free(p_aligned);
+    if (i_rc) goto done;
+    if ((i_rc = check_reads(p_cdio, p_buf + 1))) goto done;
+    if (DRIVER_OP_SUCCESS != cdio_set_arg(p_cdio, "mmc-max-transfer", "0")
+        || (i_rc = check_reads(p_cdio, p_buf + 1))) {
+      if (!i_rc) i_rc = 28;
+      goto done;
+    }
+
+    if (DRIVER_OP_SUCCESS != cdio_set_arg(p_cdio, "direct-io", "false")
+        || 0 != strcmp(cdio_get_arg(p_cdio, "direct-io"), "false")) {
+      i_rc = 29;
+      goto done;
+    }
+  }
+  if ((i_rc = check_reads(p_cdio, p_buf))) goto done;
+  printf("-- Good! data sectors of %s read buffered and direct\n", psz_loop);
+
+ done:
+  cdio_destroy(p_cdio);
+  ioctl(i_loop_fd, LOOP_CLR_FD, 0);
+  close(i_loop_fd);
+  close(i_image_fd);
+  unlink(psz_image);
+  free(p_buf);
+  return i_rc;
+}
+
+#else
+
+int
+main(int argc, const char *argv[])
+{
+  printf("-- Not GNU/Linux; skipping\n");
+  return 77;
+}
+
+#endif /* HAVE_LINUX_CDROM */
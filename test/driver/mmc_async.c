@@ -0,0 +1,347 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Unit test for queueing MMC commands with mmc_submit_cmd() and
+   collecting them with mmc_reap_cmds(), against stand-ins for a
+   driver: one that can only run commands as they come and one with a
+   queue of its own, so that no drive is needed.
+
+   To compile as standalone program:
+gcc -g3 -Wall -DHAVE_CONFIG_H -I../.. -I../../include -I../../lib/driver mmc_async.c ../../lib/driver/.libs/libcdio.a -o mmc_async
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/mmc_async.h>
+#include "cdio_private.h"
+
+#define BAD_LSN   666
+#define QUEUE_LEN 4
+#define COMMANDS  6
+
+/* A stand-in for a driver and its drive. */
+typedef struct {
+  generic_img_private_t gen;    /* must come first, as in real drivers */
+  unsigned int i_run;           /* commands run as they came */
+  mmc_async_cmd_t *ap_queue[QUEUE_LEN];
+  unsigned int i_queued;
+  int ai_pipe[2];               /* a byte in it for each queued command */
+  bool b_reap_fails;
+} fake_drive_t;
+
+/* Answer a READ CD by putting the LBA of each block at its start. A
+   read of BAD_LSN fails with a MEDIUM ERROR. */
+static driver_return_code_t
+read_cd_fake(fake_drive_t *p_drive, unsigned int i_cdb,
+             const mmc_cdb_t *p_cdb, unsigned int i_buf, void *p_buf)
+{
+  const uint8_t *f = p_cdb->field;
+  const uint32_t i_lba =
+    ((uint32_t) f[2] << 24) | (f[3] << 16) | (f[4] << 8) | f[5];
+  const uint32_t i_blocks = (f[6] << 16) | (f[7] << 8) | f[8];
+  uint32_t i;
+
+  p_drive->gen.scsi_mmc_sense_valid = 0;
+  if (12 != i_cdb || CDIO_MMC_GPCMD_READ_CD != f[0]
+      || i_buf != i_blocks * CDIO_CD_FRAMESIZE_RAW)
+    return DRIVER_OP_BAD_PARAMETER;
+  if (BAD_LSN == i_lba) {
+    memset(p_drive->gen.scsi_mmc_sense, 0, 18);
+    p_drive->gen.scsi_mmc_sense[0] = 0x70;
+    p_drive->gen.scsi_mmc_sense[2] = 0x03;  /* MEDIUM ERROR */
+    p_drive->gen.scsi_mmc_sense[7] = 10;
+    p_drive->gen.scsi_mmc_sense_valid = 18;
+    return DRIVER_OP_ERROR;
+  }
+  for (i = 0; i < i_blocks; i++) {
+    const uint32_t i_block_lba = i_lba + i;
+    memcpy((uint8_t *) p_buf + i * CDIO_CD_FRAMESIZE_RAW, &i_block_lba,
+           sizeof(i_block_lba));
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+static driver_return_code_t
+run_mmc_cmd_fake(void *p_user_data, unsigned int i_timeout_ms,
+                 unsigned int i_cdb, const mmc_cdb_t *p_cdb,
+                 cdio_mmc_direction_t e_direction,
+                 unsigned int i_buf, /*in/out*/ void *p_buf)
+{
+  fake_drive_t *p_drive = p_user_data;
+
+  p_drive->i_run++;
+  return read_cd_fake(p_drive, i_cdb, p_cdb, i_buf, p_buf);
+}
+
+/* Queue up to QUEUE_LEN commands, and refuse the rest. */
+static driver_return_code_t
+submit_mmc_cmd_fake(void *p_user_data, mmc_async_cmd_t *p_cmd)
+{
+  fake_drive_t *p_drive = p_user_data;
+
+  if (0 != p_cmd->cdb.field[1] && CDIO_MMC_GPCMD_READ_CD != p_cmd->cdb.field[0])
+    return DRIVER_OP_NOT_PERMITTED;
+  if (QUEUE_LEN == p_drive->i_queued) return DRIVER_OP_UNSUPPORTED;
+  p_drive->ap_queue[p_drive->i_queued++] = p_cmd;
+  if (1 != write(p_drive->ai_pipe[1], "c", 1)) return DRIVER_OP_ERROR;
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Finish the most recently queued commands first. */
+static int
+reap_mmc_cmds_fake(void *p_user_data, mmc_async_cmd_t *ap_done[],
+                   unsigned int i_max, int i_timeout_ms)
+{
+  fake_drive_t *p_drive = p_user_data;
+  unsigned int i_done = 0;
+
+  if (p_drive->b_reap_fails) return DRIVER_OP_ERROR;
+  while (i_done < i_max && p_drive->i_queued > 0) {
+    mmc_async_cmd_t *p_cmd = p_drive->ap_queue[--p_drive->i_queued];
+    char c;
+
+    if (1 != read(p_drive->ai_pipe[0], &c, 1)) return DRIVER_OP_ERROR;
+    p_cmd->i_status = read_cd_fake(p_drive, p_cmd->i_cdb, &p_cmd->cdb,
+                                   p_cmd->i_buf, p_cmd->p_buf);
+    p_cmd->i_sense = p_drive->gen.scsi_mmc_sense_valid;
+    memcpy(&p_cmd->sense, p_drive->gen.scsi_mmc_sense, p_cmd->i_sense);
+    ap_done[i_done++] = p_cmd;
+  }
+  return (int) i_done;
+}
+
+static int
+get_mmc_completion_fd_fake(void *p_user_data)
+{
+  return ((fake_drive_t *) p_user_data)->ai_pipe[0];
+}
+
+/* Check a finished command read what it was asked to. */
+static int
+check_cmd(const mmc_async_cmd_t *p_cmd)
+{
+  const uint32_t i_lsn = (uint32_t) (size_t) p_cmd->p_user_data;
+  const uint32_t i_blocks = p_cmd->i_buf / CDIO_CD_FRAMESIZE_RAW;
+  uint32_t i;
+
+  if (BAD_LSN == i_lsn) {
+    if (DRIVER_OP_ERROR != p_cmd->i_status || 18 != p_cmd->i_sense
+        || 0x03 != p_cmd->sense.sense_key) {
+      fprintf(stderr, "the read at %u should have failed with sense\n",
+              i_lsn);
+      return 1;
+    }
+    return 0;
+  }
+  if (DRIVER_OP_SUCCESS != p_cmd->i_status || 0 != p_cmd->i_sense
+      || 12 != p_cmd->i_cdb) {
+    fprintf(stderr, "the read at %u failed: %d\n", i_lsn, p_cmd->i_status);
+    return 2;
+  }
+  for (i = 0; i < i_blocks; i++) {
+    uint32_t i_got;
+
+    memcpy(&i_got, (uint8_t *) p_cmd->p_buf + i * CDIO_CD_FRAMESIZE_RAW,
+           sizeof(i_got));
+    if (i_got != i_lsn + i) {
+      fprintf(stderr, "block %u read at %u holds %u\n", i, i_lsn, i_got);
+      return 3;
+    }
+  }
+  return 0;
+}
+
+/* Submit reads of 1, 2, ... blocks at each of ai_lsn. */
+static int
+submit_reads(CdIo_t *p_cdio, mmc_async_cmd_t a_cmd[], uint8_t *p_buf,
+             const lsn_t ai_lsn[])
+{
+  unsigned int i;
+
+  memset(p_buf, 0, COMMANDS * COMMANDS * CDIO_CD_FRAMESIZE_RAW);
+  for (i = 0; i < COMMANDS; i++) {
+    memset(&a_cmd[i], 0, sizeof(a_cmd[i]));
+    a_cmd[i].p_user_data = (void *) (size_t) ai_lsn[i];
+    a_cmd[i].i_status = DRIVER_OP_UNINIT;
+    mmc_prep_read_sectors(&a_cmd[i],
+                          p_buf + i * COMMANDS * CDIO_CD_FRAMESIZE_RAW,
+                          ai_lsn[i], 0, i + 1);
+    if (DRIVER_OP_SUCCESS != mmc_submit_cmd(p_cdio, &a_cmd[i])) {
+      fprintf(stderr, "submitting command %u failed\n", i);
+      return 10;
+    }
+    if (mmc_get_cmds_pending(p_cdio) != i + 1) {
+      fprintf(stderr, "%u commands pending after %u were submitted\n",
+              mmc_get_cmds_pending(p_cdio), i + 1);
+      return 11;
+    }
+  }
+  return 0;
+}
+
+/* Reap everything, i_max at a time, checking each command comes back
+   once. ai_order, if given, is the order they must come back in. */
+static int
+reap_all(CdIo_t *p_cdio, mmc_async_cmd_t a_cmd[], unsigned int i_max,
+         const unsigned int ai_order[])
+{
+  mmc_async_cmd_t *ap_done[COMMANDS];
+  bool ab_seen[COMMANDS];
+  unsigned int i_reaped = 0;
+  int i_rc;
+
+  memset(ab_seen, 0, sizeof(ab_seen));
+  while (i_reaped < COMMANDS) {
+    int i, i_got = mmc_reap_cmds(p_cdio, ap_done, i_max, -1);
+
+    if (i_got <= 0 || (unsigned int) i_got > i_max) {
+      fprintf(stderr, "mmc_reap_cmds() gave %d with %u commands left\n",
+              i_got, COMMANDS - i_reaped);
+      return 20;
+    }
+    for (i = 0; i < i_got; i++) {
+      const unsigned int i_cmd = ap_done[i] - a_cmd;
+
+      if (i_cmd >= COMMANDS || ab_seen[i_cmd]
+          || (ai_order && ai_order[i_reaped] != i_cmd)) {
+        fprintf(stderr, "command %u came back when it shouldn't have\n",
+                i_cmd);
+        return 21;
+      }
+      ab_seen[i_cmd] = true;
+      if ((i_rc = check_cmd(ap_done[i]))) return i_rc;
+      i_reaped++;
+    }
+    if (mmc_get_cmds_pending(p_cdio) != COMMANDS - i_reaped) return 22;
+  }
+
+  /* With nothing pending, there's nothing to wait for. */
+  if (0 != mmc_reap_cmds(p_cdio, ap_done, i_max, -1)) return 23;
+  return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  static const lsn_t ai_lsn[COMMANDS] = {0, 100, BAD_LSN, 7, 2000, 50};
+  static const unsigned int ai_in_order[COMMANDS] = {0, 1, 2, 3, 4, 5};
+  /* Commands 4 and 5 didn't fit in the queue and were run at once. */
+  static const unsigned int ai_queued_order[COMMANDS] = {4, 5, 3, 2, 1, 0};
+  mmc_async_cmd_t a_cmd[COMMANDS];
+  mmc_async_cmd_t *ap_done[COMMANDS];
+  uint8_t *p_buf = malloc(COMMANDS * COMMANDS * CDIO_CD_FRAMESIZE_RAW);
+  fake_drive_t drive;
+  CdIo_t cdio;
+  int i_rc;
+
+  if (!p_buf) return 1;
+  memset(&drive, 0, sizeof(drive));
+  memset(&cdio, 0, sizeof(cdio));
+  cdio.env = &drive;
+
+  /* Nothing can be run without a way to run commands. */
+  if (DRIVER_OP_UNSUPPORTED != mmc_submit_cmd(&cdio, &a_cmd[0])) return 2;
+  if (DRIVER_OP_UNINIT != mmc_submit_cmd(NULL, &a_cmd[0])
+      || DRIVER_OP_BAD_POINTER != mmc_submit_cmd(&cdio, NULL)
+      || DRIVER_OP_BAD_PARAMETER != mmc_reap_cmds(&cdio, ap_done, 0, 0)
+      || 0 != mmc_get_cmds_pending(&cdio))
+    return 3;
+
+  /* A driver that runs each command as it comes. */
+  cdio.op.run_mmc_cmd = run_mmc_cmd_fake;
+  if (-1 != mmc_get_completion_fd(&cdio)) return 4;
+  if ((i_rc = submit_reads(&cdio, a_cmd, p_buf, ai_lsn))) return i_rc;
+  if (COMMANDS != drive.i_run) return 5;
+  if ((i_rc = reap_all(&cdio, a_cmd, 4, ai_in_order))) return i_rc;
+  if ((i_rc = submit_reads(&cdio, a_cmd, p_buf, ai_lsn))) return i_rc;
+  if ((i_rc = reap_all(&cdio, a_cmd, 1, ai_in_order))) return i_rc;
+  printf("-- Good! commands run as they came were reaped in order\n");
+
+  /* A driver with a queue, which takes only so many. */
+  if (0 != pipe(drive.ai_pipe)) return 6;
+  cdio.op.submit_mmc_cmd = submit_mmc_cmd_fake;
+  cdio.op.reap_mmc_cmds = reap_mmc_cmds_fake;
+  cdio.op.get_mmc_completion_fd = get_mmc_completion_fd_fake;
+  if (drive.ai_pipe[0] != mmc_get_completion_fd(&cdio)) return 7;
+  drive.i_run = 0;
+  if ((i_rc = submit_reads(&cdio, a_cmd, p_buf, ai_lsn))) return i_rc;
+  if (QUEUE_LEN != drive.i_queued || COMMANDS - QUEUE_LEN != drive.i_run)
+    return 8;
+#ifdef HAVE_POLL_H
+  {
+    struct pollfd pfd;
+
+    pfd.fd = mmc_get_completion_fd(&cdio);
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (1 != poll(&pfd, 1, 0) || !(pfd.revents & POLLIN)) return 9;
+  }
+#endif
+  if ((i_rc = reap_all(&cdio, a_cmd, 3, ai_queued_order))) return i_rc;
+
+  /* A driver error when reaping is passed on once nothing else is
+     there to give, and the commands stay pending. */
+  if ((i_rc = submit_reads(&cdio, a_cmd, p_buf, ai_lsn))) return i_rc;
+  drive.b_reap_fails = true;
+  if (2 != mmc_reap_cmds(&cdio, ap_done, COMMANDS, 0)
+      || ap_done[0] != &a_cmd[4] || ap_done[1] != &a_cmd[5])
+    return 12;
+  if (DRIVER_OP_ERROR != mmc_reap_cmds(&cdio, ap_done, COMMANDS, 0)
+      || QUEUE_LEN != mmc_get_cmds_pending(&cdio))
+    return 13;
+  drive.b_reap_fails = false;
+  if (QUEUE_LEN != mmc_reap_cmds(&cdio, ap_done, COMMANDS, 0)
+      || 0 != mmc_get_cmds_pending(&cdio))
+    return 14;
+
+  /* Errors other than not being able to queue aren't papered over. */
+  drive.i_run = 0;
+  memset(&a_cmd[0], 0, sizeof(a_cmd[0]));
+  a_cmd[0].cdb.field[0] = CDIO_MMC_GPCMD_TEST_UNIT_READY;
+  a_cmd[0].cdb.field[1] = 1;
+  if (DRIVER_OP_NOT_PERMITTED != mmc_submit_cmd(&cdio, &a_cmd[0])
+      || 0 != drive.i_run || 0 != mmc_get_cmds_pending(&cdio))
+    return 15;
+  printf("-- Good! commands queued by the driver were reaped as they "
+         "finished\n");
+
+  close(drive.ai_pipe[0]);
+  close(drive.ai_pipe[1]);
+  free(p_buf);
+  return 0;
+}
@@ -0,0 +1,227 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Unit test for how MMC reads in lib/driver/mmc are split into
+   commands, against a stand-in for a driver's run_mmc_cmd, so that no
+   drive is needed.
+
+   To compile as standalone program:
+gcc -g3 -Wall -DHAVE_CONFIG_H -I../.. -I../../include -I../../lib/driver mmc_chunk.c ../../lib/driver/.libs/libcdio.a -o mmc_chunk
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/mmc.h>
+#include <cdio/mmc_ll_cmds.h>
+#include "cdio_private.h"
+
+#define MAX_CMDS 64
+
+/* What the stand-in driver was asked to do. */
+typedef struct {
+  unsigned int i_cmds;
+  unsigned int i_fail_at;       /* fail this command, counting from 1 */
+  uint32_t     ai_lba[MAX_CMDS];
+  uint32_t     ai_blocks[MAX_CMDS];
+  unsigned int ai_buf[MAX_CMDS];
+} fake_drive_t;
+
+/* Answer a READ CD by putting the LBA of each block at its start. */
+static driver_return_code_t
+run_mmc_cmd_fake(void *p_user_data, unsigned int i_timeout_ms,
+                 unsigned int i_cdb, const mmc_cdb_t *p_cdb,
+                 cdio_mmc_direction_t e_direction,
+                 unsigned int i_buf, /*in/out*/ void *p_buf)
+{
+  fake_drive_t *p_drive = p_user_data;
+  const uint8_t *f = p_cdb->field;
+  const uint32_t i_lba =
+    ((uint32_t) f[2] << 24) | (f[3] << 16) | (f[4] << 8) | f[5];
+  const uint32_t i_blocks = (f[6] << 16) | (f[7] << 8) | f[8];
+  uint32_t i_blocksize, i;
+
+  if (CDIO_MMC_GPCMD_READ_CD != f[0] || SCSI_MMC_DATA_READ != e_direction
+      || p_drive->i_cmds == MAX_CMDS || 0 == i_blocks)
+    return DRIVER_OP_ERROR;
+  p_drive->ai_lba[p_drive->i_cmds] = i_lba;
+  p_drive->ai_blocks[p_drive->i_cmds] = i_blocks;
+  p_drive->ai_buf[p_drive->i_cmds] = i_buf;
+  if (++p_drive->i_cmds == p_drive->i_fail_at)
+    return DRIVER_OP_ERROR;
+
+  i_blocksize = i_buf / i_blocks;
+  for (i = 0; i < i_blocks; i++) {
+    const uint32_t i_block_lba = i_lba + i;
+
+    memcpy((uint8_t *) p_buf + i * i_blocksize, &i_block_lba,
+           sizeof(i_block_lba));
+  }
+  return DRIVER_OP_SUCCESS;
+}
+
+/* Check that p_buf holds i_blocks blocks from i_lsn on, and that the
+   commands were for the block counts in ai_expected, ending in 0. */
+static int
+check_reads(const fake_drive_t *p_drive, const uint8_t *p_buf,
+            uint16_t i_blocksize, lsn_t i_lsn, uint32_t i_blocks,
+            const uint32_t ai_expected[])
+{
+  uint32_t i, i_next = i_lsn;
+
+  for (i = 0; ai_expected[i]; i++) {
+    if (i >= p_drive->i_cmds || p_drive->ai_blocks[i] != ai_expected[i]
+        || p_drive->ai_lba[i] != i_next
+        || p_drive->ai_buf[i] != ai_expected[i] * i_blocksize) {
+      fprintf(stderr, "command %u is not for %u blocks at %u\n",
+              i, ai_expected[i], i_next);
+      return 1;
+    }
+    i_next += ai_expected[i];
+  }
+  if (i != p_drive->i_cmds) {
+    fprintf(stderr, "%u commands were run, not %u\n", p_drive->i_cmds, i);
+    return 2;
+  }
+  for (i = 0; i < i_blocks; i++) {
+    uint32_t i_got;
+
+    memcpy(&i_got, p_buf + i * i_blocksize, sizeof(i_got));
+    if (i_got != i_lsn + i) {
+      fprintf(stderr, "block %u holds %u, not %u\n", i, i_got, i_lsn + i);
+      return 3;
+    }
+  }
+  return 0;
+}
+
+static int
+read_cd(CdIo_t *p_cdio, fake_drive_t *p_drive, uint8_t *p_buf,
+        uint16_t i_blocksize, lsn_t i_lsn, uint32_t i_blocks,
+        const uint32_t ai_expected[])
+{
+  memset(p_drive, 0, sizeof(*p_drive));
+  if (DRIVER_OP_SUCCESS !=
+      mmc_read_cd(p_cdio, p_buf, i_lsn, 0, false, false, 0, true, false,
+                  false, 0, i_blocksize, i_blocks)) {
+    fprintf(stderr, "mmc_read_cd() of %u blocks failed\n", i_blocks);
+    return 10;
+  }
+  return check_reads(p_drive, p_buf, i_blocksize, i_lsn, i_blocks,
+                     ai_expected);
+}
+
+int
+main(int argc, const char *argv[])
+{
+  static const uint32_t ai_default[]  = {16, 16, 8, 0};
+  static const uint32_t ai_64k[]      = {32, 32, 32, 4, 0};
+  static const uint32_t ai_64k_raw[]  = {27, 23, 0};
+  static const uint32_t ai_1k[]       = {1, 1, 1, 0};
+  static const uint32_t ai_2m[]       = {1024, 976, 0};
+  static const uint32_t ai_one_cmd[]  = {50, 0};
+  static const char *apsz_bad[] = {"", "abc", "-1", "12x", "99999999999"};
+  fake_drive_t drive;
+  CdIo_t cdio;
+  uint8_t *p_buf = malloc(2000 * CDIO_CD_FRAMESIZE_RAW);
+  unsigned int i;
+  int i_rc;
+
+  if (!p_buf) return 20;
+  memset(&cdio, 0, sizeof(cdio));
+  cdio.op.run_mmc_cmd = run_mmc_cmd_fake;
+  cdio.env = &drive;
+
+  /* Not knowing what the host can take, reads are as they always were. */
+  if (NULL != cdio_get_arg(&cdio, "mmc-max-transfer")) return 21;
+  if ((i_rc = read_cd(&cdio, &drive, p_buf, 2048, 100, 40, ai_default)))
+    return i_rc;
+  memset(&drive, 0, sizeof(drive));
+  if (DRIVER_OP_SUCCESS !=
+      mmc_read_sectors(&cdio, p_buf, 7, 0, 50)
+      || (i_rc = check_reads(&drive, p_buf, CDIO_CD_FRAMESIZE_RAW, 7, 50,
+                             ai_one_cmd)))
+    return 22;
+
+  /* With a limit, as many blocks as fit in it are read at a time. */
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(&cdio, "mmc-max-transfer", "65536")
+      || NULL == cdio_get_arg(&cdio, "mmc-max-transfer")
+      || 0 != strcmp(cdio_get_arg(&cdio, "mmc-max-transfer"), "65536"))
+    return 23;
+  if ((i_rc = read_cd(&cdio, &drive, p_buf, 2048, 0, 100, ai_64k)))
+    return i_rc;
+  memset(&drive, 0, sizeof(drive));
+  if (DRIVER_OP_SUCCESS !=
+      mmc_read_sectors(&cdio, p_buf, 1000, 0, 50)
+      || (i_rc = check_reads(&drive, p_buf, CDIO_CD_FRAMESIZE_RAW, 1000, 50,
+                             ai_64k_raw)))
+    return 24;
+
+  /* Never less than a block per command. */
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(&cdio, "mmc-max-transfer", "1024"))
+    return 25;
+  if ((i_rc = read_cd(&cdio, &drive, p_buf, 2048, 5, 3, ai_1k)))
+    return i_rc;
+
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(&cdio, "mmc-max-transfer",
+                                        "2097152"))
+    return 26;
+  if ((i_rc = read_cd(&cdio, &drive, p_buf, 2048, 0, 2000, ai_2m)))
+    return i_rc;
+
+  /* A failed command ends the read. */
+  memset(&drive, 0, sizeof(drive));
+  drive.i_fail_at = 1;
+  if (DRIVER_OP_SUCCESS ==
+      mmc_read_cd(&cdio, p_buf, 0, 0, false, false, 0, true, false,
+                  false, 0, 2048, 2000)
+      || 1 != drive.i_cmds)
+    return 27;
+
+  for (i = 0; i < sizeof(apsz_bad) / sizeof(apsz_bad[0]); i++)
+    if (DRIVER_OP_BAD_PARAMETER !=
+        cdio_set_arg(&cdio, "mmc-max-transfer", apsz_bad[i])) {
+      fprintf(stderr, "\"%s\" was taken as a transfer size\n", apsz_bad[i]);
+      return 28;
+    }
+  if (DRIVER_OP_BAD_PARAMETER !=
+      cdio_set_arg(&cdio, "mmc-max-transfer", NULL))
+    return 29;
+
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(&cdio, "mmc-max-transfer", "0")
+      || NULL != cdio_get_arg(&cdio, "mmc-max-transfer"))
+    return 30;
+  if ((i_rc = read_cd(&cdio, &drive, p_buf, 2048, 100, 40, ai_default)))
+    return i_rc;
+
+  free(p_buf);
+  return 0;
+}
@@ -0,0 +1,449 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Unit test for the MMC emulator in lib/driver/mmc_emu.c. Disc images
+   are opened with it and with their own drivers, and what is read
+   through MMC commands is checked against what the image drivers
+   give. Its timing and faults are then checked.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/audio.h>
+#include <cdio/cdtext.h>
+#include <cdio/logging.h>
+#include <cdio/mmc.h>
+#include <cdio/mmc_hl_cmds.h>
+#include <cdio/mmc_ll_cmds.h>
+
+#ifndef DATA_DIR
+#define DATA_DIR "../data"
+#endif
+
+#define MAX_BLOCKS 302
+#define EDC_OFFSET (200 * CDIO_CD_FRAMESIZE_RAW)
+
+/* The emulator and the image it was opened from must agree on the
+   TOC. */
+static int
+check_toc(CdIo_t *p_emu, CdIo_t *p_image, const char *psz_image)
+{
+  const track_t i_first = cdio_get_first_track_num(p_image);
+  const track_t i_tracks = cdio_get_num_tracks(p_image);
+  track_t i;
+
+  if (cdio_get_first_track_num(p_emu) != i_first
+      || cdio_get_num_tracks(p_emu) != i_tracks) {
+    fprintf(stderr, "%s: tracks %d-%d, not %d-%d\n", psz_image,
+            cdio_get_first_track_num(p_emu), cdio_get_num_tracks(p_emu),
+            i_first, i_tracks);
+    return 1;
+  }
+  for (i = i_first; i < i_first + i_tracks; i++)
+    if (cdio_get_track_lsn(p_emu, i) != cdio_get_track_lsn(p_image, i)
+        || cdio_get_track_format(p_emu, i)
+           != cdio_get_track_format(p_image, i)
+        || cdio_get_track_copy_permit(p_emu, i)
+           != cdio_get_track_copy_permit(p_image, i)) {
+      fprintf(stderr, "%s: track %d differs\n", psz_image, i);
+      return 2;
+    }
+  if (cdio_get_track_lsn(p_emu, CDIO_CDROM_LEADOUT_TRACK)
+      != cdio_get_track_lsn(p_image, CDIO_CDROM_LEADOUT_TRACK)
+      || cdio_get_disc_last_lsn(p_emu)
+         != cdio_get_disc_last_lsn(p_image)) {
+    fprintf(stderr, "%s: the lead-out differs\n", psz_image);
+    return 3;
+  }
+  return 0;
+}
+
+/* Read all of an audio disc both ways. */
+static int
+check_audio(CdIo_t *p_emu, CdIo_t *p_image, const char *psz_image)
+{
+  const lsn_t i_blocks =
+    cdio_get_track_lsn(p_image, CDIO_CDROM_LEADOUT_TRACK);
+  uint8_t *p_emu_buf = calloc(MAX_BLOCKS, CDIO_CD_FRAMESIZE_RAW);
+  uint8_t *p_image_buf = calloc(MAX_BLOCKS, CDIO_CD_FRAMESIZE_RAW);
+  int i_rc = 0;
+
+  if (!p_emu_buf || !p_image_buf || i_blocks > MAX_BLOCKS)
+    i_rc = 10;
+  else if (DRIVER_OP_SUCCESS !=
+           cdio_read_audio_sectors(p_emu, p_emu_buf, 0, i_blocks)
+           || DRIVER_OP_SUCCESS !=
+           cdio_read_audio_sectors(p_image, p_image_buf, 0, i_blocks)) {
+    fprintf(stderr, "%s: reading audio failed\n", psz_image);
+    i_rc = 11;
+  } else if (0 != memcmp(p_emu_buf, p_image_buf,
+                         i_blocks * CDIO_CD_FRAMESIZE_RAW)) {
+    fprintf(stderr, "%s: audio read differs\n", psz_image);
+    i_rc = 12;
+  }
+  free(p_emu_buf);
+  free(p_image_buf);
+  return i_rc;
+}
+
+static int
+check_audio_image(const char *psz_image, driver_id_t driver_id)
+{
+  CdIo_t *p_emu = cdio_open(psz_image, DRIVER_MMC_EMU);
+  CdIo_t *p_image = cdio_open(psz_image, driver_id);
+  int i_rc;
+
+  if (!p_emu || !p_image) {
+    fprintf(stderr, "can't open %s\n", psz_image);
+    i_rc = 20;
+  } else if (0 == (i_rc = check_toc(p_emu, p_image, psz_image))
+             && 0 == (i_rc = check_audio(p_emu, p_image, psz_image))) {
+    char *psz_emu_mcn = cdio_get_mcn(p_emu);
+    char *psz_image_mcn = cdio_get_mcn(p_image);
+
+    /* Some image drivers give an empty MCN rather than none. */
+    if (0 != strcmp(psz_emu_mcn ? psz_emu_mcn : "",
+                    psz_image_mcn ? psz_image_mcn : "")) {
+      fprintf(stderr, "%s: MCN %s, not %s\n", psz_image,
+              psz_emu_mcn ? psz_emu_mcn : "(none)",
+              psz_image_mcn ? psz_image_mcn : "(none)");
+      i_rc = 21;
+    }
+    cdio_free(psz_emu_mcn);
+    cdio_free(psz_image_mcn);
+  }
+  cdio_destroy(p_emu);
+  cdio_destroy(p_image);
+  if (!i_rc)
+    printf("-- Good! %s reads the same through the emulator\n", psz_image);
+  return i_rc;
+}
+
+/* The sense of the last command, as the emulator gave it. */
+static int
+check_sense(CdIo_t *p_cdio, int i_key, int i_asc, lsn_t i_info)
+{
+  cdio_mmc_request_sense_t *p_sense = NULL;
+  const int i_sense = mmc_last_cmd_sense(p_cdio, &p_sense);
+  int i_rc = 0;
+
+  if (i_sense < 14 || !p_sense)
+    i_rc = 1;
+  else if (p_sense->sense_key != i_key || p_sense->asc != i_asc)
+    i_rc = 2;
+  else if (i_info >= 0
+           && (!p_sense->valid
+               || (p_sense->information[0] << 24 | p_sense->information[1] << 16
+                   | p_sense->information[2] << 8 | p_sense->information[3])
+                  != i_info))
+    i_rc = 3;
+  if (i_rc)
+    fprintf(stderr, "sense is not key %d ASC 0x%02x\n", i_key, i_asc);
+  cdio_free(p_sense);
+  return i_rc;
+}
+
+static unsigned long
+get_number(CdIo_t *p_cdio, const char *psz_key)
+{
+  const char *psz_value = cdio_get_arg(p_cdio, psz_key);
+  return psz_value ? strtoul(psz_value, NULL, 10) : 0;
+}
+
+/* Time one-block reads from i_lsn on. */
+static unsigned long
+time_reads(CdIo_t *p_cdio, uint8_t *p_buf, lsn_t i_lsn, unsigned int i_reads)
+{
+  unsigned int i;
+
+  cdio_set_arg(p_cdio, "emu-elapsed-us", "0");
+  for (i = 0; i < i_reads; i++)
+    if (DRIVER_OP_SUCCESS !=
+        cdio_read_mode1_sector(p_cdio, p_buf, i_lsn + i, false))
+      return 0;
+  return get_number(p_cdio, "emu-elapsed-us");
+}
+
+/* Data reads, chunking, timing and faults on a mode 1 disc. */
+static int
+check_data_image(const char *psz_image)
+{
+  CdIo_t *p_emu = cdio_open(psz_image, DRIVER_MMC_EMU);
+  CdIo_t *p_image = cdio_open(psz_image, DRIVER_BINCUE);
+  uint8_t *p_emu_buf = calloc(MAX_BLOCKS, CDIO_CD_FRAMESIZE_RAW);
+  uint8_t *p_image_buf = calloc(MAX_BLOCKS, CDIO_CD_FRAMESIZE_RAW);
+  unsigned long i_sequential, i_seeking;
+  int i_rc = 0;
+
+  if (!p_emu || !p_image || !p_emu_buf || !p_image_buf) {
+    fprintf(stderr, "can't open %s\n", psz_image);
+    i_rc = 30;
+    goto done;
+  }
+  if ((i_rc = check_toc(p_emu, p_image, psz_image))) goto done;
+
+  if (DRIVER_OP_SUCCESS !=
+      cdio_read_mode1_sectors(p_emu, p_emu_buf, 0, false, 100)
+      || DRIVER_OP_SUCCESS !=
+      cdio_read_mode1_sectors(p_image, p_image_buf, 0, false, 100)
+      || 0 != memcmp(p_emu_buf, p_image_buf, 100 * CDIO_CD_FRAMESIZE)) {
+    fprintf(stderr, "%s: mode 1 reads differ\n", psz_image);
+    i_rc = 31;
+    goto done;
+  }
+  /* Past what was just read, which is compared with again below. */
+  if (DRIVER_OP_SUCCESS !=
+      cdio_read_mode1_sector(p_emu, p_emu_buf + EDC_OFFSET, 16, true)
+      || DRIVER_OP_SUCCESS !=
+      cdio_read_mode1_sector(p_image, p_image_buf + EDC_OFFSET, 16, true)
+      || 0 != memcmp(p_emu_buf + EDC_OFFSET, p_image_buf + EDC_OFFSET,
+                     M2RAW_SECTOR_SIZE)) {
+    fprintf(stderr, "%s: mode 1 read with EDC differs\n", psz_image);
+    i_rc = 32;
+    goto done;
+  }
+  /* A data track isn't audio. */
+  if (DRIVER_OP_SUCCESS ==
+      mmc_read_cd(p_emu, p_emu_buf, 0, CDIO_MMC_READ_TYPE_CDDA, false, true,
+                  3, true, true, 0, 0, CDIO_CD_FRAMESIZE_RAW, 1)
+      || (i_rc = check_sense(p_emu, CDIO_MMC_SENSE_KEY_ILLEGAL_REQUEST,
+                             0x64, 0))) {
+    if (!i_rc) i_rc = 33;
+    goto done;
+  }
+
+  /* The "host" takes only 8 kB at a time, so reads must be chunked. */
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(p_emu, "emu-max-transfer", "8192")
+      || DRIVER_OP_SUCCESS ==
+      cdio_read_mode1_sectors(p_emu, p_emu_buf, 0, false, 20)) {
+    fprintf(stderr, "%s: a 40 kB read got through\n", psz_image);
+    i_rc = 34;
+    goto done;
+  }
+  memset(p_emu_buf, 0, 20 * CDIO_CD_FRAMESIZE);
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(p_emu, "mmc-max-transfer", "8192")
+      || DRIVER_OP_SUCCESS !=
+      cdio_read_mode1_sectors(p_emu, p_emu_buf, 0, false, 20)
+      || 0 != memcmp(p_emu_buf, p_image_buf, 20 * CDIO_CD_FRAMESIZE)) {
+    fprintf(stderr, "%s: chunked reads failed\n", psz_image);
+    i_rc = 35;
+    goto done;
+  }
+
+  /* Reading on costs less than seeking; and time is only counted. */
+  if (DRIVER_OP_BAD_PARAMETER ==
+      cdio_set_arg(p_emu, "emu-command-us", "100")
+      || DRIVER_OP_BAD_PARAMETER ==
+      cdio_set_arg(p_emu, "emu-seek-min-us", "1000")
+      || DRIVER_OP_BAD_PARAMETER ==
+      cdio_set_arg(p_emu, "emu-seek-max-us", "100000")
+      || DRIVER_OP_BAD_PARAMETER == cdio_set_arg(p_emu, "emu-block-us", "10")
+      || DRIVER_OP_BAD_PARAMETER != cdio_set_arg(p_emu, "emu-block-us", "x")
+      || DRIVER_OP_SUCCESS != cdio_set_arg(p_emu, "emu-head", "0")) {
+    i_rc = 36;
+    goto done;
+  }
+  i_sequential = time_reads(p_emu, p_emu_buf, 0, 10);
+  cdio_set_arg(p_emu, "emu-head", "0");
+  i_seeking = time_reads(p_emu, p_emu_buf, 200, 1);
+  if (10 * 110 != i_sequential || i_seeking <= 1000 + 110
+      || i_seeking >= 100000 + 110
+      || get_number(p_emu, "emu-head") != 201) {
+    fprintf(stderr, "%s: reads took %lu and %lu us\n", psz_image,
+            i_sequential, i_seeking);
+    i_rc = 37;
+    goto done;
+  }
+  cdio_set_arg(p_emu, "emu-head", "0");
+  if (time_reads(p_emu, p_emu_buf, 200, 1) != i_seeking) {
+    fprintf(stderr, "%s: the same seek took a different time\n", psz_image);
+    i_rc = 38;
+    goto done;
+  }
+
+  /* Unreadable sectors. */
+  if (DRIVER_OP_SUCCESS !=
+      cdio_set_arg(p_emu, "emu-bad-sectors", "100,150-152")
+      || DRIVER_OP_BAD_PARAMETER !=
+      cdio_set_arg(p_emu, "emu-bad-sectors", "152-150")) {
+    i_rc = 39;
+    goto done;
+  }
+  if (DRIVER_OP_SUCCESS == cdio_read_mode1_sector(p_emu, p_emu_buf, 151,
+                                                  false)
+      || (i_rc = check_sense(p_emu, CDIO_MMC_SENSE_KEY_MEDIUM_ERROR, 0x11,
+                             151))) {
+    fprintf(stderr, "%s: unreadable sector 151 was read\n", psz_image);
+    if (!i_rc) i_rc = 40;
+    goto done;
+  }
+  if (DRIVER_OP_SUCCESS != cdio_read_mode1_sector(p_emu, p_emu_buf, 149,
+                                                  false)
+      || DRIVER_OP_SUCCESS != cdio_read_mode1_sector(p_emu, p_emu_buf, 153,
+                                                     false)
+      || DRIVER_OP_SUCCESS != cdio_set_arg(p_emu, "emu-bad-sectors", "")
+      || DRIVER_OP_SUCCESS != cdio_read_mode1_sector(p_emu, p_emu_buf, 151,
+                                                     false)) {
+    fprintf(stderr, "%s: readable sectors were not read\n", psz_image);
+    i_rc = 41;
+    goto done;
+  }
+
+  /* The largest block READ CD can ask for: a raw frame, C2 pointers
+     with the block error byte, and raw P-W. */
+  memset(p_emu_buf, 0xff, 2744);
+  if (DRIVER_OP_SUCCESS !=
+      mmc_read_cd(p_emu, p_emu_buf, 20, 0, false, true, 3, true, true, 2, 1,
+                  2744, 1)
+      || 0 != memcmp(p_emu_buf + CDIO_CD_SYNC_SIZE + CDIO_CD_HEADER_SIZE,
+                     p_image_buf + 20 * CDIO_CD_FRAMESIZE, CDIO_CD_FRAMESIZE)
+      || p_emu_buf[CDIO_CD_FRAMESIZE_RAW] != 0
+      || p_emu_buf[CDIO_CD_FRAMESIZE_RAW + 295] != 0) {
+    fprintf(stderr, "%s: a 2744-byte READ CD block failed\n", psz_image);
+    i_rc = 42;
+    goto done;
+  }
+  printf("-- Good! %s reads, chunks, times and fails as asked\n",
+         psz_image);
+
+ done:
+  cdio_destroy(p_emu);
+  cdio_destroy(p_image);
+  free(p_emu_buf);
+  free(p_image_buf);
+  return i_rc;
+}
+
+/* Things a drive does besides reading. */
+static int
+check_drive(const char *psz_image)
+{
+  CdIo_t *p_emu = cdio_open(psz_image, DRIVER_MMC_EMU);
+  uint8_t buf[64] = { 0, };
+  cdio_subchannel_t subchannel;
+  cdtext_t *p_cdtext;
+  uint8_t *p_cdtext_raw;
+  const char *psz_title;
+  int i_rc = 0;
+
+  if (!p_emu) return 50;
+
+  if (yep != mmc_have_interface(p_emu, CDIO_MMC_FEATURE_INTERFACE_ATAPI)
+      || DRIVER_OP_SUCCESS !=
+      mmc_get_configuration(p_emu, buf, sizeof(buf),
+                            CDIO_MMC_GET_CONF_NAMED_FEATURE,
+                            CDIO_MMC_FEATURE_CD_READ, 0)
+      || 0x08 != buf[7] || CDIO_MMC_FEATURE_CD_READ != buf[9]) {
+    fprintf(stderr, "%s: GET CONFIGURATION is wrong\n", psz_image);
+    i_rc = 51;
+    goto done;
+  }
+
+  /* Where the head is, in the Q sub-channel. */
+  if (DRIVER_OP_SUCCESS != cdio_set_arg(p_emu, "emu-head", "300")
+      || DRIVER_OP_SUCCESS != cdio_audio_read_subchannel(p_emu, &subchannel)
+      || 1 != subchannel.track
+      || 0 != subchannel.abs_addr.m || 6 != subchannel.abs_addr.s
+      || 0 != subchannel.abs_addr.f) {
+    fprintf(stderr, "%s: the sub-channel position is wrong\n", psz_image);
+    i_rc = 52;
+    goto done;
+  }
+
+  /* CD-Text packs. */
+  if (DRIVER_OP_SUCCESS !=
+      cdio_set_arg(p_emu, "emu-cdtext", DATA_DIR "/cdtext.cdt")) {
+    i_rc = 53;
+    goto done;
+  }
+  p_cdtext_raw = cdio_get_cdtext_raw(p_emu);
+  p_cdtext = cdio_get_cdtext(p_emu);
+  psz_title = p_cdtext ? cdtext_get_const(p_cdtext, CDTEXT_FIELD_TITLE, 0)
+    : NULL;
+  if (!p_cdtext_raw || 1728 + 2 != CDIO_MMC_GET_LEN16(p_cdtext_raw)
+      || !psz_title || 0 != strcmp(psz_title, "Joyful Nights")) {
+    fprintf(stderr, "%s: CD-Text title is %s\n", psz_image,
+            psz_title ? psz_title : "missing");
+    i_rc = 54;
+  }
+  free(p_cdtext_raw);
+  if (i_rc) goto done;
+
+  /* The tray. The TOC, once read, is kept while the disc is out. */
+  if (1 != cdio_get_num_tracks(p_emu)
+      || DRIVER_OP_SUCCESS != mmc_eject_media(p_emu)
+      || DRIVER_OP_SUCCESS == mmc_test_unit_ready(p_emu, 0)
+      || (i_rc = check_sense(p_emu, CDIO_MMC_SENSE_KEY_NOT_READY, 0x3a, -1))
+      || cdio_get_num_tracks(p_emu) != 1) {
+    fprintf(stderr, "%s: ejecting isn't right\n", psz_image);
+    if (!i_rc) i_rc = 55;
+    goto done;
+  }
+  if (DRIVER_OP_SUCCESS != mmc_close_tray(p_emu)
+      || DRIVER_OP_SUCCESS != mmc_test_unit_ready(p_emu, 0)
+      || 1 != cdio_get_media_changed(p_emu)
+      || 0 != cdio_get_media_changed(p_emu)) {
+    fprintf(stderr, "%s: closing the tray isn't right\n", psz_image);
+    i_rc = 56;
+    goto done;
+  }
+  printf("-- Good! the emulated drive configures, ejects and has CD-Text\n");
+
+ done:
+  cdio_destroy(p_emu);
+  return i_rc;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  int i_rc;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_ERROR;
+
+  if (!cdio_have_driver(DRIVER_MMC_EMU)) {
+    fprintf(stderr, "The MMC emulator should always be there\n");
+    return 1;
+  }
+  if (NULL != cdio_open(DATA_DIR "/no-such-image.cue", DRIVER_MMC_EMU)) {
+    fprintf(stderr, "A missing image opened\n");
+    return 2;
+  }
+
+  if ((i_rc = check_audio_image(DATA_DIR "/cdda.cue", DRIVER_BINCUE)))
+    return i_rc;
+  if ((i_rc = check_audio_image(DATA_DIR "/p1.nrg", DRIVER_NRG)))
+    return i_rc;
+  if ((i_rc = check_data_image(DATA_DIR "/isofs-m1.cue")))
+    return i_rc;
+  return check_drive(DATA_DIR "/cdda.cue");
+}
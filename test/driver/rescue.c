@@ -0,0 +1,313 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+   Unit test for the rescue reader in lib/driver/rescue.c. A disc image
+   is opened with the MMC emulator, sectors of it are made unreadable,
+   and what is rescued is checked against the image, as are the time it
+   took and the map.
+*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/logging.h>
+#include <cdio/mmc_hl_cmds.h>
+#include <cdio/rescue.h>
+
+#ifndef DATA_DIR
+#define DATA_DIR "../data"
+#endif
+
+#define IMAGE      DATA_DIR "/isofs-m1.cue"
+#define MAP        "rescue.map"
+#define BAD        "100,150-152,200-239"
+#define NUM_BAD    44
+
+static uint8_t *p_image;   /* the image, as its own driver reads it */
+static uint8_t *p_copy;    /* what was rescued */
+static lsn_t    i_blocks;
+
+static driver_return_code_t
+write_copy(void *p_user_data, lsn_t i_lsn, const void *p_buf,
+           uint32_t i_count)
+{
+  (void) p_user_data;
+  if (i_lsn < 0 || i_lsn + (lsn_t) i_count > i_blocks)
+    return DRIVER_OP_BAD_PARAMETER;
+  memcpy(p_copy + (size_t) i_lsn * CDIO_CD_FRAMESIZE, p_buf,
+         (size_t) i_count * CDIO_CD_FRAMESIZE);
+  return DRIVER_OP_SUCCESS;
+}
+
+static driver_return_code_t
+write_fail(void *p_user_data, lsn_t i_lsn, const void *p_buf,
+           uint32_t i_count)
+{
+  (void) p_user_data; (void) i_lsn; (void) p_buf; (void) i_count;
+  return DRIVER_OP_NOT_PERMITTED;
+}
+
+static bool
+is_bad(lsn_t i_lsn)
+{
+  return 100 == i_lsn || (i_lsn >= 150 && i_lsn <= 152)
+    || (i_lsn >= 200 && i_lsn <= 239);
+}
+
+static unsigned long
+get_number(CdIo_t *p_cdio, const char *psz_key)
+{
+  const char *psz_value = cdio_get_arg(p_cdio, psz_key);
+  return psz_value ? strtoul(psz_value, NULL, 10) : 0;
+}
+
+/* The sectors that could be read must be the image's, and the map must
+   have just the bad ones as bad. */
+static int
+check_copy(const cdio_rescue_t *p_rescue, bool b_all_good)
+{
+  lsn_t i_lsn, i_region_lsn;
+  uint32_t i_region_blocks;
+  cdio_rescue_status_t status;
+  unsigned int i;
+
+  for (i = 0; cdio_rescue_get_region(p_rescue, i, &i_region_lsn,
+                                     &i_region_blocks, &status); i++)
+    for (i_lsn = i_region_lsn;
+         i_lsn < i_region_lsn + (lsn_t) i_region_blocks; i_lsn++) {
+      const bool b_bad = !b_all_good && is_bad(i_lsn);
+
+      if (b_bad != (CDIO_RESCUE_BAD == status)
+          || (!b_bad && CDIO_RESCUE_FINISHED != status)) {
+        fprintf(stderr, "sector %d is '%c'\n", i_lsn, status);
+        return 1;
+      }
+      if (!b_bad
+          && memcmp(p_copy + (size_t) i_lsn * CDIO_CD_FRAMESIZE,
+                    p_image + (size_t) i_lsn * CDIO_CD_FRAMESIZE,
+                    CDIO_CD_FRAMESIZE)) {
+        fprintf(stderr, "sector %d was rescued wrong\n", i_lsn);
+        return 2;
+      }
+    }
+  if (cdio_rescue_get_count(p_rescue, CDIO_RESCUE_BAD)
+      != (b_all_good ? 0 : NUM_BAD)) {
+    fprintf(stderr, "%u bad sectors\n",
+            cdio_rescue_get_count(p_rescue, CDIO_RESCUE_BAD));
+    return 3;
+  }
+  return 0;
+}
+
+/* What reading each sector in turn, as a naive copy does, costs. */
+static unsigned long
+time_naive(CdIo_t *p_emu)
+{
+  uint8_t buf[CDIO_CD_FRAMESIZE];
+  lsn_t i_lsn;
+
+  cdio_set_arg(p_emu, "emu-head", "0");
+  cdio_set_arg(p_emu, "emu-elapsed-us", "0");
+  for (i_lsn = 0; i_lsn < i_blocks; i_lsn++)
+    cdio_read_data_sectors(p_emu, buf, i_lsn, CDIO_CD_FRAMESIZE, 1);
+  return get_number(p_emu, "emu-elapsed-us");
+}
+
+int
+main(int argc, const char *argv[])
+{
+  CdIo_t *p_cdio, *p_emu;
+  cdio_rescue_t *p_rescue = NULL;
+  unsigned long i_naive_us, i_rescue_us, i_commands;
+  FILE *fp;
+  int i_rc = 0;
+
+  cdio_loglevel_default = (argc > 1) ? CDIO_LOG_DEBUG : CDIO_LOG_ERROR;
+
+  p_cdio = cdio_open(IMAGE, DRIVER_BINCUE);
+  p_emu = cdio_open(IMAGE, DRIVER_MMC_EMU);
+  if (!p_cdio || !p_emu) {
+    fprintf(stderr, "Can't open %s\n", IMAGE);
+    return 77;
+  }
+  i_blocks = cdio_get_disc_last_lsn(p_cdio);
+  p_image = calloc(i_blocks, CDIO_CD_FRAMESIZE);
+  p_copy = calloc(i_blocks, CDIO_CD_FRAMESIZE);
+  if (!p_image || !p_copy
+      || DRIVER_OP_SUCCESS != cdio_read_data_sectors(p_cdio, p_image, 0,
+                                                     CDIO_CD_FRAMESIZE,
+                                                     i_blocks)) {
+    fprintf(stderr, "Can't read %s\n", IMAGE);
+    i_rc = 1;
+    goto done;
+  }
+
+  if (NULL != cdio_rescue_new(p_emu, 0, 0, CDIO_CD_FRAMESIZE)
+      || NULL != cdio_rescue_new(NULL, 0, i_blocks, CDIO_CD_FRAMESIZE)) {
+    fprintf(stderr, "cdio_rescue_new() took nonsense\n");
+    i_rc = 2;
+    goto done;
+  }
+
+  /* Rescue with faults injected. Each failed try takes a second, as
+     on a drive retrying a scratch. */
+  remove(MAP);
+  cdio_set_arg(p_emu, "emu-bad-sectors", BAD);
+  cdio_set_arg(p_emu, "emu-command-us", "100");
+  cdio_set_arg(p_emu, "emu-block-us", "50");
+  cdio_set_arg(p_emu, "emu-seek-min-us", "1000");
+  cdio_set_arg(p_emu, "emu-seek-max-us", "50000");
+  cdio_set_arg(p_emu, "emu-error-us", "60000");
+  i_naive_us = time_naive(p_emu);
+
+  p_rescue = cdio_rescue_new(p_emu, 0, i_blocks, CDIO_CD_FRAMESIZE);
+  if (!p_rescue
+      || DRIVER_OP_BAD_PARAMETER != cdio_rescue_set_read_blocks(p_rescue, 0)
+      || DRIVER_OP_SUCCESS != cdio_rescue_set_read_blocks(p_rescue, 16)
+      || cdio_rescue_get_count(p_rescue, CDIO_RESCUE_UNTRIED)
+         != (uint32_t) i_blocks) {
+    fprintf(stderr, "Can't set up a rescue\n");
+    i_rc = 3;
+    goto done;
+  }
+  cdio_rescue_set_drive_retries(p_rescue, 0);
+  cdio_set_arg(p_emu, "emu-head", "0");
+  cdio_set_arg(p_emu, "emu-elapsed-us", "0");
+  if (DRIVER_OP_SUCCESS != cdio_rescue_run(p_rescue, write_copy, NULL, MAP)) {
+    fprintf(stderr, "The rescue failed\n");
+    i_rc = 4;
+    goto done;
+  }
+  i_rescue_us = get_number(p_emu, "emu-elapsed-us");
+  if ((i_rc = check_copy(p_rescue, false))) {
+    i_rc += 10;
+    goto done;
+  }
+  printf("-- Good! Rescued all but the %d bad sectors\n", NUM_BAD);
+
+  if (i_rescue_us * 4 > i_naive_us) {
+    fprintf(stderr, "Rescuing took %lu us; reading each sector %lu us\n",
+            i_rescue_us, i_naive_us);
+    i_rc = 5;
+    goto done;
+  }
+  printf("-- Good! Rescuing took %lu ms, reading each sector %lu ms\n",
+         i_rescue_us / 1000, i_naive_us / 1000);
+
+  if (16 != mmc_get_read_retries(p_emu)) {
+    fprintf(stderr, "The drive's read retries were left at %d\n",
+            mmc_get_read_retries(p_emu));
+    i_rc = 6;
+    goto done;
+  }
+
+  /* Carrying on from the map reads nothing more. */
+  cdio_rescue_destroy(p_rescue);
+  p_rescue = cdio_rescue_new(p_emu, 0, i_blocks, CDIO_CD_FRAMESIZE);
+  i_commands = get_number(p_emu, "emu-commands");
+  if (!p_rescue
+      || DRIVER_OP_SUCCESS != cdio_rescue_load_map(p_rescue, MAP)
+      || cdio_rescue_get_count(p_rescue, CDIO_RESCUE_BAD) != NUM_BAD
+      || DRIVER_OP_SUCCESS != cdio_rescue_run(p_rescue, write_copy, NULL,
+                                              NULL)
+      || get_number(p_emu, "emu-commands") != i_commands) {
+    fprintf(stderr, "Carrying on from a finished map read more\n");
+    i_rc = 7;
+    goto done;
+  }
+
+  /* Retrying once the disc is clean rescues the rest. */
+  cdio_set_arg(p_emu, "emu-bad-sectors", "");
+  cdio_rescue_set_retry_passes(p_rescue, 2);
+  if (DRIVER_OP_SUCCESS != cdio_rescue_run(p_rescue, write_copy, NULL, MAP)
+      || (i_rc = check_copy(p_rescue, true))) {
+    fprintf(stderr, "Retrying didn't rescue the rest\n");
+    i_rc = 8;
+    goto done;
+  }
+  printf("-- Good! Retrying rescued the rest\n");
+
+  /* Only what a map hasn't tried is read. */
+  fp = fopen(MAP, "w");
+  if (!fp) {
+    i_rc = 77;
+    goto done;
+  }
+  fprintf(fp, "# hand written\n0 100 +\n100 10 ?\n110 %ld +\n",
+          (long) i_blocks - 110);
+  fclose(fp);
+  memset(p_copy, 0, (size_t) i_blocks * CDIO_CD_FRAMESIZE);
+  cdio_rescue_destroy(p_rescue);
+  p_rescue = cdio_rescue_new(p_emu, 0, i_blocks, CDIO_CD_FRAMESIZE);
+  if (!p_rescue
+      || DRIVER_OP_SUCCESS != cdio_rescue_load_map(p_rescue, MAP)
+      || cdio_rescue_get_count(p_rescue, CDIO_RESCUE_UNTRIED) != 10
+      || DRIVER_OP_SUCCESS != cdio_rescue_run(p_rescue, write_copy, NULL,
+                                              NULL)
+      || memcmp(p_copy + 100 * CDIO_CD_FRAMESIZE,
+                p_image + 100 * CDIO_CD_FRAMESIZE, 10 * CDIO_CD_FRAMESIZE)
+      || p_copy[99 * CDIO_CD_FRAMESIZE + 16] != 0
+      || p_copy[110 * CDIO_CD_FRAMESIZE + 16] != 0) {
+    fprintf(stderr, "A partial map wasn't followed\n");
+    i_rc = 9;
+    goto done;
+  }
+
+  /* A failing write stops the rescue; a broken map is refused. */
+  cdio_rescue_destroy(p_rescue);
+  p_rescue = cdio_rescue_new(p_emu, 0, i_blocks, CDIO_CD_FRAMESIZE);
+  if (DRIVER_OP_NOT_PERMITTED != cdio_rescue_run(p_rescue, write_fail, NULL,
+                                                 NULL)) {
+    fprintf(stderr, "A failing write didn't stop the rescue\n");
+    i_rc = 20;
+    goto done;
+  }
+  fp = fopen(MAP, "w");
+  if (fp) {
+    fprintf(fp, "0 10 x\n");
+    fclose(fp);
+  }
+  if (DRIVER_OP_BAD_PARAMETER != cdio_rescue_load_map(p_rescue, MAP)) {
+    fprintf(stderr, "A broken map was taken\n");
+    i_rc = 21;
+    goto done;
+  }
+  printf("-- Good! Maps are followed and broken ones refused\n");
+
+ done:
+  remove(MAP);
+  cdio_rescue_destroy(p_rescue);
+  free(p_image);
+  free(p_copy);
+  cdio_destroy(p_emu);
+  cdio_destroy(p_cdio);
+  return i_rc;
+}
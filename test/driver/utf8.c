@@ -0,0 +1,89 @@
+/* -*- C -*-
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Unit test for cdio_utf16be_to_utf8() in lib/driver/utf8.c */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/utf8.h>
+
+typedef struct {
+  const char    *psz_name;
+  const uint8_t *p_src;
+  size_t         i_src_len;
+  const char    *psz_expected;
+} utf8_test_t;
+
+static const uint8_t ascii[] = {
+  0, 'R', 0, 'E', 0, 'A', 0, 'D', 0, 'M', 0, 'E', 0, '.', 0, 'T',
+  0, 'X', 0, 'T', 0, ';', 0, '1'
+};
+/* "Grüße €x" */
+static const uint8_t bmp[] = {
+  0, 'G', 0, 'r', 0x00, 0xfc, 0x00, 0xdf, 0, 'e', 0, ' ', 0x20, 0xac, 0, 'x'
+};
+/* ASCII run broken by a non-ASCII unit in the middle of a group */
+static const uint8_t mixed[] = {
+  0, 'a', 0, 'b', 0, 'c', 0x03, 0xa9, 0, 'd', 0, 'e', 0, 'f', 0, 'g', 0, 'h'
+};
+/* U+1F4BF as a surrogate pair, then an unpaired low and high surrogate */
+static const uint8_t surrogates[] = {
+  0xd8, 0x3d, 0xdc, 0xbf, 0xdc, 0x00, 0, 'z', 0xd8, 0x00
+};
+
+static const utf8_test_t tests[] = {
+  {"ASCII", ascii, sizeof(ascii), "README.TXT;1"},
+  {"BMP", bmp, sizeof(bmp), "Gr\xc3\xbc\xc3\x9f" "e \xe2\x82\xac" "x"},
+  {"mixed", mixed, sizeof(mixed), "abc\xce\xa9" "defgh"},
+  {"surrogates", surrogates, sizeof(surrogates),
+   "\xf0\x9f\x92\xbf\xef\xbf\xbdz\xef\xbf\xbd"},
+  {"odd length", ascii, 5, "RE"},
+  {"empty", ascii, 0, ""},
+};
+
+int
+main(int argc, const char *argv[])
+{
+  char buf[CDIO_UTF16BE_TO_UTF8_SIZE(64)];
+  unsigned int i;
+
+  for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+    size_t i_len;
+
+    memset(buf, 'X', sizeof(buf));
+    i_len = cdio_utf16be_to_utf8(tests[i].p_src, tests[i].i_src_len, buf);
+    if (i_len != strlen(tests[i].psz_expected)
+        || 0 != strcmp(buf, tests[i].psz_expected)) {
+      printf("%s: got \"%s\" (%lu bytes), expected \"%s\"\n",
+             tests[i].psz_name, buf, (unsigned long) i_len,
+             tests[i].psz_expected);
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -257,6 +257,23 @@ main (int argc, const char *argv[])
       return 42;
     }
 
+    /* Sweep across leap days, century years and the Epoch, at
+       varying times of day. */
+    {
+      time_t t;
+      for (t = -2147483647; t < 2147483647 - 262807; t += 262807) {
+        struct tm tm_set;
+        tm_set = *gmtime(&t);
+        iso9660_set_dtime_with_timezone(&tm_set, 0, &dtime);
+        if (!iso9660_get_dtime(&dtime, false, &tm)
+            || !time_compare(&tm_set, &tm)) {
+          printf("GMT time %ld not retrieved correctly by "
+                 "iso9660_get_dtime()\n", (long int) t);
+          return 49;
+        }
+      }
+    }
+
 #ifdef HAVE_TM_GMTOFF
     if ( !time_compare(p_tm, &tm) ) {
       return 43;
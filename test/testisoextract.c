@@ -0,0 +1,386 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Tests iso9660_ifs_extract_tree() by comparing the extracted files
+   with the same files read through iso9660_iso_seek_read().  */
+
+#ifndef DATA_DIR
+#define DATA_DIR "./data"
+#endif
+
+#define EXTRACT_DIR "testisoextract.tmp"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/iso9660.h>
+
+/* Read all of a local file. */
+static char *
+read_local(const char *psz_path, long int *p_size)
+{
+  FILE *p_fd = fopen(psz_path, "rb");
+  char *p_buf;
+
+  if (!p_fd) return NULL;
+  fseek(p_fd, 0, SEEK_END);
+  *p_size = ftell(p_fd);
+  fseek(p_fd, 0, SEEK_SET);
+  p_buf = malloc(*p_size + 1);
+  if (!p_buf || (*p_size && 1 != fread(p_buf, *p_size, 1, p_fd))) {
+    free(p_buf);
+    p_buf = NULL;
+  }
+  fclose(p_fd);
+  return p_buf;
+}
+
+/* Compare the extracted copy of psz_iso_path with the image. */
+static int
+check_file(iso9660_t *p_iso, const char *psz_iso_path,
+           const char *psz_local_path)
+{
+  iso9660_stat_t *p_stat = iso9660_ifs_stat_translate(p_iso, psz_iso_path);
+  char *p_expected, *p_got;
+  long int i_size;
+  int i_rc = 0;
+
+  if (!p_stat) {
+    fprintf(stderr, "Couldn't stat %s in the image\n", psz_iso_path);
+    return 1;
+  }
+  p_expected = calloc(1, CDIO_EXTENT_BLOCKS(p_stat->total_size)
+                      * ISO_BLOCKSIZE + 1);
+  if (CDIO_EXTENT_BLOCKS(p_stat->total_size) * ISO_BLOCKSIZE
+      != iso9660_iso_seek_read(p_iso, p_expected, p_stat->lsn,
+                               CDIO_EXTENT_BLOCKS(p_stat->total_size))) {
+    fprintf(stderr, "Couldn't read %s from the image\n", psz_iso_path);
+    i_rc = 2;
+  } else if (!(p_got = read_local(psz_local_path, &i_size))) {
+    fprintf(stderr, "Couldn't read extracted file %s\n", psz_local_path);
+    i_rc = 3;
+  } else {
+    if (i_size != (long int) p_stat->total_size
+        || 0 != memcmp(p_expected, p_got, i_size)) {
+      fprintf(stderr, "%s differs from %s in the image\n",
+              psz_local_path, psz_iso_path);
+      i_rc = 4;
+    }
+    free(p_got);
+  }
+  free(p_expected);
+  iso9660_stat_free(p_stat);
+  return i_rc;
+}
+
+/* Remove the named paths, deepest first, making directories writable
+   again beforehand. */
+static void
+cleanup(const char *apsz_path[])
+{
+  int i;
+
+  for (i = 0; apsz_path[i]; i++)
+    chmod(apsz_path[i], 0700);
+  for (i--; i >= 0; i--)
+    if (0 != unlink(apsz_path[i]))
+      rmdir(apsz_path[i]);
+}
+
+static int
+check_rock_ridge(void)
+{
+  static const char *apsz_path[] = {
+    EXTRACT_DIR, EXTRACT_DIR "/copy", EXTRACT_DIR "/tmp",
+    EXTRACT_DIR "/COPYING", EXTRACT_DIR "/Copy2", EXTRACT_DIR "/fd0",
+    EXTRACT_DIR "/zero", EXTRACT_DIR "/copy/COPYING",
+    EXTRACT_DIR "/tmp/COPYING", NULL
+  };
+  iso9660_t *p_iso = iso9660_open_ext(DATA_DIR "/copying-rr.iso",
+                                      ISO_EXTENSION_ALL);
+  struct stat st;
+  int i_rc;
+
+  if (!p_iso) {
+    fprintf(stderr, "Sorry, couldn't open copying-rr.iso\n");
+    return 10;
+  }
+  cleanup(apsz_path);
+
+  if (0 != iso9660_ifs_extract_tree(p_iso, "/", EXTRACT_DIR, NULL)) {
+    fprintf(stderr, "Extracting copying-rr.iso failed\n");
+    return 11;
+  }
+  if ((i_rc = check_file(p_iso, "/COPYING", EXTRACT_DIR "/COPYING")))
+    return 10 + i_rc;
+
+  if (0 != stat(EXTRACT_DIR "/COPYING", &st) || 0444 != (st.st_mode & 0777)) {
+    fprintf(stderr, "Rock Ridge permissions of COPYING not applied\n");
+    return 16;
+  }
+  /* zero and fd0 are devices, which aren't extracted. */
+  if (0 == lstat(EXTRACT_DIR "/zero", &st)) {
+    fprintf(stderr, "Device zero extracted\n");
+    return 17;
+  }
+#if defined(HAVE_SYMLINK) && defined(HAVE_READLINK)
+  {
+    char buf[64];
+    ssize_t i_len = readlink(EXTRACT_DIR "/copy/COPYING", buf,
+                             sizeof(buf) - 1);
+    if (i_len < 0 || (buf[i_len] = '\0', 0 != strcmp(buf, "../COPYING"))) {
+      fprintf(stderr, "Symbolic link copy/COPYING not extracted\n");
+      return 18;
+    }
+  }
+#endif
+
+  cleanup(apsz_path);
+  iso9660_close(p_iso);
+  printf("-- Good! Extracted copying-rr.iso\n");
+  return 0;
+}
+
+static int
+check_joliet(void)
+{
+  static const char *apsz_path[] = {
+    EXTRACT_DIR, EXTRACT_DIR "/libcdio", EXTRACT_DIR "/libcdio/test",
+    EXTRACT_DIR "/libcdio/COPYING", EXTRACT_DIR "/libcdio/README",
+    EXTRACT_DIR "/libcdio/README.libcdio",
+    EXTRACT_DIR "/libcdio/test/isofs-m1.cue", NULL
+  };
+  iso9660_t *p_iso = iso9660_open_ext(DATA_DIR "/joliet.iso",
+                                      ISO_EXTENSION_ALL);
+  iso9660_extract_opts_t opts;
+  int i_rc;
+
+  if (!p_iso) {
+    fprintf(stderr, "Sorry, couldn't open joliet.iso\n");
+    return 20;
+  }
+  cleanup(apsz_path);
+
+  /* Small reads that bridge the gaps between files, from several
+     walker threads. */
+  memset(&opts, 0, sizeof(opts));
+  opts.i_max_read_blocks = 3;
+  opts.i_max_gap_blocks  = 4;
+  opts.i_threads         = 3;
+  if (0 != iso9660_ifs_extract_tree(p_iso, "/", EXTRACT_DIR, &opts)) {
+    fprintf(stderr, "Extracting joliet.iso failed\n");
+    return 21;
+  }
+  if ((i_rc = check_file(p_iso, "/libcdio/COPYING",
+                         EXTRACT_DIR "/libcdio/COPYING"))
+      || (i_rc = check_file(p_iso, "/libcdio/README",
+                            EXTRACT_DIR "/libcdio/README"))
+      || (i_rc = check_file(p_iso, "/libcdio/README.libcdio",
+                            EXTRACT_DIR "/libcdio/README.libcdio"))
+      || (i_rc = check_file(p_iso, "/libcdio/test/isofs-m1.cue",
+                            EXTRACT_DIR "/libcdio/test/isofs-m1.cue")))
+    return 20 + i_rc;
+
+  cleanup(apsz_path);
+  iso9660_close(p_iso);
+  printf("-- Good! Extracted joliet.iso\n");
+  return 0;
+}
+
+static int
+check_multi_extent(void)
+{
+  static const char *apsz_path[] = {
+    EXTRACT_DIR, EXTRACT_DIR "/multi_extent_file", NULL
+  };
+  iso9660_t *p_iso = iso9660_open_ext(DATA_DIR "/multi_extent_8k.iso",
+                                      ISO_EXTENSION_ALL);
+  iso9660_extract_opts_t opts;
+  char *p_expected, *p_got;
+  long int i_expected, i_got;
+
+  if (!p_iso) {
+    fprintf(stderr, "Sorry, couldn't open multi_extent_8k.iso\n");
+    return 30;
+  }
+  cleanup(apsz_path);
+
+  memset(&opts, 0, sizeof(opts));
+  opts.i_max_read_blocks = 5;
+  if (0 != iso9660_ifs_extract_tree(p_iso, "/", EXTRACT_DIR, &opts)) {
+    fprintf(stderr, "Extracting multi_extent_8k.iso failed\n");
+    return 31;
+  }
+  p_expected = read_local(DATA_DIR "/multi_extent_file", &i_expected);
+  p_got = read_local(EXTRACT_DIR "/multi_extent_file", &i_got);
+  if (!p_expected || !p_got || i_expected != i_got
+      || 0 != memcmp(p_expected, p_got, i_got)) {
+    fprintf(stderr, "multi_extent_file was not extracted correctly\n");
+    return 32;
+  }
+  free(p_expected);
+  free(p_got);
+
+  cleanup(apsz_path);
+  iso9660_close(p_iso);
+  printf("-- Good! Extracted multi_extent_8k.iso\n");
+  return 0;
+}
+
+/* Copy copying-rr.iso to psz_path with the first Rock Ridge name
+   "COPYING" changed to psz_name, of the same length. */
+static bool
+write_renamed_image(const char *psz_path, const char *psz_name)
+{
+  long int i_size, i;
+  char *p_image = read_local(DATA_DIR "/copying-rr.iso", &i_size);
+  FILE *p_fd;
+  bool b_ok = false;
+
+  if (!p_image) return false;
+  for (i = 0; i + 12 <= i_size; i++)
+    if (0 == memcmp(p_image + i, "NM\014\001\000COPYING", 12)) {
+      memcpy(p_image + i + 5, psz_name, 7);
+      b_ok = true;
+      break;
+    }
+  if (b_ok && (p_fd = fopen(psz_path, "wb"))) {
+    b_ok = (1 == fwrite(p_image, i_size, 1, p_fd));
+    fclose(p_fd);
+  } else
+    b_ok = false;
+  free(p_image);
+  return b_ok;
+}
+
+/* Names from the image can't lead out of the destination, and what is
+   already there isn't written through. */
+static int
+check_unsafe(void)
+{
+  static const char *apsz_path[] = {
+    EXTRACT_DIR, EXTRACT_DIR "/copy", EXTRACT_DIR "/tmp",
+    EXTRACT_DIR "/COPYING", EXTRACT_DIR "/Copy2", EXTRACT_DIR "/fd0",
+    EXTRACT_DIR "/zero", EXTRACT_DIR "/copy/COPYING",
+    EXTRACT_DIR "/tmp/COPYING", NULL
+  };
+  static const char psz_image[] = "testisoextract.iso";
+  static const char psz_victim[] = "testisoextract.victim";
+  iso9660_t *p_iso;
+  struct stat st;
+  FILE *p_fd;
+  int i_rc = 0;
+
+  cleanup(apsz_path);
+  unlink("EVIL");
+  if (!write_renamed_image(psz_image, "../EVIL")) {
+    fprintf(stderr, "Couldn't make an image with a name of ../EVIL\n");
+    return 40;
+  }
+  p_iso = iso9660_open_ext(psz_image, ISO_EXTENSION_ALL);
+  if (!p_iso) {
+    fprintf(stderr, "Sorry, couldn't open %s\n", psz_image);
+    unlink(psz_image);
+    return 41;
+  }
+  if (0 == iso9660_ifs_extract_tree(p_iso, "/", EXTRACT_DIR, NULL)) {
+    fprintf(stderr, "Extracting an entry named ../EVIL succeeded\n");
+    i_rc = 42;
+  } else if (0 == lstat("EVIL", &st)) {
+    fprintf(stderr, "An entry named ../EVIL was written outside\n");
+    i_rc = 43;
+  }
+  iso9660_close(p_iso);
+  unlink(psz_image);
+  unlink("EVIL");
+  cleanup(apsz_path);
+  if (i_rc) return i_rc;
+  printf("-- Good! An entry named ../EVIL isn't extracted\n");
+
+#if defined(HAVE_SYMLINK)
+  /* A symbolic link where a file goes is replaced, not followed. */
+  if (!(p_fd = fopen(psz_victim, "w"))) return 44;
+  fputs("untouched\n", p_fd);
+  fclose(p_fd);
+  mkdir(EXTRACT_DIR, 0700);
+  if (0 != symlink("../testisoextract.victim", EXTRACT_DIR "/COPYING")) {
+    fprintf(stderr, "Couldn't make symbolic links\n");
+    i_rc = 45;
+  } else if (!(p_iso = iso9660_open_ext(DATA_DIR "/copying-rr.iso",
+                                        ISO_EXTENSION_ALL))) {
+    i_rc = 46;
+  } else {
+    long int i_size;
+    char *p_victim;
+
+    if (0 != iso9660_ifs_extract_tree(p_iso, "/", EXTRACT_DIR, NULL)) {
+      fprintf(stderr, "Extracting over symbolic links failed\n");
+      i_rc = 47;
+    } else if (!(p_victim = read_local(psz_victim, &i_size))
+               || 10 != i_size || 0 != memcmp(p_victim, "untouched\n", 10)
+               || 0 != lstat(EXTRACT_DIR "/COPYING", &st)
+               || !S_ISREG(st.st_mode)
+               || check_file(p_iso, "/COPYING", EXTRACT_DIR "/COPYING")) {
+      fprintf(stderr, "A symbolic link in the destination was followed\n");
+      i_rc = 48;
+    } else if (0 == lstat(EXTRACT_DIR "/fd0", &st)
+               || 0 == lstat(EXTRACT_DIR "/zero", &st)) {
+      fprintf(stderr, "A device was extracted\n");
+      i_rc = 49;
+    }
+    if (!i_rc) free(p_victim);
+    iso9660_close(p_iso);
+  }
+  cleanup(apsz_path);
+  unlink(psz_victim);
+  if (i_rc) return i_rc;
+  printf("-- Good! Symbolic links and devices in the way are left alone\n");
+#endif
+  return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  int i_rc;
+
+  if ((i_rc = check_rock_ridge()))   return i_rc;
+  if ((i_rc = check_joliet()))       return i_rc;
+  if ((i_rc = check_multi_extent())) return i_rc;
+  if ((i_rc = check_unsafe()))       return i_rc;
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Tests that iso9660_open_fuzzy() tries the sectors after
+   ISO_PVD_SECTOR before those the same distance before it. The image
+   is copying.iso moved down one sector, with a copy of its PVD put
+   one sector before ISO_PVD_SECTOR too. Only the one after gives an
+   image whose files can be found.  */
+
+#ifndef DATA_DIR
+#define DATA_DIR "./data"
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/iso9660.h>
+
+#define FUZZY_ISO "testisofuzzy.iso"
+
+/* Write copying.iso to FUZZY_ISO one sector further in, with its PVD
+   at both ISO_PVD_SECTOR + 1 and ISO_PVD_SECTOR - 1. */
+static bool
+write_fuzzy_image(void)
+{
+  FILE *p_in = fopen(DATA_DIR "/copying.iso", "rb");
+  FILE *p_out;
+  uint8_t *p_image;
+  long int i_size;
+  bool b_ok;
+
+  if (!p_in) return false;
+  fseek(p_in, 0, SEEK_END);
+  i_size = ftell(p_in);
+  fseek(p_in, 0, SEEK_SET);
+  p_image = calloc(1, i_size + ISO_BLOCKSIZE);
+  if (!p_image
+      || 1 != fread(p_image + ISO_BLOCKSIZE, i_size, 1, p_in)) {
+    free(p_image);
+    fclose(p_in);
+    return false;
+  }
+  fclose(p_in);
+  memcpy(p_image + (ISO_PVD_SECTOR - 1) * ISO_BLOCKSIZE,
+         p_image + (ISO_PVD_SECTOR + 1) * ISO_BLOCKSIZE, ISO_BLOCKSIZE);
+
+  p_out = fopen(FUZZY_ISO, "wb");
+  b_ok = p_out && 1 == fwrite(p_image, i_size + ISO_BLOCKSIZE, 1, p_out);
+  if (p_out && 0 != fclose(p_out)) b_ok = false;
+  free(p_image);
+  return b_ok;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  iso9660_t *p_iso;
+  iso9660_stat_t *p_stat;
+  int i_rc = 0;
+
+  if (!write_fuzzy_image()) {
+    fprintf(stderr, "Couldn't write %s\n", FUZZY_ISO);
+    remove(FUZZY_ISO);
+    return 1;
+  }
+
+  p_iso = iso9660_open_fuzzy(FUZZY_ISO, 2);
+  if (!p_iso) {
+    fprintf(stderr, "Couldn't open %s with a fuzz of 2\n", FUZZY_ISO);
+    remove(FUZZY_ISO);
+    return 2;
+  }
+
+  p_stat = iso9660_ifs_stat_translate(p_iso, "/copying");
+  if (!p_stat || 18002 != p_stat->total_size) {
+    fprintf(stderr, "The PVD before ISO_PVD_SECTOR was taken\n");
+    i_rc = 3;
+  } else
+    printf("-- Good! The PVD after ISO_PVD_SECTOR was taken\n");
+
+  iso9660_stat_free(p_stat);
+  iso9660_close(p_iso);
+  remove(FUZZY_ISO);
+  return i_rc;
+}
@@ -0,0 +1,120 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Tests iso9660_ifs_file_pread() on a multi-extent file against a
+   copy of that file, over byte ranges that start and end inside and
+   on block boundaries.  */
+
+#ifndef DATA_DIR
+#define DATA_DIR "./data"
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/iso9660.h>
+
+int
+main(int argc, const char *argv[])
+{
+  static const struct { uint64_t i_offset; size_t i_len; } ranges[] = {
+    {0, 1}, {0, ISO_BLOCKSIZE}, {1, ISO_BLOCKSIZE}, {100, 10},
+    {ISO_BLOCKSIZE - 1, 2}, {ISO_BLOCKSIZE, 3 * ISO_BLOCKSIZE},
+    {700, 5 * ISO_BLOCKSIZE + 1000}, {8191, 8193}, {0, 54305},
+    {54300, 100}, {3, 0}
+  };
+  const char *psz_fname = DATA_DIR "/multi_extent_8k.iso";
+  iso9660_t *p_iso = iso9660_open(psz_fname);
+  iso9660_stat_t *p_stat;
+  FILE *p_fd;
+  uint8_t *p_expected, *p_got;
+  long int i_size;
+  unsigned int i;
+
+  if (!p_iso) {
+    fprintf(stderr, "Sorry, couldn't open %s as an ISO-9660 image\n",
+            psz_fname);
+    return 1;
+  }
+  p_stat = iso9660_ifs_stat(p_iso, "/multi_extent_file");
+  if (!p_stat) {
+    fprintf(stderr, "Couldn't stat /multi_extent_file in %s\n", psz_fname);
+    return 2;
+  }
+
+  p_fd = fopen(DATA_DIR "/multi_extent_file", "rb");
+  if (!p_fd) {
+    fprintf(stderr, "Couldn't open %s\n", DATA_DIR "/multi_extent_file");
+    return 3;
+  }
+  fseek(p_fd, 0, SEEK_END);
+  i_size = ftell(p_fd);
+  fseek(p_fd, 0, SEEK_SET);
+  p_expected = malloc(i_size);
+  p_got = malloc(i_size + 1);
+  if (!p_expected || !p_got || 1 != fread(p_expected, i_size, 1, p_fd)
+      || (uint64_t) i_size != p_stat->total_size) {
+    fprintf(stderr, "Couldn't read %s\n", DATA_DIR "/multi_extent_file");
+    return 4;
+  }
+  fclose(p_fd);
+
+  for (i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+    size_t i_want = ranges[i].i_len;
+    ssize_t i_read;
+
+    if (ranges[i].i_offset + i_want > (uint64_t) i_size)
+      i_want = i_size - ranges[i].i_offset;
+    memset(p_got, 0xa5, i_size + 1);
+    i_read = iso9660_ifs_file_pread(p_iso, p_stat, p_got, ranges[i].i_len,
+                                    ranges[i].i_offset);
+    if (i_read != (ssize_t) i_want
+        || 0 != memcmp(p_got, p_expected + ranges[i].i_offset, i_want)
+        || 0xa5 != p_got[i_want]) {
+      fprintf(stderr, "Reading %lu bytes at %lu gave %ld bytes, "
+              "expected %lu\n", (unsigned long) ranges[i].i_len,
+              (unsigned long) ranges[i].i_offset, (long) i_read,
+              (unsigned long) i_want);
+      return 5;
+    }
+  }
+
+  if (0 != iso9660_ifs_file_pread(p_iso, p_stat, p_got, 10, i_size)) {
+    fprintf(stderr, "Reading at the end of the file should give 0\n");
+    return 6;
+  }
+
+  printf("-- Good! byte ranges of multi_extent_file read correctly\n");
+  free(p_expected);
+  free(p_got);
+  iso9660_stat_free(p_stat);
+  iso9660_close(p_iso);
+  return 0;
+}
@@ -25,6 +25,12 @@
 #define ISO9660_IMAGE_PATH DATA_DIR "/"
 #define ISO9660_IMAGE    ISO9660_IMAGE_PATH "copying.iso"
 #define ISO9660_IMAGE_RR ISO9660_IMAGE_PATH "copying-rr.iso"
+#define ISO9660_IMAGE_JOLIET ISO9660_IMAGE_PATH "joliet.iso"
+
+/* A copy of joliet.iso whose Joliet "libcdio" entry has a Rock Ridge
+   name a little longer than the Joliet one */
+#define JOLIET_RR_IMAGE "testisorr.iso"
+#define JOLIET_RR_NAME  "libcdio-renamed"
 
 #define SKIP_TEST_RC 77
 
@@ -52,6 +58,119 @@
 #include <cdio/cdio.h>
 #include <cdio/iso9660.h>
 
+/* Write JOLIET_RR_IMAGE. The record for "libcdio" in the Joliet root
+   directory gets an NM entry of JOLIET_RR_NAME. */
+static bool
+write_joliet_rr_image(void)
+{
+  FILE *p_in = fopen(ISO9660_IMAGE_JOLIET, "rb");
+  FILE *p_out;
+  uint8_t *p_image;
+  uint8_t *p_dir = NULL;
+  long int i_size;
+  unsigned int i, i_offset;
+  bool b_ok = false;
+
+  if (!p_in) return false;
+  fseek(p_in, 0, SEEK_END);
+  i_size = ftell(p_in);
+  fseek(p_in, 0, SEEK_SET);
+  p_image = malloc(i_size);
+  if (!p_image || 1 != fread(p_image, i_size, 1, p_in)) {
+    free(p_image);
+    fclose(p_in);
+    return false;
+  }
+  fclose(p_in);
+
+  /* The supplementary volume descriptor has the Joliet root. */
+  for (i = ISO_PVD_SECTOR; (i + 1) * ISO_BLOCKSIZE <= (unsigned long) i_size;
+       i++) {
+    const uint8_t *p_vd = p_image + i * ISO_BLOCKSIZE;
+
+    if (ISO_VD_END == p_vd[0]) break;
+    if (ISO_VD_SUPPLEMENTARY == p_vd[0]) {
+      const uint8_t *p_root = p_vd + 156;
+      const uint32_t i_lsn = p_root[2] | (p_root[3] << 8)
+        | (p_root[4] << 16) | ((uint32_t) p_root[5] << 24);
+
+      if ((i_lsn + 1) * ISO_BLOCKSIZE <= (unsigned long) i_size)
+        p_dir = p_image + i_lsn * ISO_BLOCKSIZE;
+      break;
+    }
+  }
+
+  /* "libcdio" is the entry after "." and "..". It is the last one, so
+     it can grow into the free space after it. */
+  for (i_offset = 0; p_dir && i_offset < ISO_BLOCKSIZE && p_dir[i_offset];
+       i_offset += p_dir[i_offset]) {
+    uint8_t *p_rec = p_dir + i_offset;
+    const unsigned int i_su = (33 + p_rec[32] + 1) & ~1U;
+    const unsigned int i_nm = 5 + strlen(JOLIET_RR_NAME);
+
+    if (14 != p_rec[32] || memcmp(p_rec + 33, "\0l\0i\0b\0c\0d\0i\0o", 14))
+      continue;
+    if (0 != p_rec[p_rec[0]]
+        || i_offset + i_su + i_nm + 1 > ISO_BLOCKSIZE)
+      break;
+    p_rec[i_su]     = 'N';
+    p_rec[i_su + 1] = 'M';
+    p_rec[i_su + 2] = i_nm;
+    p_rec[i_su + 3] = 1;
+    p_rec[i_su + 4] = 0;
+    memcpy(p_rec + i_su + 5, JOLIET_RR_NAME, i_nm - 5);
+    p_rec[0] = (i_su + i_nm + 1) & ~1U;
+    b_ok = true;
+    break;
+  }
+
+  p_out = b_ok ? fopen(JOLIET_RR_IMAGE, "wb") : NULL;
+  b_ok = p_out && 1 == fwrite(p_image, i_size, 1, p_out);
+  if (p_out && 0 != fclose(p_out)) b_ok = false;
+  free(p_image);
+  return b_ok;
+}
+
+/* A Rock Ridge name longer than the Joliet one, but not than the room
+   left for the Joliet one in UTF-8, is taken. */
+static int
+check_joliet_rr(void)
+{
+  iso9660_t *p_iso;
+  CdioISO9660FileList_t *p_entlist;
+  CdioListNode_t *p_entnode;
+  bool b_found = false;
+  uint8_t u_joliet_level = 0;
+
+  if (!write_joliet_rr_image()) {
+    fprintf(stderr, "-- Couldn't write %s\n", JOLIET_RR_IMAGE);
+    remove(JOLIET_RR_IMAGE);
+    return 10;
+  }
+  p_iso = iso9660_open_ext(JOLIET_RR_IMAGE, ISO_EXTENSION_ALL);
+  if (p_iso) u_joliet_level = iso9660_ifs_get_joliet_level(p_iso);
+  p_entlist = p_iso ? iso9660_ifs_readdir(p_iso, "/") : NULL;
+  if (p_entlist) {
+    _CDIO_LIST_FOREACH (p_entnode, p_entlist) {
+      iso9660_stat_t *p_stat = _cdio_list_node_data (p_entnode);
+      if (0 == strcmp(p_stat->filename, JOLIET_RR_NAME))
+        b_found = true;
+    }
+    iso9660_filelist_free(p_entlist);
+  }
+  iso9660_close(p_iso);
+  remove(JOLIET_RR_IMAGE);
+
+  if (!b_found || 0 == u_joliet_level) {
+    fprintf(stderr, "-- Expected %s in the Joliet tree of %s\n",
+            JOLIET_RR_NAME, JOLIET_RR_IMAGE);
+    return 11;
+  }
+  printf("-- Good! Rock Ridge name %s read in a Joliet tree\n",
+         JOLIET_RR_NAME);
+  return 0;
+}
+
 int
 main(int argc, const char *argv[])
 {
@@ -99,7 +218,87 @@ main(int argc, const char *argv[])
     return 3;
   }
 
+  /* Entries of a directory listing must stay usable after the list
+     itself is gone, as long as each one is freed on its own. */
+  {
+    CdioISO9660FileList_t *p_entlist = iso9660_ifs_readdir(p_iso, "/copy/");
+    CdioListNode_t *p_entnode;
+    iso9660_stat_t *ap_stat[3] = {NULL, NULL, NULL};
+    iso9660_stat_t *p_link = NULL;
+    unsigned int i = 0;
+
+    if (NULL == p_entlist || _cdio_list_length(p_entlist) != 3) {
+      fprintf(stderr, "-- Expected 3 entries in /copy/ of %s\n", psz_fname);
+      return 4;
+    }
+    _CDIO_LIST_FOREACH (p_entnode, p_entlist) {
+      ap_stat[i] = (iso9660_stat_t *) _cdio_list_node_data (p_entnode);
+      if (0 == strcmp(ap_stat[i]->filename, "COPYING"))
+	p_link = ap_stat[i];
+      i++;
+    }
+    _cdio_list_free(p_entlist, false, NULL);
+
+    if (NULL == p_link || NULL == p_link->rr.psz_symlink
+	|| 0 != strcmp(p_link->rr.psz_symlink, "../COPYING")) {
+      fprintf(stderr, "-- Expected symlink /copy/COPYING -> ../COPYING\n");
+      return 5;
+    }
+    for (i = 0; i < 3; i++)
+      iso9660_stat_free(ap_stat[i]);
+  }
+
+  /* With lazy decoding, only names come with a directory listing;
+     the rest is filled in when asked for. */
+  iso9660_ifs_set_rock_ridge_lazy(p_iso, true);
+  {
+    CdioISO9660FileList_t *p_entlist = iso9660_ifs_readdir(p_iso, "/");
+    CdioListNode_t *p_entnode;
+    iso9660_stat_t *p_link = NULL;
+    const iso_rock_statbuf_t *p_rr;
+
+    if (NULL == p_entlist) {
+      fprintf(stderr, "-- Couldn't read / of %s lazily\n", psz_fname);
+      return 6;
+    }
+    _CDIO_LIST_FOREACH (p_entnode, p_entlist) {
+      iso9660_stat_t *p_stat = _cdio_list_node_data (p_entnode);
+      if (0 == strcmp(p_stat->filename, "Copy2"))
+	p_link = p_stat;
+    }
+    if (NULL == p_link || yep != p_link->rr.b3_rock
+	|| !p_link->rr.b_deferred || NULL != p_link->rr.psz_symlink) {
+      fprintf(stderr, "-- Expected Copy2 with deferred Rock Ridge fields\n");
+      return 7;
+    }
+    p_rr = iso9660_ifs_get_rock_ridge(p_iso, p_link);
+    if (NULL == p_rr || p_link->rr.b_deferred
+	|| ISO_ROCK_ISLNK != (p_rr->st_mode & 0170000)
+	|| NULL == p_rr->psz_symlink
+	|| 0 != strcmp(p_rr->psz_symlink, "COPYING")) {
+      fprintf(stderr, "-- Expected symlink Copy2 -> COPYING on access\n");
+      return 8;
+    }
+    printf("-- Good! Rock Ridge fields of Copy2 decoded on access\n");
+    iso9660_filelist_free(p_entlist);
+  }
+
+  /* The root's come from its "." entry. */
+  {
+    iso9660_stat_t *p_root = iso9660_ifs_stat(p_iso, "/");
+    const iso_rock_statbuf_t *p_rr =
+      iso9660_ifs_get_rock_ridge(p_iso, p_root);
+
+    if (NULL == p_rr || ISO_ROCK_ISDIR != (p_rr->st_mode & 0170000)) {
+      fprintf(stderr, "-- Expected Rock Ridge fields for / on access\n");
+      iso9660_stat_free(p_root);
+      return 9;
+    }
+    printf("-- Good! Rock Ridge fields of / decoded on access\n");
+    iso9660_stat_free(p_root);
+  }
+
   iso9660_close(p_iso);
 
-  return 0;
+  return check_joliet_rr();
 }
@@ -0,0 +1,242 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Reads every ISO 9660 image in the test data directory from several
+   threads at once and checks each thread sees what a single thread
+   does. Meant to be run under ThreadSanitizer too.  */
+
+#ifndef DATA_DIR
+#define DATA_DIR "./data"
+#endif
+
+#define THREADS    4
+#define ITERATIONS 3
+#define MAX_IMAGES 32
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/cd_types.h>
+#include <cdio/iso9660.h>
+#include <cdio/logging.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <dirent.h>
+
+static char *apsz_image[MAX_IMAGES];
+static unsigned long ai_expected[MAX_IMAGES];
+static unsigned int i_images;
+static cdio_fs_anal_t expected_fs;
+
+/* Logging is on at every level but goes nowhere, so that cdio_logv()
+   is entered from all threads at the same time. */
+static void
+quiet_log_handler(cdio_log_level_t level, const char message[])
+{
+}
+
+static unsigned long
+hash_str(unsigned long i_hash, const char *psz)
+{
+  while (*psz)
+    i_hash = i_hash * 33 + (unsigned char) *psz++;
+  return i_hash * 33 + '\n';
+}
+
+/* Hash what a listing of psz_path and everything below it shows,
+   looking each entry up by path again on the way. */
+static unsigned long
+hash_dir(iso9660_t *p_iso, const char psz_path[], unsigned long i_hash)
+{
+  CdioISO9660FileList_t *p_entlist = iso9660_ifs_readdir(p_iso, psz_path);
+  CdioListNode_t *p_entnode;
+
+  if (!p_entlist) return hash_str(i_hash, "?");
+
+  _CDIO_LIST_FOREACH (p_entnode, p_entlist) {
+    iso9660_stat_t *p_stat = _cdio_list_node_data (p_entnode);
+    char rock_str[ISO_ROCK_ATTR_STR_SIZE];
+    char xa_str[ISO_XA_ATTR_STR_SIZE];
+    char *psz_child;
+    iso9660_stat_t *p_found;
+
+    i_hash = hash_str(i_hash, p_stat->filename);
+    i_hash = i_hash * 33 + p_stat->lsn;
+    i_hash = i_hash * 33 + (unsigned long) p_stat->total_size;
+
+    iso9660_get_rock_attr_str_r(p_stat->rr.st_mode, rock_str);
+    if (0 != strcmp(rock_str, iso9660_get_rock_attr_str(p_stat->rr.st_mode)))
+      return 1;
+    i_hash = hash_str(i_hash, rock_str);
+    iso9660_get_xa_attr_str_r(p_stat->xa.attributes, xa_str);
+    if (0 != strcmp(xa_str, iso9660_get_xa_attr_str(p_stat->xa.attributes)))
+      return 2;
+    i_hash = hash_str(i_hash, xa_str);
+
+    if (0 == strcmp(p_stat->filename, ".")
+        || 0 == strcmp(p_stat->filename, ".."))
+      continue;
+
+    psz_child = calloc(1, strlen(psz_path) + strlen(p_stat->filename) + 2);
+    if (!psz_child) exit(20);
+    sprintf(psz_child, "%s%s", psz_path, p_stat->filename);
+    p_found = iso9660_ifs_stat(p_iso, psz_child);
+    i_hash = i_hash * 33 + (p_found ? p_found->lsn : 0);
+    iso9660_stat_free(p_found);
+    if (_STAT_DIR == p_stat->type) {
+      strcat(psz_child, "/");
+      i_hash = hash_dir(p_iso, psz_child, i_hash);
+    }
+    free(psz_child);
+  }
+  iso9660_filelist_free(p_entlist);
+  return i_hash;
+}
+
+static unsigned long
+hash_image(const char *psz_fname)
+{
+  iso9660_t *p_iso = iso9660_open_ext(psz_fname, ISO_EXTENSION_ALL);
+  unsigned long i_hash = 5381;
+  char *psz_id = NULL;
+
+  if (!p_iso) return 0;
+  if (iso9660_ifs_get_volume_id(p_iso, &psz_id)) {
+    i_hash = hash_str(i_hash, psz_id);
+    free(psz_id);
+  }
+  i_hash = hash_dir(p_iso, "/", i_hash);
+  iso9660_close(p_iso);
+  return i_hash;
+}
+
+static cdio_fs_anal_t
+guess_cue(void)
+{
+  CdIo_t *p_cdio = cdio_open(DATA_DIR "/isofs-m1.cue", DRIVER_BINCUE);
+  cdio_iso_analysis_t analysis;
+  cdio_fs_anal_t fs;
+
+  if (!p_cdio) return CDIO_FS_UNKNOWN;
+  memset(&analysis, 0, sizeof(analysis));
+  fs = cdio_guess_cd_type(p_cdio, 0, 1, &analysis);
+  cdio_destroy(p_cdio);
+  return fs;
+}
+
+static void *
+stress(void *p_arg)
+{
+  unsigned int i_thread = (unsigned int) (size_t) p_arg;
+  unsigned int i, j;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    for (j = 0; j < i_images; j++) {
+      unsigned int k = (i_thread + j) % i_images;
+      if (hash_image(apsz_image[k]) != ai_expected[k]) {
+        fprintf(stderr, "thread %u saw %s differently\n", i_thread,
+                apsz_image[k]);
+        return (void *) 1;
+      }
+    }
+    if (guess_cue() != expected_fs) {
+      fprintf(stderr, "thread %u guessed isofs-m1.cue differently\n",
+              i_thread);
+      return (void *) 1;
+    }
+  }
+  return NULL;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  DIR *p_dir = opendir(DATA_DIR);
+  struct dirent *p_dirent;
+  pthread_t thread[THREADS];
+  unsigned int i;
+  int i_rc = 0;
+
+  if (!p_dir) {
+    fprintf(stderr, "Can't open %s\n", DATA_DIR);
+    return 1;
+  }
+  while (i_images < MAX_IMAGES && (p_dirent = readdir(p_dir))) {
+    size_t i_len = strlen(p_dirent->d_name);
+    if (i_len < 4 || 0 != strcmp(p_dirent->d_name + i_len - 4, ".iso"))
+      continue;
+    apsz_image[i_images] = calloc(1, sizeof(DATA_DIR) + i_len + 1);
+    if (!apsz_image[i_images]) exit(20);
+    sprintf(apsz_image[i_images], "%s/%s", DATA_DIR, p_dirent->d_name);
+    i_images++;
+  }
+  closedir(p_dir);
+
+  cdio_log_set_handler(quiet_log_handler);
+  cdio_loglevel_default = CDIO_LOG_DEBUG;
+
+  /* What a single thread sees. */
+  for (i = 0; i < i_images; i++)
+    ai_expected[i] = hash_image(apsz_image[i]);
+  expected_fs = guess_cue();
+  if (0 == (expected_fs & CDIO_FS_MASK)) {
+    fprintf(stderr, "isofs-m1.cue wasn't recognized\n");
+    return 2;
+  }
+
+  for (i = 0; i < THREADS; i++)
+    if (0 != pthread_create(&thread[i], NULL, stress, (void *) (size_t) i)) {
+      fprintf(stderr, "Can't create thread %u\n", i);
+      return 77;
+    }
+  for (i = 0; i < THREADS; i++) {
+    void *p_ret;
+    pthread_join(thread[i], &p_ret);
+    if (p_ret) i_rc = 3;
+  }
+
+  for (i = 0; i < i_images; i++)
+    free(apsz_image[i]);
+  if (0 == i_rc)
+    printf("-- Good! %u images read by %u threads\n", i_images, THREADS);
+  return i_rc;
+}
+
+#else
+
+int
+main(int argc, const char *argv[])
+{
+  printf("-- POSIX threads not available; skipping\n");
+  return 77;
+}
+
+#endif /* HAVE_PTHREAD */
@@ -45,11 +45,352 @@
 #endif
 
 #include <cdio/cdio.h>
+#include <cdio/bytesex.h>
 #include <cdio/udf.h>
 
 #define EXPECTED_NAME    "FéжΘvrier"
 #define EXPECTED_LENGTH  10
 
+/* A copy of UDF_IMAGE with an allocation extent descriptor added */
+#define AED_IMAGE        "testudf.tmp"
+#define AED_EXTENTS      40
+
+/* A copy of UDF_IMAGE with its Main Volume Descriptor Sequence wiped,
+   or moved to the end of a longer extent */
+#define VDS_IMAGE        "testudf-vds.tmp"
+#define VDS_PAD_BLOCKS   100
+
+static void
+set_short_ad(uint8_t *p_ad, uint32_t i_len, uint32_t i_pos)
+{
+  udf_short_ad_t short_ad;
+
+  short_ad.len = uint32_to_le(i_len);
+  short_ad.pos = uint32_to_le(i_pos);
+  memcpy(p_ad, &short_ad, sizeof(short_ad));
+}
+
+/* Make a copy of UDF_IMAGE with an allocation extent descriptor of
+   AED_EXTENTS one-block extents appended. Return the block it is at,
+   relative to the partition, or 0 on failure. */
+static uint32_t
+write_aed_image(uint32_t i_part_start)
+{
+  FILE *p_in = fopen(UDF_IMAGE, "rb");
+  FILE *p_out = fopen(AED_IMAGE, "wb");
+  uint8_t block[UDF_BLOCKSIZE];
+  uint32_t i_blocks = 0;
+  struct allocExtDesc aed;
+  uint8_t cksum = 0;
+  unsigned int i;
+
+  if (!p_in || !p_out) return 0;
+  while (fread(block, UDF_BLOCKSIZE, 1, p_in) == 1) {
+    if (fwrite(block, UDF_BLOCKSIZE, 1, p_out) != 1) return 0;
+    i_blocks++;
+  }
+  fclose(p_in);
+
+  /* Allocation Extent Descriptor for the first blocks of the
+     partition, backwards and over again. */
+  memset(&aed, 0, sizeof(aed));
+  aed.tag.id = uint16_to_le(TAGID_AED);
+  aed.tag.desc_version = uint16_to_le(2);
+  aed.i_alloc_descs = uint32_to_le(AED_EXTENTS * sizeof(udf_short_ad_t));
+  memset(block, 0, sizeof(block));
+  memcpy(block, &aed, sizeof(aed));
+  for (i = 0; i < 16; i++)
+    if (i != 4) cksum += block[i];
+  block[4] = cksum;
+  for (i = 0; i < AED_EXTENTS; i++)
+    set_short_ad(block + sizeof(aed) + i * sizeof(udf_short_ad_t),
+                 UDF_BLOCKSIZE, (AED_EXTENTS - i) % 13);
+  if (fwrite(block, UDF_BLOCKSIZE, 1, p_out) != 1) return 0;
+  if (fclose(p_out)) return 0;
+  return i_blocks - i_part_start;
+}
+
+/* Make a copy of UDF_IMAGE whose Main Volume Descriptor Sequence is
+   zeroed out, so that only the Reserve one can be used. If b_long,
+   the sequence is instead copied to the end of the image, after
+   VDS_PAD_BLOCKS empty blocks, and both anchor extents cover the
+   empty blocks and the copy. That is more than udf_open() reads at
+   once. */
+static bool
+write_vds_image(bool b_long)
+{
+  FILE *p_in = fopen(UDF_IMAGE, "rb");
+  FILE *p_out = fopen(VDS_IMAGE, "wb");
+  uint8_t block[UDF_BLOCKSIZE];
+  anchor_vol_desc_ptr_t avdp;
+  uint32_t i_mvds_start = 0, i_mvds_end = 0;
+  uint32_t i_lba, i_blocks;
+
+  if (!p_in || !p_out) return false;
+  for (i_lba = 0; fread(block, UDF_BLOCKSIZE, 1, p_in) == 1; i_lba++) {
+    if (256 == i_lba) {
+      memcpy(&avdp, block, sizeof(avdp));
+      i_mvds_start = uint32_from_le(avdp.main_vol_desc_seq_ext.loc);
+      i_mvds_end = i_mvds_start
+        + uint32_from_le(avdp.main_vol_desc_seq_ext.len) / UDF_BLOCKSIZE;
+    }
+    if (fwrite(block, UDF_BLOCKSIZE, 1, p_out) != 1) return false;
+  }
+  i_blocks = i_lba;
+  if (i_mvds_start >= i_mvds_end) return false;
+
+  if (b_long) {
+    const uint32_t i_len =
+      (VDS_PAD_BLOCKS + i_mvds_end - i_mvds_start) * UDF_BLOCKSIZE;
+
+    memset(block, 0, sizeof(block));
+    for (i_lba = 0; i_lba < VDS_PAD_BLOCKS; i_lba++)
+      if (fwrite(block, UDF_BLOCKSIZE, 1, p_out) != 1) return false;
+    if (fseek(p_in, (long) i_mvds_start * UDF_BLOCKSIZE, SEEK_SET))
+      return false;
+    for (i_lba = i_mvds_start; i_lba < i_mvds_end; i_lba++)
+      if (fread(block, UDF_BLOCKSIZE, 1, p_in) != 1
+          || fwrite(block, UDF_BLOCKSIZE, 1, p_out) != 1) return false;
+    fclose(p_in);
+
+    /* Only the tag's own checksum is checked, which this leaves
+       alone. */
+    avdp.main_vol_desc_seq_ext.loc = uint32_to_le(i_blocks);
+    avdp.main_vol_desc_seq_ext.len = uint32_to_le(i_len);
+    avdp.reserve_vol_desc_seq_ext = avdp.main_vol_desc_seq_ext;
+    if (fseek(p_out, 256L * UDF_BLOCKSIZE, SEEK_SET)
+        || fwrite(&avdp, sizeof(avdp), 1, p_out) != 1)
+      return false;
+    return 0 == fclose(p_out);
+  }
+  fclose(p_in);
+
+  memset(block, 0, sizeof(block));
+  if (fseek(p_out, (long) i_mvds_start * UDF_BLOCKSIZE, SEEK_SET))
+    return false;
+  for (i_lba = i_mvds_start; i_lba < i_mvds_end; i_lba++)
+    if (fwrite(block, UDF_BLOCKSIZE, 1, p_out) != 1) return false;
+  return 0 == fclose(p_out);
+}
+
+/* The copy with no Main Volume Descriptor Sequence must read just
+   like the original, through the Reserve one; and so must the one
+   whose sequence comes after many empty blocks. */
+static int
+check_reserve_vds(udf_t *p_udf, bool b_long)
+{
+  char volume_id[192], volume_id2[192];
+  uint8_t volset_id[UDF_VOLSET_ID_SIZE], volset_id2[UDF_VOLSET_ID_SIZE];
+  udf_t *p_udf2;
+  udf_dirent_t *p_udf_root2, *p_udf_file2 = NULL;
+  int rc = 0;
+
+  if (!write_vds_image(b_long)) return 30;
+  p_udf2 = udf_open(VDS_IMAGE);
+  unlink(VDS_IMAGE);
+  if (!p_udf2) return b_long ? 35 : 31;
+
+  /* Served from the descriptors udf_open() kept, with no root yet. */
+  if (udf_get_logical_volume_id(p_udf2, volume_id2, sizeof(volume_id2)) <= 0
+      || 0 != strcmp(EXPECTED_NAME, volume_id2)
+      || udf_get_volume_id(p_udf, volume_id, sizeof(volume_id)) <= 0
+      || udf_get_volume_id(p_udf2, volume_id2, sizeof(volume_id2)) <= 0
+      || 0 != strcmp(volume_id, volume_id2)
+      || UDF_VOLSET_ID_SIZE != udf_get_volumeset_id(p_udf, volset_id,
+                                                    sizeof(volset_id))
+      || UDF_VOLSET_ID_SIZE != udf_get_volumeset_id(p_udf2, volset_id2,
+                                                    sizeof(volset_id2))
+      || 0 != memcmp(volset_id, volset_id2, UDF_VOLSET_ID_SIZE))
+    rc = 32;
+
+  p_udf_root2 = udf_get_root(p_udf2, true, 0);
+  if (p_udf_root2) p_udf_file2 = udf_fopen(p_udf_root2, EXPECTED_NAME);
+  if (!rc && (!p_udf_file2
+              || udf_get_file_length(p_udf_file2) != EXPECTED_LENGTH))
+    rc = 33;
+  if (!rc && udf_get_root(p_udf2, false, 1))
+    rc = 34;
+
+  udf_dirent_free(p_udf_file2);
+  udf_dirent_free(p_udf_root2);
+  udf_close(p_udf2);
+  return rc;
+}
+
+/* Give p_udf_file a file entry for a file in many extents, a few in
+   the file entry and the rest in an allocation extent descriptor, and
+   read it back with udf_read_block() and udf_pread(). */
+static int
+check_extents(udf_dirent_t *p_udf_file, uint32_t i_aed_lba)
+{
+  udf_t *p_udf = p_udf_file->p_udf;
+  udf_file_entry_t *p_fe = &p_udf_file->fe;
+  uint16_t i_flags;
+  uint8_t *p_ads = p_fe->u.alloc_descs;
+  uint8_t buf[UDF_BLOCKSIZE], expected[UDF_BLOCKSIZE];
+  uint8_t *p_file, *p_got;
+  uint64_t i_length = 0, i_pos = 0;
+  ssize_t i_read;
+  unsigned int i;
+  /* offset and length of udf_pread() calls, some of them unaligned,
+     crossing extents or going past the end of the file */
+  static const unsigned int ai_range[][2] = {
+    { 0, 4 * UDF_BLOCKSIZE + 100 + AED_EXTENTS * UDF_BLOCKSIZE },
+    { 0, 1 }, { 10, 20 }, { 2000, 100 }, { 1000, 3 * UDF_BLOCKSIZE },
+    { 3 * UDF_BLOCKSIZE + 7, 2 * UDF_BLOCKSIZE },
+    { 4 * UDF_BLOCKSIZE + 50, 10 * UDF_BLOCKSIZE + 3 },
+    { 4 * UDF_BLOCKSIZE + 100, AED_EXTENTS * UDF_BLOCKSIZE },
+    { 20 * UDF_BLOCKSIZE, 100 * UDF_BLOCKSIZE },
+  };
+
+  /* The file entry is read on first use, which must not be after it
+     has been set up here. */
+  if (udf_get_link_count(p_udf_file) == 0) return 11;
+  i_flags = uint16_from_le(p_fe->icb_tag.flags);
+  i_flags = (i_flags & ~ICBTAG_FLAG_AD_MASK) | ICBTAG_FLAG_AD_SHORT;
+  p_fe->icb_tag.flags = uint16_to_le(i_flags);
+  p_fe->icb_tag.strat_type = uint16_to_le(ICBTAG_STRATEGY_TYPE_4);
+  p_fe->i_extended_attr = 0;
+  memset(p_ads, 0, 5 * sizeof(udf_short_ad_t));
+  /* two blocks at partition block 1, two not recorded, then 100 bytes
+     at partition block 0 */
+  set_short_ad(p_ads, 2 * UDF_BLOCKSIZE, 1);
+  set_short_ad(p_ads + 8, EXT_NOT_RECORDED_ALLOCATED | 2 * UDF_BLOCKSIZE, 0);
+  set_short_ad(p_ads + 16, 100, 0);
+  set_short_ad(p_ads + 24, EXT_NEXT_EXTENT_ALLOCDECS | UDF_BLOCKSIZE,
+               i_aed_lba);
+  p_fe->i_alloc_descs = uint32_to_le(4 * sizeof(udf_short_ad_t));
+  i_length = 4 * UDF_BLOCKSIZE + 100
+    + (uint64_t) AED_EXTENTS * UDF_BLOCKSIZE;
+  p_fe->info_len = uint64_to_le(i_length);
+  p_file = malloc(i_length);
+  p_got = malloc(i_length);
+  if (!p_file || !p_got) exit(20);
+
+  for (i = 0; i < 5 + AED_EXTENTS; i++) {
+    memset(expected, 0, sizeof(expected));
+    if (i < 2)
+      udf_read_sectors(p_udf, expected, p_udf_file->i_part_start + 1 + i, 1);
+    else if (4 == i)
+      udf_read_sectors(p_udf, expected, p_udf_file->i_part_start, 1);
+    else if (i > 4)
+      udf_read_sectors(p_udf, expected, p_udf_file->i_part_start
+                       + (AED_EXTENTS - (i - 5)) % 13, 1);
+
+    i_read = udf_read_block(p_udf_file, buf, 1);
+    if (i_read != (4 == i ? 100 : UDF_BLOCKSIZE)
+        || 0 != memcmp(buf, expected, i_read)) {
+      fprintf(stderr, "Block %u of a fragmented file read wrongly "
+              "(%ld bytes)\n", i, (long) i_read);
+      return 6;
+    }
+    memcpy(p_file + i_pos, buf, i_read);
+    i_pos += i_read;
+  }
+  if (udf_read_block(p_udf_file, buf, 1) >= 0) {
+    fprintf(stderr, "Read past the end of a fragmented file\n");
+    return 7;
+  }
+
+  for (i = 0; i < sizeof(ai_range) / sizeof(ai_range[0]); i++) {
+    uint64_t i_offset = ai_range[i][0];
+    size_t i_len = ai_range[i][1];
+    ssize_t i_expected = (i_offset + i_len > i_length)
+      ? (ssize_t) (i_length - i_offset) : (ssize_t) i_len;
+
+    memset(p_got, 0xa5, i_length);
+    i_read = udf_pread(p_udf_file, p_got, i_len, i_offset);
+    if (i_read != i_expected
+        || 0 != memcmp(p_got, p_file + i_offset, i_read)) {
+      fprintf(stderr, "udf_pread() of %lu bytes at %lu read wrongly "
+              "(%ld bytes)\n", (unsigned long) i_len,
+              (unsigned long) i_offset, (long) i_read);
+      return 9;
+    }
+  }
+  if (0 != udf_pread(p_udf_file, p_got, 10, i_length)) {
+    fprintf(stderr, "udf_pread() at the end of the file read something\n");
+    return 10;
+  }
+
+  free(p_file);
+  free(p_got);
+  return 0;
+}
+
+static int
+count_visitor(const char psz_dir[], const udf_dirent_t *p_udf_dirent,
+              void *p_user_data)
+{
+  if (0 == strcmp(udf_get_filename(p_udf_dirent), EXPECTED_NAME)
+      && udf_get_file_length(p_udf_dirent) == EXPECTED_LENGTH)
+    (*(unsigned int *) p_user_data)++;
+  return 0;
+}
+
+/* Turn p_udf_file into a file, and p_udf_root into a directory, whose
+   data is in the file entry, and read them. */
+static int
+check_in_icb(udf_dirent_t *p_udf_root, udf_dirent_t *p_udf_file)
+{
+  udf_file_entry_t *p_fe = &p_udf_file->fe;
+  uint8_t *p_data = p_fe->u.alloc_descs;
+  uint8_t buf[2 * UDF_BLOCKSIZE];
+  uint16_t i_flags;
+  uint64_t i_dir_len;
+  unsigned int i, i_found = 0;
+  ssize_t i_read;
+
+  if (udf_get_link_count(p_udf_file) == 0) return 20;
+  i_flags = uint16_from_le(p_fe->icb_tag.flags);
+  i_flags = (i_flags & ~ICBTAG_FLAG_AD_MASK) | ICBTAG_FLAG_AD_IN_ICB;
+  p_fe->icb_tag.flags = uint16_to_le(i_flags);
+  p_fe->i_extended_attr = 0;
+  p_fe->i_alloc_descs = uint32_to_le(100);
+  p_fe->info_len = uint64_to_le(100);
+  for (i = 0; i < 100; i++)
+    p_data[i] = (uint8_t) (7 * i);
+
+  memset(buf, 0xa5, sizeof(buf));
+  i_read = udf_read_block(p_udf_file, buf, 2);
+  if (100 != i_read || 0 != memcmp(buf, p_data, 100)
+      || 0 != buf[100] || 0 != buf[UDF_BLOCKSIZE-1]
+      || 0xa5 != buf[UDF_BLOCKSIZE]) {
+    fprintf(stderr, "Data in the file entry read wrongly (%ld bytes)\n",
+            (long) i_read);
+    return 21;
+  }
+  if (udf_read_block(p_udf_file, buf, 1) >= 0
+      || 5 != udf_pread(p_udf_file, buf, 10, 95)
+      || 0 != memcmp(buf, p_data + 95, 5)
+      || 0 != udf_pread(p_udf_file, buf, 10, 100)) {
+    fprintf(stderr, "Data in the file entry read wrongly\n");
+    return 22;
+  }
+
+  /* The same for the root directory, with its File Identifier
+     Descriptors moved into its file entry */
+  p_fe = &p_udf_root->fe;
+  i_dir_len = uint64_from_le(p_fe->info_len);
+  if (i_dir_len > sizeof(p_fe->u) || i_dir_len > UDF_BLOCKSIZE
+      || DRIVER_OP_SUCCESS != udf_read_sectors(p_udf_root->p_udf, buf,
+                                               p_udf_root->i_part_start
+                                               + p_udf_root->i_loc, 1))
+    return 23;
+  i_flags = uint16_from_le(p_fe->icb_tag.flags);
+  i_flags = (i_flags & ~ICBTAG_FLAG_AD_MASK) | ICBTAG_FLAG_AD_IN_ICB;
+  p_fe->icb_tag.flags = uint16_to_le(i_flags);
+  p_fe->i_extended_attr = 0;
+  p_fe->i_alloc_descs = uint32_to_le((uint32_t) i_dir_len);
+  memcpy(p_fe->u.alloc_descs, buf, i_dir_len);
+  if (0 != udf_walk(p_udf_root, "/", count_visitor, &i_found, 1,
+                    UDF_WALK_ORDERED) || 1 != i_found) {
+    fprintf(stderr, "Directory in the file entry read wrongly\n");
+    return 24;
+  }
+  return 0;
+}
+
 int
 main(int argc, const char *argv[])
 {
@@ -99,11 +440,74 @@ main(int argc, const char *argv[])
   }
   printf("-- Good! File length matches expected length\n");
 
+  /* Looked up again, from the cached directory and path */
+  {
+    static const char *apsz_path[] = {
+      EXPECTED_NAME, "/" EXPECTED_NAME, "//" EXPECTED_NAME "/", EXPECTED_NAME
+    };
+    udf_fileid_desc_t fid;
+    unsigned int i;
+
+    for (i = 0; i < sizeof(apsz_path) / sizeof(apsz_path[0]); i++) {
+      udf_dirent_t *p_udf_again = udf_fopen(p_udf_root, apsz_path[i]);
+
+      if (!p_udf_again
+          || 0 != strcmp(udf_get_filename(p_udf_again), EXPECTED_NAME)
+          || udf_get_file_length(p_udf_again) != EXPECTED_LENGTH
+          || !udf_get_fileid_descriptor(p_udf_again, &fid)
+          || uint32_from_le(fid.icb.loc.lba)
+             != uint32_from_le(p_udf_file->fid->icb.loc.lba)) {
+        fprintf(stderr, "Looking up %s again failed\n", apsz_path[i]);
+        rc=12;
+        goto exit;
+      }
+      udf_dirent_free(p_udf_again);
+    }
+    if (udf_fopen(p_udf_root, "no-such-file")
+        || udf_fopen(p_udf_root, EXPECTED_NAME "/no-such-file")) {
+      fprintf(stderr, "Found a file that doesn't exist\n");
+      rc=13;
+      goto exit;
+    }
+  }
+  printf("-- Good! Repeated lookups find the same file\n");
+
+  rc = check_reserve_vds(p_udf, false);
+  if (rc) goto exit;
+  rc = check_reserve_vds(p_udf, true);
+  if (rc) goto exit;
+  printf("-- Good! Reserve Volume Descriptor Sequence is used if need be\n");
+
+  rc = check_in_icb(p_udf_root, p_udf_file);
+  if (rc) goto exit;
+  printf("-- Good! Data in file entries reads back as expected\n");
+
+  {
+    uint32_t i_aed_lba = write_aed_image(p_udf_file->i_part_start);
+
+    udf_dirent_free(p_udf_root);
+    udf_dirent_free(p_udf_file);
+    p_udf_root = p_udf_file = NULL;
+    udf_close(p_udf);
+    p_udf = i_aed_lba ? udf_open(AED_IMAGE) : NULL;
+    if (p_udf) p_udf_root = udf_get_root(p_udf, true, 0);
+    if (p_udf_root) p_udf_file = udf_fopen(p_udf_root, EXPECTED_NAME);
+    if (!p_udf_file) {
+      fprintf(stderr, "Could not open the copy of %s\n", psz_fname);
+      rc=8;
+      goto exit;
+    }
+    rc = check_extents(p_udf_file, i_aed_lba);
+    if (rc) goto exit;
+  }
+  printf("-- Good! File in many extents reads back as expected\n");
+
  exit:
   if (p_udf_root != NULL)
     udf_dirent_free(p_udf_root);
   if (p_udf_file != NULL)
     udf_dirent_free(p_udf_file);
   udf_close(p_udf);
+  unlink(AED_IMAGE);
   return rc;
 }
@@ -0,0 +1,459 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Tests reading a UDF 2.50 volume, whose files and directories are in
+   a metadata partition, as Blu-ray discs have. The image is made here:
+   none of the ones in the test data directory is of that kind.  */
+
+#ifndef DATA_DIR
+#define DATA_DIR "./data"
+#endif
+#define UDF102_IMAGE DATA_DIR "/udf102.iso"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/bytesex.h>
+#include <cdio/udf.h>
+
+#define UDF250_IMAGE  "testudf250.tmp"
+
+/* Where things are. Blocks of the physical partition are relative to
+   PART_START; those of the metadata partition are blocks of the
+   metadata file, which is in two extents in the physical partition and
+   in one for its mirror. */
+#define PART_START    300
+#define PART_BLOCKS   64
+#define IMAGE_BLOCKS  (PART_START + PART_BLOCKS)
+
+#define PHYS_META_FE    0  /* metadata file entry */
+#define PHYS_MIRROR_FE  1  /* metadata mirror file entry */
+#define PHYS_META_A     10 /* metadata blocks 0-3 */
+#define PHYS_META_B     5  /* metadata blocks 4-6 */
+#define PHYS_MIRROR     20 /* metadata blocks 0-6 */
+#define PHYS_DATA       40 /* hello.txt */
+#define META_BLOCKS     7
+
+#define META_FSD        0
+#define META_ROOT_FE    1
+#define META_ROOT_DIR   2
+#define META_HELLO_FE   3
+#define META_SUB_FE     4
+#define META_SUB_DIR    5
+#define META_INNER_FE   6
+
+#define HELLO_LENGTH    3000
+#define INNER_DATA      "Stored in its file entry\n"
+
+static uint8_t *p_image;
+
+static uint8_t *
+phys_block(uint32_t i_lba)
+{
+  return p_image + (size_t) (PART_START + i_lba) * UDF_BLOCKSIZE;
+}
+
+static uint8_t *
+meta_block(uint32_t i_lba)
+{
+  return phys_block(i_lba < 4 ? PHYS_META_A + i_lba
+                    : PHYS_META_B + i_lba - 4);
+}
+
+static void
+set_tag(void *p_desc, uint16_t i_id)
+{
+  uint8_t *p = p_desc;
+  udf_tag_t *p_tag = p_desc;
+  uint8_t cksum = 0;
+  unsigned int i;
+
+  p_tag->id = uint16_to_le(i_id);
+  p_tag->desc_version = uint16_to_le(3);
+  p_tag->cksum = 0;
+  for (i = 0; i < 16; i++)
+    if (i != 4) cksum += p[i];
+  p_tag->cksum = cksum;
+}
+
+static void
+set_long_ad(udf_long_ad_t *p_ad, uint32_t i_len, uint32_t i_lba,
+            uint16_t i_part)
+{
+  p_ad->len = uint32_to_le(i_len);
+  p_ad->loc.lba = uint32_to_le(i_lba);
+  p_ad->loc.partitionReferenceNum = uint16_to_le(i_part);
+}
+
+static void
+set_short_ad(uint8_t *p_ad, uint32_t i_len, uint32_t i_pos)
+{
+  udf_short_ad_t short_ad;
+
+  short_ad.len = uint32_to_le(i_len);
+  short_ad.pos = uint32_to_le(i_pos);
+  memcpy(p_ad, &short_ad, sizeof(short_ad));
+}
+
+/* An Extended File Entry of i_type with i_ads bytes of allocation
+   descriptors of kind i_ad_flag, which the caller fills in. */
+static struct extended_file_entry *
+new_efe(uint8_t *p_block, uint8_t i_type, uint16_t i_ad_flag,
+        uint64_t i_len, uint32_t i_ads)
+{
+  struct extended_file_entry *p_efe = (struct extended_file_entry *) p_block;
+
+  p_efe->icb_tag.strat_type = uint16_to_le(ICBTAG_STRATEGY_TYPE_4);
+  p_efe->icb_tag.max_num_entries = uint16_to_le(1);
+  p_efe->icb_tag.file_type = i_type;
+  p_efe->icb_tag.flags = uint16_to_le(i_ad_flag);
+  p_efe->permissions = uint32_to_le(0x14a5);
+  p_efe->link_count = uint16_to_le(1);
+  p_efe->info_len = uint64_to_le(i_len);
+  p_efe->object_size = uint64_to_le(i_len);
+  p_efe->length_alloc_descs = uint32_to_le(i_ads);
+  return p_efe;
+}
+
+/* Append a File Identifier Descriptor for psz_name, or for the parent
+   if that is NULL, at p; return its length. */
+static unsigned int
+add_fid(uint8_t *p, const char *psz_name, uint8_t i_characteristics,
+        uint32_t i_icb)
+{
+  udf_fileid_desc_t *p_fid = (udf_fileid_desc_t *) p;
+  unsigned int i_name = psz_name ? strlen(psz_name) + 1 : 0;
+
+  p_fid->file_version_num = uint16_to_le(1);
+  p_fid->file_characteristics = i_characteristics;
+  p_fid->i_file_id = i_name;
+  set_long_ad(&p_fid->icb, UDF_BLOCKSIZE, i_icb, 1);
+  if (psz_name) {
+    p[sizeof(udf_fileid_desc_t)] = 8;
+    memcpy(p + sizeof(udf_fileid_desc_t) + 1, psz_name, i_name - 1);
+  }
+  set_tag(p_fid, TAGID_FID);
+  return (sizeof(udf_fileid_desc_t) + i_name + 3) & ~3;
+}
+
+static void
+build_metadata(void)
+{
+  udf_fsd_t *p_fsd = (udf_fsd_t *) meta_block(META_FSD);
+  struct extended_file_entry *p_efe;
+  unsigned int i_root_len = 0, i_sub_len = 0;
+  uint8_t *p;
+
+  set_long_ad(&p_fsd->root_icb, UDF_BLOCKSIZE, META_ROOT_FE, 1);
+  set_tag(p_fsd, TAGID_FSD);
+
+  p = meta_block(META_ROOT_DIR);
+  i_root_len += add_fid(p, NULL, UDF_FILE_DIRECTORY | UDF_FILE_PARENT,
+                        META_ROOT_FE);
+  i_root_len += add_fid(p + i_root_len, "hello.txt", 0, META_HELLO_FE);
+  i_root_len += add_fid(p + i_root_len, "sub", UDF_FILE_DIRECTORY,
+                        META_SUB_FE);
+  p_efe = new_efe(meta_block(META_ROOT_FE), ICBTAG_FILE_TYPE_DIRECTORY,
+                  ICBTAG_FLAG_AD_SHORT, i_root_len, sizeof(udf_short_ad_t));
+  set_short_ad(p_efe->u.alloc_descs, i_root_len, META_ROOT_DIR);
+  set_tag(p_efe, TAGID_EFE);
+
+  p = meta_block(META_SUB_DIR);
+  i_sub_len += add_fid(p, NULL, UDF_FILE_DIRECTORY | UDF_FILE_PARENT,
+                       META_ROOT_FE);
+  i_sub_len += add_fid(p + i_sub_len, "inner.txt", 0, META_INNER_FE);
+  p_efe = new_efe(meta_block(META_SUB_FE), ICBTAG_FILE_TYPE_DIRECTORY,
+                  ICBTAG_FLAG_AD_SHORT, i_sub_len, sizeof(udf_short_ad_t));
+  set_short_ad(p_efe->u.alloc_descs, i_sub_len, META_SUB_DIR);
+  set_tag(p_efe, TAGID_EFE);
+
+  /* Data of hello.txt is in the physical partition. */
+  p_efe = new_efe(meta_block(META_HELLO_FE), ICBTAG_FILE_TYPE_REGULAR,
+                  ICBTAG_FLAG_AD_LONG, HELLO_LENGTH, sizeof(udf_long_ad_t));
+  set_long_ad((udf_long_ad_t *) p_efe->u.alloc_descs, HELLO_LENGTH,
+              PHYS_DATA, 0);
+  set_tag(p_efe, TAGID_EFE);
+
+  p_efe = new_efe(meta_block(META_INNER_FE), ICBTAG_FILE_TYPE_REGULAR,
+                  ICBTAG_FLAG_AD_IN_ICB, strlen(INNER_DATA),
+                  strlen(INNER_DATA));
+  memcpy(p_efe->u.alloc_descs, INNER_DATA, strlen(INNER_DATA));
+  set_tag(p_efe, TAGID_EFE);
+}
+
+static void
+build_vds(uint32_t i_lba)
+{
+  udf_pvd_t *p_pvd = (udf_pvd_t *) (p_image + i_lba * UDF_BLOCKSIZE);
+  partition_desc_t *p_partition =
+    (partition_desc_t *) (p_image + (i_lba + 1) * UDF_BLOCKSIZE);
+  logical_vol_desc_t *p_logvol =
+    (logical_vol_desc_t *) (p_image + (i_lba + 2) * UDF_BLOCKSIZE);
+  struct generic_partition_map1 *p_map1 =
+    (struct generic_partition_map1 *) p_logvol->partition_maps;
+  struct metadata_partition_map *p_meta =
+    (struct metadata_partition_map *) (p_logvol->partition_maps
+                                       + sizeof(*p_map1));
+
+  p_pvd->vol_ident[0] = 8;
+  memcpy(p_pvd->vol_ident + 1, "UDF250", 6);
+  p_pvd->vol_ident[UDF_VOLID_SIZE - 1] = 7;
+  set_tag(p_pvd, TAGID_PRI_VOL);
+
+  p_partition->number = uint16_to_le(0);
+  p_partition->start_loc = uint32_to_le(PART_START);
+  p_partition->part_len = uint32_to_le(PART_BLOCKS);
+  set_tag(p_partition, TAGID_PARTITION);
+
+  p_logvol->logical_blocksize = uint32_to_le(UDF_BLOCKSIZE);
+  set_long_ad(&p_logvol->lvd_use.fsd_loc, UDF_BLOCKSIZE, META_FSD, 1);
+  p_logvol->maptable_len = uint32_to_le(sizeof(*p_map1) + sizeof(*p_meta));
+  p_logvol->i_partition_maps = uint32_to_le(2);
+  p_map1->partition_map_type = GP_PARTIITON_MAP_TYPE_1;
+  p_map1->partition_map_length = sizeof(*p_map1);
+  p_map1->vol_seq_num = uint16_to_le(1);
+  p_map1->i_partition = uint16_to_le(0);
+  p_meta->partition_map_type = GP_PARTITION_MAP_TYPE_2;
+  p_meta->partition_map_length = sizeof(*p_meta);
+  memcpy(p_meta->partition_type_id.id, UDF_ID_METADATA,
+         strlen(UDF_ID_METADATA));
+  p_meta->vol_seq_num = uint16_to_le(1);
+  p_meta->i_partition = uint16_to_le(0);
+  p_meta->metadata_file_loc = uint32_to_le(PHYS_META_FE);
+  p_meta->metadata_mirror_file_loc = uint32_to_le(PHYS_MIRROR_FE);
+  p_meta->metadata_bitmap_file_loc = uint32_to_le(0xFFFFFFFF);
+  set_tag(p_logvol, TAGID_LOGVOL);
+
+  set_tag(p_image + (i_lba + 3) * UDF_BLOCKSIZE, TAGID_TERM);
+}
+
+/* Write a UDF 2.50 volume with a metadata partition holding the root
+   directory, hello.txt, sub/ and sub/inner.txt. */
+static bool
+write_udf250_image(void)
+{
+  anchor_vol_desc_ptr_t *p_avdp;
+  struct extended_file_entry *p_efe;
+  FILE *p_out;
+  unsigned int i;
+
+  free(p_image);
+  p_image = calloc(IMAGE_BLOCKS, UDF_BLOCKSIZE);
+  if (!p_image) return false;
+
+  build_vds(32);
+  build_vds(48);
+  p_avdp = (anchor_vol_desc_ptr_t *) (p_image + 256 * UDF_BLOCKSIZE);
+  p_avdp->main_vol_desc_seq_ext.len = uint32_to_le(16 * UDF_BLOCKSIZE);
+  p_avdp->main_vol_desc_seq_ext.loc = uint32_to_le(32);
+  p_avdp->reserve_vol_desc_seq_ext.len = uint32_to_le(16 * UDF_BLOCKSIZE);
+  p_avdp->reserve_vol_desc_seq_ext.loc = uint32_to_le(48);
+  set_tag(p_avdp, TAGID_ANCHOR);
+
+  build_metadata();
+  for (i = 0; i < META_BLOCKS; i++)
+    memcpy(phys_block(PHYS_MIRROR + i), meta_block(i), UDF_BLOCKSIZE);
+
+  p_efe = new_efe(phys_block(PHYS_META_FE), 250, ICBTAG_FLAG_AD_SHORT,
+                  META_BLOCKS * UDF_BLOCKSIZE, 2 * sizeof(udf_short_ad_t));
+  set_short_ad(p_efe->u.alloc_descs, 4 * UDF_BLOCKSIZE, PHYS_META_A);
+  set_short_ad(p_efe->u.alloc_descs + sizeof(udf_short_ad_t),
+               3 * UDF_BLOCKSIZE, PHYS_META_B);
+  set_tag(p_efe, TAGID_EFE);
+
+  p_efe = new_efe(phys_block(PHYS_MIRROR_FE), 251, ICBTAG_FLAG_AD_SHORT,
+                  META_BLOCKS * UDF_BLOCKSIZE, sizeof(udf_short_ad_t));
+  set_short_ad(p_efe->u.alloc_descs, META_BLOCKS * UDF_BLOCKSIZE,
+               PHYS_MIRROR);
+  set_tag(p_efe, TAGID_EFE);
+
+  for (i = 0; i < HELLO_LENGTH; i++)
+    phys_block(PHYS_DATA)[i] = (uint8_t) (i * 7);
+
+  p_out = fopen(UDF250_IMAGE, "wb");
+  if (!p_out) return false;
+  if (fwrite(p_image, UDF_BLOCKSIZE, IMAGE_BLOCKS, p_out) != IMAGE_BLOCKS) {
+    fclose(p_out);
+    return false;
+  }
+  return 0 == fclose(p_out);
+}
+
+/* Zero i_blocks blocks of the physical partition from i_lba on, in
+   the image on disk. */
+static bool
+wipe_blocks(uint32_t i_lba, unsigned int i_blocks)
+{
+  FILE *p_file = fopen(UDF250_IMAGE, "r+b");
+  uint8_t block[UDF_BLOCKSIZE];
+  bool b_ok;
+
+  if (!p_file) return false;
+  memset(block, 0, sizeof(block));
+  b_ok = 0 == fseek(p_file, (long) (PART_START + i_lba) * UDF_BLOCKSIZE,
+                    SEEK_SET);
+  while (b_ok && i_blocks--)
+    b_ok = fwrite(block, UDF_BLOCKSIZE, 1, p_file) == 1;
+  return 0 == fclose(p_file) && b_ok;
+}
+
+/* Append the names in directory p_udf_dir and below it to psz_out,
+   depth first, each followed by a space and those of directories by
+   a slash too. p_udf_dir is freed. */
+static void
+list_dir(udf_dirent_t *p_udf_dir, char *psz_out, size_t i_out)
+{
+  while ((p_udf_dir = udf_readdir(p_udf_dir))) {
+    if (p_udf_dir->b_parent) continue;
+    strncat(psz_out, udf_get_filename(p_udf_dir),
+            i_out - strlen(psz_out) - 3);
+    strcat(psz_out, udf_is_dir(p_udf_dir) ? "/ " : " ");
+    if (udf_is_dir(p_udf_dir))
+      list_dir(udf_opendir(p_udf_dir), psz_out, i_out);
+  }
+}
+
+/* Look the files up and read them. */
+static int
+check_files(udf_dirent_t *p_udf_root)
+{
+  udf_dirent_t *p_udf_file;
+  uint8_t buf[UDF_BLOCKSIZE];
+  char names[64];
+  unsigned int i;
+
+  p_udf_file = udf_fopen(p_udf_root, "hello.txt");
+  if (!p_udf_file || HELLO_LENGTH != udf_get_file_length(p_udf_file))
+    return 1;
+  if (100 != udf_pread(p_udf_file, buf, 100, 2000)) return 2;
+  for (i = 0; i < 100; i++)
+    if (buf[i] != (uint8_t) ((2000 + i) * 7)) return 3;
+  if (UDF_BLOCKSIZE != udf_read_block(p_udf_file, buf, 1)
+      || 0 != memcmp(buf, phys_block(PHYS_DATA), UDF_BLOCKSIZE))
+    return 4;
+  udf_dirent_free(p_udf_file);
+
+  p_udf_file = udf_fopen(p_udf_root, "/sub/inner.txt");
+  if (!p_udf_file
+      || (ssize_t) strlen(INNER_DATA) != udf_pread(p_udf_file, buf,
+                                                   sizeof(buf), 0)
+      || 0 != memcmp(buf, INNER_DATA, strlen(INNER_DATA)))
+    return 5;
+  udf_dirent_free(p_udf_file);
+
+  /* Read from a root of its own, as udf_readdir() frees it. */
+  names[0] = '\0';
+  list_dir(udf_get_root(p_udf_root->p_udf, true, 0), names, sizeof(names));
+  if (0 != strcmp(names, "hello.txt sub/ inner.txt ")) return 6;
+  return 0;
+}
+
+static int
+check_udf250(void)
+{
+  udf_t *p_udf;
+  udf_dirent_t *p_udf_root, *p_udf_root2;
+  char volume_id[64];
+  int rc;
+
+  if (!write_udf250_image()) return 10;
+  p_udf = udf_open(UDF250_IMAGE);
+  if (!p_udf) return 11;
+  if (udf_get_volume_id(p_udf, volume_id, sizeof(volume_id)) <= 0
+      || 0 != strcmp(volume_id, "UDF250"))
+    return 12;
+  p_udf_root = udf_get_root(p_udf, true, 0);
+  if (!p_udf_root) return 13;
+  if ((rc = check_files(p_udf_root))) return 20 + rc;
+  printf("-- Good! Files in a metadata partition can be read\n");
+
+  /* Once pinned, the metadata on the disc isn't read any more. */
+  if (udf_pin_metadata(p_udf, 4 * UDF_BLOCKSIZE)) return 14;
+  if (!udf_pin_metadata(p_udf, 1024 * 1024)) return 15;
+  if (!wipe_blocks(PHYS_META_A, 4) || !wipe_blocks(PHYS_META_B, 3)
+      || !wipe_blocks(PHYS_MIRROR, META_BLOCKS))
+    return 16;
+  p_udf_root2 = udf_get_root(p_udf, true, 0);
+  if (!p_udf_root2) return 17;
+  if ((rc = check_files(p_udf_root2))) return 30 + rc;
+  udf_dirent_free(p_udf_root2);
+  udf_dirent_free(p_udf_root);
+  udf_close(p_udf);
+  printf("-- Good! Pinned metadata is read from memory\n");
+
+  /* With its file entry gone, the metadata file is read through its
+     mirror. */
+  if (!write_udf250_image() || !wipe_blocks(PHYS_META_FE, 1)
+      || !wipe_blocks(PHYS_META_A, 4) || !wipe_blocks(PHYS_META_B, 3))
+    return 18;
+  p_udf = udf_open(UDF250_IMAGE);
+  if (!p_udf) return 19;
+  p_udf_root = udf_get_root(p_udf, true, 0);
+  if (!p_udf_root) return 40;
+  if ((rc = check_files(p_udf_root))) return 40 + rc;
+  udf_dirent_free(p_udf_root);
+  udf_close(p_udf);
+  printf("-- Good! The metadata mirror is used if need be\n");
+  return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  udf_t *p_udf;
+  int rc = check_udf250();
+
+  unlink(UDF250_IMAGE);
+  free(p_image);
+  if (rc) {
+    fprintf(stderr, "UDF 2.50 metadata partition check failed (rc %d)\n",
+            rc);
+    return rc;
+  }
+
+  /* Older volumes have no metadata partition to pin. */
+  p_udf = udf_open(UDF102_IMAGE);
+  if (!p_udf) {
+    fprintf(stderr, "Couldn't open %s as an UDF image\n", UDF102_IMAGE);
+    return 50;
+  }
+  if (udf_pin_metadata(p_udf, 1024 * 1024)) {
+    fprintf(stderr, "%s has no metadata partition to pin\n", UDF102_IMAGE);
+    return 51;
+  }
+  udf_close(p_udf);
+  return 0;
+}
@@ -0,0 +1,314 @@
+/*
+  Copyright (C) 2026 agent <agent@local>
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Tests iso9660_ifs_walk() and udf_walk() against a plain recursive
+   directory listing and lookups by path, with one and with several
+   threads.  */
+
+#ifndef DATA_DIR
+#define DATA_DIR "./data"
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#define __CDIO_CONFIG_H__ 1
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <cdio/cdio.h>
+#include <cdio/iso9660.h>
+#include <cdio/udf.h>
+
+typedef struct {
+  char  *psz;
+  size_t i_len;
+  size_t i_alloc;
+  unsigned int i_count;
+  unsigned int i_stop_after;
+} listing_t;
+
+static void
+listing_add(listing_t *p_listing, const char *psz_dir, const char *psz_name)
+{
+  size_t i_need = strlen(psz_dir) + strlen(psz_name) + 2;
+
+  if (p_listing->i_len + i_need + 1 > p_listing->i_alloc) {
+    p_listing->i_alloc = 2 * (p_listing->i_len + i_need + 1);
+    p_listing->psz = realloc(p_listing->psz, p_listing->i_alloc);
+    if (!p_listing->psz) exit(20);
+  }
+  p_listing->i_len += sprintf(p_listing->psz + p_listing->i_len, "%s%s\n",
+                              psz_dir, psz_name);
+  p_listing->i_count++;
+}
+
+static int
+iso_visitor(const char psz_dir[], const iso9660_stat_t *p_stat,
+            void *p_user_data)
+{
+  listing_t *p_listing = p_user_data;
+
+  listing_add(p_listing, psz_dir, p_stat->filename);
+  if (p_listing->i_stop_after
+      && p_listing->i_count == p_listing->i_stop_after)
+    return 42;
+  return 0;
+}
+
+static int
+udf_visitor(const char psz_dir[], const udf_dirent_t *p_udf_dirent,
+            void *p_user_data)
+{
+  char psz_entry[1024];
+
+  snprintf(psz_entry, sizeof(psz_entry), "%s %lu",
+           udf_get_filename(p_udf_dirent),
+           (unsigned long) udf_get_file_length(p_udf_dirent));
+  listing_add(p_user_data, psz_dir, psz_entry);
+  return 0;
+}
+
+/* Every entry but the parent one must be found again by path, and
+   what is read for it then must match what the walk read. */
+static int
+udf_lookup_visitor(const char psz_dir[], const udf_dirent_t *p_udf_dirent,
+                   void *p_user_data)
+{
+  udf_dirent_t *p_udf_root = p_user_data;
+  const char *psz_name = udf_get_filename(p_udf_dirent);
+  char *psz_path;
+  udf_dirent_t *p_found;
+  int i_rc = 0;
+
+  if (p_udf_dirent->b_parent) return 0;
+  psz_path = calloc(1, strlen(psz_dir) + strlen(psz_name) + 1);
+  if (!psz_path) exit(20);
+  sprintf(psz_path, "%s%s", psz_dir, psz_name);
+  p_found = udf_fopen(p_udf_root, psz_path);
+  if (!p_found
+      || udf_get_file_length(p_found) != udf_get_file_length(p_udf_dirent)
+      || udf_get_modification_time(p_found)
+         != udf_get_modification_time(p_udf_dirent)
+      || udf_get_posix_filemode(p_found)
+         != udf_get_posix_filemode(p_udf_dirent)) {
+    fprintf(stderr, "lookup of %s failed\n", psz_path);
+    i_rc = 44;
+  }
+  udf_dirent_free(p_found);
+  free(psz_path);
+  return i_rc;
+}
+
+/* Every entry the walk reports must be found again by path. */
+static int
+lookup_visitor(const char psz_dir[], const iso9660_stat_t *p_stat,
+               void *p_user_data)
+{
+  iso9660_t *p_iso = p_user_data;
+  char *psz_path = calloc(1, strlen(psz_dir) + strlen(p_stat->filename) + 1);
+  iso9660_stat_t *p_found;
+  int i_rc = 0;
+
+  if (!psz_path) exit(20);
+  sprintf(psz_path, "%s%s", psz_dir, p_stat->filename);
+  p_found = iso9660_ifs_stat(p_iso, psz_path);
+  if (!p_found || p_found->lsn != p_stat->lsn
+      || 0 != strcmp(p_found->filename, p_stat->filename)) {
+    fprintf(stderr, "lookup of %s failed\n", psz_path);
+    i_rc = 43;
+  }
+  iso9660_stat_free(p_found);
+  free(psz_path);
+  return i_rc;
+}
+
+/* The single-threaded, depth-first listing the walk must reproduce. */
+static void
+iso_list_recurse(iso9660_t *p_iso, const char psz_path[],
+                 listing_t *p_listing)
+{
+  CdioISO9660FileList_t *p_entlist = iso9660_ifs_readdir(p_iso, psz_path);
+  CdioListNode_t *p_entnode;
+
+  if (!p_entlist) exit(21);
+
+  _CDIO_LIST_FOREACH (p_entnode, p_entlist) {
+    iso9660_stat_t *p_stat = _cdio_list_node_data (p_entnode);
+    listing_add(p_listing, psz_path, p_stat->filename);
+  }
+  _CDIO_LIST_FOREACH (p_entnode, p_entlist) {
+    iso9660_stat_t *p_stat = _cdio_list_node_data (p_entnode);
+    char *psz_subdir;
+
+    if (_STAT_DIR != p_stat->type || 0 == strcmp(p_stat->filename, ".")
+        || 0 == strcmp(p_stat->filename, ".."))
+      continue;
+    psz_subdir = calloc(1, strlen(psz_path) + strlen(p_stat->filename) + 2);
+    sprintf(psz_subdir, "%s%s/", psz_path, p_stat->filename);
+    iso_list_recurse(p_iso, psz_subdir, p_listing);
+    free(psz_subdir);
+  }
+  iso9660_filelist_free(p_entlist);
+}
+
+static int
+check_iso(const char *psz_fname)
+{
+  iso9660_t *p_iso = iso9660_open_ext(psz_fname, ISO_EXTENSION_ALL);
+  listing_t expected, got;
+  unsigned int i_threads;
+  int i_rc;
+
+  if (!p_iso) {
+    fprintf(stderr, "Sorry, couldn't open %s as an ISO-9660 image\n",
+            psz_fname);
+    return 1;
+  }
+
+  memset(&expected, 0, sizeof(expected));
+  iso_list_recurse(p_iso, "/", &expected);
+
+  for (i_threads = 1; i_threads <= 4; i_threads += 3) {
+    memset(&got, 0, sizeof(got));
+    i_rc = iso9660_ifs_walk(p_iso, "/", iso_visitor, &got, i_threads,
+                            ISO9660_WALK_ORDERED);
+    if (0 != i_rc || NULL == got.psz || 0 != strcmp(expected.psz, got.psz)) {
+      fprintf(stderr, "%s: ordered walk with %u thread(s) differs "
+              "(rc %d)\n", psz_fname, i_threads, i_rc);
+      return 2;
+    }
+    free(got.psz);
+
+    memset(&got, 0, sizeof(got));
+    i_rc = iso9660_ifs_walk(p_iso, "/", iso_visitor, &got, i_threads,
+                            ISO9660_WALK_UNORDERED);
+    if (0 != i_rc || got.i_count != expected.i_count
+        || got.i_len != expected.i_len) {
+      fprintf(stderr, "%s: unordered walk with %u thread(s) saw %u "
+              "entries, expected %u (rc %d)\n", psz_fname, i_threads,
+              got.i_count, expected.i_count, i_rc);
+      return 3;
+    }
+    free(got.psz);
+
+    memset(&got, 0, sizeof(got));
+    got.i_stop_after = 3;
+    i_rc = iso9660_ifs_walk(p_iso, "/", iso_visitor, &got, i_threads,
+                            ISO9660_WALK_ORDERED);
+    if (42 != i_rc || 3 != got.i_count) {
+      fprintf(stderr, "%s: walk with %u thread(s) didn't stop when asked "
+              "(rc %d, %u entries)\n", psz_fname, i_threads, i_rc,
+              got.i_count);
+      return 4;
+    }
+    free(got.psz);
+  }
+
+  i_rc = iso9660_ifs_walk(p_iso, "/", lookup_visitor, p_iso, 1,
+                          ISO9660_WALK_ORDERED);
+  if (0 != i_rc) {
+    fprintf(stderr, "%s: not every entry could be looked up by path "
+            "(rc %d)\n", psz_fname, i_rc);
+    return 10;
+  }
+
+  if (-1 != iso9660_ifs_walk(p_iso, "/no-such-directory/", iso_visitor,
+                             &got, 2, ISO9660_WALK_ORDERED)) {
+    fprintf(stderr, "%s: walk of a missing directory should fail\n",
+            psz_fname);
+    return 5;
+  }
+
+  printf("-- Good! %u entries walked in %s\n", expected.i_count, psz_fname);
+  free(expected.psz);
+  iso9660_close(p_iso);
+  return 0;
+}
+
+static int
+check_udf(const char *psz_fname)
+{
+  udf_t *p_udf = udf_open(psz_fname);
+  udf_dirent_t *p_udf_root;
+  listing_t single, multi;
+  int i_rc;
+
+  if (!p_udf) {
+    fprintf(stderr, "Sorry, couldn't open %s as a UDF image\n", psz_fname);
+    return 6;
+  }
+  p_udf_root = udf_get_root(p_udf, true, 0);
+  if (!p_udf_root) {
+    fprintf(stderr, "Could not locate UDF root directory in %s\n",
+            psz_fname);
+    return 7;
+  }
+
+  memset(&single, 0, sizeof(single));
+  memset(&multi, 0, sizeof(multi));
+  i_rc = udf_walk(p_udf_root, "/", udf_visitor, &single, 1,
+                  UDF_WALK_ORDERED);
+  if (0 != i_rc || single.i_count < 2) {
+    fprintf(stderr, "%s: UDF walk failed (rc %d, %u entries)\n",
+            psz_fname, i_rc, single.i_count);
+    return 8;
+  }
+  i_rc = udf_walk(p_udf_root, "/", udf_visitor, &multi, 4,
+                  UDF_WALK_ORDERED);
+  if (0 != i_rc || 0 != strcmp(single.psz, multi.psz)) {
+    fprintf(stderr, "%s: UDF walks with 1 and 4 threads differ (rc %d)\n",
+            psz_fname, i_rc);
+    return 9;
+  }
+  i_rc = udf_walk(p_udf_root, "/", udf_lookup_visitor, p_udf_root, 2,
+                  UDF_WALK_UNORDERED);
+  if (0 != i_rc) {
+    fprintf(stderr, "%s: not every UDF entry could be looked up by path "
+            "(rc %d)\n", psz_fname, i_rc);
+    return 11;
+  }
+
+  printf("-- Good! %u entries walked in %s\n", single.i_count, psz_fname);
+  free(single.psz);
+  free(multi.psz);
+  udf_dirent_free(p_udf_root);
+  udf_close(p_udf);
+  return 0;
+}
+
+int
+main(int argc, const char *argv[])
+{
+  int i_rc;
+
+  if ((i_rc = check_iso(DATA_DIR "/deep-directory.iso"))) return i_rc;
+  if ((i_rc = check_iso(DATA_DIR "/copying-rr.iso")))     return i_rc;
+  if ((i_rc = check_iso(DATA_DIR "/joliet.iso")))         return i_rc;
+  if ((i_rc = check_udf(DATA_DIR "/udf102.iso")))         return i_rc;
+  if ((i_rc = check_udf(DATA_DIR "/test-udf1.iso")))      return i_rc;
+
+  return 0;
+}